@@ -50,6 +50,10 @@ THE SOFTWARE.
 #include "CCApplication.h"
 #include "label_nodes/CCLabelBMFont.h"
 #include "label_nodes/CCLabelAtlas.h"
+#include "label_nodes/CCGlyphAtlas.h"
+#include "label_nodes/CCAsyncTextRenderer.h"
+#include "label_nodes/CCTextLayoutCache.h"
+#include "script_support/CCScriptSupport.h"
 #include "actions/CCActionManager.h"
 #include "CCConfiguration.h"
 #include "keypad_dispatcher/CCKeypadDispatcher.h"
@@ -131,6 +135,9 @@ bool CCDirector::init(void)
     m_pFPSLabel = NULL;
     m_pSPFLabel = NULL;
     m_pDrawsLabel = NULL;
+    m_pScriptGCLabel = NULL;
+    m_pScriptHeapLabel = NULL;
+    m_fAccumScriptGCTime = 0.0f;
     m_uTotalFrames = m_uFrames = 0;
     m_pszFPS = new char[10];
     m_pLastUpdate = new struct cc_timeval();
@@ -176,6 +183,8 @@ CCDirector::~CCDirector(void)
     CC_SAFE_RELEASE(m_pFPSLabel);
     CC_SAFE_RELEASE(m_pSPFLabel);
     CC_SAFE_RELEASE(m_pDrawsLabel);
+    CC_SAFE_RELEASE(m_pScriptGCLabel);
+    CC_SAFE_RELEASE(m_pScriptHeapLabel);
     
     CC_SAFE_RELEASE(m_pRunningScene);
     CC_SAFE_RELEASE(m_pNotificationNode);
@@ -305,6 +314,16 @@ void CCDirector::drawScene(void)
 
     m_uTotalFrames++;
 
+    // let script engine use spare time of this frame
+    CCScriptEngineProtocol* pEngine = CCScriptEngineManager::sharedManager()->getScriptEngine();
+    if (pEngine)
+    {
+        struct cc_timeval now;
+        CCTime::gettimeofdayCocos2d(&now, NULL);
+        float elapsed = (now.tv_sec - m_pLastUpdate->tv_sec) + (now.tv_usec - m_pLastUpdate->tv_usec) / 1000000.0f;
+        pEngine->onFrameEnd(MAX(0, (float)m_dAnimationInterval - elapsed));
+    }
+
     // swap buffers
     if (m_pobOpenGLView)
     {
@@ -471,10 +490,12 @@ void CCDirector::setProjection(ccDirectorProjection kProjection)
 
 void CCDirector::purgeCachedData(void)
 {
-    CCLabelBMFont::purgeCachedData();
+    FNTConfigRemoveUnusedCache();
     if (s_SharedDirector->getOpenGLView())
     {
         CCSpriteFrameCache::sharedSpriteFrameCache()->purgeSharedSpriteFrameCache();
+        CCTextLayoutCache::sharedTextLayoutCache()->removeAllObjects();
+        CCGlyphAtlasCache::sharedGlyphAtlasCache()->removeUnusedAtlases();
         CCTextureCache::sharedTextureCache()->removeUnusedTextures();
 #if defined(COCOS2D_DEBUG) && (COCOS2D_DEBUG > 0)
         CCTextureCache::sharedTextureCache()->dumpCachedTextureInfo();
@@ -741,6 +762,8 @@ void CCDirector::purgeDirector()
     CC_SAFE_RELEASE_NULL(m_pFPSLabel);
     CC_SAFE_RELEASE_NULL(m_pSPFLabel);
     CC_SAFE_RELEASE_NULL(m_pDrawsLabel);
+    CC_SAFE_RELEASE_NULL(m_pScriptGCLabel);
+    CC_SAFE_RELEASE_NULL(m_pScriptHeapLabel);
 
     // purge bitmap cache
     CCLabelBMFont::purgeCachedData();
@@ -749,6 +772,9 @@ void CCDirector::purgeDirector()
     ccDrawFree();
     CCAnimationCache::purgeSharedAnimationCache();
     CCSpriteFrameCache::purgeSharedSpriteFrameCache();
+    CCAsyncTextRenderer::purgeSharedRenderer();
+    CCTextLayoutCache::purgeSharedTextLayoutCache();
+    CCGlyphAtlasCache::purgeSharedGlyphAtlasCache();
     CCTextureCache::purgeSharedTextureCache();
     CCShaderCache::purgeSharedShaderCache();
     CCFileUtils::purgeFileUtils();
@@ -850,11 +876,28 @@ void CCDirector::showStats(void)
     {
         if (m_pFPSLabel && m_pSPFLabel && m_pDrawsLabel)
         {
+            // script gc stats, only if engine provides them
+            float gcTime = 0;
+            unsigned int heapSize = 0;
+            CCScriptEngineProtocol* pEngine = CCScriptEngineManager::sharedManager()->getScriptEngine();
+            bool hasGCStats = pEngine && pEngine->getGCStats(&gcTime, &heapSize) && m_pScriptGCLabel && m_pScriptHeapLabel;
+            m_fAccumScriptGCTime += gcTime;
+            
             if (m_fAccumDt > CC_DIRECTOR_STATS_INTERVAL)
             {
                 sprintf(m_pszFPS, "%.3f", m_fSecondsPerFrame);
                 m_pSPFLabel->setString(m_pszFPS);
                 
+                if (hasGCStats)
+                {
+                    sprintf(m_pszFPS, "%.2f", m_fAccumScriptGCTime * 1000 / m_uFrames);
+                    m_pScriptGCLabel->setString(m_pszFPS);
+                    
+                    sprintf(m_pszFPS, "%u", MIN(heapSize, 999999999u));
+                    m_pScriptHeapLabel->setString(m_pszFPS);
+                }
+                m_fAccumScriptGCTime = 0;
+                
                 m_fFrameRate = m_uFrames / m_fAccumDt;
                 m_uFrames = 0;
                 m_fAccumDt = 0;
@@ -869,6 +912,11 @@ void CCDirector::showStats(void)
             m_pDrawsLabel->visit();
             m_pFPSLabel->visit();
             m_pSPFLabel->visit();
+            if (hasGCStats)
+            {
+                m_pScriptHeapLabel->visit();
+                m_pScriptGCLabel->visit();
+            }
         }
     }    
     
@@ -901,6 +949,8 @@ void CCDirector::createStatsLabel()
         CC_SAFE_RELEASE_NULL(m_pFPSLabel);
         CC_SAFE_RELEASE_NULL(m_pSPFLabel);
         CC_SAFE_RELEASE_NULL(m_pDrawsLabel);
+        CC_SAFE_RELEASE_NULL(m_pScriptGCLabel);
+        CC_SAFE_RELEASE_NULL(m_pScriptHeapLabel);
         textureCache->removeTextureForKey("cc_fps_images");
         CCFileUtils::sharedFileUtils()->purgeCachedEntries();
     }
@@ -951,8 +1001,20 @@ void CCDirector::createStatsLabel()
     m_pDrawsLabel->initWithString("000", texture, 12, 32, '.');
     m_pDrawsLabel->setScale(factor);
 
+    m_pScriptGCLabel = new CCLabelAtlas();
+    m_pScriptGCLabel->setIgnoreContentScaleFactor(true);
+    m_pScriptGCLabel->initWithString("0.00", texture, 12, 32, '.');
+    m_pScriptGCLabel->setScale(factor);
+
+    m_pScriptHeapLabel = new CCLabelAtlas();
+    m_pScriptHeapLabel->setIgnoreContentScaleFactor(true);
+    m_pScriptHeapLabel->initWithString("0", texture, 12, 32, '.');
+    m_pScriptHeapLabel->setScale(factor);
+
     CCTexture2D::setDefaultAlphaPixelFormat(currentFormat);
 
+    m_pScriptGCLabel->setPosition(ccpAdd(ccp(0, 68*factor), CC_DIRECTOR_STATS_POSITION));
+    m_pScriptHeapLabel->setPosition(ccpAdd(ccp(0, 51*factor), CC_DIRECTOR_STATS_POSITION));
     m_pDrawsLabel->setPosition(ccpAdd(ccp(0, 34*factor), CC_DIRECTOR_STATS_POSITION));
     m_pSPFLabel->setPosition(ccpAdd(ccp(0, 17*factor), CC_DIRECTOR_STATS_POSITION));
     m_pFPSLabel->setPosition(CC_DIRECTOR_STATS_POSITION);
@@ -404,6 +404,11 @@ protected:
     CCLabelAtlas *m_pSPFLabel;
     CCLabelAtlas *m_pDrawsLabel;
     
+    /* script garbage collection stats, ms per frame and heap in KB */
+    CCLabelAtlas *m_pScriptGCLabel;
+    CCLabelAtlas *m_pScriptHeapLabel;
+    float m_fAccumScriptGCTime;
+    
     /** Whether or not the Director is paused */
     bool m_bPaused;
 
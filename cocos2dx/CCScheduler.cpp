@@ -254,6 +254,7 @@ CCScheduler::CCScheduler(void)
 , m_bCurrentTargetSalvaged(false)
 , m_bUpdateHashLocked(false)
 , m_pScriptHandlerEntries(NULL)
+, m_pCurrentScriptEntry(NULL)
 {
 
 }
@@ -913,11 +914,20 @@ void CCScheduler::update(float dt)
             }
             else if (!pEntry->isPaused())
             {
+                m_pCurrentScriptEntry = pEntry;
                 pEntry->getTimer()->update(dt);
+                m_pCurrentScriptEntry = NULL;
             }
         }
     }
 
+    // script engine may queue schedule functions and call them in one shot
+    CCScriptEngineProtocol* pEngine = CCScriptEngineManager::sharedManager()->getScriptEngine();
+    if (pEngine)
+    {
+        pEngine->flushScheduleBatch();
+    }
+
     // delete all updates that are marked for deletion
     // updates with priority < 0
     DL_FOREACH_SAFE(m_pUpdatesNegList, pEntry, pTmp)
@@ -245,6 +245,13 @@ public:
      */
     void unscheduleAllScriptEntryForTarget(CCObject* target);
     
+    /** Script entry whose timer is being ticked, NULL if it is not in update of script entries.
+     Script engine can retain it to check if it is unscheduled before a deferred call.
+     * @js NA
+     * @lua NA
+     */
+    inline CCSchedulerScriptHandlerEntry* getCurrentScriptEntry(void) { return m_pCurrentScriptEntry; }
+    
     /** Pauses the target.
      All scheduled selectors/update for a given target won't be 'ticked' until the target is resumed.
      If the target is not present, nothing happens.
@@ -315,6 +322,7 @@ protected:
     // If true unschedule will not remove anything from a hash. Elements will only be marked for deletion.
     bool m_bUpdateHashLocked;
     CCArray* m_pScriptHandlerEntries;
+    CCSchedulerScriptHandlerEntry* m_pCurrentScriptEntry;
 };
 
 // end of global group
@@ -28,58 +28,72 @@ NS_CC_BEGIN
 
 static CCPoolManager* s_pPoolManager = NULL;
 
-CCAutoreleasePool::CCAutoreleasePool(void)
+// pool storage chunk, must be power of 2
+#define POOL_CHUNK_SHIFT 10
+#define POOL_CHUNK_SIZE (1 << POOL_CHUNK_SHIFT)
+#define POOL_CHUNK_MASK (POOL_CHUNK_SIZE - 1)
+
+CCAutoreleasePool::CCAutoreleasePool(void) :
+m_uCount(0)
 {
-    m_pManagedObjectArray = new CCArray();
-    m_pManagedObjectArray->init();
 }
 
 CCAutoreleasePool::~CCAutoreleasePool(void)
 {
-    CC_SAFE_DELETE(m_pManagedObjectArray);
+    clear();
+    
+    for(std::vector<CCObject**>::iterator iter = m_vChunks.begin(); iter != m_vChunks.end(); iter++) {
+        free(*iter);
+    }
+    m_vChunks.clear();
 }
 
-void CCAutoreleasePool::addObject(CCObject* pObject)
+void CCAutoreleasePool::grow()
+{
+    CCObject** chunk = (CCObject**)malloc(sizeof(CCObject*) * POOL_CHUNK_SIZE);
+    m_vChunks.push_back(chunk);
+}
+
+unsigned int CCAutoreleasePool::capacity() const
 {
-    m_pManagedObjectArray->addObject(pObject);
+    return (unsigned int)m_vChunks.size() << POOL_CHUNK_SHIFT;
+}
 
-    CCAssert(pObject->m_uReference > 1, "reference count should be greater than 1");
+void CCAutoreleasePool::addObject(CCObject* pObject)
+{
+    CCAssert(pObject->m_uReference > 0, "reference count should be greater than 0");
+    
+    // the pool takes over the reference of caller, so no retain here
+    if(m_uCount == capacity())
+        grow();
+    m_vChunks[m_uCount >> POOL_CHUNK_SHIFT][m_uCount & POOL_CHUNK_MASK] = pObject;
+    m_uCount++;
     ++(pObject->m_uAutoReleaseCount);
-    pObject->release(); // no ref count, in this case autorelease pool added.
 }
 
 void CCAutoreleasePool::removeObject(CCObject* pObject)
 {
-    for (unsigned int i = 0; i < pObject->m_uAutoReleaseCount; ++i)
-    {
-        m_pManagedObjectArray->removeObject(pObject, false);
+    unsigned int left = pObject->m_uAutoReleaseCount;
+    for(unsigned int i = m_uCount; i > 0 && left > 0; i--) {
+        CCObject*& slot = m_vChunks[(i - 1) >> POOL_CHUNK_SHIFT][(i - 1) & POOL_CHUNK_MASK];
+        if(slot == pObject) {
+            slot = NULL;
+            left--;
+        }
     }
 }
 
 void CCAutoreleasePool::clear()
 {
-    if(m_pManagedObjectArray->count() > 0)
-    {
-        //CCAutoreleasePool* pReleasePool;
-#ifdef _DEBUG
-        int nIndex = m_pManagedObjectArray->count() - 1;
-#endif
-
-        CCObject* pObj = NULL;
-        CCARRAY_FOREACH_REVERSE(m_pManagedObjectArray, pObj)
-        {
-            if(!pObj)
-                break;
-
+    // pop from tail, so objects autoreleased by destructors during
+    // clear are appended and released in same pass
+    while(m_uCount > 0) {
+        m_uCount--;
+        CCObject* pObj = m_vChunks[m_uCount >> POOL_CHUNK_SHIFT][m_uCount & POOL_CHUNK_MASK];
+        if(pObj) {
             --(pObj->m_uAutoReleaseCount);
-            //CC_SAFE_RELEASE((*it));
-            //delete (*it);
-#ifdef _DEBUG
-            nIndex--;
-#endif
+            pObj->release();
         }
-
-        m_pManagedObjectArray->removeAllObjects();
     }
 }
 
@@ -109,6 +123,9 @@ CCPoolManager::CCPoolManager()
     m_pReleasePoolStack = new CCArray();    
     m_pReleasePoolStack->init();
     m_pCurReleasePool = 0;
+    m_uFrameAutoreleaseCount = 0;
+    m_uLastFrameAutoreleaseCount = 0;
+    m_uPeakFrameAutoreleaseCount = 0;
 }
 
 CCPoolManager::~CCPoolManager()
@@ -159,6 +176,14 @@ void CCPoolManager::pop()
      int nCount = m_pReleasePoolStack->count();
 
     m_pCurReleasePool->clear();
+    
+    // popping root pool means a frame ends
+    if(nCount <= 1)
+    {
+        m_uLastFrameAutoreleaseCount = m_uFrameAutoreleaseCount;
+        m_uPeakFrameAutoreleaseCount = MAX(m_uPeakFrameAutoreleaseCount, m_uFrameAutoreleaseCount);
+        m_uFrameAutoreleaseCount = 0;
+    }
  
       if(nCount > 1)
       {
@@ -185,6 +210,14 @@ void CCPoolManager::removeObject(CCObject* pObject)
 void CCPoolManager::addObject(CCObject* pObject)
 {
     getCurReleasePool()->addObject(pObject);
+    m_uFrameAutoreleaseCount++;
+}
+
+void CCPoolManager::resetAutoreleaseStatistics()
+{
+    m_uFrameAutoreleaseCount = 0;
+    m_uLastFrameAutoreleaseCount = 0;
+    m_uPeakFrameAutoreleaseCount = 0;
 }
 
 
@@ -26,6 +26,7 @@ THE SOFTWARE.
 
 #include "CCObject.h"
 #include "CCArray.h"
+#include <vector>
 
 NS_CC_BEGIN
 
@@ -38,15 +39,35 @@ NS_CC_BEGIN
 
 class CC_DLL CCAutoreleasePool : public CCObject
 {
-    CCArray*    m_pManagedObjectArray;    
+    /**
+     * Managed objects live in an append-only list of fixed size chunks. Chunks are
+     * kept after clear so a pool which is drained every frame stops allocating once
+     * it reached its high water mark, and growing never moves stored pointers.
+     */
+    std::vector<CCObject**>    m_vChunks;
+    unsigned int               m_uCount;
+    
+    void grow();
 public:
     CCAutoreleasePool(void);
     ~CCAutoreleasePool(void);
 
     void addObject(CCObject *pObject);
+    
+    /**
+     * Forget an object which is destroyed while still managed by this pool. It is
+     * only reached when an object is over released, so it is allowed to be slow.
+     */
     void removeObject(CCObject *pObject);
 
+    /// release all managed objects, in reverse order of adding
     void clear();
+    
+    /// number of objects currently managed by this pool
+    unsigned int count() const { return m_uCount; }
+    
+    /// number of object slots allocated by this pool
+    unsigned int capacity() const;
 };
 
 /**
@@ -57,6 +78,11 @@ class CC_DLL CCPoolManager
 {
     CCArray*    m_pReleasePoolStack;    
     CCAutoreleasePool*                    m_pCurReleasePool;
+    
+    // autorelease statistics
+    unsigned int m_uFrameAutoreleaseCount;
+    unsigned int m_uLastFrameAutoreleaseCount;
+    unsigned int m_uPeakFrameAutoreleaseCount;
 
     CCAutoreleasePool* getCurReleasePool();
 public:
@@ -69,6 +95,18 @@ public:
     void removeObject(CCObject* pObject);
     void addObject(CCObject* pObject);
 
+    /// count of autorelease calls in the last completed frame
+    unsigned int getLastFrameAutoreleaseCount() const { return m_uLastFrameAutoreleaseCount; }
+    
+    /// count of autorelease calls in the current frame so far
+    unsigned int getFrameAutoreleaseCount() const { return m_uFrameAutoreleaseCount; }
+    
+    /// max autorelease calls seen in a single frame
+    unsigned int getPeakFrameAutoreleaseCount() const { return m_uPeakFrameAutoreleaseCount; }
+    
+    /// reset peak autorelease count
+    void resetAutoreleaseStatistics();
+
     static CCPoolManager* sharedPoolManager();
     static void purgePoolManager();
 
@@ -26,44 +26,118 @@
 #include "CCString.h"
 #include "CCInteger.h"
 #include "platform/CCFileUtils.h"
+#include <pthread.h>
 
 using namespace std;
 
 NS_CC_BEGIN
 
 // -----------------------------------------------------------------------
-// CCDictElement
-
-CCDictElement::CCDictElement(const char* pszKey, CCObject* pObject)
-{
-    CCAssert(pszKey && strlen(pszKey) > 0, "Invalid key value.");
-    m_iKey = 0;
-    const char* pStart = pszKey;
-    
-    int len = strlen(pszKey);
-    if (len > MAX_KEY_LEN )
-    {
-        char* pEnd = (char*)&pszKey[len-1];
-        pStart = pEnd - (MAX_KEY_LEN-1);
+// interned keys
+
+// header of an interned string key, key string follows it
+typedef struct _tDictKey {
+    unsigned int refCount;
+    unsigned int hash;
+    char str[1];
+} tDictKey;
+
+#define KEY_HEADER(k) ((tDictKey*)((k) - offsetof(tDictKey, str)))
+
+// key table may be touched by loader threads, so it needs a lock
+static pthread_mutex_t s_keyMutex = PTHREAD_MUTEX_INITIALIZER;
+static tDictKey** s_pKeyTable = NULL;
+static unsigned int s_uKeyMask = 0;
+static unsigned int s_uKeyCount = 0;
+
+// FNV-1a
+static inline unsigned int hashStrKey(const char* key) {
+    unsigned int h = 2166136261u;
+    for(const unsigned char* p = (const unsigned char*)key; *p; p++) {
+        h ^= *p;
+        h *= 16777619u;
     }
-    
-    strcpy(m_szKey, pStart);
-    
-    m_pObject = pObject;
-    memset(&hh, 0, sizeof(hh));
+    return h;
 }
 
-CCDictElement::CCDictElement(intptr_t iKey, CCObject* pObject)
-{
-    m_szKey[0] = '\0';
-    m_iKey = iKey;
-    m_pObject = pObject;
-    memset(&hh, 0, sizeof(hh));
+static inline unsigned int hashIntKey(intptr_t key) {
+    uint64_t k = (uint64_t)key;
+    return (unsigned int)((k ^ (k >> 32)) * 2654435761u);
 }
 
-CCDictElement::~CCDictElement()
-{
+static void growKeyTable() {
+    unsigned int oldSize = s_pKeyTable ? (s_uKeyMask + 1) : 0;
+    unsigned int newSize = oldSize ? oldSize * 2 : 1024;
+    tDictKey** table = (tDictKey**)calloc(newSize, sizeof(tDictKey*));
+    unsigned int mask = newSize - 1;
+    for(unsigned int i = 0; i < oldSize; i++) {
+        tDictKey* k = s_pKeyTable[i];
+        if(k) {
+            unsigned int slot = k->hash & mask;
+            while(table[slot])
+                slot = (slot + 1) & mask;
+            table[slot] = k;
+        }
+    }
+    free(s_pKeyTable);
+    s_pKeyTable = table;
+    s_uKeyMask = mask;
+}
 
+static const char* acquireKey(const char* key, unsigned int hash) {
+    pthread_mutex_lock(&s_keyMutex);
+    
+    // keep load factor under 0.5
+    if(!s_pKeyTable || (s_uKeyCount + 1) * 2 > s_uKeyMask + 1)
+        growKeyTable();
+    
+    // find or add
+    unsigned int slot = hash & s_uKeyMask;
+    tDictKey* k;
+    while((k = s_pKeyTable[slot]) != NULL) {
+        if(k->hash == hash && !strcmp(k->str, key))
+            break;
+        slot = (slot + 1) & s_uKeyMask;
+    }
+    if(!k) {
+        size_t len = strlen(key);
+        k = (tDictKey*)malloc(sizeof(tDictKey) + len);
+        k->refCount = 0;
+        k->hash = hash;
+        memcpy(k->str, key, len + 1);
+        s_pKeyTable[slot] = k;
+        s_uKeyCount++;
+    }
+    k->refCount++;
+    
+    pthread_mutex_unlock(&s_keyMutex);
+    return k->str;
+}
+
+static void releaseKey(const char* key) {
+    tDictKey* k = KEY_HEADER(key);
+    pthread_mutex_lock(&s_keyMutex);
+    if(--k->refCount == 0) {
+        // find slot
+        unsigned int slot = k->hash & s_uKeyMask;
+        while(s_pKeyTable[slot] != k)
+            slot = (slot + 1) & s_uKeyMask;
+        
+        // backward shift following keys so no tombstone is needed
+        unsigned int next = (slot + 1) & s_uKeyMask;
+        while(s_pKeyTable[next]) {
+            unsigned int ideal = s_pKeyTable[next]->hash & s_uKeyMask;
+            if(((next - ideal) & s_uKeyMask) >= ((next - slot) & s_uKeyMask)) {
+                s_pKeyTable[slot] = s_pKeyTable[next];
+                slot = next;
+            }
+            next = (next + 1) & s_uKeyMask;
+        }
+        s_pKeyTable[slot] = NULL;
+        s_uKeyCount--;
+        free(k);
+    }
+    pthread_mutex_unlock(&s_keyMutex);
 }
 
 // -----------------------------------------------------------------------
@@ -71,6 +145,11 @@ CCDictElement::~CCDictElement()
 
 CCDictionary::CCDictionary()
 : m_pElements(NULL)
+, m_uElementsUsed(0)
+, m_uElementsCapacity(0)
+, m_uCount(0)
+, m_pIndex(NULL)
+, m_uIndexMask(0)
 , m_eDictType(kCCDictUnknown)
 {
 
@@ -79,11 +158,127 @@ CCDictionary::CCDictionary()
 CCDictionary::~CCDictionary()
 {
     removeAllObjects();
+    free(m_pElements);
+    free(m_pIndex);
 }
 
 unsigned int CCDictionary::count()
 {
-    return HASH_COUNT(m_pElements);
+    return m_uCount;
+}
+
+int CCDictionary::findElement(const char* key, unsigned int hash) const
+{
+    if(!m_pIndex)
+        return -1;
+    
+    unsigned int slot = hash & m_uIndexMask;
+    int idx;
+    while((idx = m_pIndex[slot]) != -1) {
+        const CCDictElement& e = m_pElements[idx];
+        if(e.m_uHash == hash && !strcmp(e.m_pszKey, key))
+            return idx;
+        slot = (slot + 1) & m_uIndexMask;
+    }
+    return -1;
+}
+
+int CCDictionary::findElement(intptr_t key, unsigned int hash) const
+{
+    if(!m_pIndex)
+        return -1;
+    
+    unsigned int slot = hash & m_uIndexMask;
+    int idx;
+    while((idx = m_pIndex[slot]) != -1) {
+        if(m_pElements[idx].m_iKey == key)
+            return idx;
+        slot = (slot + 1) & m_uIndexMask;
+    }
+    return -1;
+}
+
+void CCDictionary::rehash()
+{
+    unsigned int size = 16;
+    while(size < m_uElementsCapacity * 2)
+        size <<= 1;
+    if(size != m_uIndexMask + 1 || !m_pIndex) {
+        free(m_pIndex);
+        m_pIndex = (int*)malloc(sizeof(int) * size);
+        m_uIndexMask = size - 1;
+    }
+    memset(m_pIndex, 0xff, sizeof(int) * size);
+    
+    for(unsigned int i = 0; i < m_uElementsUsed; i++) {
+        if(m_pElements[i].m_pObject) {
+            unsigned int slot = m_pElements[i].m_uHash & m_uIndexMask;
+            while(m_pIndex[slot] != -1)
+                slot = (slot + 1) & m_uIndexMask;
+            m_pIndex[slot] = i;
+        }
+    }
+}
+
+void CCDictionary::reserveElement()
+{
+    if(m_uElementsUsed < m_uElementsCapacity)
+        return;
+    
+    if(m_uElementsUsed - m_uCount >= m_uElementsUsed / 2 && m_uElementsUsed > 0) {
+        // many holes, compact is enough
+        unsigned int dst = 0;
+        for(unsigned int i = 0; i < m_uElementsUsed; i++) {
+            if(m_pElements[i].m_pObject) {
+                if(dst != i)
+                    m_pElements[dst] = m_pElements[i];
+                dst++;
+            }
+        }
+        m_uElementsUsed = dst;
+    } else {
+        m_uElementsCapacity = MAX(8, m_uElementsCapacity * 2);
+        m_pElements = (CCDictElement*)realloc(m_pElements, sizeof(CCDictElement) * m_uElementsCapacity);
+    }
+    rehash();
+}
+
+void CCDictionary::removeElementAtIndex(unsigned int index)
+{
+    CCDictElement& e = m_pElements[index];
+    
+    // find slot of element
+    unsigned int slot = e.m_uHash & m_uIndexMask;
+    while(m_pIndex[slot] != (int)index)
+        slot = (slot + 1) & m_uIndexMask;
+    
+    // backward shift following slots so no tombstone is needed
+    unsigned int next = (slot + 1) & m_uIndexMask;
+    int idx;
+    while((idx = m_pIndex[next]) != -1) {
+        unsigned int ideal = m_pElements[idx].m_uHash & m_uIndexMask;
+        if(((next - ideal) & m_uIndexMask) >= ((next - slot) & m_uIndexMask)) {
+            m_pIndex[slot] = idx;
+            slot = next;
+        }
+        next = (next + 1) & m_uIndexMask;
+    }
+    m_pIndex[slot] = -1;
+    
+    // unlink element first, releasing object may call back into dictionary
+    CCObject* pObject = e.m_pObject;
+    const char* pszKey = e.m_pszKey;
+    e.m_pObject = NULL;
+    e.m_pszKey = NULL;
+    m_uCount--;
+    
+    // trailing holes can be reused at once
+    while(m_uElementsUsed > 0 && !m_pElements[m_uElementsUsed - 1].m_pObject)
+        m_uElementsUsed--;
+    
+    if(pszKey)
+        releaseKey(pszKey);
+    CC_SAFE_RELEASE(pObject);
 }
 
 CCArray* CCDictionary::allKeys()
@@ -93,19 +288,19 @@ CCArray* CCDictionary::allKeys()
 
     CCArray* pArray = CCArray::createWithCapacity(iKeyCount);
 
-    CCDictElement *pElement, *tmp;
+    CCDictElement *pElement = NULL;
     if (m_eDictType == kCCDictStr)
     {
-        HASH_ITER(hh, m_pElements, pElement, tmp) 
+        CCDICT_FOREACH(this, pElement)
         {
-            CCString* pOneKey = new CCString(pElement->m_szKey);
+            CCString* pOneKey = new CCString(pElement->m_pszKey);
             pArray->addObject(pOneKey);
             CC_SAFE_RELEASE(pOneKey);
         }
     }
     else if (m_eDictType == kCCDictInt)
     {
-        HASH_ITER(hh, m_pElements, pElement, tmp) 
+        CCDICT_FOREACH(this, pElement)
         {
             CCInteger* pOneKey = new CCInteger(pElement->m_iKey);
             pArray->addObject(pOneKey);
@@ -122,15 +317,15 @@ CCArray* CCDictionary::allKeysForObject(CCObject* object)
     if (iKeyCount <= 0) return NULL;
     CCArray* pArray = CCArray::create();
 
-    CCDictElement *pElement, *tmp;
+    CCDictElement *pElement = NULL;
 
     if (m_eDictType == kCCDictStr)
     {
-        HASH_ITER(hh, m_pElements, pElement, tmp) 
+        CCDICT_FOREACH(this, pElement)
         {
             if (object == pElement->m_pObject)
             {
-                CCString* pOneKey = new CCString(pElement->m_szKey);
+                CCString* pOneKey = new CCString(pElement->m_pszKey);
                 pArray->addObject(pOneKey);
                 CC_SAFE_RELEASE(pOneKey);
             }
@@ -138,7 +333,7 @@ CCArray* CCDictionary::allKeysForObject(CCObject* object)
     }
     else if (m_eDictType == kCCDictInt)
     {
-        HASH_ITER(hh, m_pElements, pElement, tmp) 
+        CCDICT_FOREACH(this, pElement)
         {
             if (object == pElement->m_pObject)
             {
@@ -159,14 +354,8 @@ CCObject* CCDictionary::objectForKey(const std::string& key)
     // This method uses string as key, therefore we should make sure that the key type of this CCDictionary is string.
     CCAssert(m_eDictType == kCCDictStr, "this dictionary does not use string as key.");
 
-    CCObject* pRetObject = NULL;
-    CCDictElement *pElement = NULL;
-    HASH_FIND_STR(m_pElements, key.c_str(), pElement);
-    if (pElement != NULL)
-    {
-        pRetObject = pElement->m_pObject;
-    }
-    return pRetObject;
+    int idx = findElement(key.c_str(), hashStrKey(key.c_str()));
+    return idx >= 0 ? m_pElements[idx].m_pObject : NULL;
 }
 
 CCObject* CCDictionary::objectForKey(intptr_t key)
@@ -177,14 +366,8 @@ CCObject* CCDictionary::objectForKey(intptr_t key)
     // This method uses integer as key, therefore we should make sure that the key type of this CCDictionary is integer.
     CCAssert(m_eDictType == kCCDictInt, "this dictionary does not use integer as key.");
 
-    CCObject* pRetObject = NULL;
-    CCDictElement *pElement = NULL;
-    HASH_FIND_PTR(m_pElements, &key, pElement);
-    if (pElement != NULL)
-    {
-        pRetObject = pElement->m_pObject;
-    }
-    return pRetObject;
+    int idx = findElement(key, hashIntKey(key));
+    return idx >= 0 ? m_pElements[idx].m_pObject : NULL;
 }
 
 const CCString* CCDictionary::valueForKey(const std::string& key)
@@ -217,18 +400,18 @@ void CCDictionary::setObject(CCObject* pObject, const std::string& key)
 
     CCAssert(m_eDictType == kCCDictStr, "this dictionary doesn't use string as key.");
 
-    CCDictElement *pElement = NULL;
-    HASH_FIND_STR(m_pElements, key.c_str(), pElement);
-    if (pElement == NULL)
+    unsigned int hash = hashStrKey(key.c_str());
+    int idx = findElement(key.c_str(), hash);
+    if (idx < 0)
     {
-        setObjectUnSafe(pObject, key);
+        setObjectUnSafe(pObject, key, hash);
     }
-    else if (pElement->m_pObject != pObject)
+    else if (m_pElements[idx].m_pObject != pObject)
     {
-        CCObject* pTmpObj = pElement->m_pObject;
+        CCObject* pTmpObj = m_pElements[idx].m_pObject;
         CC_SAFE_RETAIN(pTmpObj);
-        removeObjectForElememt(pElement);
-        setObjectUnSafe(pObject, key);
+        removeElementAtIndex(idx);
+        setObjectUnSafe(pObject, key, hash);
         CC_SAFE_RELEASE(pTmpObj);
     }
 }
@@ -243,18 +426,18 @@ void CCDictionary::setObject(CCObject* pObject, intptr_t key)
 
     CCAssert(m_eDictType == kCCDictInt, "this dictionary doesn't use integer as key.");
 
-    CCDictElement *pElement = NULL;
-    HASH_FIND_PTR(m_pElements, &key, pElement);
-    if (pElement == NULL)
+    unsigned int hash = hashIntKey(key);
+    int idx = findElement(key, hash);
+    if (idx < 0)
     {
-        setObjectUnSafe(pObject, key);
+        setObjectUnSafe(pObject, key, hash);
     }
-    else if (pElement->m_pObject != pObject)
+    else if (m_pElements[idx].m_pObject != pObject)
     {
-        CCObject* pTmpObj = pElement->m_pObject;
+        CCObject* pTmpObj = m_pElements[idx].m_pObject;
         CC_SAFE_RETAIN(pTmpObj);
-        removeObjectForElememt(pElement);
-        setObjectUnSafe(pObject, key);
+        removeElementAtIndex(idx);
+        setObjectUnSafe(pObject, key, hash);
         CC_SAFE_RELEASE(pTmpObj);
     }
 
@@ -269,9 +452,11 @@ void CCDictionary::removeObjectForKey(const std::string& key)
     
     CCAssert(m_eDictType == kCCDictStr, "this dictionary doesn't use string as its key");
     CCAssert(key.length() > 0, "Invalid Argument!");
-    CCDictElement *pElement = NULL;
-    HASH_FIND_STR(m_pElements, key.c_str(), pElement);
-    removeObjectForElememt(pElement);
+    int idx = findElement(key.c_str(), hashStrKey(key.c_str()));
+    if (idx >= 0)
+    {
+        removeElementAtIndex(idx);
+    }
 }
 
 void CCDictionary::removeObjectForKey(intptr_t key)
@@ -282,23 +467,49 @@ void CCDictionary::removeObjectForKey(intptr_t key)
     }
     
     CCAssert(m_eDictType == kCCDictInt, "this dictionary doesn't use integer as its key");
-    CCDictElement *pElement = NULL;
-    HASH_FIND_PTR(m_pElements, &key, pElement);
-    removeObjectForElememt(pElement);
+    int idx = findElement(key, hashIntKey(key));
+    if (idx >= 0)
+    {
+        removeElementAtIndex(idx);
+    }
 }
 
-void CCDictionary::setObjectUnSafe(CCObject* pObject, const std::string& key)
+void CCDictionary::setObjectUnSafe(CCObject* pObject, const std::string& key, unsigned int hash)
 {
     CC_SAFE_RETAIN(pObject);
-    CCDictElement* pElement = new CCDictElement(key.c_str(), pObject);
-    HASH_ADD_STR(m_pElements, m_szKey, pElement);
+    reserveElement();
+    
+    unsigned int idx = m_uElementsUsed++;
+    CCDictElement& e = m_pElements[idx];
+    e.m_pszKey = acquireKey(key.c_str(), hash);
+    e.m_iKey = 0;
+    e.m_pObject = pObject;
+    e.m_uHash = hash;
+    m_uCount++;
+    
+    unsigned int slot = hash & m_uIndexMask;
+    while(m_pIndex[slot] != -1)
+        slot = (slot + 1) & m_uIndexMask;
+    m_pIndex[slot] = idx;
 }
 
-void CCDictionary::setObjectUnSafe(CCObject* pObject, const intptr_t key)
+void CCDictionary::setObjectUnSafe(CCObject* pObject, const intptr_t key, unsigned int hash)
 {
     CC_SAFE_RETAIN(pObject);
-    CCDictElement* pElement = new CCDictElement(key, pObject);
-    HASH_ADD_PTR(m_pElements, m_iKey, pElement);
+    reserveElement();
+    
+    unsigned int idx = m_uElementsUsed++;
+    CCDictElement& e = m_pElements[idx];
+    e.m_pszKey = NULL;
+    e.m_iKey = key;
+    e.m_pObject = pObject;
+    e.m_uHash = hash;
+    m_uCount++;
+    
+    unsigned int slot = hash & m_uIndexMask;
+    while(m_pIndex[slot] != -1)
+        slot = (slot + 1) & m_uIndexMask;
+    m_pIndex[slot] = idx;
 }
 
 void CCDictionary::removeObjectsForKeys(CCArray* pKeyArray)
@@ -313,24 +524,35 @@ void CCDictionary::removeObjectsForKeys(CCArray* pKeyArray)
 
 void CCDictionary::removeObjectForElememt(CCDictElement* pElement)
 {
-    if (pElement != NULL)
+    if (pElement != NULL && pElement->m_pObject != NULL)
     {
-        HASH_DEL(m_pElements, pElement);
-        CC_SAFE_RELEASE(pElement->m_pObject);
-        CC_SAFE_DELETE(pElement);
+        CCAssert(pElement >= m_pElements && pElement < m_pElements + m_uElementsUsed, "element doesn't belong to this dictionary");
+        removeElementAtIndex(pElement - m_pElements);
     }
 }
 
 void CCDictionary::removeAllObjects()
 {
-    CCDictElement *pElement, *tmp;
-    HASH_ITER(hh, m_pElements, pElement, tmp) 
-    {
-        HASH_DEL(m_pElements, pElement);
-        CC_SAFE_RELEASE(pElement->m_pObject);
-        CC_SAFE_DELETE(pElement);
-
+    // detach all elements first, releasing an object may call back into dictionary
+    CCDictElement* pElements = m_pElements;
+    unsigned int uUsed = m_uElementsUsed;
+    m_pElements = NULL;
+    m_uElementsUsed = 0;
+    m_uElementsCapacity = 0;
+    m_uCount = 0;
+    free(m_pIndex);
+    m_pIndex = NULL;
+    m_uIndexMask = 0;
+    
+    for(unsigned int i = 0; i < uUsed; i++) {
+        CCDictElement& e = pElements[i];
+        if(e.m_pObject) {
+            if(e.m_pszKey)
+                releaseKey(e.m_pszKey);
+            e.m_pObject->release();
+        }
     }
+    free(pElements);
 }
 
 CCObject* CCDictionary::copyWithZone(CCZone* pZone)
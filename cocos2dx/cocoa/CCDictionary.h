@@ -62,29 +62,7 @@ class CCDictionary;
  */
 class CC_DLL CCDictElement
 {
-private:
-    /**
-     *  Constructor of CCDictElement. It's only for internal usage. CCDictionary is its friend class.
-     *  
-     *  @param  pszKey    The string key of this element.
-     *  @param  pObject   The object of this element.
-     */
-    CCDictElement(const char* pszKey, CCObject* pObject);
-
-    /**
-     *  Constructor of CCDictElement. It's only for internal usage. CCDictionary is its friend class.
-     *
-     *  @param  iKey    The integer key of this element.
-     *  @param  pObject   The object of this element.
-     */
-    CCDictElement(intptr_t iKey, CCObject* pObject);
-    
 public:
-    /**
-     *  The destructor of CCDictElement.
-     */
-    ~CCDictElement();
-
     // Inline functions need to be implemented in header file on Android.
     
     /**
@@ -96,8 +74,8 @@ public:
      */
     inline const char* getStrKey() const
     {
-        CCAssert(m_szKey[0] != '\0', "Should not call this function for integer dictionary");
-        return m_szKey;
+        CCAssert(m_pszKey != NULL, "Should not call this function for integer dictionary");
+        return m_pszKey;
     }
 
     /**
@@ -109,39 +87,38 @@ public:
      */
     inline intptr_t getIntKey() const
     {
-        CCAssert(m_szKey[0] == '\0', "Should not call this function for string dictionary");
+        CCAssert(m_pszKey == NULL, "Should not call this function for string dictionary");
         return m_iKey;
     }
     
     /**
      * Get the object of this element.
      *
-     * @return  The object of this element.
+     * @return  The object of this element. It is NULL if element is already removed.
      */
     inline CCObject* getObject() const { return m_pObject; }
 
 private:
-    // The max length of string key.
-    #define   MAX_KEY_LEN   256
-    // char array is needed for HASH_ADD_STR in UT_HASH.
-    // So it's a pain that all elements will allocate 256 bytes for this array.
-    char      m_szKey[MAX_KEY_LEN];     // hash key of string type
-    intptr_t  m_iKey;       // hash key of integer type
-    CCObject* m_pObject;    // hash value
-public:
-    UT_hash_handle hh;      // makes this class hashable
+    // string keys are interned and shared by all dictionaries, so a key
+    // used in many dictionaries, such as plist keys, is stored only once
+    const char*  m_pszKey;     // hash key of string type, NULL for integer key
+    intptr_t     m_iKey;       // hash key of integer type
+    CCObject*    m_pObject;    // hash value, NULL if element is removed
+    unsigned int m_uHash;      // cached hash of key
+    
     friend class CCDictionary; // declare CCDictionary as friend class
 };
 
 /** The macro for traversing dictionary
  *  
  *  @note It's faster than getting all keys and traversing keys to get objects by objectForKey.
- *        It's also safe to remove elements while traversing.
+ *        Elements are traversed in insertion order. It's also safe to remove elements while traversing,
+ *        but an element pointer is not valid any more once a new key is inserted.
  */
 #define CCDICT_FOREACH(__dict__, __el__) \
-    CCDictElement* pTmp##__dict__##__el__ = NULL; \
+    unsigned int uIdx##__dict__##__el__ = 0; \
     if (__dict__) \
-    HASH_ITER(hh, (__dict__)->m_pElements, __el__, pTmp##__dict__##__el__)
+    for (; ((__el__) = (__dict__)->nextElement(uIdx##__dict__##__el__)) != NULL; uIdx##__dict__##__el__++)
 
 
 
@@ -398,21 +375,60 @@ public:
      */
     virtual void acceptVisitor(CCDataVisitor &visitor);
 
+    /**
+     *  Get first element which is not removed, starting from an element index.
+     *
+     *  @note For internal usage, it's used by CCDICT_FOREACH.
+     *  @param index  Index to start with, it will be moved to the index of returned element.
+     *  @return The element, or NULL if no more element.
+     *  @lua NA
+     */
+    inline CCDictElement* nextElement(unsigned int& index) const
+    {
+        for(; index < m_uElementsUsed; index++) {
+            if(m_pElements[index].m_pObject)
+                return m_pElements + index;
+        }
+        return NULL;
+    }
+
 private:
     /** 
      *  For internal usage, invoked by setObject.
      */
-    void setObjectUnSafe(CCObject* pObject, const std::string& key);
-    void setObjectUnSafe(CCObject* pObject, const intptr_t key);
+    void setObjectUnSafe(CCObject* pObject, const std::string& key, unsigned int hash);
+    void setObjectUnSafe(CCObject* pObject, const intptr_t key, unsigned int hash);
     
-public:
+    /// find element index of a key, -1 if not found
+    int findElement(const char* key, unsigned int hash) const;
+    int findElement(intptr_t key, unsigned int hash) const;
+    
+    /// make room for a new element
+    void reserveElement();
+    
+    /// rebuild index table from elements
+    void rehash();
+    
+    /// unlink element from index table and release it
+    void removeElementAtIndex(unsigned int index);
+    
+private:
     /**
-     *  All the elements in dictionary.
-     * 
-     *  @note For internal usage, we need to declare this member variable as public since it's used in UT_HASH.
+     *  All the elements in dictionary, in insertion order. Removed elements
+     *  stay as holes until the storage is compacted when it is full.
      */
     CCDictElement* m_pElements;
-private:
+    unsigned int m_uElementsUsed;
+    unsigned int m_uElementsCapacity;
+    unsigned int m_uCount;
+    
+    /**
+     *  Open addressing table with linear probing, saves element index or -1 for
+     *  empty slot. Its size is power of 2 and at least twice of element capacity.
+     */
+    int* m_pIndex;
+    unsigned int m_uIndexMask;
+    
     
     /** The support type of dictionary, it's confirmed when setObject is invoked. */
     enum CCDictType
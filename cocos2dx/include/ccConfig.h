@@ -204,6 +204,21 @@ Only valid for cocos2d-mac. Not supported on cocos2d-ios.
 #define CC_USE_LA88_LABELS 1
 #endif
 
+/** @def CC_USE_FREETYPE
+ If enabled, CCGlyphAtlas rasterises glyphs with FreeType from a TTF file bundled with the game,
+ the font name of a label must be the path of that file. If it is disabled, glyphs are rasterised
+ one by one by the platform text renderer (CCImage).
+
+ It is enabled by default on Linux, which has no platform text renderer.
+ */
+#ifndef CC_USE_FREETYPE
+    #if CC_TARGET_PLATFORM == CC_PLATFORM_LINUX
+        #define CC_USE_FREETYPE 1
+    #else
+        #define CC_USE_FREETYPE 0
+    #endif
+#endif
+
 /** @def CC_SPRITE_DEBUG_DRAW
  If enabled, all subclasses of CCSprite will draw a bounding box
  Useful for debugging purposes only. It is recommended to leave it disabled.
@@ -266,4 +281,23 @@ To enable set it to a value different than 0. Disabled by default.
 #define CC_LUA_ENGINE_DEBUG 0
 #endif
 
+/** @def CC_LUA_PROFILER
+ If enabled, generated Lua bindings and script handler calls are instrumented, so CCLuaProfiler
+ can count calls and time of them after its counters are enabled. Sampling profiler of
+ CCLuaProfiler doesn't need it. Disabled by default because every bound call is checked.
+ */
+#ifndef CC_LUA_PROFILER
+#define CC_LUA_PROFILER 0
+#endif
+
+/** @def CC_LUA_FFI_VALUE_TYPES
+ If enabled, Lua bindings accept LuaJIT FFI cdata for CCPoint, CCSize, CCRect and colors, besides
+ tables. The cdata must be a struct value with same layout as native type, such as one created
+ by cc.fp, cc.fsize, cc.frect or cc.fc3b in script/cocos/valuetypes.lua. Layout is not checked, so it
+ is disabled by default.
+ */
+#ifndef CC_LUA_FFI_VALUE_TYPES
+#define CC_LUA_FFI_VALUE_TYPES 0
+#endif
+
 #endif // __CCCONFIG_H__
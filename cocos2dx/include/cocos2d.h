@@ -118,7 +118,12 @@ THE SOFTWARE.
 #include "label_nodes/CCLabelAtlas.h"
 #include "label_nodes/CCLabelTTF.h"
 #include "label_nodes/CCLabelBMFont.h"
+#include "label_nodes/CCBMFontBatchNode.h"
 #include "label_nodes/CCLabelTTFLinkStateSynchronizer.h"
+#include "label_nodes/CCGlyphAtlas.h"
+#include "label_nodes/CCAsyncTextRenderer.h"
+#include "label_nodes/CCTextLayoutCache.h"
+#include "label_nodes/CCTextLayout.h"
 
 // layers_scenes_transitions_nodes
 #include "layers_scenes_transitions_nodes/CCLayer.h"
@@ -0,0 +1,199 @@
+/****************************************************************************
+ Author: Luma (stubma@gmail.com)
+
+ https://github.com/stubma/cocos2dx-classical
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+#include "CCAsyncTextRenderer.h"
+#include "CCLabelTTF.h"
+#include "CCDirector.h"
+#include "CCScheduler.h"
+#include "platform/CCImage.h"
+#include "platform/CCThread.h"
+#include "textures/CCTexture2D.h"
+
+NS_CC_BEGIN
+
+static CCAsyncTextRenderer* s_sharedRenderer = NULL;
+
+CCAsyncTextRenderer::CCAsyncTextRenderer() :
+m_inFlight(0),
+m_threadStarted(false),
+m_quit(false) {
+    pthread_mutex_init(&m_mutex, NULL);
+    pthread_cond_init(&m_cond, NULL);
+}
+
+CCAsyncTextRenderer::~CCAsyncTextRenderer() {
+    // stop worker
+    if(m_threadStarted) {
+        pthread_mutex_lock(&m_mutex);
+        m_quit = true;
+        pthread_cond_signal(&m_cond);
+        pthread_mutex_unlock(&m_mutex);
+        pthread_join(m_thread, NULL);
+    }
+
+    // drop requests not dispatched
+    for(list<Request*>::iterator iter = m_pending.begin(); iter != m_pending.end(); iter++) {
+        releaseRequest(*iter);
+    }
+    for(vector<Request*>::iterator iter = m_done.begin(); iter != m_done.end(); iter++) {
+        releaseRequest(*iter);
+    }
+    if(m_inFlight > 0) {
+        CCDirector::sharedDirector()->getScheduler()->unscheduleSelector(schedule_selector(CCAsyncTextRenderer::dispatchResults), this);
+    }
+
+    pthread_cond_destroy(&m_cond);
+    pthread_mutex_destroy(&m_mutex);
+}
+
+CCAsyncTextRenderer* CCAsyncTextRenderer::sharedRenderer() {
+    if(!s_sharedRenderer) {
+        s_sharedRenderer = new CCAsyncTextRenderer();
+    }
+    return s_sharedRenderer;
+}
+
+void CCAsyncTextRenderer::purgeSharedRenderer() {
+    CC_SAFE_RELEASE_NULL(s_sharedRenderer);
+}
+
+void* CCAsyncTextRenderer::renderThread(void* arg) {
+    ((CCAsyncTextRenderer*)arg)->renderLoop();
+    return NULL;
+}
+
+void CCAsyncTextRenderer::renderLoop() {
+    pthread_mutex_lock(&m_mutex);
+    while(!m_quit) {
+        if(m_pending.empty()) {
+            pthread_cond_wait(&m_cond, &m_mutex);
+            continue;
+        }
+
+        // take request, label may queue a newer one while it is rendering
+        Request* r = m_pending.front();
+        m_pending.pop_front();
+        pthread_mutex_unlock(&m_mutex);
+
+        // autorelease pool for iOS, drained after every string
+        {
+            CCThread thread;
+            thread.createAutoreleasePool();
+            r->image = new CCImage();
+            if(!CCTexture2D::renderStringImage(r->image, r->text.c_str(), &r->fontDef)) {
+                CC_SAFE_RELEASE_NULL(r->image);
+            }
+        }
+
+        pthread_mutex_lock(&m_mutex);
+        m_done.push_back(r);
+    }
+    pthread_mutex_unlock(&m_mutex);
+}
+
+void CCAsyncTextRenderer::releaseRequest(Request* r) {
+    CC_SAFE_RELEASE(r->image);
+    CC_SAFE_RELEASE(r->label);
+    delete r;
+}
+
+void CCAsyncTextRenderer::render(CCLabelTTF* label, const string& text, const ccFontDefinition& fontDef, unsigned int serial) {
+    pthread_mutex_lock(&m_mutex);
+
+    // coalesce with pending request of same label
+    for(list<Request*>::iterator iter = m_pending.begin(); iter != m_pending.end(); iter++) {
+        Request* r = *iter;
+        if(r->label == label) {
+            r->text = text;
+            r->fontDef = fontDef;
+            r->serial = serial;
+            pthread_mutex_unlock(&m_mutex);
+            return;
+        }
+    }
+
+    // new request
+    Request* r = new Request();
+    r->label = label;
+    r->text = text;
+    r->fontDef = fontDef;
+    r->serial = serial;
+    r->image = NULL;
+    CC_SAFE_RETAIN(label);
+    m_pending.push_back(r);
+
+    // lazy start worker
+    if(!m_threadStarted) {
+        m_threadStarted = pthread_create(&m_thread, NULL, renderThread, this) == 0;
+    }
+    pthread_cond_signal(&m_cond);
+    pthread_mutex_unlock(&m_mutex);
+
+    // poll results while anything is in flight
+    if(m_inFlight++ == 0) {
+        CCDirector::sharedDirector()->getScheduler()->scheduleSelector(schedule_selector(CCAsyncTextRenderer::dispatchResults), this, 0, false);
+    }
+}
+
+void CCAsyncTextRenderer::cancel(CCLabelTTF* label) {
+    Request* r = NULL;
+    pthread_mutex_lock(&m_mutex);
+    for(list<Request*>::iterator iter = m_pending.begin(); iter != m_pending.end(); iter++) {
+        if((*iter)->label == label) {
+            r = *iter;
+            m_pending.erase(iter);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&m_mutex);
+
+    if(r) {
+        releaseRequest(r);
+        if(--m_inFlight == 0) {
+            CCDirector::sharedDirector()->getScheduler()->unscheduleSelector(schedule_selector(CCAsyncTextRenderer::dispatchResults), this);
+        }
+    }
+}
+
+void CCAsyncTextRenderer::dispatchResults(float delta) {
+    vector<Request*> done;
+    pthread_mutex_lock(&m_mutex);
+    done.swap(m_done);
+    pthread_mutex_unlock(&m_mutex);
+    if(done.empty())
+        return;
+
+    // label drops result if it is stale, failed one is delivered too so label stops waiting
+    for(vector<Request*>::iterator iter = done.begin(); iter != done.end(); iter++) {
+        Request* r = *iter;
+        r->label->onAsyncTextRendered(r->text, r->fontDef, r->image, r->serial);
+        releaseRequest(r);
+    }
+
+    m_inFlight -= (int)done.size();
+    if(m_inFlight == 0) {
+        CCDirector::sharedDirector()->getScheduler()->unscheduleSelector(schedule_selector(CCAsyncTextRenderer::dispatchResults), this);
+    }
+}
+
+NS_CC_END
@@ -0,0 +1,123 @@
+/****************************************************************************
+ Author: Luma (stubma@gmail.com)
+
+ https://github.com/stubma/cocos2dx-classical
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+#ifndef __CCAsyncTextRenderer__
+#define __CCAsyncTextRenderer__
+
+#include "cocoa/CCObject.h"
+#include "ccTypes.h"
+#include <string>
+#include <list>
+#include <vector>
+#include <pthread.h>
+
+using namespace std;
+
+NS_CC_BEGIN
+
+class CCImage;
+class CCLabelTTF;
+
+/**
+ * Renders strings of CCLabelTTF in a worker thread. Layout and rasterisation of a rich string are
+ * done in worker, only texture upload is done in GL thread, in the next frame after image is ready.
+ *
+ * \par
+ * A label has at most one pending request. If label requests again before worker starts rendering
+ * previous one, pending request is replaced so only latest string is rendered. If worker already
+ * started, result of older request is dropped when it arrives.
+ *
+ * \par
+ * Platform text renderers share one bitmap, so worker and GL thread never render strings at
+ * the same time, see CCTexture2D::renderStringImage.
+ */
+class CC_DLL CCAsyncTextRenderer : public CCObject {
+private:
+    /// a render request
+    struct Request {
+        CCLabelTTF* label;
+        string text;
+        ccFontDefinition fontDef;
+        unsigned int serial;
+        CCImage* image;
+    };
+
+    /// requests waiting for worker
+    list<Request*> m_pending;
+
+    /// rendered requests, waiting for GL thread
+    vector<Request*> m_done;
+
+    /// count of requests not dispatched yet
+    int m_inFlight;
+
+    /// worker
+    pthread_t m_thread;
+    pthread_mutex_t m_mutex;
+    pthread_cond_t m_cond;
+    bool m_threadStarted;
+    bool m_quit;
+
+protected:
+    CCAsyncTextRenderer();
+
+    /// worker entry
+    static void* renderThread(void* arg);
+
+    /// render requests until quit
+    void renderLoop();
+
+    /// dispatch rendered images to labels, scheduled while requests are in flight
+    void dispatchResults(float delta);
+
+    /// release label of a request and delete it
+    void releaseRequest(Request* r);
+
+public:
+    virtual ~CCAsyncTextRenderer();
+
+    /// get shared instance
+    static CCAsyncTextRenderer* sharedRenderer();
+
+    /// stop worker and drop all requests
+    static void purgeSharedRenderer();
+
+    /**
+     * queue a string to be rendered for a label. Label is retained until the result
+     * is dispatched or dropped. Must be called in GL thread
+     *
+     * @param label label which wants the texture
+     * @param text string to render
+     * @param fontDef text definition, adjusted for resolution
+     * @param serial serial of this request, result is dropped if label has a newer serial
+     *      when it arrives
+     */
+    void render(CCLabelTTF* label, const string& text, const ccFontDefinition& fontDef, unsigned int serial);
+
+    /// drop pending request of a label, the one being rendered will be dropped when it arrives
+    void cancel(CCLabelTTF* label);
+};
+
+NS_CC_END
+
+#endif /* defined(__CCAsyncTextRenderer__) */
@@ -0,0 +1,577 @@
+/****************************************************************************
+Copyright (c) 2010-2012 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+#include "CCBMFontBatchNode.h"
+#include "textures/CCTexture2D.h"
+#include "textures/CCTextureAtlas.h"
+#include "textures/CCTextureCache.h"
+#include "effects/CCGrid.h"
+#include "shaders/CCShaderCache.h"
+#include "shaders/CCGLProgram.h"
+#include "shaders/ccGLStateCache.h"
+#include "support/codec/ccUTF8.h"
+#include "label_nodes/CCTextLayoutCache.h"
+#include "label_nodes/CCTextLayout.h"
+#include "support/utils/TransformUtils.h"
+#include "cocoa/CCPointExtension.h"
+#include "kazmath/GL/matrix.h"
+#include "CCDirector.h"
+
+NS_CC_BEGIN
+
+// FNT configuration as font of text layout
+class CCBMFontLayoutFont : public CCTextLayoutFont
+{
+public:
+    CCBMFontLayoutFont(CCBMFontConfiguration *configuration) : m_pConfiguration(configuration) {}
+
+    virtual const void* getGlyph(unsigned short c)
+    {
+        const ccBMFontDef *def = m_pConfiguration->getFontDef(c);
+        if (!def)
+        {
+            CCLOGWARN("cocos2d::CCBMFontLabel: character not found %d", c);
+        }
+        return def;
+    }
+
+    virtual float getAdvance(const void *glyph)
+    {
+        return (float)((const ccBMFontDef*)glyph)->xAdvance;
+    }
+
+    virtual float getKerning(unsigned short left, unsigned short right)
+    {
+        return (float)m_pConfiguration->getKerningAmount(left, right);
+    }
+
+private:
+    CCBMFontConfiguration *m_pConfiguration;
+};
+
+// glyph quads of a laid out string, shared by labels through CCTextLayoutCache
+class CCBMFontLayout : public CCObject
+{
+public:
+    std::vector<ccV3F_C4B_T2F_Quad> m_tQuads;
+    CCSize m_tSize;
+};
+
+//
+// CCBMFontLabel
+//
+CCBMFontLabel::CCBMFontLabel()
+: m_pConfiguration(NULL)
+, m_pTexture(NULL)
+, m_fWidth(kCCLabelAutomaticWidth)
+, m_tAlignment(kCCTextAlignmentLeft)
+, m_pTextureAtlas(NULL)
+, m_bDirty(true)
+, m_bBatchVisible(false)
+{
+    m_tBlendFunc.src = CC_BLEND_SRC;
+    m_tBlendFunc.dst = CC_BLEND_DST;
+    m_tBatchTransform = CCAffineTransformMakeIdentity();
+}
+
+CCBMFontLabel::~CCBMFontLabel()
+{
+    CC_SAFE_RELEASE(m_pTextureAtlas);
+    CC_SAFE_RELEASE(m_pTexture);
+    CC_SAFE_RELEASE(m_pConfiguration);
+}
+
+CCBMFontLabel* CCBMFontLabel::create(const char *str, const char *fntFile, float width, CCTextAlignment alignment)
+{
+    CCBMFontLabel *pRet = new CCBMFontLabel();
+    if (pRet && pRet->initWithString(str, fntFile, width, alignment))
+    {
+        CC_SAFE_AUTORELEASE(pRet);
+        return pRet;
+    }
+    CC_SAFE_DELETE(pRet);
+    return NULL;
+}
+
+bool CCBMFontLabel::initWithString(const char *str, const char *fntFile, float width, CCTextAlignment alignment)
+{
+    CCAssert(fntFile && strlen(fntFile) > 0, "Invalid fnt file");
+
+    CCBMFontConfiguration *conf = FNTConfigLoadFile(fntFile);
+    if (!conf)
+    {
+        CCLOG("cocos2d: WARNING. CCBMFontLabel: Impossible to create font. Please check file: '%s'", fntFile);
+        return false;
+    }
+
+    CCTexture2D *texture = CCTextureCache::sharedTextureCache()->addImage(conf->getAtlasName());
+    if (!texture)
+    {
+        return false;
+    }
+
+    CC_SAFE_RETAIN(conf);
+    m_pConfiguration = conf;
+    CC_SAFE_RETAIN(texture);
+    m_pTexture = texture;
+    m_sFntFile = fntFile;
+    m_fWidth = width;
+    m_tAlignment = alignment;
+
+    if (!m_pTexture->hasPremultipliedAlpha())
+    {
+        m_tBlendFunc.src = GL_SRC_ALPHA;
+        m_tBlendFunc.dst = GL_ONE_MINUS_SRC_ALPHA;
+    }
+
+    setAnchorPoint(ccp(0.5f, 0.5f));
+    setCascadeColorEnabled(true);
+    setCascadeOpacityEnabled(true);
+    setShaderProgram(CCShaderCache::sharedShaderCache()->programForKey(kCCShader_PositionTextureColor));
+
+    m_sString = str ? str : "";
+    updateQuads();
+
+    return true;
+}
+
+void CCBMFontLabel::setString(const char *label)
+{
+    if (!label)
+    {
+        label = "";
+    }
+    if (m_sString.compare(label))
+    {
+        m_sString = label;
+        updateQuads();
+    }
+}
+
+const char* CCBMFontLabel::getString(void)
+{
+    return m_sString.c_str();
+}
+
+void CCBMFontLabel::setAlignment(CCTextAlignment alignment)
+{
+    if (m_tAlignment != alignment)
+    {
+        m_tAlignment = alignment;
+        updateQuads();
+    }
+}
+
+void CCBMFontLabel::setWidth(float width)
+{
+    if (m_fWidth != width)
+    {
+        m_fWidth = width;
+        updateQuads();
+    }
+}
+
+void CCBMFontLabel::setColor(const ccColor3B& color)
+{
+    CCNodeRGBA::setColor(color);
+    m_bDirty = true;
+}
+
+void CCBMFontLabel::setOpacity(GLubyte opacity)
+{
+    CCNodeRGBA::setOpacity(opacity);
+    m_bDirty = true;
+}
+
+void CCBMFontLabel::updateDisplayedColor(const ccColor3B& parentColor)
+{
+    CCNodeRGBA::updateDisplayedColor(parentColor);
+    m_bDirty = true;
+}
+
+void CCBMFontLabel::updateDisplayedOpacity(GLubyte parentOpacity)
+{
+    CCNodeRGBA::updateDisplayedOpacity(parentOpacity);
+    m_bDirty = true;
+}
+
+void CCBMFontLabel::updateQuads()
+{
+    m_tQuads.clear();
+    m_bDirty = true;
+
+    // same string in same font and box was laid out recently
+    char buf[64];
+    snprintf(buf, sizeof(buf), "|%.1f|%d|%.1f|", m_fWidth, (int)m_tAlignment, CC_CONTENT_SCALE_FACTOR());
+    std::string cacheKey = "bmf|" + m_sFntFile + buf + m_sString;
+    CCTextLayoutCache *cache = CCTextLayoutCache::sharedTextLayoutCache();
+    CCBMFontLayout *cached = (CCBMFontLayout*)cache->objectForKey(cacheKey);
+    if (cached)
+    {
+        m_tQuads = cached->m_tQuads;
+        setContentSize(cached->m_tSize);
+        return;
+    }
+
+    int stringLen = 0;
+    unsigned short *utf16 = cc_utf8_to_utf16(m_sString.c_str(), &stringLen);
+    if (!utf16 || stringLen == 0)
+    {
+        CC_SAFE_DELETE_ARRAY(utf16);
+        setContentSize(CCSizeZero);
+        return;
+    }
+
+    // layout in pixels, metrics of FNT file are integers
+    CCBMFontLayoutFont font(m_pConfiguration);
+    CCTextLayout textLayout;
+    int maxWidth = m_fWidth > 0 ? (int)(m_fWidth * CC_CONTENT_SCALE_FACTOR()) : 0;
+    textLayout.layout(&font, utf16, stringLen, (float)maxWidth, m_tAlignment);
+    CC_SAFE_DELETE_ARRAY(utf16);
+
+    int commonHeight = m_pConfiguration->m_nCommonHeight;
+    int width = (int)textLayout.m_width;
+    int height = commonHeight * textLayout.getLineCount();
+
+    float scale = CC_CONTENT_SCALE_FACTOR();
+    float atlasWidth = (float)m_pTexture->getPixelsWide();
+    float atlasHeight = (float)m_pTexture->getPixelsHigh();
+
+    m_tQuads.reserve(textLayout.m_glyphs.size());
+    for (std::vector<ccTextLayoutGlyph>::iterator it = textLayout.m_glyphs.begin(); it != textLayout.m_glyphs.end(); ++it)
+    {
+        const ccBMFontDef *def = (const ccBMFontDef*)it->glyph;
+        const CCRect &rect = def->rect;
+        if (rect.size.width <= 0 || rect.size.height <= 0)
+        {
+            continue;
+        }
+
+        // keep glyphs on whole pixels, centered lines may be shifted by half a pixel
+        float x = floorf(it->x) + def->xOffset;
+        float y = (float)(height - it->line * commonHeight - def->yOffset);
+
+        float left = x / scale;
+        float right = (x + rect.size.width) / scale;
+        float top = y / scale;
+        float bottom = (y - rect.size.height) / scale;
+        float u0 = rect.origin.x / atlasWidth;
+        float u1 = (rect.origin.x + rect.size.width) / atlasWidth;
+        float v0 = rect.origin.y / atlasHeight;
+        float v1 = (rect.origin.y + rect.size.height) / atlasHeight;
+
+        ccV3F_C4B_T2F_Quad quad;
+        quad.bl.vertices = vertex3(left, bottom, 0);
+        quad.bl.texCoords = tex2(u0, v1);
+        quad.br.vertices = vertex3(right, bottom, 0);
+        quad.br.texCoords = tex2(u1, v1);
+        quad.tl.vertices = vertex3(left, top, 0);
+        quad.tl.texCoords = tex2(u0, v0);
+        quad.tr.vertices = vertex3(right, top, 0);
+        quad.tr.texCoords = tex2(u1, v0);
+        m_tQuads.push_back(quad);
+    }
+
+    setContentSize(CC_SIZE_PIXELS_TO_POINTS(CCSizeMake(width, height)));
+
+    CCBMFontLayout *layout = new CCBMFontLayout();
+    layout->m_tQuads = m_tQuads;
+    layout->m_tSize = getContentSize();
+    cache->setObject(layout, cacheKey, (unsigned int)(m_tQuads.size() * sizeof(ccV3F_C4B_T2F_Quad) + cacheKey.size()));
+    layout->release();
+}
+
+void CCBMFontLabel::writeQuads(ccV3F_C4B_T2F_Quad *dst, const CCAffineTransform *t)
+{
+    ccColor4B color = ccc4(_displayedColor.r, _displayedColor.g, _displayedColor.b, _displayedOpacity);
+    if (m_pTexture->hasPremultipliedAlpha())
+    {
+        color.r = color.r * color.a / 255;
+        color.g = color.g * color.a / 255;
+        color.b = color.b * color.a / 255;
+    }
+
+    for (std::vector<ccV3F_C4B_T2F_Quad>::iterator it = m_tQuads.begin(); it != m_tQuads.end(); ++it, ++dst)
+    {
+        *dst = *it;
+        dst->bl.colors = dst->br.colors = dst->tl.colors = dst->tr.colors = color;
+        if (t)
+        {
+            ccVertex3F *vertices[] = { &dst->bl.vertices, &dst->br.vertices, &dst->tl.vertices, &dst->tr.vertices };
+            for (int i = 0; i < 4; i++)
+            {
+                CCPoint p = CCPointApplyAffineTransform(ccp(vertices[i]->x, vertices[i]->y), *t);
+                vertices[i]->x = p.x;
+                vertices[i]->y = p.y;
+            }
+        }
+    }
+
+    m_bDirty = false;
+}
+
+void CCBMFontLabel::draw()
+{
+    // nothing to draw for an empty string. A label in a batch node doesn't get here,
+    // batch node doesn't visit its children
+    if (m_tQuads.empty())
+    {
+        return;
+    }
+
+    if (!m_pTextureAtlas)
+    {
+        m_pTextureAtlas = new CCTextureAtlas();
+        m_pTextureAtlas->initWithTexture(m_pTexture, m_tQuads.size());
+    }
+
+    if (m_bDirty)
+    {
+        unsigned int count = getQuadCount();
+        if (count > m_pTextureAtlas->getCapacity())
+        {
+            m_pTextureAtlas->resizeCapacity(count);
+        }
+        m_pTextureAtlas->removeAllQuads();
+        m_pTextureAtlas->increaseTotalQuadsWith(count);
+        writeQuads(m_pTextureAtlas->getQuads(), NULL);
+        m_pTextureAtlas->setDirty(true);
+    }
+
+    CC_NODE_DRAW_SETUP(this);
+    ccGLBlendFunc(m_tBlendFunc.src, m_tBlendFunc.dst);
+    m_pTextureAtlas->drawQuads();
+}
+
+//
+// CCBMFontBatchNode
+//
+CCBMFontBatchNode::CCBMFontBatchNode()
+: m_pTextureAtlas(NULL)
+, m_bDirty(true)
+{
+    m_tBlendFunc.src = CC_BLEND_SRC;
+    m_tBlendFunc.dst = CC_BLEND_DST;
+}
+
+CCBMFontBatchNode::~CCBMFontBatchNode()
+{
+    CC_SAFE_RELEASE(m_pTextureAtlas);
+}
+
+CCBMFontBatchNode* CCBMFontBatchNode::create(const char *fntFile, unsigned int capacity)
+{
+    CCBMFontBatchNode *pRet = new CCBMFontBatchNode();
+    if (pRet && pRet->initWithFntFile(fntFile, capacity))
+    {
+        CC_SAFE_AUTORELEASE(pRet);
+        return pRet;
+    }
+    CC_SAFE_DELETE(pRet);
+    return NULL;
+}
+
+bool CCBMFontBatchNode::initWithFntFile(const char *fntFile, unsigned int capacity)
+{
+    CCBMFontConfiguration *conf = FNTConfigLoadFile(fntFile);
+    if (!conf)
+    {
+        CCLOG("cocos2d: WARNING. CCBMFontBatchNode: Impossible to create font. Please check file: '%s'", fntFile);
+        return false;
+    }
+
+    CCTexture2D *texture = CCTextureCache::sharedTextureCache()->addImage(conf->getAtlasName());
+    if (!texture)
+    {
+        return false;
+    }
+
+    m_sFntFile = fntFile;
+    m_pTextureAtlas = new CCTextureAtlas();
+    m_pTextureAtlas->initWithTexture(texture, MAX(capacity, 1));
+
+    if (!texture->hasPremultipliedAlpha())
+    {
+        m_tBlendFunc.src = GL_SRC_ALPHA;
+        m_tBlendFunc.dst = GL_ONE_MINUS_SRC_ALPHA;
+    }
+
+    setShaderProgram(CCShaderCache::sharedShaderCache()->programForKey(kCCShader_PositionTextureColor));
+
+    return true;
+}
+
+CCBMFontLabel* CCBMFontBatchNode::addLabel(const char *str, float width, CCTextAlignment alignment)
+{
+    CCBMFontLabel *label = CCBMFontLabel::create(str, m_sFntFile.c_str(), width, alignment);
+    if (label)
+    {
+        addChild(label);
+    }
+    return label;
+}
+
+void CCBMFontBatchNode::addChild(CCNode *child)
+{
+    CCNode::addChild(child);
+}
+
+void CCBMFontBatchNode::addChild(CCNode *child, int zOrder)
+{
+    CCNode::addChild(child, zOrder);
+}
+
+void CCBMFontBatchNode::addChild(CCNode *child, int zOrder, int tag)
+{
+    CCAssert(child != NULL, "child should not be null");
+    CCAssert(dynamic_cast<CCBMFontLabel*>(child) != NULL, "CCBMFontBatchNode only supports CCBMFontLabel as children");
+    CCAssert(((CCBMFontLabel*)child)->m_sFntFile == m_sFntFile, "CCBMFontLabel is not using the same fnt file as the batch node");
+
+    CCNode::addChild(child, zOrder, tag);
+    m_bDirty = true;
+}
+
+void CCBMFontBatchNode::reorderChild(CCNode *child, int zOrder)
+{
+    CCNode::reorderChild(child, zOrder);
+    m_bDirty = true;
+}
+
+void CCBMFontBatchNode::removeChild(CCNode *child, bool cleanup)
+{
+    CCNode::removeChild(child, cleanup);
+    m_bDirty = true;
+}
+
+void CCBMFontBatchNode::removeAllChildrenWithCleanup(bool cleanup)
+{
+    CCNode::removeAllChildrenWithCleanup(cleanup);
+    m_bDirty = true;
+}
+
+void CCBMFontBatchNode::visit(void)
+{
+    // CAREFUL:
+    // Like CCSpriteBatchNode, it doesn't call visit on its children,
+    // labels are drawn by draw() of the batch node
+    if (!m_bVisible)
+    {
+        return;
+    }
+
+    kmGLPushMatrix();
+
+    if (m_pGrid && m_pGrid->isActive())
+    {
+        m_pGrid->beforeDraw();
+        transformAncestors();
+    }
+
+    sortAllChildren();
+    transform();
+
+    draw();
+
+    if (m_pGrid && m_pGrid->isActive())
+    {
+        m_pGrid->afterDraw(this);
+    }
+
+    kmGLPopMatrix();
+    setOrderOfArrival(0);
+}
+
+void CCBMFontBatchNode::updateAtlas()
+{
+    bool dirty = m_bDirty;
+    unsigned int total = 0;
+
+    // find out whether any label changed since last frame
+    CCObject *pObject = NULL;
+    CCARRAY_FOREACH(m_pChildren, pObject)
+    {
+        CCBMFontLabel *label = (CCBMFontLabel*)pObject;
+        bool visible = label->isVisible();
+        if (visible != label->m_bBatchVisible)
+        {
+            dirty = true;
+        }
+        if (!visible)
+        {
+            continue;
+        }
+
+        CCAffineTransform t = label->nodeToParentTransform();
+        if (label->m_bDirty || !CCAffineTransformEqualToTransform(t, label->m_tBatchTransform))
+        {
+            dirty = true;
+        }
+        total += label->getQuadCount();
+    }
+
+    if (!dirty)
+    {
+        return;
+    }
+
+    if (total > m_pTextureAtlas->getCapacity())
+    {
+        m_pTextureAtlas->resizeCapacity(total * 4 / 3);
+    }
+    m_pTextureAtlas->removeAllQuads();
+    m_pTextureAtlas->increaseTotalQuadsWith(total);
+
+    ccV3F_C4B_T2F_Quad *quads = m_pTextureAtlas->getQuads();
+    CCARRAY_FOREACH(m_pChildren, pObject)
+    {
+        CCBMFontLabel *label = (CCBMFontLabel*)pObject;
+        label->m_bBatchVisible = label->isVisible();
+        if (!label->m_bBatchVisible)
+        {
+            continue;
+        }
+
+        label->m_tBatchTransform = label->nodeToParentTransform();
+        label->writeQuads(quads, &label->m_tBatchTransform);
+        quads += label->getQuadCount();
+    }
+
+    m_pTextureAtlas->setDirty(true);
+    m_bDirty = false;
+}
+
+void CCBMFontBatchNode::draw(void)
+{
+    updateAtlas();
+
+    if (m_pTextureAtlas->getTotalQuads() == 0)
+    {
+        return;
+    }
+
+    CC_NODE_DRAW_SETUP(this);
+    ccGLBlendFunc(m_tBlendFunc.src, m_tBlendFunc.dst);
+    m_pTextureAtlas->drawQuads();
+}
+
+NS_CC_END
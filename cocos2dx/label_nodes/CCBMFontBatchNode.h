@@ -0,0 +1,185 @@
+/****************************************************************************
+Copyright (c) 2010-2012 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+#ifndef __CCBMFONT_BATCH_NODE_H__
+#define __CCBMFONT_BATCH_NODE_H__
+
+#include "base_nodes/CCNode.h"
+#include "CCProtocols.h"
+#include "label_nodes/CCLabelBMFont.h"
+#include <string>
+#include <vector>
+
+NS_CC_BEGIN
+
+class CCTexture2D;
+class CCTextureAtlas;
+
+/**
+ * @addtogroup GUI
+ * @{
+ * @addtogroup label
+ * @{
+ */
+
+/** @brief CCBMFontLabel is a lightweight bitmap font label.
+
+It doesn't create a CCSprite for every character like CCLabelBMFont does. When the string changes,
+glyph quads are laid out once in label space, so changing a label costs a quad rebuild only.
+
+If the label is a child of a CCBMFontBatchNode, its quads are drawn by the batch node in the same
+draw call as all other labels of that node. Otherwise the label draws itself with one draw call.
+
+Limitations:
+- characters can't be moved, scaled or tinted one by one, use CCLabelBMFont for that
+- a label in a batch node can't have children, they are not visited
+@js NA
+@lua NA
+*/
+class CC_DLL CCBMFontLabel : public CCNodeRGBA, public CCLabelProtocol
+{
+    friend class CCBMFontBatchNode;
+public:
+    CCBMFontLabel();
+    virtual ~CCBMFontLabel();
+
+    /** creates a label with an initial string and the FNT file */
+    static CCBMFontLabel* create(const char *str, const char *fntFile, float width = kCCLabelAutomaticWidth, CCTextAlignment alignment = kCCTextAlignmentLeft);
+
+    /** init a label with an initial string and the FNT file */
+    bool initWithString(const char *str, const char *fntFile, float width = kCCLabelAutomaticWidth, CCTextAlignment alignment = kCCTextAlignmentLeft);
+
+    // CCLabelProtocol
+    virtual void setString(const char *label);
+    virtual const char* getString(void);
+
+    virtual void setAlignment(CCTextAlignment alignment);
+    virtual void setWidth(float width);
+
+    const char* getFntFile() { return m_sFntFile.c_str(); }
+    CCBMFontConfiguration* getConfiguration() const { return m_pConfiguration; }
+    CCTexture2D* getTexture() const { return m_pTexture; }
+
+    // CCRGBAProtocol, color is applied when quads are written
+    virtual void setColor(const ccColor3B& color);
+    virtual void setOpacity(GLubyte opacity);
+    virtual void updateDisplayedColor(const ccColor3B& parentColor);
+    virtual void updateDisplayedOpacity(GLubyte parentOpacity);
+
+    virtual void draw();
+
+protected:
+    /** lays out glyph quads in label space */
+    void updateQuads();
+
+    /** writes quads with current color, transformed by t if it is not NULL */
+    void writeQuads(ccV3F_C4B_T2F_Quad *dst, const CCAffineTransform *t);
+
+    /** number of quads to draw */
+    unsigned int getQuadCount() { return (unsigned int)m_tQuads.size(); }
+
+protected:
+    std::string m_sString;
+    std::string m_sFntFile;
+    CCBMFontConfiguration *m_pConfiguration;
+    CCTexture2D *m_pTexture;
+    ccBlendFunc m_tBlendFunc;
+
+    // max width until a line break is added, in points
+    float m_fWidth;
+    CCTextAlignment m_tAlignment;
+
+    // glyph quads in label space, colors are written later
+    std::vector<ccV3F_C4B_T2F_Quad> m_tQuads;
+
+    // quads when label draws itself
+    CCTextureAtlas *m_pTextureAtlas;
+
+    // quads or color changed since they were written
+    bool m_bDirty;
+
+    // state of last write by batch node
+    CCAffineTransform m_tBatchTransform;
+    bool m_bBatchVisible;
+};
+
+/** @brief CCBMFontBatchNode draws all of its CCBMFontLabel children with one draw call.
+
+All children must be CCBMFontLabel which use the same FNT file as the batch node. Labels are drawn
+in the order of their z order. The shared quad buffer is only rewritten when a label changes its
+string, color, transform or visibility, so static HUD text costs a single draw call per frame.
+@js NA
+@lua NA
+*/
+class CC_DLL CCBMFontBatchNode : public CCNode, public CCBlendProtocol
+{
+public:
+    CCBMFontBatchNode();
+    virtual ~CCBMFontBatchNode();
+
+    /** creates a batch node for a FNT file with an initial capacity of glyph quads */
+    static CCBMFontBatchNode* create(const char *fntFile, unsigned int capacity = 256);
+
+    /** init a batch node for a FNT file with an initial capacity of glyph quads */
+    bool initWithFntFile(const char *fntFile, unsigned int capacity);
+
+    /** creates a label with the FNT file of this batch node and adds it */
+    CCBMFontLabel* addLabel(const char *str, float width = kCCLabelAutomaticWidth, CCTextAlignment alignment = kCCTextAlignmentLeft);
+
+    const char* getFntFile() { return m_sFntFile.c_str(); }
+    CCTextureAtlas* getTextureAtlas() { return m_pTextureAtlas; }
+
+    // CCNode
+    virtual void addChild(CCNode *child);
+    virtual void addChild(CCNode *child, int zOrder);
+    virtual void addChild(CCNode *child, int zOrder, int tag);
+    virtual void reorderChild(CCNode *child, int zOrder);
+    virtual void removeChild(CCNode *child, bool cleanup);
+    virtual void removeAllChildrenWithCleanup(bool cleanup);
+    virtual void visit(void);
+    virtual void draw(void);
+
+    // CCBlendProtocol
+    virtual void setBlendFunc(ccBlendFunc blendFunc) { m_tBlendFunc = blendFunc; }
+    virtual ccBlendFunc getBlendFunc(void) { return m_tBlendFunc; }
+
+protected:
+    /** rewrites shared quad buffer if any label changed */
+    void updateAtlas();
+
+protected:
+    std::string m_sFntFile;
+    CCTextureAtlas *m_pTextureAtlas;
+    ccBlendFunc m_tBlendFunc;
+
+    // labels were added, removed or reordered
+    bool m_bDirty;
+};
+
+// end of GUI group
+/// @}
+/// @}
+
+NS_CC_END
+
+#endif //__CCBMFONT_BATCH_NODE_H__
@@ -0,0 +1,370 @@
+/****************************************************************************
+ Author: Luma (stubma@gmail.com)
+
+ https://github.com/stubma/cocos2dx-classical
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+#include "CCGlyphAtlas.h"
+#include "textures/CCTexture2D.h"
+#include "textures/CCTextureCache.h"
+#include "shaders/ccGLStateCache.h"
+#include "platform/CCFileUtils.h"
+#include "platform/CCImage.h"
+#include "support/codec/ccUTF8.h"
+#include "cocoa/CCString.h"
+#include "CCGL.h"
+
+#if CC_USE_FREETYPE
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#endif
+
+NS_CC_BEGIN
+
+// gap between glyphs in page, so linear filter doesn't sample neighbours
+#define GLYPH_PADDING 2
+
+#if CC_USE_FREETYPE
+static FT_Library s_ftLibrary = NULL;
+#endif
+
+static CCGlyphAtlasCache* s_sharedGlyphAtlasCache = NULL;
+
+//
+// CCGlyphAtlas
+//
+CCGlyphAtlas::CCGlyphAtlas() :
+m_fontSize(0),
+m_packX(0),
+m_packY(0),
+m_shelfHeight(0),
+m_lineHeight(0),
+m_ascender(0),
+m_face(NULL),
+m_fontData(NULL) {
+}
+
+CCGlyphAtlas::~CCGlyphAtlas() {
+    // page textures hold pixel pointer for context restore, release them before pixels
+    for(vector<CCTexture2D*>::iterator iter = m_pages.begin(); iter != m_pages.end(); iter++) {
+        CC_SAFE_RELEASE(*iter);
+    }
+    for(vector<unsigned char*>::iterator iter = m_pageData.begin(); iter != m_pageData.end(); iter++) {
+        CC_SAFE_FREE(*iter);
+    }
+
+#if CC_USE_FREETYPE
+    if(m_face) {
+        FT_Done_Face((FT_Face)m_face);
+    }
+#endif
+    CC_SAFE_DELETE_ARRAY(m_fontData);
+}
+
+CCGlyphAtlas* CCGlyphAtlas::create(const char* fontName, int fontSize) {
+    CCGlyphAtlas* a = new CCGlyphAtlas();
+    if(a->initWithFont(fontName, fontSize)) {
+        CC_SAFE_AUTORELEASE(a);
+        return a;
+    }
+    CC_SAFE_RELEASE(a);
+    return NULL;
+}
+
+bool CCGlyphAtlas::initWithFont(const char* fontName, int fontSize) {
+    if(!fontName || fontSize <= 0)
+        return false;
+
+    m_fontName = fontName;
+    m_fontSize = fontSize;
+
+#if CC_USE_FREETYPE
+    if(!s_ftLibrary && FT_Init_FreeType(&s_ftLibrary)) {
+        CCLOGERROR("CCGlyphAtlas: failed to init FreeType");
+        s_ftLibrary = NULL;
+        return false;
+    }
+
+    // face reads font data in place, so keep it while face is alive
+    unsigned long size = 0;
+    string path = CCFileUtils::sharedFileUtils()->fullPathForFilename(fontName);
+    m_fontData = CCFileUtils::sharedFileUtils()->getFileData(path.c_str(), "rb", &size);
+    if(!m_fontData) {
+        CCLOGERROR("CCGlyphAtlas: font file %s not found", fontName);
+        return false;
+    }
+
+    FT_Face face = NULL;
+    if(FT_New_Memory_Face(s_ftLibrary, m_fontData, size, 0, &face)) {
+        CCLOGERROR("CCGlyphAtlas: %s is not a valid font", fontName);
+        return false;
+    }
+    m_face = face;
+
+    if(FT_Select_Charmap(face, FT_ENCODING_UNICODE) || FT_Set_Pixel_Sizes(face, 0, fontSize)) {
+        CCLOGERROR("CCGlyphAtlas: %s doesn't support unicode or size %d", fontName, fontSize);
+        return false;
+    }
+
+    // metrics are 26.6 fixed point
+    m_ascender = face->size->metrics.ascender >> 6;
+    m_lineHeight = face->size->metrics.height >> 6;
+#else
+    // platform renderer draws glyph in a full line box, so line height is height of any glyph
+    const ccGlyphDef* def = getGlyph('A');
+    if(!def) {
+        CCLOGERROR("CCGlyphAtlas: failed to render font %s", fontName);
+        return false;
+    }
+    m_lineHeight = def->rect.size.height;
+    m_ascender = 0;
+#endif
+
+    return true;
+}
+
+void CCGlyphAtlas::addPage() {
+    int bytes = CC_GLYPH_ATLAS_PAGE_SIZE * CC_GLYPH_ATLAS_PAGE_SIZE;
+    unsigned char* data = (unsigned char*)calloc(bytes, sizeof(unsigned char));
+
+    CCTexture2D* tex = new CCTexture2D();
+    tex->initWithData(data,
+                      kCCTexture2DPixelFormat_A8,
+                      CC_GLYPH_ATLAS_PAGE_SIZE,
+                      CC_GLYPH_ATLAS_PAGE_SIZE,
+                      CCSizeMake(CC_GLYPH_ATLAS_PAGE_SIZE, CC_GLYPH_ATLAS_PAGE_SIZE));
+
+#if CC_ENABLE_CACHE_TEXTURE_DATA
+    // pixels are updated in place when glyphs are added, so restored page is always complete
+    VolatileTexture::addDataTexture(tex, data, kCCTexture2DPixelFormat_A8,
+                                    CCSizeMake(CC_GLYPH_ATLAS_PAGE_SIZE, CC_GLYPH_ATLAS_PAGE_SIZE));
+#endif
+
+    m_pages.push_back(tex);
+    m_pageData.push_back(data);
+    m_packX = 0;
+    m_packY = 0;
+    m_shelfHeight = 0;
+}
+
+bool CCGlyphAtlas::pack(int width, int height, ccGlyphDef* def) {
+    int w = width + GLYPH_PADDING;
+    int h = height + GLYPH_PADDING;
+    if(w > CC_GLYPH_ATLAS_PAGE_SIZE || h > CC_GLYPH_ATLAS_PAGE_SIZE) {
+        CCLOGERROR("CCGlyphAtlas: glyph of %s is too big for atlas page", m_fontName.c_str());
+        return false;
+    }
+
+    // glyphs of a font have similar height, so shelves waste little space
+    if(m_pages.empty()) {
+        addPage();
+    }
+    if(m_packX + w > CC_GLYPH_ATLAS_PAGE_SIZE) {
+        m_packX = 0;
+        m_packY += m_shelfHeight;
+        m_shelfHeight = 0;
+    }
+    if(m_packY + h > CC_GLYPH_ATLAS_PAGE_SIZE) {
+        addPage();
+    }
+
+    def->page = (int)m_pages.size() - 1;
+    def->rect = CCRectMake(m_packX, m_packY, width, height);
+    m_packX += w;
+    m_shelfHeight = MAX(m_shelfHeight, h);
+    return true;
+}
+
+bool CCGlyphAtlas::rasterize(unsigned short c, unsigned char** bitmap, int* width, int* height, ccGlyphDef* def) {
+#if CC_USE_FREETYPE
+    FT_Face face = (FT_Face)m_face;
+    if(FT_Load_Char(face, c, FT_LOAD_RENDER)) {
+        return false;
+    }
+
+    FT_GlyphSlot slot = face->glyph;
+    FT_Bitmap& bmp = slot->bitmap;
+    *width = bmp.width;
+    *height = bmp.rows;
+    *bitmap = NULL;
+    if(bmp.width > 0 && bmp.rows > 0) {
+        // rows may be padded, copy them to a tight buffer
+        *bitmap = new unsigned char[bmp.width * bmp.rows];
+        for(int y = 0; y < (int)bmp.rows; y++) {
+            memcpy(*bitmap + y * bmp.width, bmp.buffer + y * bmp.pitch, bmp.width);
+        }
+    }
+    def->bearingX = slot->bitmap_left;
+    def->bearingY = m_ascender - slot->bitmap_top;
+    def->advance = slot->advance.x >> 6;
+    return true;
+#else
+    // a single char string, rich text tag chars must be escaped
+    unsigned short utf16[] = { c, 0 };
+    char* utf8 = cc_utf16_to_utf8(utf16);
+    if(!utf8)
+        return false;
+    string text = utf8;
+    CC_SAFE_DELETE_ARRAY(utf8);
+    if(c == '[' || c == '\\') {
+        text.insert(0, "\\");
+    }
+
+    CCImage* image = new CCImage();
+#if CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID || CC_TARGET_PLATFORM == CC_PLATFORM_IOS
+    // go through shared text renderer lock, async labels may be rendering
+    ccFontDefinition fontDef;
+    fontDef.m_fontName = m_fontName;
+    fontDef.m_fontSize = m_fontSize;
+    fontDef.m_alignment = kCCTextAlignmentLeft;
+    fontDef.m_vertAlignment = kCCVerticalTextAlignmentCenter;
+    fontDef.m_fontFillColor = ccWHITE;
+    fontDef.m_toCharIndex = -1;
+    bool ok = CCTexture2D::renderStringImage(image, text.c_str(), &fontDef);
+#else
+    bool ok = image->initWithString(text.c_str(), 0, 0, CCImage::kAlignLeft, m_fontName.c_str(), m_fontSize);
+#endif
+    if(ok) {
+        // coverage is alpha channel, or red channel if image is opaque
+        int w = image->getWidth();
+        int h = image->getHeight();
+        int bpp = image->hasAlpha() ? 4 : 3;
+        int channel = image->hasAlpha() ? 3 : 0;
+        unsigned char* src = image->getData();
+        *width = w;
+        *height = h;
+        *bitmap = new unsigned char[w * h];
+        for(int i = 0; i < w * h; i++) {
+            (*bitmap)[i] = src[i * bpp + channel];
+        }
+        def->bearingX = 0;
+        def->bearingY = 0;
+        def->advance = w;
+    }
+    CC_SAFE_RELEASE(image);
+    return ok;
+#endif
+}
+
+const ccGlyphDef* CCGlyphAtlas::getGlyph(unsigned short c) {
+    map<unsigned short, ccGlyphDef>::iterator iter = m_glyphs.find(c);
+    if(iter != m_glyphs.end())
+        return &iter->second;
+
+    ccGlyphDef def = ccGlyphDef();
+    unsigned char* bitmap = NULL;
+    int width = 0, height = 0;
+    if(!rasterize(c, &bitmap, &width, &height, &def)) {
+        return NULL;
+    }
+
+    // blank glyph, such as space, only has advance
+    if(bitmap) {
+        if(!pack(width, height, &def)) {
+            CC_SAFE_DELETE_ARRAY(bitmap);
+            return NULL;
+        }
+
+        // copy to page pixels
+        unsigned char* page = m_pageData[def.page];
+        int x = (int)def.rect.origin.x;
+        int y = (int)def.rect.origin.y;
+        for(int row = 0; row < height; row++) {
+            memcpy(page + (y + row) * CC_GLYPH_ATLAS_PAGE_SIZE + x, bitmap + row * width, width);
+        }
+
+        // upload only glyph rect
+        ccGLBindTexture2D(m_pages[def.page]->getName());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_ALPHA, GL_UNSIGNED_BYTE, bitmap);
+        CC_SAFE_DELETE_ARRAY(bitmap);
+    }
+
+    return &(m_glyphs[c] = def);
+}
+
+float CCGlyphAtlas::getKerning(unsigned short left, unsigned short right) {
+#if CC_USE_FREETYPE
+    FT_Face face = (FT_Face)m_face;
+    if(!FT_HAS_KERNING(face))
+        return 0;
+
+    FT_Vector delta;
+    if(FT_Get_Kerning(face, FT_Get_Char_Index(face, left), FT_Get_Char_Index(face, right), FT_KERNING_DEFAULT, &delta))
+        return 0;
+    return delta.x >> 6;
+#else
+    return 0;
+#endif
+}
+
+//
+// CCGlyphAtlasCache
+//
+CCGlyphAtlasCache::CCGlyphAtlasCache() {
+}
+
+CCGlyphAtlasCache::~CCGlyphAtlasCache() {
+}
+
+CCGlyphAtlasCache* CCGlyphAtlasCache::sharedGlyphAtlasCache() {
+    if(!s_sharedGlyphAtlasCache) {
+        s_sharedGlyphAtlasCache = new CCGlyphAtlasCache();
+    }
+    return s_sharedGlyphAtlasCache;
+}
+
+void CCGlyphAtlasCache::purgeSharedGlyphAtlasCache() {
+    CC_SAFE_RELEASE_NULL(s_sharedGlyphAtlasCache);
+}
+
+CCGlyphAtlas* CCGlyphAtlasCache::atlasForFont(const char* fontName, int fontSize) {
+    string key = CCString::createWithFormat("%s@%d", fontName, fontSize)->getCString();
+    CCGlyphAtlas* atlas = (CCGlyphAtlas*)m_atlases.objectForKey(key);
+    if(!atlas) {
+        atlas = CCGlyphAtlas::create(fontName, fontSize);
+        if(atlas) {
+            m_atlases.setObject(atlas, key);
+        }
+    }
+    return atlas;
+}
+
+void CCGlyphAtlasCache::removeUnusedAtlases() {
+    // collect keys first, labels hold a reference of atlas they are using
+    vector<string> unused;
+    CCDictionary* atlases = &m_atlases;
+    CCDictElement* pElement = NULL;
+    CCDICT_FOREACH(atlases, pElement) {
+        CCGlyphAtlas* atlas = (CCGlyphAtlas*)pElement->getObject();
+        if(atlas->retainCount() == 1) {
+            unused.push_back(pElement->getStrKey());
+        }
+    }
+    for(vector<string>::iterator iter = unused.begin(); iter != unused.end(); iter++) {
+        m_atlases.removeObjectForKey(*iter);
+    }
+}
+
+void CCGlyphAtlasCache::removeAllAtlases() {
+    m_atlases.removeAllObjects();
+}
+
+NS_CC_END
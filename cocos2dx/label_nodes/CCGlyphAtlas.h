@@ -0,0 +1,200 @@
+/****************************************************************************
+ Author: Luma (stubma@gmail.com)
+
+ https://github.com/stubma/cocos2dx-classical
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+#ifndef __CCGlyphAtlas__
+#define __CCGlyphAtlas__
+
+#include "cocoa/CCObject.h"
+#include "cocoa/CCGeometry.h"
+#include "cocoa/CCDictionary.h"
+#include "ccConfig.h"
+#include <string>
+#include <vector>
+#include <map>
+
+using namespace std;
+
+NS_CC_BEGIN
+
+class CCTexture2D;
+
+/// size of a glyph atlas page texture, in pixels
+#define CC_GLYPH_ATLAS_PAGE_SIZE 512
+
+/// location and metrics of a rasterised glyph, all in pixels
+typedef struct _ccGlyphDef {
+    /// index of page texture which holds glyph bitmap
+    int page;
+
+    /// glyph bitmap rect in page texture, origin is top left. It is empty for blank glyph
+    CCRect rect;
+
+    /// horizontal offset of bitmap from pen position
+    float bearingX;
+
+    /// vertical offset of bitmap from line top, positive is downward
+    float bearingY;
+
+    /// pen advance after this glyph
+    float advance;
+} ccGlyphDef;
+
+/**
+ * A dynamic glyph atlas of one font in one pixel size. Glyphs are rasterised when they are
+ * requested for the first time, packed into shared A8 page textures and reused by every
+ * label which uses same font and size.
+ *
+ * \par
+ * If CC_USE_FREETYPE is enabled, font name is the path of a TTF file and glyphs are rendered
+ * by FreeType. Otherwise every glyph is rendered by platform text renderer and there is no
+ * kerning.
+ *
+ * \par
+ * Page pixels are also kept in memory so that page textures can be restored after
+ * OpenGL context is lost.
+ */
+class CC_DLL CCGlyphAtlas : public CCObject {
+private:
+    /// font name or font file path
+    string m_fontName;
+
+    /// font size in pixels
+    int m_fontSize;
+
+    /// page textures
+    vector<CCTexture2D*> m_pages;
+
+    /// pixels of pages, A8
+    vector<unsigned char*> m_pageData;
+
+    /// rasterised glyphs
+    map<unsigned short, ccGlyphDef> m_glyphs;
+
+    /// pen of shelf packer in last page
+    int m_packX;
+    int m_packY;
+    int m_shelfHeight;
+
+    /// line metrics
+    float m_lineHeight;
+    float m_ascender;
+
+    /// FreeType face and font file data
+    void* m_face;
+    unsigned char* m_fontData;
+
+protected:
+    CCGlyphAtlas();
+
+    /// load font, return false if font can't be used
+    bool initWithFont(const char* fontName, int fontSize);
+
+    /// rasterise a glyph, bitmap is A8 and returned with new[]
+    bool rasterize(unsigned short c, unsigned char** bitmap, int* width, int* height, ccGlyphDef* def);
+
+    /// find room for a bitmap, add a page if current one is full
+    bool pack(int width, int height, ccGlyphDef* def);
+
+    /// add a new empty page
+    void addPage();
+
+public:
+    virtual ~CCGlyphAtlas();
+
+    /**
+     * create a glyph atlas
+     *
+     * @param fontName font name, or TTF file path if CC_USE_FREETYPE is enabled
+     * @param fontSize font size in pixels
+     * @return glyph atlas, or NULL if font can't be loaded
+     */
+    static CCGlyphAtlas* create(const char* fontName, int fontSize);
+
+    /**
+     * get a glyph, rasterise it if it is not in atlas yet. Page textures are
+     * updated in place so it must be called in GL thread
+     *
+     * @param c unicode of glyph
+     * @return glyph def, or NULL if glyph can't be rasterised. The pointer is valid
+     *      while atlas is alive
+     */
+    const ccGlyphDef* getGlyph(unsigned short c);
+
+    /// kerning between two glyphs, in pixels
+    float getKerning(unsigned short left, unsigned short right);
+
+    /// get page texture
+    CCTexture2D* getPage(int index) { return m_pages.at(index); }
+
+    /// page count
+    int getPageCount() { return (int)m_pages.size(); }
+
+    /// height of a text line, in pixels
+    float getLineHeight() { return m_lineHeight; }
+
+    /// font name of atlas
+    const string& getFontName() { return m_fontName; }
+
+    /// font size of atlas, in pixels
+    int getFontSize() { return m_fontSize; }
+};
+
+/**
+ * Shared glyph atlases, keyed by font name and pixel size
+ */
+class CC_DLL CCGlyphAtlasCache : public CCObject {
+private:
+    /// atlases
+    CCDictionary m_atlases;
+
+protected:
+    CCGlyphAtlasCache();
+
+public:
+    virtual ~CCGlyphAtlasCache();
+
+    /// get shared instance
+    static CCGlyphAtlasCache* sharedGlyphAtlasCache();
+
+    /// release shared instance
+    static void purgeSharedGlyphAtlasCache();
+
+    /**
+     * get atlas of a font and size, create it if not existent
+     *
+     * @param fontName font name, or TTF file path if CC_USE_FREETYPE is enabled
+     * @param fontSize font size in pixels
+     * @return glyph atlas, or NULL if font can't be loaded
+     */
+    CCGlyphAtlas* atlasForFont(const char* fontName, int fontSize);
+
+    /// remove atlases which are not used by any label
+    void removeUnusedAtlases();
+
+    /// remove all atlases, labels still hold atlas they are using
+    void removeAllAtlases();
+};
+
+NS_CC_END
+
+#endif /* defined(__CCGlyphAtlas__) */
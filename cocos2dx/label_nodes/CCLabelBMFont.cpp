@@ -42,6 +42,7 @@ http://www.angelcode.com/products/bmfont/ (Free, Windows only)
 #include "CCDirector.h"
 #include "textures/CCTextureCache.h"
 #include "support/codec/ccUTF8.h"
+#include <algorithm>
 
 using namespace std;
 
@@ -95,10 +96,65 @@ void FNTConfigRemoveCache( void )
     }
 }
 
+void FNTConfigRemoveUnusedCache( void )
+{
+    if (!s_pConfigurations)
+    {
+        return;
+    }
+
+    // configurations used by labels are kept, so they are not parsed again
+    std::vector<std::string> unused;
+    CCDictElement* pElement = NULL;
+    CCDICT_FOREACH(s_pConfigurations, pElement)
+    {
+        if (pElement->getObject()->retainCount() == 1)
+        {
+            unused.push_back(pElement->getStrKey());
+        }
+    }
+    for (std::vector<std::string>::iterator it = unused.begin(); it != unused.end(); ++it)
+    {
+        s_pConfigurations->removeObjectForKey(*it);
+    }
+}
+
 //
 //BitmapFontConfiguration
 //
 
+// empty slot of kerning table
+#define KERNING_EMPTY_KEY 0xffffffff
+
+// dense range of glyph table is used when it has at least one glyph per this many entries
+#define DENSE_RANGE_FACTOR 8
+
+static inline unsigned int kerningHash(unsigned int key, unsigned int mask)
+{
+    return (key * 2654435761u) & mask;
+}
+
+static inline bool glyphLessThan(const ccBMFontDef& a, const ccBMFontDef& b)
+{
+    return a.charID < b.charID;
+}
+
+// little endian readers of binary fnt, data may be unaligned
+static inline unsigned int readU32(const unsigned char* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+static inline unsigned short readU16(const unsigned char* p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static inline short readS16(const unsigned char* p)
+{
+    return (short)readU16(p);
+}
+
 CCBMFontConfiguration * CCBMFontConfiguration::create(const char *FNTfile)
 {
     CCBMFontConfiguration * pRet = new CCBMFontConfiguration();
@@ -113,151 +169,354 @@ CCBMFontConfiguration * CCBMFontConfiguration::create(const char *FNTfile)
 
 bool CCBMFontConfiguration::initWithFNTfile(const char *FNTfile)
 {
-    m_pKerningDictionary = NULL;
-    m_pFontDefDictionary = NULL;
-    
-    m_pCharacterSet = this->parseConfigFile(FNTfile);
-    
-    if (! m_pCharacterSet)
-    {
-        return false;
-    }
+    m_tFontDefs.clear();
+    m_tKernings.clear();
+    m_tDenseIndex.clear();
+    CC_SAFE_DELETE(m_pCharacterSet);
 
-    return true;
+    return this->parseConfigFile(FNTfile);
 }
 
 std::set<unsigned int>* CCBMFontConfiguration::getCharacterSet() const
 {
+    if (!m_pCharacterSet)
+    {
+        m_pCharacterSet = new std::set<unsigned int>();
+        for (std::vector<ccBMFontDef>::const_iterator it = m_tFontDefs.begin(); it != m_tFontDefs.end(); ++it)
+        {
+            m_pCharacterSet->insert(it->charID);
+        }
+    }
     return m_pCharacterSet;
 }
 
 CCBMFontConfiguration::CCBMFontConfiguration()
-: m_pFontDefDictionary(NULL)
-, m_nCommonHeight(0)
-, m_pKerningDictionary(NULL)
+: m_nCommonHeight(0)
 , m_pCharacterSet(NULL)
+, m_uDenseBase(0)
 {
-
+    memset(&m_tPadding, 0, sizeof(m_tPadding));
 }
 
 CCBMFontConfiguration::~CCBMFontConfiguration()
 {
     CCLOGINFO( "cocos2d: deallocing CCBMFontConfiguration" );
-    this->purgeFontDefDictionary();
-    this->purgeKerningDictionary();
     m_sAtlasName.clear();
     CC_SAFE_DELETE(m_pCharacterSet);
 }
 
 const char* CCBMFontConfiguration::description(void)
 {
+    unsigned int kernings = 0;
+    for (std::vector<ccBMFontKerning>::iterator it = m_tKernings.begin(); it != m_tKernings.end(); ++it)
+    {
+        if (it->key != KERNING_EMPTY_KEY)
+        {
+            kernings++;
+        }
+    }
+
     return CCString::createWithFormat(
         "<CCBMFontConfiguration = " CC_FORMAT_PRINTF_SIZE_T " | Glphys:%d Kernings:%d | Image = %s>",
         (size_t)this,
-        HASH_COUNT(m_pFontDefDictionary),
-        HASH_COUNT(m_pKerningDictionary),
+        (int)m_tFontDefs.size(),
+        (int)kernings,
         m_sAtlasName.c_str()
     )->getCString();
 }
 
-void CCBMFontConfiguration::purgeKerningDictionary()
+const ccBMFontDef* CCBMFontConfiguration::getFontDef(unsigned int charID) const
 {
-    tCCKerningHashElement *current;
-    while(m_pKerningDictionary) 
+    // dense range, index lookup
+    unsigned int dense = charID - m_uDenseBase;
+    if (dense < m_tDenseIndex.size())
     {
-        current = m_pKerningDictionary; 
-        HASH_DEL(m_pKerningDictionary,current);
-        free(current);
+        int index = m_tDenseIndex[dense];
+        return index < 0 ? NULL : &m_tFontDefs[index];
     }
+
+    // sparse fallback
+    ccBMFontDef key;
+    key.charID = charID;
+    std::vector<ccBMFontDef>::const_iterator it = std::lower_bound(m_tFontDefs.begin(), m_tFontDefs.end(), key, glyphLessThan);
+    return (it != m_tFontDefs.end() && it->charID == charID) ? &(*it) : NULL;
 }
 
-void CCBMFontConfiguration::purgeFontDefDictionary()
-{    
-    tCCFontDefHashElement *current, *tmp;
+int CCBMFontConfiguration::getKerningAmount(unsigned short first, unsigned short second) const
+{
+    if (m_tKernings.empty())
+    {
+        return 0;
+    }
+
+    unsigned int key = (first << 16) | second;
+    unsigned int mask = m_tKernings.size() - 1;
+    for (unsigned int slot = kerningHash(key, mask); ; slot = (slot + 1) & mask)
+    {
+        const ccBMFontKerning& k = m_tKernings[slot];
+        if (k.key == key)
+        {
+            return k.amount;
+        }
+        if (k.key == KERNING_EMPTY_KEY)
+        {
+            return 0;
+        }
+    }
+}
+
+void CCBMFontConfiguration::buildLookupTables(const std::vector<ccBMFontKerning>& kernings)
+{
+    // glyphs, the last definition of a char wins
+    std::stable_sort(m_tFontDefs.begin(), m_tFontDefs.end(), glyphLessThan);
+    std::vector<ccBMFontDef>::iterator out = m_tFontDefs.begin();
+    for (std::vector<ccBMFontDef>::iterator it = m_tFontDefs.begin(); it != m_tFontDefs.end(); ++it)
+    {
+        if (it + 1 == m_tFontDefs.end() || (it + 1)->charID != it->charID)
+        {
+            *out++ = *it;
+        }
+    }
+    m_tFontDefs.erase(out, m_tFontDefs.end());
+
+    // dense range covers the BMP glyphs if they are not too sparse, otherwise only latin-1
+    m_tDenseIndex.clear();
+    m_uDenseBase = 0;
+    if (!m_tFontDefs.empty())
+    {
+        unsigned int first = m_tFontDefs.front().charID;
+        unsigned int last = first;
+        for (std::vector<ccBMFontDef>::iterator it = m_tFontDefs.begin(); it != m_tFontDefs.end() && it->charID <= 0xffff; ++it)
+        {
+            last = it->charID;
+        }
+        if (last - first + 1 <= m_tFontDefs.size() * DENSE_RANGE_FACTOR)
+        {
+            m_uDenseBase = first;
+            m_tDenseIndex.resize(last - first + 1, -1);
+        }
+        else
+        {
+            m_tDenseIndex.resize(0x100, -1);
+        }
+
+        for (int i = 0; i < (int)m_tFontDefs.size(); i++)
+        {
+            unsigned int dense = m_tFontDefs[i].charID - m_uDenseBase;
+            if (dense < m_tDenseIndex.size())
+            {
+                m_tDenseIndex[dense] = i;
+            }
+        }
+    }
+
+    // kerning, load factor is at most 0.5 so a probe is short
+    m_tKernings.clear();
+    if (!kernings.empty())
+    {
+        unsigned int size = 16;
+        while (size < kernings.size() * 2)
+        {
+            size <<= 1;
+        }
+        ccBMFontKerning empty = { KERNING_EMPTY_KEY, 0 };
+        m_tKernings.resize(size, empty);
 
-    HASH_ITER(hh, m_pFontDefDictionary, current, tmp) {
-        HASH_DEL(m_pFontDefDictionary, current);
-        free(current);
+        unsigned int mask = size - 1;
+        for (std::vector<ccBMFontKerning>::const_iterator it = kernings.begin(); it != kernings.end(); ++it)
+        {
+            unsigned int slot = kerningHash(it->key, mask);
+            while (m_tKernings[slot].key != KERNING_EMPTY_KEY && m_tKernings[slot].key != it->key)
+            {
+                slot = (slot + 1) & mask;
+            }
+            m_tKernings[slot] = *it;
+        }
     }
 }
 
-std::set<unsigned int>* CCBMFontConfiguration::parseConfigFile(const char *controlFile)
+bool CCBMFontConfiguration::parseConfigFile(const char *controlFile)
 {    
     std::string fullpath = CCFileUtils::sharedFileUtils()->fullPathForFilename(controlFile);
-    CCString *contents = CCString::createWithContentsOfFile(fullpath.c_str());
+    unsigned long size = 0;
+    unsigned char* data = CCFileUtils::sharedFileUtils()->getFileData(fullpath.c_str(), "rb", &size);
 
-    CCAssert(contents, "CCBMFontConfiguration::parseConfigFile | Open file error.");
+    CCAssert(data, "CCBMFontConfiguration::parseConfigFile | Open file error.");
     
-    set<unsigned int> *validCharsString = new set<unsigned int>();
-
-    if (!contents)
+    if (!data)
     {
         CCLOG("cocos2d: Error parsing FNTfile %s", controlFile);
-        return NULL;
+        return false;
     }
 
-    // parse spacing / padding
-    std::string line;
-    std::string strLeft = contents->getCString();
-    while (strLeft.length() > 0)
+    // binary fnt of AngelCode BMFont, version 3
+    if (size >= 4 && data[0] == 'B' && data[1] == 'M' && data[2] == 'F')
     {
-        int pos = strLeft.find('\n');
+        bool ret = parseBinaryConfigFile(data, size, controlFile);
+        CC_SAFE_DELETE_ARRAY(data);
+        return ret;
+    }
 
-        if (pos != (int)std::string::npos)
-        {
-            // the data is more than a line.get one line
-            line = strLeft.substr(0, pos);
-            strLeft = strLeft.substr(pos + 1);
-        }
-        else
+    // parse text lines in place, only interesting lines are copied
+    std::vector<ccBMFontKerning> kernings;
+    const char* p = (const char*)data;
+    const char* end = p + size;
+    while (p < end)
+    {
+        const char* eol = (const char*)memchr(p, '\n', end - p);
+        if (!eol)
         {
-            // get the left data
-            line = strLeft;
-            strLeft.erase();
+            eol = end;
         }
+        size_t len = eol - p;
 
-        if(line.substr(0,strlen("info face")) == "info face") 
+#define LINE_STARTS_WITH(prefix) (len >= sizeof(prefix) - 1 && !strncmp(p, prefix, sizeof(prefix) - 1))
+        if (LINE_STARTS_WITH("info face"))
         {
             // XXX: info parsing is incomplete
             // Not needed for the Hiero editors, but needed for the AngelCode editor
             //            [self parseInfoArguments:line];
-            this->parseInfoArguments(line);
+            this->parseInfoArguments(std::string(p, len));
         }
         // Check to see if the start of the line is something we are interested in
-        else if(line.substr(0,strlen("common lineHeight")) == "common lineHeight")
+        else if (LINE_STARTS_WITH("common lineHeight"))
         {
-            this->parseCommonArguments(line);
+            this->parseCommonArguments(std::string(p, len));
         }
-        else if(line.substr(0,strlen("page id")) == "page id")
+        else if (LINE_STARTS_WITH("page id"))
         {
-            this->parseImageFileName(line, controlFile);
+            this->parseImageFileName(std::string(p, len), controlFile);
         }
-        else if(line.substr(0,strlen("chars c")) == "chars c")
+        else if (LINE_STARTS_WITH("chars c"))
         {
-            // Ignore this line
+            // reserve for the count
+            int count = 0;
+            if (sscanf(std::string(p, len).c_str(), "chars count=%d", &count) == 1 && count > 0)
+            {
+                m_tFontDefs.reserve(count);
+            }
         }
-        else if(line.substr(0,strlen("char")) == "char")
+        else if (LINE_STARTS_WITH("char"))
         {
             // Parse the current line and create a new CharDef
-            tCCFontDefHashElement* element = (tCCFontDefHashElement*)malloc( sizeof(*element) );
-            this->parseCharacterDefinition(line, &element->fontDef);
+            ccBMFontDef fontDef;
+            this->parseCharacterDefinition(std::string(p, len), &fontDef);
+            m_tFontDefs.push_back(fontDef);
+        }
+        else if (LINE_STARTS_WITH("kerning first"))
+        {
+            this->parseKerningEntry(std::string(p, len), kernings);
+        }
+#undef LINE_STARTS_WITH
 
-            element->key = element->fontDef.charID;
-            HASH_ADD_INT(m_pFontDefDictionary, key, element);
-            
-            validCharsString->insert(element->fontDef.charID);
+        p = eol + 1;
+    }
+    CC_SAFE_DELETE_ARRAY(data);
+
+    buildLookupTables(kernings);
+    return true;
+}
+
+bool CCBMFontConfiguration::parseBinaryConfigFile(const unsigned char *data, unsigned long size, const char *controlFile)
+{
+    //////////////////////////////////////////////////////////////////////////
+    // "BMF" + version 3, then blocks of: type (1 byte), size (4 bytes), data
+    // 1 info, 2 common, 3 pages, 4 chars, 5 kerning pairs
+    //////////////////////////////////////////////////////////////////////////
+    if (data[3] != 3)
+    {
+        CCLOG("cocos2d: FNTfile %s has binary version %d, only version 3 is supported", controlFile, data[3]);
+        return false;
+    }
+
+    std::vector<ccBMFontKerning> kernings;
+    unsigned long offset = 4;
+    while (offset + 5 <= size)
+    {
+        unsigned char type = data[offset];
+        unsigned int blockSize = readU32(data + offset + 1);
+        const unsigned char* block = data + offset + 5;
+        offset += 5;
+        if (blockSize > size - offset)
+        {
+            CCLOG("cocos2d: FNTfile %s is truncated", controlFile);
+            return false;
         }
-//        else if(line.substr(0,strlen("kernings count")) == "kernings count")
-//        {
-//            this->parseKerningCapacity(line);
-//        }
-        else if(line.substr(0,strlen("kerning first")) == "kerning first")
+        offset += blockSize;
+
+        switch (type)
         {
-            this->parseKerningEntry(line);
+            case 1:
+            {
+                // info, padding is up, right, down, left
+                if (blockSize >= 11)
+                {
+                    m_tPadding.top = block[7];
+                    m_tPadding.right = block[8];
+                    m_tPadding.bottom = block[9];
+                    m_tPadding.left = block[10];
+                }
+                break;
+            }
+            case 2:
+            {
+                // common, lineHeight, base, scaleW, scaleH, pages
+                if (blockSize >= 10)
+                {
+                    m_nCommonHeight = readU16(block);
+                    CCAssert(readU16(block + 4) <= CCConfiguration::sharedConfiguration()->getMaxTextureSize(), "CCLabelBMFont: page can't be larger than supported");
+                    CCAssert(readU16(block + 6) <= CCConfiguration::sharedConfiguration()->getMaxTextureSize(), "CCLabelBMFont: page can't be larger than supported");
+                    CCAssert(readU16(block + 8) == 1, "CCBitfontAtlas: only supports 1 page");
+                }
+                break;
+            }
+            case 3:
+            {
+                // page names, only first page is used
+                std::string name((const char*)block, strnlen((const char*)block, blockSize));
+                m_sAtlasName = CCFileUtils::sharedFileUtils()->fullPathFromRelativeFile(name.c_str(), controlFile);
+                break;
+            }
+            case 4:
+            {
+                // chars, 20 bytes each
+                unsigned int count = blockSize / 20;
+                m_tFontDefs.resize(count);
+                for (unsigned int i = 0; i < count; i++)
+                {
+                    const unsigned char* c = block + i * 20;
+                    ccBMFontDef& def = m_tFontDefs[i];
+                    def.charID = readU32(c);
+                    def.rect.origin.x = readU16(c + 4);
+                    def.rect.origin.y = readU16(c + 6);
+                    def.rect.size.width = readU16(c + 8);
+                    def.rect.size.height = readU16(c + 10);
+                    def.xOffset = readS16(c + 12);
+                    def.yOffset = readS16(c + 14);
+                    def.xAdvance = readS16(c + 16);
+                }
+                break;
+            }
+            case 5:
+            {
+                // kerning pairs, 10 bytes each
+                unsigned int count = blockSize / 10;
+                kernings.resize(count);
+                for (unsigned int i = 0; i < count; i++)
+                {
+                    const unsigned char* k = block + i * 10;
+                    kernings[i].key = (readU32(k) << 16) | (readU32(k + 4) & 0xffff);
+                    kernings[i].amount = readS16(k + 8);
+                }
+                break;
+            }
+            default:
+                break;
         }
     }
-    
-    return validCharsString;
+
+    buildLookupTables(kernings);
+    return true;
 }
 
 void CCBMFontConfiguration::parseImageFileName(std::string line, const char *fntFile)
@@ -376,7 +635,7 @@ void CCBMFontConfiguration::parseCharacterDefinition(std::string line, ccBMFontD
     sscanf(value.c_str(), "xadvance=%hd", &characterDefinition->xAdvance);
 }
 
-void CCBMFontConfiguration::parseKerningEntry(std::string line)
+void CCBMFontConfiguration::parseKerningEntry(std::string line, std::vector<ccBMFontKerning>& kernings)
 {        
     //////////////////////////////////////////////////////////////////////////
     // line to parse:
@@ -404,10 +663,10 @@ void CCBMFontConfiguration::parseKerningEntry(std::string line)
     value = line.substr(index, index2-index);
     sscanf(value.c_str(), "amount=%d", &amount);
 
-    tCCKerningHashElement *element = (tCCKerningHashElement *)calloc( sizeof( *element ), 1 );
-    element->amount = amount;
-    element->key = (first<<16) | (second&0xffff);
-    HASH_ADD_INT(m_pKerningDictionary,key, element);
+    ccBMFontKerning kerning;
+    kerning.amount = amount;
+    kerning.key = (first<<16) | (second&0xffff);
+    kernings.push_back(kerning);
 }
 //
 //CCLabelBMFont
@@ -560,16 +819,7 @@ CCLabelBMFont::~CCLabelBMFont()
 // LabelBMFont - Atlas generation
 int CCLabelBMFont::kerningAmountForFirst(unsigned short first, unsigned short second)
 {
-    int ret = 0;
-    unsigned int key = (first<<16) | (second & 0xffff);
-
-    if( m_pConfiguration->m_pKerningDictionary ) {
-        tCCKerningHashElement *element = NULL;
-        HASH_FIND_INT(m_pConfiguration->m_pKerningDictionary, &key, element);        
-        if(element)
-            ret = element->amount;
-    }
-    return ret;
+    return m_pConfiguration->getKerningAmount(first, second);
 }
 
 void CCLabelBMFont::createFontChars()
@@ -592,8 +842,6 @@ void CCLabelBMFont::createFontChars()
         return;
     }
 
-    set<unsigned int> *charSet = m_pConfiguration->getCharacterSet();
-
     for (unsigned int i = 0; i < stringLen - 1; ++i)
     {
         unsigned short c = m_sString[i];
@@ -621,26 +869,16 @@ void CCLabelBMFont::createFontChars()
             continue;
         }
         
-        if (charSet->find(c) == charSet->end())
+        const ccBMFontDef *pFontDef = m_pConfiguration->getFontDef(c);
+        if (! pFontDef)
         {
             CCLOGWARN("cocos2d::CCLabelBMFont: Attempted to use character not defined in this bitmap: %d", c);
             continue;      
         }
 
         kerningAmount = this->kerningAmountForFirst(prev, c);
-        
-        tCCFontDefHashElement *element = NULL;
-
-        // unichar is a short, and an int is needed on HASH_FIND_INT
-        unsigned int key = c;
-        HASH_FIND_INT(m_pConfiguration->m_pFontDefDictionary, &key, element);
-        if (! element)
-        {
-            CCLOGWARN("cocos2d::CCLabelBMFont: characer not found %d", c);
-            continue;
-        }
 
-        fontDef = element->fontDef;
+        fontDef = *pFontDef;
 
         rect = fontDef.rect;
         rect = CC_RECT_PIXELS_TO_POINTS(rect);
@@ -53,8 +53,6 @@ enum {
     kCCLabelAutomaticWidth = -1,
 };
 
-struct _FontDefHashElement;
-
 /**
 @struct ccBMFontDef
 BMFont definition
@@ -87,20 +85,15 @@ typedef struct _BMFontPadding {
     int bottom;
 } ccBMFontPadding;
 
-typedef struct _FontDefHashElement
-{
-	unsigned int	key;		// key. Font Unicode value
-	ccBMFontDef		fontDef;	// font definition
-	UT_hash_handle	hh;
-} tCCFontDefHashElement;
-
-// Equal function for targetSet.
-typedef struct _KerningHashElement
-{
-	int				key;		// key for the hash. 16-bit for 1st element, 16-bit for 2nd element
-	int				amount;
-	UT_hash_handle	hh;
-} tCCKerningHashElement;
+/** @struct ccBMFontKerning
+Slot of the kerning table
+*/
+typedef struct _BMFontKerning {
+    //! 16-bit for 1st character, 16-bit for 2nd character, 0xffffffff for an empty slot
+    unsigned int key;
+    //! kerning amount in pixels
+    int amount;
+} ccBMFontKerning;
 
 /** @brief CCBMFontConfiguration has parsed configuration of the the .fnt file
 @since v0.8
@@ -111,8 +104,8 @@ class CC_DLL CCBMFontConfiguration : public CCObject
 {
     // XXX: Creating a public interface so that the bitmapFontArray[] is accessible
 public://@public
-    // BMFont definitions
-    tCCFontDefHashElement *m_pFontDefDictionary;
+    //! BMFont definitions, sorted by charID
+    std::vector<ccBMFontDef> m_tFontDefs;
 
     //! FNTConfig: Common Height Should be signed (issue #1343)
     int m_nCommonHeight;
@@ -120,11 +113,16 @@ public://@public
     ccBMFontPadding    m_tPadding;
     //! atlas name
     std::string m_sAtlasName;
-    //! values for kerning
-    tCCKerningHashElement *m_pKerningDictionary;
+    //! values for kerning, open addressing hash table, its size is a power of 2
+    std::vector<ccBMFontKerning> m_tKernings;
+    
+    //! Character Set defines the letters that actually exist in the font, built on first use
+    mutable std::set<unsigned int> *m_pCharacterSet;
     
-    // Character Set defines the letters that actually exist in the font
-    std::set<unsigned int> *m_pCharacterSet;
+private:
+    //! index in m_tFontDefs of (charID - m_uDenseBase), -1 if the font doesn't have it
+    std::vector<int> m_tDenseIndex;
+    unsigned int m_uDenseBase;
     
 public:
     CCBMFontConfiguration();
@@ -149,16 +147,24 @@ public:
     inline void setAtlasName(const char* atlasName) { m_sAtlasName = atlasName; }
     
     std::set<unsigned int>* getCharacterSet() const;
+
+    /** definition of a character, NULL if the font doesn't have it.
+     Characters in the dense range of the font are found by index, others by binary search
+     */
+    const ccBMFontDef* getFontDef(unsigned int charID) const;
+
+    /** kerning amount between two characters, in pixels */
+    int getKerningAmount(unsigned short first, unsigned short second) const;
     
 private:
-    std::set<unsigned int>* parseConfigFile(const char *controlFile);
+    bool parseConfigFile(const char *controlFile);
+    bool parseBinaryConfigFile(const unsigned char *data, unsigned long size, const char *controlFile);
+    void buildLookupTables(const std::vector<ccBMFontKerning>& kernings);
     void parseCharacterDefinition(std::string line, ccBMFontDef *characterDefinition);
     void parseInfoArguments(std::string line);
     void parseCommonArguments(std::string line);
     void parseImageFileName(std::string line, const char *fntFile);
-    void parseKerningEntry(std::string line);
-    void purgeKerningDictionary();
-    void purgeFontDefDictionary();
+    void parseKerningEntry(std::string line, std::vector<ccBMFontKerning>& kernings);
 };
 
 /** @brief CCLabelBMFont is a subclass of CCSpriteBatchNode.
@@ -319,6 +325,10 @@ CC_DLL CCBMFontConfiguration * FNTConfigLoadFile( const char *file );
 */
 CC_DLL void FNTConfigRemoveCache( void );
 
+/** Removes the FNT configs which are not used by any label from the cache
+*/
+CC_DLL void FNTConfigRemoveUnusedCache( void );
+
 // end of GUI group
 /// @}
 /// @}
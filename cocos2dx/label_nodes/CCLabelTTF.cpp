@@ -33,6 +33,12 @@
 #include "menu_nodes/CCMenu.h"
 #include "actions/CCActionInstant.h"
 #include "cocoa/CCPointExtension.h"
+#include "textures/CCTextureAtlas.h"
+#include "support/codec/ccUTF8.h"
+#include "CCGlyphAtlas.h"
+#include "CCAsyncTextRenderer.h"
+#include "CCTextLayoutCache.h"
+#include "CCTextLayout.h"
 
 NS_CC_BEGIN
 
@@ -46,30 +52,57 @@ NS_CC_BEGIN
 #define START_TAG_LINK_ITEM 0x80000
 #define TAG_MENU 0x70000
 
+// glyph atlas as font of text layout
+class CCGlyphAtlasLayoutFont : public CCTextLayoutFont {
+private:
+    CCGlyphAtlas* m_atlas;
+    
+public:
+    CCGlyphAtlasLayoutFont(CCGlyphAtlas* atlas) : m_atlas(atlas) {}
+    
+    virtual const void* getGlyph(unsigned short c) {
+        return m_atlas->getGlyph(c);
+    }
+    
+    virtual float getAdvance(const void* glyph) {
+        return ((const ccGlyphDef*)glyph)->advance;
+    }
+    
+    virtual float getKerning(unsigned short left, unsigned short right) {
+        return m_atlas->getKerning(left, right);
+    }
+};
+
 //
 //CCLabelTTF
 //
 CCLabelTTF::CCLabelTTF() :
+m_stateListener(NULL),
+m_realLength(0),
+m_defaultTarget(NULL),
+m_glyphAtlasEnabled(false),
+m_glyphAtlas(NULL),
+m_asyncEnabled(false),
+m_asyncSerial(0),
+m_asyncPending(false),
 m_hAlignment(kCCTextAlignmentCenter),
 m_vAlignment(kCCVerticalTextAlignmentTop),
 m_pFontName(NULL),
 m_fFontSize(0.0),
-m_realLength(0),
-m_lineSpacing(0),
-m_elapsed(0),
 m_string(""),
-m_updateScheduled(false),
+m_toCharIndex(-1),
+m_lineSpacing(0),
 m_shadowEnabled(false),
 m_shadowColor(0xff333333),
+m_globalImageScaleFactor(1),
 m_strokeEnabled(false),
 m_textFillColor(ccWHITE),
-m_globalImageScaleFactor(1),
-m_stateListener(NULL),
-m_toCharIndex(-1),
-m_defaultTarget(NULL),
+m_textChanging(true),
 m_loopFunc(NULL),
-m_textChanging(true) {
+m_elapsed(0),
+m_updateScheduled(false) {
     m_stateListener = new CCLabelTTFLinkStateSynchronizer(this);
+    m_glyphColor = ccc4(255, 255, 255, 255);
 }
 
 CCLabelTTF::~CCLabelTTF() {
@@ -90,6 +123,7 @@ CCLabelTTF::~CCLabelTTF() {
     
     // release other
     CC_SAFE_RELEASE(m_stateListener);
+    releaseGlyphQuads();
 }
 
 CCLabelTTF * CCLabelTTF::create()
@@ -339,6 +373,43 @@ void CCLabelTTF::setGradientColor(const ccColor4B& start, const ccColor4B& end,
 // Helper
 bool CCLabelTTF::updateTexture()
 {
+    // glyph atlas mode only rebuilds quads
+    if(m_glyphAtlasEnabled) {
+        if(!updateGlyphQuads()) {
+            setGlyphAtlasEnabled(false);
+        }
+        return true;
+    }
+    
+    // any result of older request is stale now
+    m_asyncSerial++;
+    
+    // same string with same definition was rendered recently, reuse its texture. Label with
+    // color transition renders every frame, don't bother to look up
+    ccFontDefinition texDef = _prepareTextDefinition(true);
+    CCTexture2D* cached = NULL;
+    if(!m_updateScheduled) {
+        cached = (CCTexture2D*)CCTextLayoutCache::sharedTextLayoutCache()->objectForKey(textureCacheKey(texDef));
+    }
+    if(cached) {
+        if(m_asyncPending) {
+            CCAsyncTextRenderer::sharedRenderer()->cancel(this);
+            m_asyncPending = false;
+        }
+        applyTexture(cached);
+        return true;
+    }
+    
+#if CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID || CC_TARGET_PLATFORM == CC_PLATFORM_IOS
+    // async mode keeps current texture until worker is done
+    if(m_asyncEnabled) {
+        CCAsyncTextRenderer::sharedRenderer()->render(this, m_string, texDef, m_asyncSerial);
+        m_asyncPending = true;
+        return true;
+    }
+#endif
+    m_asyncPending = false;
+    
     CCTexture2D *tex;
     tex = new CCTexture2D();
     
@@ -347,7 +418,6 @@ bool CCLabelTTF::updateTexture()
     
 #if CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID || CC_TARGET_PLATFORM == CC_PLATFORM_IOS || CC_TARGET_PLATFORM == CC_PLATFORM_MAC
     
-    ccFontDefinition texDef = _prepareTextDefinition(true);
     tex->initWithString( m_string.c_str(), &texDef );
     
 #else
@@ -361,12 +431,65 @@ bool CCLabelTTF::updateTexture()
     
 #endif
     
-    // set the texture
-    this->setTexture(tex);
+    applyTexture(tex);
+    cacheTexture(tex, texDef);
     
     // release it
     CC_SAFE_RELEASE(tex);
     
+    //ok
+    return true;
+}
+
+string CCLabelTTF::textureCacheKey(const ccFontDefinition& textDefinition) {
+    return CCTextLayoutCache::keyForTextDefinition("ttf", m_string, textDefinition);
+}
+
+void CCLabelTTF::cacheTexture(CCTexture2D* tex, const ccFontDefinition& textDefinition) {
+    // texture changing with time or partial display is not worth caching
+    if(tex->isNeedTime() || m_toCharIndex >= 0 || m_string.empty())
+        return;
+    
+    unsigned int cost = tex->getPixelsWide() * tex->getPixelsHigh() * tex->bitsPerPixelForFormat() / 8;
+    CCTextLayoutCache::sharedTextLayoutCache()->setObject(tex, textureCacheKey(textDefinition), cost);
+}
+
+void CCLabelTTF::onAsyncTextRendered(const string& text, ccFontDefinition& textDefinition, CCImage* image, unsigned int serial) {
+    // drop stale result
+    if(serial != m_asyncSerial || m_glyphAtlasEnabled)
+        return;
+    m_asyncPending = false;
+    
+    // keep current texture, next string change renders again
+    if(!image) {
+        CCLOGWARN("CCLabelTTF: async rendering of %s failed", text.c_str());
+        return;
+    }
+    
+    CCTexture2D* tex = new CCTexture2D();
+    if(tex->initWithStringImage(text.c_str(), &textDefinition, image)) {
+        applyTexture(tex);
+        cacheTexture(tex, textDefinition);
+    }
+    CC_SAFE_RELEASE(tex);
+}
+
+void CCLabelTTF::setAsyncEnabled(bool enabled) {
+    if(m_asyncEnabled == enabled)
+        return;
+    m_asyncEnabled = enabled;
+    
+    // render latest string now if it is still waiting
+    if(!enabled && m_asyncPending) {
+        CCAsyncTextRenderer::sharedRenderer()->cancel(this);
+        updateTexture();
+    }
+}
+
+void CCLabelTTF::applyTexture(CCTexture2D* tex) {
+    // set the texture
+    this->setTexture(tex);
+    
     // set the size in the sprite
     CCRect rect =CCRectZero;
     rect.size   = m_pobTexture->getContentSize();
@@ -443,9 +566,6 @@ bool CCLabelTTF::updateTexture()
             m_updateScheduled = false;
         }
     }
-    
-    //ok
-    return true;
 }
 
 CCRect CCLabelTTF::getImageBound(int index) {
@@ -586,7 +706,10 @@ void CCLabelTTF::setColor(const ccColor3B &tintColor)
 #if CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID || CC_TARGET_PLATFORM == CC_PLATFORM_IOS || CC_TARGET_PLATFORM == CC_PLATFORM_MAC
     if (m_textFillColor.r != tintColor.r || m_textFillColor.g != tintColor.g || m_textFillColor.b != tintColor.b) {
         m_textFillColor = tintColor;
-        updateTexture();
+        
+        // glyph quads pick up fill color when drawn
+        if(!m_glyphAtlasEnabled)
+            updateTexture();
     }
 #else
     CCAssert(false, "Operation is not supported for your platform");
@@ -845,4 +968,180 @@ void CCLabelTTF::update(float delta) {
     updateTexture();
 }
 
+void CCLabelTTF::setGlyphAtlasEnabled(bool enabled) {
+    if(m_glyphAtlasEnabled == enabled)
+        return;
+    m_glyphAtlasEnabled = enabled;
+    
+    if(enabled) {
+        // tags are not parsed, so link menu, image rects and color transition are gone
+        CCMenu* menu = (CCMenu*)getChildByTag(TAG_MENU);
+        if(menu) {
+            menu->removeFromParent();
+        }
+        m_imageRects.clear();
+        if(m_asyncPending) {
+            CCAsyncTextRenderer::sharedRenderer()->cancel(this);
+            m_asyncPending = false;
+        }
+        if(m_updateScheduled) {
+            unscheduleUpdate();
+            m_updateScheduled = false;
+        }
+        
+        // release texture of whole string, glyph pages are A8 and not premultiplied
+        setTexture(NULL);
+        setShaderProgram(CCShaderCache::sharedShaderCache()->programForKey(kCCShader_PositionTextureA8Color));
+        m_sBlendFunc.src = GL_SRC_ALPHA;
+        m_sBlendFunc.dst = GL_ONE_MINUS_SRC_ALPHA;
+        
+        if(!updateGlyphQuads()) {
+            CCLOGWARN("CCLabelTTF: font %s can't be used in glyph atlas", m_pFontName->c_str());
+            m_glyphAtlasEnabled = false;
+        }
+    }
+    
+    // back to texture mode
+    if(!m_glyphAtlasEnabled) {
+        releaseGlyphQuads();
+        setShaderProgram(CCShaderCache::sharedShaderCache()->programForKey(SHADER_PROGRAM));
+        m_textChanging = true;
+        updateTexture();
+    }
+}
+
+void CCLabelTTF::releaseGlyphQuads() {
+    for(vector<CCTextureAtlas*>::iterator iter = m_glyphQuads.begin(); iter != m_glyphQuads.end(); iter++) {
+        CC_SAFE_RELEASE(*iter);
+    }
+    m_glyphQuads.clear();
+    CC_SAFE_RELEASE_NULL(m_glyphAtlas);
+}
+
+bool CCLabelTTF::updateGlyphQuads() {
+    float scale = CC_CONTENT_SCALE_FACTOR();
+    CCGlyphAtlas* atlas = CCGlyphAtlasCache::sharedGlyphAtlasCache()->atlasForFont(m_pFontName->c_str(),
+                                                                                   (int)(m_fFontSize * scale + 0.5f));
+    if(!atlas)
+        return false;
+    
+    // quads of previous font refer to its pages
+    if(atlas != m_glyphAtlas) {
+        releaseGlyphQuads();
+        m_glyphAtlas = atlas;
+        CC_SAFE_RETAIN(m_glyphAtlas);
+    }
+    
+    // layout glyphs in pixels, new glyphs are rasterised here
+    int len = 0;
+    unsigned short* utf16 = cc_utf8_to_utf16(m_string.c_str(), &len);
+    CCGlyphAtlasLayoutFont font(atlas);
+    CCTextLayout layout;
+    layout.layout(&font, utf16, len, m_tDimensions.width * scale, m_hAlignment);
+    CC_SAFE_DELETE_ARRAY(utf16);
+    m_realLength = layout.m_glyphs.size();
+    
+    // label size
+    int lines = layout.getLineCount();
+    float lineHeight = atlas->getLineHeight();
+    float textHeight = lines * lineHeight + (lines - 1) * m_lineSpacing;
+    float width = layout.m_width;
+    float height = m_tDimensions.height > 0 ? m_tDimensions.height * scale : textHeight;
+    float top = 0;
+    if(m_vAlignment == kCCVerticalTextAlignmentCenter)
+        top = (height - textHeight) / 2;
+    else if(m_vAlignment == kCCVerticalTextAlignmentBottom)
+        top = height - textHeight;
+    
+    // build quads of every page, y is flipped to node space
+    vector<vector<ccV3F_C4B_T2F_Quad> > quads(atlas->getPageCount());
+    for(size_t i = 0; i < layout.m_glyphs.size(); i++) {
+        if(m_toCharIndex >= 0 && (int)i >= m_toCharIndex)
+            break;
+        
+        const ccTextLayoutGlyph& g = layout.m_glyphs[i];
+        const ccGlyphDef* def = (const ccGlyphDef*)g.glyph;
+        const CCRect& r = def->rect;
+        if(r.size.width <= 0 || r.size.height <= 0)
+            continue;
+        
+        float x = g.x + def->bearingX;
+        float y = top + g.line * (lineHeight + m_lineSpacing) + def->bearingY;
+        
+        float left = x / scale;
+        float right = (x + r.size.width) / scale;
+        float t = (height - y) / scale;
+        float b = (height - y - r.size.height) / scale;
+        float u0 = r.origin.x / CC_GLYPH_ATLAS_PAGE_SIZE;
+        float u1 = (r.origin.x + r.size.width) / CC_GLYPH_ATLAS_PAGE_SIZE;
+        float v0 = r.origin.y / CC_GLYPH_ATLAS_PAGE_SIZE;
+        float v1 = (r.origin.y + r.size.height) / CC_GLYPH_ATLAS_PAGE_SIZE;
+        
+        ccV3F_C4B_T2F_Quad quad;
+        quad.bl.vertices = vertex3(left, b, 0);
+        quad.bl.texCoords = tex2(u0, v1);
+        quad.br.vertices = vertex3(right, b, 0);
+        quad.br.texCoords = tex2(u1, v1);
+        quad.tl.vertices = vertex3(left, t, 0);
+        quad.tl.texCoords = tex2(u0, v0);
+        quad.tr.vertices = vertex3(right, t, 0);
+        quad.tr.texCoords = tex2(u1, v0);
+        quad.bl.colors = quad.br.colors = quad.tl.colors = quad.tr.colors = m_glyphColor;
+        quads[def->page].push_back(quad);
+    }
+    
+    // pages added by this layout need a texture atlas
+    while(m_glyphQuads.size() < quads.size()) {
+        CCTextureAtlas* ta = CCTextureAtlas::createWithTexture(atlas->getPage(m_glyphQuads.size()), 16);
+        CC_SAFE_RETAIN(ta);
+        m_glyphQuads.push_back(ta);
+    }
+    for(size_t i = 0; i < quads.size(); i++) {
+        CCTextureAtlas* ta = m_glyphQuads[i];
+        vector<ccV3F_C4B_T2F_Quad>& pageQuads = quads[i];
+        ta->removeAllQuads();
+        if(pageQuads.size() > ta->getCapacity()) {
+            ta->resizeCapacity(pageQuads.size());
+        }
+        for(size_t j = 0; j < pageQuads.size(); j++) {
+            ta->updateQuad(&pageQuads[j], j);
+        }
+    }
+    
+    setContentSize(CCSizeMake(width / scale, height / scale));
+    return true;
+}
+
+void CCLabelTTF::draw() {
+    if(!m_glyphAtlasEnabled) {
+        CCGradientSprite::draw();
+        return;
+    }
+    
+    // displayed color changes without notifying label, so check it here
+    ccColor4B color = ccc4(m_textFillColor.r * _displayedColor.r / 255,
+                           m_textFillColor.g * _displayedColor.g / 255,
+                           m_textFillColor.b * _displayedColor.b / 255,
+                           _displayedOpacity);
+    if(color.r != m_glyphColor.r || color.g != m_glyphColor.g || color.b != m_glyphColor.b || color.a != m_glyphColor.a) {
+        m_glyphColor = color;
+        for(vector<CCTextureAtlas*>::iterator iter = m_glyphQuads.begin(); iter != m_glyphQuads.end(); iter++) {
+            CCTextureAtlas* ta = *iter;
+            ccV3F_C4B_T2F_Quad* q = ta->getQuads();
+            for(unsigned int i = 0; i < ta->getTotalQuads(); i++) {
+                q[i].bl.colors = q[i].br.colors = q[i].tl.colors = q[i].tr.colors = color;
+            }
+            ta->setDirty(true);
+        }
+    }
+    
+    CC_NODE_DRAW_SETUP(this);
+    ccGLBlendFunc(m_sBlendFunc.src, m_sBlendFunc.dst);
+    for(vector<CCTextureAtlas*>::iterator iter = m_glyphQuads.begin(); iter != m_glyphQuads.end(); iter++) {
+        if((*iter)->getTotalQuads() > 0) {
+            (*iter)->drawQuads();
+        }
+    }
+}
+
 NS_CC_END
@@ -33,6 +33,10 @@ using namespace std;
 NS_CC_BEGIN
 
 class CCTexture2D;
+class CCTextureAtlas;
+class CCGlyphAtlas;
+class CCImage;
+class CCAsyncTextRenderer;
 class CCLabelTTFLinkStateSynchronizer;
 
 /**
@@ -75,6 +79,17 @@ class CCLabelTTFLinkStateSynchronizer;
  * effect.
  *
  * \par
+ * For text which changes often, such as score counters or chat, call setGlyphAtlasEnabled.
+ * Label will be drawn with glyph quads from a CCGlyphAtlas which is shared by all labels
+ * of same font and size, so changing string doesn't create a new texture. Tags, shadow,
+ * stroke and gradient are not supported in that mode.
+ *
+ * \par
+ * For long rich text which changes at runtime, such as chat or mail, call setAsyncEnabled.
+ * String will be rendered in a worker thread and label keeps showing previous texture until
+ * new one is ready, so setString doesn't block GL thread.
+ *
+ * \par
  * Android version will hold a bitmap for encountered atlas, but it only holds last one. If a new atlas image is
  * parsed, previous one will be released and current will be held. For better performance, you should put images which
  * will be embedded in a rich label into one atlas image.
@@ -83,6 +98,8 @@ class CCLabelTTFLinkStateSynchronizer;
  * Currently it only supports iOS and Android, please do it yourself if you want other platform.
  */
 class CC_DLL CCLabelTTF : public CCGradientSprite, public CCLabelProtocol {
+    friend class CCAsyncTextRenderer;
+    
 private:
     /// menu item state listener
     CCLabelTTFLinkStateSynchronizer* m_stateListener;
@@ -99,6 +116,27 @@ private:
     /// default target for all link items (if no function in link target map)
     CCCallFunc* m_defaultTarget;
     
+    /// true means label is drawn with glyph quads
+    bool m_glyphAtlasEnabled;
+    
+    /// atlas of current font and size, in glyph atlas mode
+    CCGlyphAtlas* m_glyphAtlas;
+    
+    /// glyph quads, one texture atlas for every atlas page
+    vector<CCTextureAtlas*> m_glyphQuads;
+    
+    /// color of glyph quads
+    ccColor4B m_glyphColor;
+    
+    /// true means string is rendered in worker thread
+    bool m_asyncEnabled;
+    
+    /// serial of latest texture request, older async results are dropped
+    unsigned int m_asyncSerial;
+    
+    /// an async request is not applied yet
+    bool m_asyncPending;
+    
 protected:
     // when link item is clicked
     void onLinkMenuItemClicked(CCObject* sender);
@@ -174,7 +212,8 @@ public:
     virtual bool init();
     
     /** changes the string to render
-     * @warning Changing the string is as expensive as creating a new CCLabelTTF. To obtain better performance use CCLabelAtlas
+     * @warning Changing the string is as expensive as creating a new CCLabelTTF. To obtain better performance use
+     *      CCLabelAtlas, or enable glyph atlas mode
      */
     virtual void setString(const char *label);
     virtual const char* getString(void);
@@ -260,9 +299,56 @@ public:
     /// set the char visible range, from first to specified index, exclusive
     void setDisplayTo(int to);
     
+    /**
+     * Draw label with quads of a glyph atlas shared by all labels of same font and size, instead of
+     * rendering whole string into a texture. Changing string only rebuilds quads, and rasterises glyphs
+     * which are not in atlas yet. In this mode string is drawn as is, tags are not parsed, shadow,
+     * stroke and gradient are ignored. If font can't be loaded into atlas, label stays in texture mode.
+     *
+     * @param enabled true to enable glyph atlas mode
+     */
+    void setGlyphAtlasEnabled(bool enabled);
+    
+    /// is label drawn with glyph quads
+    bool isGlyphAtlasEnabled() { return m_glyphAtlasEnabled; }
+    
+    /**
+     * Render string in a worker thread. Label keeps previous texture, content size and
+     * link menu until new texture is uploaded, in the frame after rendering is done. If string
+     * is changed again before that, only latest string is rendered. Glyph atlas mode takes
+     * precedence. Only iOS and Android support it, other platforms always render synchronously.
+     *
+     * @param enabled true to enable async rendering. If false and a request is pending, it is
+     *      rendered synchronously
+     */
+    void setAsyncEnabled(bool enabled);
+    
+    /// is string rendered in worker thread
+    bool isAsyncEnabled() { return m_asyncEnabled; }
+    
+    virtual void draw();
+    
 private:
     bool updateTexture();
     
+    // use a new texture of whole string, update image rects, link menu and effect update
+    void applyTexture(CCTexture2D* tex);
+    
+    // key of current string and a text definition in CCTextLayoutCache
+    string textureCacheKey(const ccFontDefinition& textDefinition);
+    
+    // put a texture of whole string into CCTextLayoutCache if it can be reused
+    void cacheTexture(CCTexture2D* tex, const ccFontDefinition& textDefinition);
+    
+    // async rendering is done, called by CCAsyncTextRenderer in GL thread. image is NULL if it failed
+    void onAsyncTextRendered(const string& text, ccFontDefinition& textDefinition, CCImage* image, unsigned int serial);
+    
+    // layout string into glyph quads, return false if font can't be used in glyph atlas
+    bool updateGlyphQuads();
+    
+    // release glyph quads and atlas
+    void releaseGlyphQuads();
+    
     // update method of startLoopDisplay
     void displayNextChar(float delta);
     
@@ -0,0 +1,101 @@
+/****************************************************************************
+ Author: Luma (stubma@gmail.com)
+
+ https://github.com/stubma/cocos2dx-classical
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+#include "CCTextLayout.h"
+#include "ccMacros.h"
+
+NS_CC_BEGIN
+
+CCTextLayout::CCTextLayout() :
+m_width(0) {
+}
+
+void CCTextLayout::layout(CCTextLayoutFont* font, const unsigned short* text, int len, float maxWidth, CCTextAlignment alignment) {
+    m_glyphs.clear();
+    m_lineWidths.clear();
+    
+    // place glyphs in lines
+    float penX = 0;
+    size_t lineStart = 0;
+    int lastSpace = -1;
+    unsigned short prev = 0;
+    for(int i = 0; i < len; i++) {
+        unsigned short c = text[i];
+        if(c == '\n') {
+            m_lineWidths.push_back(penX);
+            penX = 0;
+            lineStart = m_glyphs.size();
+            lastSpace = -1;
+            prev = 0;
+            continue;
+        }
+        
+        const void* glyph = font->getGlyph(c);
+        if(!glyph)
+            continue;
+        
+        // wrap at last space of line, or before this glyph if line has no space
+        float kerning = prev ? font->getKerning(prev, c) : 0;
+        float advance = font->getAdvance(glyph);
+        if(maxWidth > 0 && m_glyphs.size() > lineStart && penX + kerning + advance > maxWidth) {
+            size_t breakAt = lastSpace >= 0 ? lastSpace + 1 : m_glyphs.size();
+            float lineWidth = lastSpace >= 0 ? m_glyphs[lastSpace].x : penX;
+            float origin = breakAt < m_glyphs.size() ? m_glyphs[breakAt].x : penX;
+            for(size_t j = breakAt; j < m_glyphs.size(); j++) {
+                m_glyphs[j].x -= origin;
+                m_glyphs[j].line++;
+            }
+            m_lineWidths.push_back(lineWidth);
+            penX -= origin;
+            lineStart = breakAt;
+            lastSpace = -1;
+            if(breakAt == m_glyphs.size())
+                kerning = 0;
+        }
+        
+        if(c == ' ')
+            lastSpace = m_glyphs.size();
+        ccTextLayoutGlyph g = { glyph, penX + kerning, (int)m_lineWidths.size() };
+        m_glyphs.push_back(g);
+        penX += kerning + advance;
+        prev = c;
+    }
+    m_lineWidths.push_back(penX);
+    
+    // layout box
+    float textWidth = 0;
+    for(vector<float>::iterator iter = m_lineWidths.begin(); iter != m_lineWidths.end(); iter++) {
+        textWidth = MAX(textWidth, *iter);
+    }
+    m_width = maxWidth > 0 ? maxWidth : textWidth;
+    
+    // align lines in box
+    if(alignment != kCCTextAlignmentLeft) {
+        for(vector<ccTextLayoutGlyph>::iterator iter = m_glyphs.begin(); iter != m_glyphs.end(); iter++) {
+            float space = m_width - m_lineWidths[iter->line];
+            iter->x += alignment == kCCTextAlignmentCenter ? space / 2 : space;
+        }
+    }
+}
+
+NS_CC_END
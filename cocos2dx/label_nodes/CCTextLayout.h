@@ -0,0 +1,97 @@
+/****************************************************************************
+ Author: Luma (stubma@gmail.com)
+
+ https://github.com/stubma/cocos2dx-classical
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+#ifndef __CCTextLayout__
+#define __CCTextLayout__
+
+#include "ccTypes.h"
+#include <vector>
+
+using namespace std;
+
+NS_CC_BEGIN
+
+/// a glyph placed by CCTextLayout, position is in pixels
+typedef struct _ccTextLayoutGlyph {
+    /// glyph returned by font
+    const void* glyph;
+    
+    /// pen position in line, alignment is applied
+    float x;
+    
+    /// line index, from top
+    int line;
+} ccTextLayoutGlyph;
+
+/// font of CCTextLayout, metrics are in pixels
+class CC_DLL CCTextLayoutFont {
+public:
+    virtual ~CCTextLayoutFont() {}
+    
+    /// glyph of a character, or NULL if font doesn't have it
+    virtual const void* getGlyph(unsigned short c) = 0;
+    
+    /// pen advance after a glyph
+    virtual float getAdvance(const void* glyph) = 0;
+    
+    /// kerning between two characters
+    virtual float getKerning(unsigned short left, unsigned short right) = 0;
+};
+
+/**
+ * Word wrap and alignment shared by labels which place glyph quads themselves, such as
+ * CCLabelTTF in glyph atlas mode and CCBMFontLabel. Lines break at '\n', and at last space
+ * of line when it exceeds max width, or before the glyph if line has no space.
+ */
+class CC_DLL CCTextLayout {
+public:
+    /// placed glyphs, characters missed in font are skipped
+    vector<ccTextLayoutGlyph> m_glyphs;
+    
+    /// width of every line
+    vector<float> m_lineWidths;
+    
+    /// width of layout box, it is max width if set, or width of longest line
+    float m_width;
+    
+public:
+    CCTextLayout();
+    
+    /**
+     * lay out a string, previous result is cleared
+     *
+     * @param font font of string
+     * @param text utf-16 string
+     * @param len length of string
+     * @param maxWidth max width of line in pixels, 0 means no limit
+     * @param alignment horizontal alignment of lines in layout box
+     */
+    void layout(CCTextLayoutFont* font, const unsigned short* text, int len, float maxWidth, CCTextAlignment alignment);
+    
+    /// count of lines, it is at least 1
+    int getLineCount() { return (int)m_lineWidths.size(); }
+};
+
+NS_CC_END
+
+#endif /* defined(__CCTextLayout__) */
@@ -0,0 +1,165 @@
+/****************************************************************************
+ Author: Luma (stubma@gmail.com)
+
+ https://github.com/stubma/cocos2dx-classical
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+#include "CCTextLayoutCache.h"
+#include "platform/platform.h"
+
+NS_CC_BEGIN
+
+static CCTextLayoutCache* s_sharedTextLayoutCache = NULL;
+
+CCTextLayoutCache::CCTextLayoutCache() :
+m_memoryLimit(CC_TEXT_LAYOUT_CACHE_LIMIT),
+m_memoryUsage(0),
+m_hitCount(0),
+m_missCount(0) {
+}
+
+CCTextLayoutCache::~CCTextLayoutCache() {
+    removeAllObjects();
+}
+
+CCTextLayoutCache* CCTextLayoutCache::sharedTextLayoutCache() {
+    if(!s_sharedTextLayoutCache) {
+        s_sharedTextLayoutCache = new CCTextLayoutCache();
+    }
+    return s_sharedTextLayoutCache;
+}
+
+void CCTextLayoutCache::purgeSharedTextLayoutCache() {
+    CC_SAFE_RELEASE_NULL(s_sharedTextLayoutCache);
+}
+
+string CCTextLayoutCache::keyForTextDefinition(const char* prefix, const string& text, const ccFontDefinition& textDefinition) {
+    char buf[256];
+    string key = prefix;
+    snprintf(buf, sizeof(buf), "|%s|%d|%.1fx%.1f|%d|%d|%02x%02x%02x|%.1f|%.2f|%d",
+             textDefinition.m_fontName.c_str(),
+             textDefinition.m_fontSize,
+             textDefinition.m_dimensions.width,
+             textDefinition.m_dimensions.height,
+             (int)textDefinition.m_alignment,
+             (int)textDefinition.m_vertAlignment,
+             textDefinition.m_fontFillColor.r,
+             textDefinition.m_fontFillColor.g,
+             textDefinition.m_fontFillColor.b,
+             textDefinition.m_lineSpacing,
+             textDefinition.m_globalImageScaleFactor,
+             textDefinition.m_toCharIndex);
+    key += buf;
+    
+    // effect fields are only meaningful when effect is enabled
+    if(textDefinition.m_shadow.m_shadowEnabled) {
+        snprintf(buf, sizeof(buf), "|s%.1f,%.1f,%.1f,%08x",
+                 textDefinition.m_shadow.m_shadowOffset.width,
+                 textDefinition.m_shadow.m_shadowOffset.height,
+                 textDefinition.m_shadow.m_shadowBlur,
+                 textDefinition.m_shadowColor);
+        key += buf;
+    }
+    if(textDefinition.m_stroke.m_strokeEnabled) {
+        snprintf(buf, sizeof(buf), "|k%02x%02x%02x,%.1f",
+                 textDefinition.m_stroke.m_strokeColor.r,
+                 textDefinition.m_stroke.m_strokeColor.g,
+                 textDefinition.m_stroke.m_strokeColor.b,
+                 textDefinition.m_stroke.m_strokeSize);
+        key += buf;
+    }
+    
+    // string is last so it can't be confused with fields
+    key += '|';
+    key += text;
+    return key;
+}
+
+CCObject* CCTextLayoutCache::objectForKey(const string& key) {
+    EntryMap::iterator iter = m_index.find(key);
+    if(iter == m_index.end()) {
+        m_missCount++;
+        return NULL;
+    }
+
+    // move to front
+    m_hitCount++;
+    m_entries.splice(m_entries.begin(), m_entries, iter->second);
+    return iter->second->obj;
+}
+
+void CCTextLayoutCache::setObject(CCObject* obj, const string& key, unsigned int cost) {
+    removeObjectForKey(key);
+    if(!obj || cost > m_memoryLimit)
+        return;
+
+    Entry e;
+    e.key = key;
+    e.obj = obj;
+    e.cost = cost;
+    CC_SAFE_RETAIN(obj);
+    m_entries.push_front(e);
+    m_index[key] = m_entries.begin();
+    m_memoryUsage += cost;
+
+    trim();
+}
+
+void CCTextLayoutCache::removeObjectForKey(const string& key) {
+    EntryMap::iterator iter = m_index.find(key);
+    if(iter == m_index.end())
+        return;
+
+    m_memoryUsage -= iter->second->cost;
+    CC_SAFE_RELEASE(iter->second->obj);
+    m_entries.erase(iter->second);
+    m_index.erase(iter);
+}
+
+void CCTextLayoutCache::removeAllObjects() {
+    for(EntryList::iterator iter = m_entries.begin(); iter != m_entries.end(); iter++) {
+        CC_SAFE_RELEASE(iter->obj);
+    }
+    m_entries.clear();
+    m_index.clear();
+    m_memoryUsage = 0;
+}
+
+void CCTextLayoutCache::trim() {
+    while(m_memoryUsage > m_memoryLimit && !m_entries.empty()) {
+        Entry& e = m_entries.back();
+        m_memoryUsage -= e.cost;
+        CC_SAFE_RELEASE(e.obj);
+        m_index.erase(e.key);
+        m_entries.pop_back();
+    }
+}
+
+void CCTextLayoutCache::setMemoryLimit(unsigned int limit) {
+    m_memoryLimit = limit;
+    trim();
+}
+
+void CCTextLayoutCache::resetCounters() {
+    m_hitCount = 0;
+    m_missCount = 0;
+}
+
+NS_CC_END
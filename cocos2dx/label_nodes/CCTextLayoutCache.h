@@ -0,0 +1,143 @@
+/****************************************************************************
+ Author: Luma (stubma@gmail.com)
+
+ https://github.com/stubma/cocos2dx-classical
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+#ifndef __CCTextLayoutCache__
+#define __CCTextLayoutCache__
+
+#include "cocoa/CCObject.h"
+#include "ccTypes.h"
+#include <string>
+#include <list>
+#include <map>
+
+using namespace std;
+
+NS_CC_BEGIN
+
+/// default memory limit of text layout cache, in bytes
+#define CC_TEXT_LAYOUT_CACHE_LIMIT (16 * 1024 * 1024)
+
+/**
+ * A shared LRU cache of text layout results, so a string which is set again, such as text of
+ * a recycled CCTableView cell, isn't laid out and rendered again. CCLabelTTF caches the texture
+ * of whole string, which also holds link and image rects of rich text, CCBMFontLabel caches
+ * glyph quads.
+ *
+ * \par
+ * Key must contain everything which affects result: string, font, size, dimensions, alignment
+ * and so on. Cost of an entry is the memory it holds, least recently used entries are removed
+ * when total cost exceeds memory limit. A cached texture may still be used by labels after it
+ * is removed from cache.
+ */
+class CC_DLL CCTextLayoutCache : public CCObject {
+private:
+    /// a cached result
+    struct Entry {
+        string key;
+        CCObject* obj;
+        unsigned int cost;
+    };
+    typedef list<Entry> EntryList;
+    typedef map<string, EntryList::iterator> EntryMap;
+
+    /// entries, most recently used first
+    EntryList m_entries;
+
+    /// index of entries
+    EntryMap m_index;
+
+    /// memory limit and usage, in bytes
+    unsigned int m_memoryLimit;
+    unsigned int m_memoryUsage;
+
+    /// counters
+    unsigned int m_hitCount;
+    unsigned int m_missCount;
+
+protected:
+    CCTextLayoutCache();
+
+    /// remove least recently used entries until usage is in limit
+    void trim();
+
+public:
+    virtual ~CCTextLayoutCache();
+
+    /// get shared instance
+    static CCTextLayoutCache* sharedTextLayoutCache();
+
+    /// release shared instance
+    static void purgeSharedTextLayoutCache();
+
+    /**
+     * build key of a string rendered with a text definition
+     *
+     * @param prefix type of result, so different label classes don't share entries
+     * @param text string
+     * @param textDefinition text definition used to render string
+     */
+    static string keyForTextDefinition(const char* prefix, const string& text, const ccFontDefinition& textDefinition);
+
+    /**
+     * get a cached result, it is moved to front of LRU list
+     *
+     * @param key key of result
+     * @return cached object, or NULL if it is not cached. It is not retained
+     */
+    CCObject* objectForKey(const string& key);
+
+    /**
+     * cache a result, replace old one of same key. If cost is larger than memory limit,
+     * it is not cached
+     *
+     * @param obj result object, it will be retained
+     * @param key key of result
+     * @param cost memory held by result, in bytes
+     */
+    void setObject(CCObject* obj, const string& key, unsigned int cost);
+
+    /// remove a result
+    void removeObjectForKey(const string& key);
+
+    /// remove all results
+    void removeAllObjects();
+
+    /// memory limit in bytes, 0 disables cache
+    void setMemoryLimit(unsigned int limit);
+    unsigned int getMemoryLimit() { return m_memoryLimit; }
+
+    /// memory held by cached results, in bytes
+    unsigned int getMemoryUsage() { return m_memoryUsage; }
+
+    /// count of cached results
+    unsigned int getCount() { return (unsigned int)m_entries.size(); }
+
+    /// hit and miss count of objectForKey since last reset
+    unsigned int getHitCount() { return m_hitCount; }
+    unsigned int getMissCount() { return m_missCount; }
+    void resetCounters();
+};
+
+NS_CC_END
+
+#endif /* defined(__CCTextLayoutCache__) */
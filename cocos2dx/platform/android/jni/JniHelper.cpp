@@ -78,6 +78,44 @@ extern "C"
         return bRet;
     }
 
+    // class loader of application classes, FindClass in a thread attached
+    // from native code only sees system classes
+    static jobject s_classLoader = 0;
+    static jmethodID s_loadClassMethod = 0;
+
+    static void cacheClassLoader(JNIEnv *pEnv, jclass appClass)
+    {
+        jclass classClass = pEnv->GetObjectClass(appClass);
+        jmethodID getClassLoader = pEnv->GetMethodID(classClass, "getClassLoader", "()Ljava/lang/ClassLoader;");
+        jobject loader = pEnv->CallObjectMethod(appClass, getClassLoader);
+        jclass loaderClass = pEnv->FindClass("java/lang/ClassLoader");
+        s_loadClassMethod = pEnv->GetMethodID(loaderClass, "loadClass", "(Ljava/lang/String;)Ljava/lang/Class;");
+        s_classLoader = pEnv->NewGlobalRef(loader);
+        pEnv->DeleteLocalRef(loader);
+        pEnv->DeleteLocalRef(loaderClass);
+        pEnv->DeleteLocalRef(classClass);
+    }
+
+    static jclass loadClass(JNIEnv *pEnv, const char *className)
+    {
+        // class loader wants a binary name
+        string name = className;
+        for (string::iterator iter = name.begin(); iter != name.end(); iter++)
+        {
+            if (*iter == '/')
+                *iter = '.';
+        }
+        jstring jname = pEnv->NewStringUTF(name.c_str());
+        jclass ret = (jclass)pEnv->CallObjectMethod(s_classLoader, s_loadClassMethod, jname);
+        pEnv->DeleteLocalRef(jname);
+        if (pEnv->ExceptionCheck())
+        {
+            pEnv->ExceptionClear();
+            ret = 0;
+        }
+        return ret;
+    }
+
     static jclass getClassID_(const char *className, JNIEnv *env)
     {
         JNIEnv *pEnv = env;
@@ -95,6 +133,19 @@ extern "C"
             
             ret = pEnv->FindClass(className);
             if (! ret)
+            {
+                // worker thread, try application class loader
+                pEnv->ExceptionClear();
+                if (s_classLoader)
+                {
+                    ret = loadClass(pEnv, className);
+                }
+            }
+            else if (! s_classLoader)
+            {
+                cacheClassLoader(pEnv, ret);
+            }
+            if (! ret)
             {
                  LOGD("Failed to find class of %s", className);
                 break;
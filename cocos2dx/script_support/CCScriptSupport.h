@@ -222,6 +222,29 @@ public:
     /** execute a schedule function */
     virtual int executeSchedule(ccScriptFunction& func, float dt) = 0;
     
+    /** 
+     * deliver schedule functions which are queued by engine in batch mode. It is called by scheduler
+     * at the end of every update, engine which doesn't batch can ignore it
+     */
+    virtual void flushScheduleBatch() {};
+    
+    /**
+     * called by director at the end of every frame, before buffers are swapped. Engine can use
+     * spare time of frame, such as collecting garbage
+     *
+     * @param timeLeft seconds left until next frame, 0 if frame is late
+     */
+    virtual void onFrameEnd(float timeLeft) {};
+    
+    /**
+     * get garbage collection counters, for stats display
+     *
+     * @param gcTime seconds spent in collection at the end of last frame
+     * @param heapSize script heap size in KB
+     * @return false if engine doesn't provide them
+     */
+    virtual bool getGCStats(float* gcTime, unsigned int* heapSize) { return false; };
+    
     /** functions for executing touch event */
     virtual int executeLayerTouchesEvent(CCLayer* pLayer, const char* pEventName, CCSet *pTouches) = 0;
     virtual int executeLayerTouchEvent(CCLayer* pLayer, const char* pEventName, CCTouch *pTouch) = 0;
@@ -45,6 +45,47 @@ NS_CC_BEGIN
 
 static CCSpriteFrameCache *pSharedSpriteFrameCache = NULL;
 
+/*
+ * Binary sprite sheet, generated from plist by tools/sfb/plist2sfb.py. All values
+ * are little endian and 4 bytes aligned, so data can be used in place after one read.
+ *
+ * layout:
+ *   header
+ *   frames, frameCount entries, values are normalized to CCSpriteFrame::initWithTexture
+ *   aliases, aliasCount entries
+ *   string table, NUL terminated strings, referred by offset in table
+ */
+#define SFB_MAGIC 0x42465343 // "CSFB"
+#define SFB_VERSION 1
+#define SFB_NO_STRING 0xffffffff
+
+typedef struct _tSFBHeader {
+    unsigned int magic;
+    unsigned short version;
+    unsigned short flags;
+    unsigned int frameCount;
+    unsigned int aliasCount;
+    unsigned int stringTableSize;
+    unsigned int textureName;
+} tSFBHeader;
+
+typedef struct _tSFBFrame {
+    unsigned int name;
+    float x, y, width, height;
+    float offsetX, offsetY;
+    float sourceWidth, sourceHeight;
+    unsigned int rotated;
+} tSFBFrame;
+
+typedef struct _tSFBAlias {
+    unsigned int name;
+    unsigned int frame;
+} tSFBAlias;
+
+#define SFB_FRAMES(h) ((const tSFBFrame*)((const char*)(h) + sizeof(tSFBHeader)))
+#define SFB_ALIASES(h) ((const tSFBAlias*)(SFB_FRAMES(h) + (h)->frameCount))
+#define SFB_STRINGS(h) ((const char*)(SFB_ALIASES(h) + (h)->aliasCount))
+
 CCSpriteFrameCache* CCSpriteFrameCache::sharedSpriteFrameCache(void)
 {
     if (! pSharedSpriteFrameCache)
@@ -201,12 +242,126 @@ void CCSpriteFrameCache::addSpriteFramesWithDictionary(CCDictionary* dictionary,
     }
 }
 
+std::string CCSpriteFrameCache::binaryPathForPlist(const char* pszPlist)
+{
+    std::string binPath = pszPlist;
+    size_t startPos = binPath.find_last_of(".");
+    if (startPos != std::string::npos)
+    {
+        binPath.erase(startPos);
+    }
+    binPath.append(".sfb");
+    
+    CCFileUtils* fu = CCFileUtils::sharedFileUtils();
+    binPath = fu->fullPathForFilename(binPath.c_str());
+    if (!fu->isFileExist(binPath))
+    {
+        binPath.clear();
+    }
+    return binPath;
+}
+
+unsigned char* CCSpriteFrameCache::loadBinary(const std::string& path)
+{
+    size_t size = 0;
+    unsigned char* data = CCFileUtils::sharedFileUtils()->getFileData(path.c_str(), "rb", &size);
+    if (!data)
+    {
+        return NULL;
+    }
+    
+    // validate header and string table, so frame loop needn't check anything
+    const tSFBHeader* header = (const tSFBHeader*)data;
+    bool valid = size >= sizeof(tSFBHeader) &&
+        header->magic == SFB_MAGIC &&
+        header->version == SFB_VERSION &&
+        header->frameCount <= size / sizeof(tSFBFrame) &&
+        header->aliasCount <= size / sizeof(tSFBAlias) &&
+        size == sizeof(tSFBHeader) + header->frameCount * sizeof(tSFBFrame) + header->aliasCount * sizeof(tSFBAlias) + header->stringTableSize &&
+        header->stringTableSize > 0;
+    if (valid)
+    {
+        const char* strings = SFB_STRINGS(header);
+        valid = strings[header->stringTableSize - 1] == '\0' &&
+            (header->textureName == SFB_NO_STRING || header->textureName < header->stringTableSize);
+        const tSFBFrame* frames = SFB_FRAMES(header);
+        for (unsigned int i = 0; valid && i < header->frameCount; i++)
+        {
+            valid = frames[i].name < header->stringTableSize;
+        }
+        const tSFBAlias* aliases = SFB_ALIASES(header);
+        for (unsigned int i = 0; valid && i < header->aliasCount; i++)
+        {
+            valid = aliases[i].name < header->stringTableSize && aliases[i].frame < header->frameCount;
+        }
+    }
+    
+    if (!valid)
+    {
+        CCLOGWARN("cocos2d: CCSpriteFrameCache: invalid binary sprite sheet %s", path.c_str());
+        delete[] data;
+        return NULL;
+    }
+    return data;
+}
+
+void CCSpriteFrameCache::addSpriteFramesWithBinary(const unsigned char* data, CCTexture2D *pobTexture)
+{
+    const tSFBHeader* header = (const tSFBHeader*)data;
+    const tSFBFrame* frames = SFB_FRAMES(header);
+    const char* strings = SFB_STRINGS(header);
+    
+    for (unsigned int i = 0; i < header->frameCount; i++)
+    {
+        const tSFBFrame& f = frames[i];
+        const char* name = strings + f.name;
+        if (m_pSpriteFrames->objectForKey(name))
+        {
+            continue;
+        }
+        
+        CCSpriteFrame* spriteFrame = new CCSpriteFrame();
+        spriteFrame->initWithTexture(pobTexture,
+                                     CCRectMake(f.x, f.y, f.width, f.height),
+                                     f.rotated != 0,
+                                     CCPointMake(f.offsetX, f.offsetY),
+                                     CCSizeMake(f.sourceWidth, f.sourceHeight));
+        m_pSpriteFrames->setObject(spriteFrame, name);
+        CC_SAFE_RELEASE(spriteFrame);
+    }
+    
+    const tSFBAlias* aliases = SFB_ALIASES(header);
+    for (unsigned int i = 0; i < header->aliasCount; i++)
+    {
+        const char* alias = strings + aliases[i].name;
+        if (m_pSpriteFramesAliases->objectForKey(alias))
+        {
+            CCLOGWARN("cocos2d: WARNING: an alias with name %s already exists", alias);
+        }
+        CCString* frameKey = new CCString(strings + frames[aliases[i].frame].name);
+        m_pSpriteFramesAliases->setObject(frameKey, alias);
+        CC_SAFE_RELEASE(frameKey);
+    }
+}
+
 void CCSpriteFrameCache::addSpriteFramesWithFile(const char *pszPlist, CCTexture2D *pobTexture)
 {
     if (m_pLoadedFileNames->find(pszPlist) != m_pLoadedFileNames->end())
     {
         return;//We already added it
     }
+    
+    // prefer binary sprite sheet
+    std::string binPath = binaryPathForPlist(pszPlist);
+    unsigned char* data = binPath.empty() ? NULL : loadBinary(binPath);
+    if (data)
+    {
+        addSpriteFramesWithBinary(data, pobTexture);
+        m_pLoadedFileNames->insert(pszPlist);
+        delete[] data;
+        return;
+    }
+    
     std::string fullPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(pszPlist);
     CCDictionary *dict = CCDictionary::createWithContentsOfFileThreadSafe(fullPath.c_str());
 
@@ -237,6 +392,41 @@ void CCSpriteFrameCache::addSpriteFramesWithFile(const char *pszPlist)
 
     if (m_pLoadedFileNames->find(pszPlist) == m_pLoadedFileNames->end())
     {
+        // prefer binary sprite sheet
+        std::string binPath = binaryPathForPlist(pszPlist);
+        unsigned char* data = binPath.empty() ? NULL : loadBinary(binPath);
+        if (data)
+        {
+            const tSFBHeader* header = (const tSFBHeader*)data;
+            string texturePath;
+            if (header->textureName != SFB_NO_STRING)
+            {
+                // build texture path relative to plist file
+                texturePath = CCFileUtils::sharedFileUtils()->fullPathFromRelativeFile(SFB_STRINGS(header) + header->textureName, pszPlist);
+            }
+            else
+            {
+                // build texture path by replacing file extension
+                texturePath = pszPlist;
+                size_t startPos = texturePath.find_last_of(".");
+                texturePath = texturePath.erase(startPos);
+                texturePath = texturePath.append(".png");
+            }
+            
+            CCTexture2D *pTexture = CCTextureCache::sharedTextureCache()->addImage(texturePath.c_str());
+            if (pTexture)
+            {
+                addSpriteFramesWithBinary(data, pTexture);
+                m_pLoadedFileNames->insert(pszPlist);
+            }
+            else
+            {
+                CCLOG("cocos2d: CCSpriteFrameCache: Couldn't load texture");
+            }
+            delete[] data;
+            return;
+        }
+        
         std::string fullPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(pszPlist);
         CCDictionary *dict = CCDictionary::createWithContentsOfFileThreadSafe(fullPath.c_str());
 
@@ -348,10 +538,20 @@ void CCSpriteFrameCache::removeSpriteFrameByName(const char *pszName)
 
 void CCSpriteFrameCache::removeSpriteFramesFromFile(const char* plist)
 {
-    std::string fullPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(plist);
-    CCDictionary* dict = CCDictionary::createWithContentsOfFileThreadSafe(fullPath.c_str());
-
-    removeSpriteFramesFromDictionary((CCDictionary*)dict);
+    std::string binPath = binaryPathForPlist(plist);
+    unsigned char* data = binPath.empty() ? NULL : loadBinary(binPath);
+    CCDictionary* dict = NULL;
+    if (data)
+    {
+        removeSpriteFramesFromBinary(data);
+        delete[] data;
+    }
+    else
+    {
+        std::string fullPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(plist);
+        dict = CCDictionary::createWithContentsOfFileThreadSafe(fullPath.c_str());
+        removeSpriteFramesFromDictionary((CCDictionary*)dict);
+    }
 
     // remove it from the cache
     set<string>::iterator ret = m_pLoadedFileNames->find(plist);
@@ -380,6 +580,17 @@ void CCSpriteFrameCache::removeSpriteFramesFromDictionary(CCDictionary* dictiona
     m_pSpriteFrames->removeObjectsForKeys(keysToRemove);
 }
 
+void CCSpriteFrameCache::removeSpriteFramesFromBinary(const unsigned char* data)
+{
+    const tSFBHeader* header = (const tSFBHeader*)data;
+    const tSFBFrame* frames = SFB_FRAMES(header);
+    const char* strings = SFB_STRINGS(header);
+    for (unsigned int i = 0; i < header->frameCount; i++)
+    {
+        m_pSpriteFrames->removeObjectForKey(strings + frames[i].name);
+    }
+}
+
 void CCSpriteFrameCache::removeSpriteFramesFromTexture(CCTexture2D* texture)
 {
     CCArray* keysToRemove = CCArray::create();
@@ -32,6 +32,9 @@ THE SOFTWARE.
 /*
  * To create sprite frames and texture atlas, use this tool:
  * http://zwoptex.zwopple.com/
+ *
+ * A plist can be precompiled to binary sprite sheet (.sfb) with tools/sfb/plist2sfb.py.
+ * When a .sfb file exists beside the plist, it is loaded instead of plist.
  */
 
 #include "sprite_nodes/CCSpriteFrame.h"
@@ -75,6 +78,18 @@ private:
     /*Adds multiple Sprite Frames with a dictionary. The texture will be associated with the created sprite frames.
      */
     void addSpriteFramesWithDictionary(CCDictionary* pobDictionary, CCTexture2D *pobTexture);
+    
+    /* Adds multiple Sprite Frames with binary sprite sheet data. The texture will be associated with the created sprite frames.
+     */
+    void addSpriteFramesWithBinary(const unsigned char* data, CCTexture2D *pobTexture);
+    
+    /* Get full path of binary sprite sheet for a plist, or empty string if no binary sheet
+     */
+    std::string binaryPathForPlist(const char* pszPlist);
+    
+    /* Load and validate binary sprite sheet, returns NULL if file is invalid. Caller should delete[] it.
+     */
+    unsigned char* loadBinary(const std::string& path);
 public:
     /** Adds multiple Sprite Frames from a plist file.
      * A texture will be loaded automatically. The texture name will composed by replacing the .plist suffix with .png
@@ -130,6 +145,10 @@ private:
     * @since v0.99.5
     */
     void removeSpriteFramesFromDictionary(CCDictionary* dictionary);
+    
+    /* Removes multiple Sprite Frames listed in binary sprite sheet data.
+     */
+    void removeSpriteFramesFromBinary(const unsigned char* data);
 public:
     /** Removes all Sprite Frames associated with the specified textures.
     * It is convenient to call this method when a specific texture needs to be removed.
@@ -84,20 +84,12 @@ bool CCComponentContainer::remove(const char *pName)
     do 
     {        
         CC_BREAK_IF(!m_pComponents);
-        CCObject* pRetObject = NULL;
-        CCDictElement *pElement = NULL;
-        HASH_FIND_PTR(m_pComponents->m_pElements, pName, pElement);
-        if (pElement != NULL)
-        {
-           pRetObject = pElement->getObject();
-        }
+        CCObject* pRetObject = m_pComponents->objectForKey(pName);
         CCComponent *com = dynamic_cast<CCComponent*>(pRetObject);
         CC_BREAK_IF(!com);
         com->onExit();
         com->setOwner(NULL);
-        HASH_DEL(m_pComponents->m_pElements, pElement);
-        CC_SAFE_RELEASE(pElement->getObject());
-        CC_SAFE_DELETE(pElement);
+        m_pComponents->removeObjectForKey(pName);
         bRet = true;
     } while(0);
     return bRet;
@@ -110,16 +102,13 @@ bool CCComponentContainer::remove(CCComponent *pCom)
     { 
         CC_BREAK_IF(!m_pComponents);
         CCDictElement *pElement = NULL;
-        CCDictElement *tmp = NULL;
-        HASH_ITER(hh, m_pComponents->m_pElements, pElement, tmp)
+        CCDICT_FOREACH(m_pComponents, pElement)
         {
             if (pElement->getObject() == pCom)
             {
                 pCom->onExit();
                 pCom->setOwner(NULL);
-                HASH_DEL(m_pComponents->m_pElements, pElement);
-                CC_SAFE_RELEASE(pElement->getObject());
-                CC_SAFE_DELETE(pElement);
+                m_pComponents->removeObjectForElememt(pElement);
                 break;
             }
         }
@@ -132,15 +121,13 @@ void CCComponentContainer::removeAll()
 {
     if (m_pComponents != NULL)
     {
-        CCDictElement *pElement, *tmp;
-        HASH_ITER(hh, m_pComponents->m_pElements, pElement, tmp)
+        CCDictElement *pElement = NULL;
+        CCDICT_FOREACH(m_pComponents, pElement)
         {
-            HASH_DEL(m_pComponents->m_pElements, pElement);
             ((CCComponent*)pElement->getObject())->onExit();
             ((CCComponent*)pElement->getObject())->setOwner(NULL);
-            CC_SAFE_RELEASE(pElement->getObject());
-            CC_SAFE_DELETE(pElement);
         }
+        m_pComponents->removeAllObjects();
         m_pOwner->unscheduleUpdate();
     }
 }
@@ -155,8 +142,8 @@ void CCComponentContainer::visit(float fDelta)
 {
     if (m_pComponents != NULL)
     {
-        CCDictElement *pElement, *tmp;
-        HASH_ITER(hh, m_pComponents->m_pElements, pElement, tmp)
+        CCDictElement *pElement = NULL;
+        CCDICT_FOREACH(m_pComponents, pElement)
         {
             ((CCComponent*)pElement->getObject())->update(fDelta);
         }
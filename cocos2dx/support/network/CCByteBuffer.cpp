@@ -23,16 +23,170 @@
  ****************************************************************************/
 #include "CCByteBuffer.h"
 #include "cocoa/CCString.h"
+#include <pthread.h>
 
 NS_CC_BEGIN
 
 #define DEFAULT_SIZE 0x1000
 
+/// chunks in a slab
+#define CHUNKS_PER_SLAB 16
+
+/// max empty slabs kept by pool
+#define MAX_EMPTY_SLABS 4
+
+struct ccByteSlab;
+
+/// a chunk of chunked buffer, data follows it
+struct ccByteChunk {
+    /// slab which chunk belongs to
+    ccByteSlab* slab;
+    
+    /// next free chunk in slab
+    ccByteChunk* next;
+    
+    /// data range, begin is not zero if chunk is partially read when it is moved
+    size_t begin;
+    size_t end;
+    
+    uint8* data() { return (uint8*)(this + 1); }
+    size_t length() { return end - begin; }
+};
+
+/// a slab is allocated once and cut into chunks, chunks follow it
+struct ccByteSlab {
+    /// link of slabs which have free chunks
+    ccByteSlab* prev;
+    ccByteSlab* next;
+    
+    /// free chunks
+    ccByteChunk* freeChunks;
+    int freeCount;
+};
+
+/**
+ * shared pool of chunks. Buffers are filled in network thread and consumed in other threads,
+ * so it is locked. A slab is freed when all its chunks are returned, except a few which are
+ * kept for next use
+ */
+class CCByteChunkPool {
+private:
+    pthread_mutex_t m_mutex;
+    
+    /// slabs which have free chunks
+    ccByteSlab* m_available;
+    
+    /// count of slabs whose chunks are all free
+    int m_emptySlabs;
+    
+private:
+    void link(ccByteSlab* slab) {
+        slab->prev = NULL;
+        slab->next = m_available;
+        if(m_available)
+            m_available->prev = slab;
+        m_available = slab;
+    }
+    
+    void unlink(ccByteSlab* slab) {
+        if(slab->prev)
+            slab->prev->next = slab->next;
+        else
+            m_available = slab->next;
+        if(slab->next)
+            slab->next->prev = slab->prev;
+        slab->prev = slab->next = NULL;
+    }
+    
+    ccByteSlab* newSlab() {
+        size_t chunkSize = sizeof(ccByteChunk) + CC_BYTE_BUFFER_CHUNK_SIZE;
+        ccByteSlab* slab = (ccByteSlab*)malloc(sizeof(ccByteSlab) + chunkSize * CHUNKS_PER_SLAB);
+        slab->freeChunks = NULL;
+        slab->freeCount = CHUNKS_PER_SLAB;
+        uint8* p = (uint8*)(slab + 1);
+        for(int i = 0; i < CHUNKS_PER_SLAB; i++, p += chunkSize) {
+            ccByteChunk* c = (ccByteChunk*)p;
+            c->slab = slab;
+            c->next = slab->freeChunks;
+            slab->freeChunks = c;
+        }
+        return slab;
+    }
+    
+public:
+    CCByteChunkPool() :
+    m_available(NULL),
+    m_emptySlabs(0) {
+        pthread_mutex_init(&m_mutex, NULL);
+    }
+    
+    ccByteChunk* alloc() {
+        pthread_mutex_lock(&m_mutex);
+        ccByteSlab* slab = m_available;
+        if(!slab) {
+            slab = newSlab();
+            link(slab);
+            m_emptySlabs++;
+        }
+        if(slab->freeCount == CHUNKS_PER_SLAB)
+            m_emptySlabs--;
+        ccByteChunk* c = slab->freeChunks;
+        slab->freeChunks = c->next;
+        if(--slab->freeCount == 0)
+            unlink(slab);
+        pthread_mutex_unlock(&m_mutex);
+        
+        c->next = NULL;
+        c->begin = c->end = 0;
+        return c;
+    }
+    
+    void free(ccByteChunk* c) {
+        pthread_mutex_lock(&m_mutex);
+        ccByteSlab* slab = c->slab;
+        if(slab->freeCount == 0)
+            link(slab);
+        c->next = slab->freeChunks;
+        slab->freeChunks = c;
+        if(++slab->freeCount == CHUNKS_PER_SLAB) {
+            if(m_emptySlabs < MAX_EMPTY_SLABS) {
+                m_emptySlabs++;
+            } else {
+                unlink(slab);
+                ::free(slab);
+            }
+        }
+        pthread_mutex_unlock(&m_mutex);
+    }
+    
+    void trim() {
+        pthread_mutex_lock(&m_mutex);
+        ccByteSlab* slab = m_available;
+        while(slab) {
+            ccByteSlab* next = slab->next;
+            if(slab->freeCount == CHUNKS_PER_SLAB) {
+                unlink(slab);
+                ::free(slab);
+            }
+            slab = next;
+        }
+        m_emptySlabs = 0;
+        pthread_mutex_unlock(&m_mutex);
+    }
+};
+
+static CCByteChunkPool s_chunkPool;
+
 CCByteBuffer::CCByteBuffer() :
 m_buffer(NULL),
 m_readPos(0),
 m_writePos(0),
-m_external(false) {
+m_bufferSize(0),
+m_external(false),
+m_chunked(false),
+m_readChunk(0),
+m_readOffset(0),
+m_writeChunk(0) {
 	reserve(DEFAULT_SIZE);
 }
 
@@ -40,7 +194,12 @@ CCByteBuffer::CCByteBuffer(size_t res) :
 m_buffer(NULL),
 m_readPos(0),
 m_writePos(0),
-m_external(false) {
+m_bufferSize(0),
+m_external(false),
+m_chunked(false),
+m_readChunk(0),
+m_readOffset(0),
+m_writeChunk(0) {
 	reserve(res);
 }
 
@@ -48,23 +207,40 @@ CCByteBuffer::CCByteBuffer(const CCByteBuffer& b) :
 m_buffer(NULL),
 m_readPos(0),
 m_writePos(0),
-m_external(false) {
-	reserve(b.m_bufferSize);
-	memcpy(b.m_buffer, m_buffer, b.m_writePos);
-	m_readPos = b.m_readPos;
-	m_writePos = b.m_writePos;
+m_bufferSize(0),
+m_external(false),
+m_chunked(b.m_chunked),
+m_readChunk(0),
+m_readOffset(0),
+m_writeChunk(0) {
+    if(m_chunked) {
+        for(vector<ccByteChunk*>::const_iterator iter = b.m_chunks.begin(); iter != b.m_chunks.end(); iter++) {
+            write((*iter)->data() + (*iter)->begin, (*iter)->length());
+        }
+        setReadPos(b.m_readPos);
+    } else {
+        reserve(b.m_bufferSize);
+        memcpy(m_buffer, b.m_buffer, b.m_writePos);
+        m_readPos = b.m_readPos;
+        m_writePos = b.m_writePos;
+    }
 }
 
 CCByteBuffer::CCByteBuffer(const char* buf, size_t bufSize, size_t dataLen) :
 m_buffer((uint8*)buf),
 m_readPos(0),
 m_writePos(dataLen),
+m_bufferSize(bufSize),
 m_external(true),
-m_bufferSize(bufSize) {
+m_chunked(false),
+m_readChunk(0),
+m_readOffset(0),
+m_writeChunk(0) {
     
 }
 
 CCByteBuffer::~CCByteBuffer() {
+    releaseChunks();
     if(!m_external) {
         CC_SAFE_FREE(m_buffer);
     }
@@ -80,6 +256,88 @@ CCByteBuffer* CCByteBuffer::create(size_t res) {
 	CC_SAFE_AUTORELEASE_RETURN(b, CCByteBuffer*);
 }
 
+CCByteBuffer* CCByteBuffer::createChunked() {
+    CCByteBuffer* b = new CCByteBuffer((size_t)0);
+    b->initChunked();
+    CC_SAFE_AUTORELEASE_RETURN(b, CCByteBuffer*);
+}
+
+void CCByteBuffer::initChunked() {
+    clear();
+    if(!m_external) {
+        CC_SAFE_FREE(m_buffer);
+    }
+    m_buffer = NULL;
+    m_bufferSize = 0;
+    m_external = false;
+    m_chunked = true;
+}
+
+void CCByteBuffer::trimChunkPool() {
+    s_chunkPool.trim();
+}
+
+void CCByteBuffer::clear() {
+    releaseChunks();
+    m_readPos = m_writePos = 0;
+}
+
+const uint8* CCByteBuffer::getBuffer() {
+    if(m_chunked)
+        linearize();
+    return m_buffer;
+}
+
+void CCByteBuffer::releaseChunks() {
+    for(vector<ccByteChunk*>::iterator iter = m_chunks.begin(); iter != m_chunks.end(); iter++) {
+        s_chunkPool.free(*iter);
+    }
+    m_chunks.clear();
+    m_readChunk = 0;
+    m_readOffset = 0;
+    m_writeChunk = 0;
+}
+
+void CCByteBuffer::releaseReservedChunks() {
+    // chunks after write chunk have no data, write chunk may have
+    while(m_chunks.size() > m_writeChunk) {
+        ccByteChunk* c = m_chunks.back();
+        if(c->length() > 0)
+            break;
+        s_chunkPool.free(c);
+        m_chunks.pop_back();
+    }
+}
+
+void CCByteBuffer::linearize() {
+    size_t size = MAX(m_writePos, (size_t)DEFAULT_SIZE);
+    uint8* buf = (uint8*)malloc(size);
+    size_t pos = 0;
+    for(vector<ccByteChunk*>::iterator iter = m_chunks.begin(); iter != m_chunks.end(); iter++) {
+        ccByteChunk* c = *iter;
+        memcpy(buf + pos, c->data() + c->begin, c->length());
+        pos += c->length();
+    }
+    releaseChunks();
+    m_chunked = false;
+    m_buffer = buf;
+    m_bufferSize = size;
+}
+
+void CCByteBuffer::seekReadChunk() {
+    // stay in last chunk, so next write can extend it
+    while(m_readChunk < m_writeChunk && m_readChunk + 1 < m_chunks.size() && m_readOffset >= m_chunks[m_readChunk]->length()) {
+        m_readOffset -= m_chunks[m_readChunk]->length();
+        m_readChunk++;
+    }
+}
+
+void CCByteBuffer::advanceRead(size_t len) {
+    m_readPos += len;
+    m_readOffset += len;
+    seekReadChunk();
+}
+
 void CCByteBuffer::reserve(size_t res) {
     if(m_external)
         return;
@@ -93,7 +351,25 @@ void CCByteBuffer::reserve(size_t res) {
 }
 
 void CCByteBuffer::compact() {
-    if(m_readPos > 0) {
+    if(m_chunked) {
+        if(available() == 0) {
+            clear();
+            return;
+        }
+        
+        // release read chunks, rest of read chunk is kept
+        seekReadChunk();
+        for(size_t i = 0; i < m_readChunk; i++) {
+            s_chunkPool.free(m_chunks[i]);
+        }
+        m_chunks.erase(m_chunks.begin(), m_chunks.begin() + m_readChunk);
+        m_writeChunk -= m_readChunk;
+        m_chunks[0]->begin += m_readOffset;
+        m_writePos -= m_readPos;
+        m_readPos = 0;
+        m_readChunk = 0;
+        m_readOffset = 0;
+    } else if(m_readPos > 0) {
         memmove(m_buffer, m_buffer + m_readPos, available());
         m_writePos -= m_readPos;
         m_readPos = 0;
@@ -103,6 +379,21 @@ void CCByteBuffer::compact() {
 size_t CCByteBuffer::read(uint8 * buffer, size_t len) {
 	if(m_readPos + len > m_writePos)
 		len = (m_writePos - m_readPos);
+    
+    if(m_chunked) {
+        size_t done = 0;
+        while(done < len) {
+            seekReadChunk();
+            ccByteChunk* c = m_chunks[m_readChunk];
+            size_t n = MIN(len - done, c->length() - m_readOffset);
+            memcpy(buffer + done, c->data() + c->begin + m_readOffset, n);
+            done += n;
+            m_readOffset += n;
+        }
+        m_readPos += len;
+        seekReadChunk();
+        return len;
+    }
 	
 	memcpy(buffer, &m_buffer[m_readPos], len);
 	m_readPos += len;
@@ -135,7 +426,7 @@ void CCByteBuffer::readPascalString(string& dest) {
 void CCByteBuffer::readLine(string& dest) {
 	dest.clear();
 	char c;
-	while(m_readPos < m_bufferSize)	{
+	while(available() > 0)	{
 		c = read<char>();
 		if(c == '\r')
 			continue;
@@ -146,6 +437,23 @@ void CCByteBuffer::readLine(string& dest) {
 }
 
 void CCByteBuffer::write(const uint8* data, size_t size) {
+    if(m_chunked) {
+        while(size > 0) {
+            if(m_writeChunk == m_chunks.size())
+                m_chunks.push_back(s_chunkPool.alloc());
+            ccByteChunk* c = m_chunks[m_writeChunk];
+            size_t n = MIN(size, CC_BYTE_BUFFER_CHUNK_SIZE - c->end);
+            memcpy(c->data() + c->end, data, n);
+            c->end += n;
+            data += n;
+            size -= n;
+            m_writePos += n;
+            if(c->end == CC_BYTE_BUFFER_CHUNK_SIZE)
+                m_writeChunk++;
+        }
+        return;
+    }
+    
 	size_t new_size = m_writePos + size;
 	if(new_size > m_bufferSize) {
         if(m_external) {
@@ -165,6 +473,11 @@ void CCByteBuffer::write(const string& value) {
 }
 
 void CCByteBuffer::writeCString(const string& value) {
+    if(m_chunked) {
+        write((const uint8*)value.c_str(), value.length() + 1);
+        return;
+    }
+    
     if(m_writePos + value.length() + 1 > m_bufferSize) {
         if(m_external) {
             CCLOGWARN("external mode: buffer size is not enough to write");
@@ -178,6 +491,12 @@ void CCByteBuffer::writeCString(const string& value) {
 }
 
 void CCByteBuffer::writePascalString(const string& value) {
+    if(m_chunked) {
+        write<uint16>(value.length());
+        write((const uint8*)value.c_str(), value.length());
+        return;
+    }
+    
     if(m_writePos + value.length() + sizeof(uint16) > m_bufferSize) {
         if(m_external) {
             CCLOGWARN("external mode: buffer size is not enough to write");
@@ -192,6 +511,12 @@ void CCByteBuffer::writePascalString(const string& value) {
 }
 
 void CCByteBuffer::writeLine(const string& value) {
+    if(m_chunked) {
+        write((const uint8*)value.c_str(), value.length());
+        write((const uint8*)"\r\n", 2);
+        return;
+    }
+    
     if(m_writePos + value.length() + 2 * sizeof(char) > m_bufferSize) {
         if(m_external) {
             CCLOGWARN("external mode: buffer size is not enough to write");
@@ -209,12 +534,165 @@ void CCByteBuffer::writeLine(const string& value) {
 void CCByteBuffer::skip(size_t len) {
 	if(m_readPos + len > m_writePos)
 		len = (m_writePos - m_readPos);
-	m_readPos += len;
+    if(m_chunked)
+        advanceRead(len);
+    else
+        m_readPos += len;
 }
 
 void CCByteBuffer::revoke(size_t len) {
-    m_readPos -= len;
-    m_readPos = MAX(0, m_readPos);
+    setReadPos(m_readPos - MIN(len, m_readPos));
+}
+
+void CCByteBuffer::setReadPos(size_t p) {
+    if(p > m_writePos)
+        return;
+    m_readPos = p;
+    if(m_chunked) {
+        m_readChunk = 0;
+        m_readOffset = p;
+        seekReadChunk();
+    }
+}
+
+void CCByteBuffer::setWritePos(size_t p) {
+    if(!m_chunked) {
+        if(p <= m_bufferSize)
+            m_writePos = p;
+        return;
+    }
+    
+    // forward only in reserved space
+    if(p >= m_writePos) {
+        commitWrite(p - m_writePos);
+        return;
+    }
+    
+    // drop data after p, chunks after it become reserved
+    size_t pos = 0;
+    size_t i = 0;
+    for(; i < m_chunks.size(); i++) {
+        ccByteChunk* c = m_chunks[i];
+        if(pos + c->length() >= p) {
+            c->end = c->begin + (p - pos);
+            break;
+        }
+        pos += c->length();
+    }
+    for(size_t j = i + 1; j < m_chunks.size(); j++) {
+        m_chunks[j]->begin = m_chunks[j]->end = 0;
+    }
+    m_writeChunk = m_chunks[i]->end == CC_BYTE_BUFFER_CHUNK_SIZE ? i + 1 : i;
+    m_writePos = p;
+    
+    // read chunk may be dropped
+    setReadPos(MIN(m_readPos, p));
+}
+
+int CCByteBuffer::getReadableVectors(struct iovec* iov, int count) {
+    if(count <= 0 || available() == 0)
+        return 0;
+    if(!m_chunked) {
+        iov[0].iov_base = m_buffer + m_readPos;
+        iov[0].iov_len = available();
+        return 1;
+    }
+    
+    seekReadChunk();
+    int n = 0;
+    size_t offset = m_readOffset;
+    for(size_t i = m_readChunk; i < m_chunks.size() && n < count; i++) {
+        ccByteChunk* c = m_chunks[i];
+        if(c->length() > offset) {
+            iov[n].iov_base = c->data() + c->begin + offset;
+            iov[n].iov_len = c->length() - offset;
+            n++;
+        }
+        offset = 0;
+    }
+    return n;
+}
+
+int CCByteBuffer::getWritableVectors(struct iovec* iov, int count, size_t size) {
+    if(count <= 0 || size == 0)
+        return 0;
+    if(!m_chunked) {
+        ensureCanWrite(size);
+        if(m_writePos >= m_bufferSize)
+            return 0;
+        iov[0].iov_base = m_buffer + m_writePos;
+        iov[0].iov_len = MIN(size, m_bufferSize - m_writePos);
+        return 1;
+    }
+    
+    // write chunk always has space
+    int n = 0;
+    for(size_t i = m_writeChunk; size > 0 && n < count; i++) {
+        if(i == m_chunks.size())
+            m_chunks.push_back(s_chunkPool.alloc());
+        ccByteChunk* c = m_chunks[i];
+        iov[n].iov_base = c->data() + c->end;
+        iov[n].iov_len = MIN(size, CC_BYTE_BUFFER_CHUNK_SIZE - c->end);
+        size -= iov[n].iov_len;
+        n++;
+    }
+    return n;
+}
+
+void CCByteBuffer::commitWrite(size_t len) {
+    if(!m_chunked) {
+        m_writePos += MIN(len, m_bufferSize - m_writePos);
+        return;
+    }
+    
+    while(len > 0 && m_writeChunk < m_chunks.size()) {
+        ccByteChunk* c = m_chunks[m_writeChunk];
+        size_t n = MIN(len, CC_BYTE_BUFFER_CHUNK_SIZE - c->end);
+        c->end += n;
+        len -= n;
+        m_writePos += n;
+        if(c->end == CC_BYTE_BUFFER_CHUNK_SIZE)
+            m_writeChunk++;
+    }
+}
+
+size_t CCByteBuffer::moveFrom(CCByteBuffer* src) {
+    size_t len = src->available();
+    if(len == 0 || src == this)
+        return 0;
+    
+    // copy if any one is not chunked
+    if(!m_chunked || !src->m_chunked) {
+        struct iovec iov[16];
+        int n;
+        while((n = src->getReadableVectors(iov, 16)) > 0) {
+            for(int i = 0; i < n; i++) {
+                write((const uint8*)iov[i].iov_base, iov[i].iov_len);
+                src->skip(iov[i].iov_len);
+            }
+        }
+        src->clear();
+        return len;
+    }
+    
+    // take unread chunks of source, data is appended after our last data chunk
+    releaseReservedChunks();
+    src->seekReadChunk();
+    for(size_t i = src->m_readChunk; i < src->m_chunks.size(); i++) {
+        ccByteChunk* c = src->m_chunks[i];
+        if(i == src->m_readChunk)
+            c->begin += src->m_readOffset;
+        if(c->length() > 0)
+            m_chunks.push_back(c);
+        else
+            s_chunkPool.free(c);
+    }
+    src->m_chunks.resize(src->m_readChunk);
+    src->clear();
+    
+    m_writePos += len;
+    m_writeChunk = m_chunks.back()->end == CC_BYTE_BUFFER_CHUNK_SIZE ? m_chunks.size() : m_chunks.size() - 1;
+    return len;
 }
 
 void CCByteBuffer::ensureCanWrite(size_t size) {
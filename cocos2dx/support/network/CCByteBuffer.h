@@ -30,13 +30,27 @@
 #include <vector>
 #include <list>
 #include <map>
+#include <sys/uio.h>
 
 using namespace std;
 
 NS_CC_BEGIN
 
+/// size of a chunk of chunked byte buffer
+#define CC_BYTE_BUFFER_CHUNK_SIZE 0x1000
+
+struct ccByteChunk;
+
 /**
  * Byte buffer
+ *
+ * \par
+ * By default data is kept in one memory block which is reallocated when it grows, so big data
+ * is copied again and again. A chunked buffer, created by createChunked, keeps data in fixed size
+ * chunks taken from a shared slab pool, it never moves written data and chunks can be handed to
+ * another chunked buffer by moveFrom without copying. Chunked buffer supports all read and write
+ * methods, getReadableVectors and getWritableVectors expose its data as iovec so it can be used
+ * by writev/readv directly.
  */
 class CC_DLL CCByteBuffer : public CCObject {
 private:
@@ -57,6 +71,22 @@ protected:
     
     /// external mode
     bool m_external;
+    
+    /// chunked mode
+    bool m_chunked;
+    
+    /**
+     * chunks of chunked mode, positions start from first chunk. Chunks before write chunk
+     * are not written any more, chunks after write chunk are reserved by getWritableVectors
+     */
+    vector<ccByteChunk*> m_chunks;
+    
+    /// read position of chunked mode, offset is relative to chunk data start
+    size_t m_readChunk;
+    size_t m_readOffset;
+    
+    /// index of chunk which next write goes to
+    size_t m_writeChunk;
 	
 protected:
 	/// Allocates/reallocates buffer with specified size.
@@ -68,6 +98,21 @@ protected:
      * @param size number of bytes to fit
      */
     void ensureCanWrite(size_t size);
+    
+    /// move read chunk forward if read position is at end of it
+    void seekReadChunk();
+    
+    /// move read position of chunked mode forward
+    void advanceRead(size_t len);
+    
+    /// release all chunks
+    void releaseChunks();
+    
+    /// release reserved chunks which have no data
+    void releaseReservedChunks();
+    
+    /// copy data of chunks to one memory block, buffer leaves chunked mode
+    void linearize();
 	
 public:
 	CCByteBuffer();
@@ -90,12 +135,27 @@ public:
 	
 	/// Creates a CCByteBuffer with the specified size
 	static CCByteBuffer* create(size_t res);
+    
+    /// Creates a chunked CCByteBuffer, memory is allocated when data is written
+    static CCByteBuffer* createChunked();
+    
+    /// switch to chunked mode, all data is dropped
+    void initChunked();
+    
+    /// release cached chunks of shared pool, in use chunks are not affected
+    static void trimChunkPool();
 	
-    /// Resets read/write indexes
-    void clear() { m_readPos = m_writePos = 0; }
+    /// Resets read/write indexes, chunks of chunked buffer are released
+    void clear();
 	
-    /// Returns the buffer pointer
-    const uint8* getBuffer() { return m_buffer; }
+    /**
+     * Returns the buffer pointer. For chunked buffer, data is copied to one memory block and
+     * buffer is not chunked any more, use getReadableVectors to avoid copy
+     */
+    const uint8* getBuffer();
+    
+    /// is chunked mode?
+    bool isChunked() { return m_chunked; }
 	
     /// Gets the readable content size.
     size_t available() { return m_writePos - m_readPos; }
@@ -108,6 +168,11 @@ public:
     template<typename T> T read() {
         if(m_readPos + sizeof(T) > m_writePos)
             return (T)0;
+        if(m_chunked) {
+            T ret;
+            read((uint8*)&ret, sizeof(T));
+            return ret;
+        }
         T ret = *(T*)&m_buffer[m_readPos];
         m_readPos += sizeof(T);
         return ret;
@@ -119,7 +184,7 @@ public:
     /// move read pos back
     void revoke(size_t len);
     
-    /// move available data to start of buffer
+    /// move available data to start of buffer, chunked buffer releases read chunks without copy
     void compact();
 	
     /**
@@ -150,6 +215,10 @@ public:
      * @param T data The data to be written
      */
     template<typename T> void write(const T& data) {
+        if(m_chunked) {
+            write((const uint8*)&data, sizeof(T));
+            return;
+        }
         size_t new_size = m_writePos + sizeof(T);
         if(new_size > m_bufferSize) {
             new_size = (new_size / DEFAULT_INCREASE_SIZE + 1) * DEFAULT_INCREASE_SIZE;
@@ -189,10 +258,51 @@ public:
     size_t getReadPos() { return m_readPos; }
 	
 	/// move read position
-    void setReadPos(size_t p) { if(p <= m_writePos) m_readPos = p; }
+    void setReadPos(size_t p);
+    
+    /// get write position
+    size_t getWritePos() { return m_writePos; }
 	
-	/// set write position, that will change available size
-    void setWritePos(size_t p) { if(p <= m_bufferSize) m_writePos = p; }
+	/**
+     * set write position, that will change available size. For chunked buffer, it can move back,
+     * or move forward in space got from getWritableVectors
+     */
+    void setWritePos(size_t p);
+    
+    /**
+     * Gets readable data as iovec array, without copying. Data is not consumed, call skip after
+     * it is used. Vectors are valid until buffer is changed
+     *
+     * @param iov iovec array
+     * @param count max count of iovec
+     * @return count of iovec filled, 0 if no data
+     */
+    int getReadableVectors(struct iovec* iov, int count);
+    
+    /**
+     * Gets writable space as iovec array, space is allocated if not enough. Nothing is written
+     * until commitWrite is called, so it can be used by readv
+     *
+     * @param iov iovec array
+     * @param count max count of iovec
+     * @param size bytes want to be written, iovec may cover less if count is not enough, and
+     *      it may be less for buffer in external mode
+     * @return count of iovec filled
+     */
+    int getWritableVectors(struct iovec* iov, int count, size_t size);
+    
+    /// commit bytes written to space got from getWritableVectors
+    void commitWrite(size_t len);
+    
+    /**
+     * move available data of another buffer to the end of this buffer, source buffer becomes
+     * empty. If both are chunked, chunks are moved without copying data, so the only copy of
+     * received data can be passed along
+     *
+     * @param src source buffer
+     * @return bytes moved
+     */
+    size_t moveFrom(CCByteBuffer* src);
 	
 	/// write a vector
     template<typename T> size_t writeVector(const vector<T>& v) {
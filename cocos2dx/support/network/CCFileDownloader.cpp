@@ -23,10 +23,51 @@
  ****************************************************************************/
 #include "CCFileDownloader.h"
 #include "support/utils/CCUtils.h"
+#include "support/codec/MD5.h"
+#include "platform/CCFileUtils.h"
 #include "CCNotificationCenter.h"
+#include "CCDirector.h"
+#include "CCScheduler.h"
+#include "CCByteBuffer.h"
+#include <list>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <pthread.h>
 
 NS_CC_BEGIN
 
+/// suffix of state file of an unfinished file
+#define STATE_SUFFIX ".dlstate"
+
+/// first line of state file
+#define STATE_MAGIC "CCDL1"
+
+/// state is saved after so many bytes are written
+#define STATE_SAVE_INTERVAL (1024 * 1024)
+
+/// a range of file downloaded by one request
+typedef struct {
+    /// file offsets, end is exclusive and zero means unknown. Writer reads them so they are changed with writer locked
+    size_t start;
+    size_t end;
+    
+    /// offset of next received byte, main thread only
+    size_t pos;
+    
+    /// offset which is written to disk, changed by writer with writer locked
+    size_t written;
+    
+    /// below are main thread only
+    CCHttpRequest* request;
+    bool ranged;
+    bool accepted;
+    bool done;
+    int retries;
+} ccDownloadSegment;
+
 /// download entry
 class CCDownloadEntry : public CCObject {
 public:
@@ -34,11 +75,52 @@ public:
     string m_dstFilename;
     size_t m_size;
     bool m_append;
+    string m_md5;
+    
+    /// full path of destination file
+    string m_path;
+    
+    /// file offset of first byte of content, it is not zero when appending
+    size_t m_base;
+    
+    /// segments
+    vector<ccDownloadSegment> m_segments;
+    
+    /// below are set by main thread before entry is closed
+    bool m_started;
+    bool m_finishing;
+    bool m_failed;
+    bool m_aborted;
+    bool m_truncate;
+    bool m_saveState;
+    bool m_discardState;
+    int m_activeRequests;
+    
+    /// below are writer only
+    int m_fd;
+    bool m_writeError;
+    size_t m_unsavedBytes;
+    
+    /// result set by writer when it is closed
+    bool m_succeeded;
     
 public:
     CCDownloadEntry() :
     m_size(0),
-    m_append(false) {
+    m_append(false),
+    m_base(0),
+    m_started(false),
+    m_finishing(false),
+    m_failed(false),
+    m_aborted(false),
+    m_truncate(false),
+    m_saveState(false),
+    m_discardState(false),
+    m_activeRequests(0),
+    m_fd(-1),
+    m_writeError(false),
+    m_unsavedBytes(0),
+    m_succeeded(false) {
     }
     
     virtual ~CCDownloadEntry() {}
@@ -47,17 +129,365 @@ public:
         CCDownloadEntry* e = new CCDownloadEntry();
         CC_SAFE_AUTORELEASE_RETURN(e, CCDownloadEntry*);
     }
+    
+    /// index of segment which is downloaded by request, or -1
+    int segmentOf(CCHttpRequest* request) {
+        for(int i = 0; i < (int)m_segments.size(); i++) {
+            if(m_segments[i].request == request)
+                return i;
+        }
+        return -1;
+    }
+    
+    /// bytes received, resumed bytes are included
+    size_t getReceivedSize() {
+        size_t size = 0;
+        for(vector<ccDownloadSegment>::iterator iter = m_segments.begin(); iter != m_segments.end(); iter++) {
+            size += iter->pos - iter->start;
+        }
+        return size;
+    }
+    
+    /// read state file, segments are restored if it matches entry
+    bool loadState() {
+        struct stat st;
+        if(stat(m_path.c_str(), &st) != 0)
+            return false;
+        size_t len = 0;
+        char* buf = (char*)CCFileUtils::sharedFileUtils()->getFileData((m_path + STATE_SUFFIX).c_str(), "rb", &len);
+        if(!buf)
+            return false;
+        string state(buf, len);
+        delete[] buf;
+        
+        // magic, url, size, then one segment per line
+        vector<string> lines;
+        size_t lineStart = 0;
+        while(lineStart < state.length()) {
+            size_t lineEnd = state.find('\n', lineStart);
+            if(lineEnd == string::npos)
+                lineEnd = state.length();
+            lines.push_back(state.substr(lineStart, lineEnd - lineStart));
+            lineStart = lineEnd + 1;
+        }
+        if(lines.size() < 4 || lines[0] != STATE_MAGIC || lines[1] != m_url)
+            return false;
+        size_t size = strtoul(lines[2].c_str(), NULL, 10);
+        if(m_size > 0 && size != m_size)
+            return false;
+        vector<ccDownloadSegment> segments;
+        for(size_t i = 3; i < lines.size(); i++) {
+            unsigned long start, written, end;
+            if(sscanf(lines[i].c_str(), "%lu %lu %lu", &start, &written, &end) != 3)
+                return false;
+            if(written < start || (end > 0 && written > end) || written > (size_t)st.st_size)
+                return false;
+            ccDownloadSegment seg;
+            memset(&seg, 0, sizeof(seg));
+            seg.start = start;
+            seg.end = end;
+            seg.pos = seg.written = written;
+            seg.done = end > 0 && written == end;
+            segments.push_back(seg);
+        }
+        m_size = size;
+        m_segments = segments;
+        return true;
+    }
+};
+
+/**
+ * writes received data of all entries in a background thread, so disk is not
+ * touched in main thread. Jobs are done in order, so closing an entry happens after
+ * all its data is written
+ */
+class CCDownloadWriter {
+private:
+    typedef struct {
+        CCDownloadEntry* entry;
+        
+        /// segment index, or -1 means close entry
+        int segment;
+        size_t offset;
+        size_t size;
+        
+        /// received chunks, owned by job
+        CCByteBuffer* data;
+    } Job;
+    
+    pthread_mutex_t m_mutex;
+    pthread_cond_t m_cond;
+    pthread_t m_thread;
+    bool m_threadStarted;
+    bool m_quit;
+    
+    /// queued jobs
+    list<Job> m_jobs;
+    
+    /// closed entries, main thread takes them
+    vector<CCDownloadEntry*> m_closed;
+    
+private:
+    static void* threadEntry(void* arg) {
+        ((CCDownloadWriter*)arg)->run();
+        return NULL;
+    }
+    
+    void run() {
+        pthread_mutex_lock(&m_mutex);
+        while(true) {
+            // pending jobs are still done when quit, so state is saved
+            if(m_jobs.empty()) {
+                if(m_quit)
+                    break;
+                pthread_cond_wait(&m_cond, &m_mutex);
+                continue;
+            }
+            Job job = m_jobs.front();
+            m_jobs.pop_front();
+            pthread_mutex_unlock(&m_mutex);
+            
+            if(job.segment < 0) {
+                closeEntry(job.entry);
+            } else {
+                writeData(job);
+                CC_SAFE_RELEASE(job.data);
+            }
+            
+            pthread_mutex_lock(&m_mutex);
+            if(job.segment < 0)
+                m_closed.push_back(job.entry);
+        }
+        pthread_mutex_unlock(&m_mutex);
+    }
+    
+    bool openFile(CCDownloadEntry* e) {
+        if(e->m_fd < 0 && !e->m_writeError) {
+            e->m_fd = open(e->m_path.c_str(), O_WRONLY | O_CREAT | (e->m_truncate ? O_TRUNC : 0), 0644);
+            if(e->m_fd < 0) {
+                CCLOGWARN("open file %s failed: %s", e->m_path.c_str(), strerror(errno));
+                e->m_writeError = true;
+            }
+        }
+        return e->m_fd >= 0;
+    }
+    
+    void writeData(Job& job) {
+        CCDownloadEntry* e = job.entry;
+        if(!openFile(e))
+            return;
+        
+        // write all, chunks are gathered so one call writes many of them
+        struct iovec iov[16];
+        size_t done = 0;
+        while(done < job.size) {
+            int count = job.data->getReadableVectors(iov, 16);
+            ssize_t n = -1;
+            if(lseek(e->m_fd, job.offset + done, SEEK_SET) >= 0)
+                n = writev(e->m_fd, iov, count);
+            if(n < 0 && errno == EINTR)
+                continue;
+            if(n <= 0) {
+                CCLOGWARN("write file %s failed: %s", e->m_path.c_str(), strerror(errno));
+                e->m_writeError = true;
+                return;
+            }
+            job.data->skip(n);
+            done += n;
+        }
+        
+        // segment may be gone if server stops supporting range
+        pthread_mutex_lock(&m_mutex);
+        if(job.segment < (int)e->m_segments.size())
+            e->m_segments[job.segment].written = job.offset + job.size;
+        pthread_mutex_unlock(&m_mutex);
+        
+        // save state from time to time
+        e->m_unsavedBytes += job.size;
+        if(e->m_saveState && e->m_unsavedBytes >= STATE_SAVE_INTERVAL) {
+            saveState(e);
+        }
+    }
+    
+    /// write state to temp file then rename, so a partial state is never read
+    void saveState(CCDownloadEntry* e) {
+        // file data must be in disk before state says so
+        if(e->m_fd >= 0)
+            fsync(e->m_fd);
+        e->m_unsavedBytes = 0;
+        
+        // snapshot
+        char buf[128];
+        string state = STATE_MAGIC "\n" + e->m_url + "\n";
+        pthread_mutex_lock(&m_mutex);
+        sprintf(buf, "%lu\n", (unsigned long)e->m_size);
+        state += buf;
+        for(vector<ccDownloadSegment>::iterator iter = e->m_segments.begin(); iter != e->m_segments.end(); iter++) {
+            sprintf(buf, "%lu %lu %lu\n", (unsigned long)iter->start, (unsigned long)iter->written, (unsigned long)iter->end);
+            state += buf;
+        }
+        pthread_mutex_unlock(&m_mutex);
+        
+        string statePath = e->m_path + STATE_SUFFIX;
+        string tmpPath = statePath + ".tmp";
+        FILE* f = fopen(tmpPath.c_str(), "wb");
+        if(f) {
+            bool ok = fwrite(state.data(), 1, state.length(), f) == state.length();
+            ok = fclose(f) == 0 && ok;
+            if(!ok || rename(tmpPath.c_str(), statePath.c_str()) != 0) {
+                CCLOGWARN("failed to save download state %s, errno %d", statePath.c_str(), errno);
+                CCUtils::deleteFile(tmpPath);
+            }
+        }
+    }
+    
+    bool verify(CCDownloadEntry* e) {
+        FILE* f = fopen(e->m_path.c_str(), "rb");
+        if(!f)
+            return false;
+        MD5 md5;
+        char buf[64 * 1024];
+        size_t n;
+        while((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+            md5.update(buf, (MD5::size_type)n);
+        }
+        fclose(f);
+        md5.finalize();
+        return md5.hexdigest() == e->m_md5;
+    }
+    
+    void closeEntry(CCDownloadEntry* e) {
+        // an empty file is still created
+        bool ok = !e->m_failed && (e->m_fd >= 0 || openFile(e)) && !e->m_writeError;
+        
+        // drop old content after end
+        if(ok) {
+            size_t end = e->m_base;
+            pthread_mutex_lock(&m_mutex);
+            for(vector<ccDownloadSegment>::iterator iter = e->m_segments.begin(); iter != e->m_segments.end(); iter++) {
+                end = MAX(end, iter->written);
+            }
+            pthread_mutex_unlock(&m_mutex);
+            if(ftruncate(e->m_fd, end) != 0) {
+                CCLOGWARN("truncate file %s failed: %s", e->m_path.c_str(), strerror(errno));
+            }
+        }
+        if(e->m_fd >= 0) {
+            if(!ok && e->m_saveState && !e->m_discardState)
+                saveState(e);
+            ::close(e->m_fd);
+            e->m_fd = -1;
+        }
+        
+        // verify
+        if(ok && !e->m_md5.empty() && !verify(e)) {
+            CCLOGWARN("md5 of downloaded file %s mismatched", e->m_path.c_str());
+            CCUtils::deleteFile(e->m_path);
+            ok = false;
+        }
+        
+        // state is useless if file is done or it is not valid
+        if(ok || e->m_discardState || !CCUtils::isPathExistent(e->m_path)) {
+            CCUtils::deleteFile(e->m_path + STATE_SUFFIX);
+        }
+        e->m_succeeded = ok;
+    }
+    
+public:
+    CCDownloadWriter() :
+    m_threadStarted(false),
+    m_quit(false) {
+        pthread_mutex_init(&m_mutex, NULL);
+        pthread_cond_init(&m_cond, NULL);
+    }
+    
+    ~CCDownloadWriter() {
+        if(m_threadStarted) {
+            pthread_mutex_lock(&m_mutex);
+            m_quit = true;
+            pthread_cond_signal(&m_cond);
+            pthread_mutex_unlock(&m_mutex);
+            pthread_join(m_thread, NULL);
+        }
+        for(list<Job>::iterator iter = m_jobs.begin(); iter != m_jobs.end(); iter++) {
+            CC_SAFE_RELEASE(iter->data);
+        }
+        pthread_cond_destroy(&m_cond);
+        pthread_mutex_destroy(&m_mutex);
+    }
+    
+    /// lock before changing segment layout of an entry which has queued jobs
+    void lock() { pthread_mutex_lock(&m_mutex); }
+    void unlock() { pthread_mutex_unlock(&m_mutex); }
+    
+    /// queue a job, thread is started lazily
+    void addJob(CCDownloadEntry* e, int segment, size_t offset, size_t size, CCByteBuffer* data) {
+        Job job;
+        job.entry = e;
+        job.segment = segment;
+        job.offset = offset;
+        job.size = size;
+        job.data = data;
+        
+        pthread_mutex_lock(&m_mutex);
+        m_jobs.push_back(job);
+        if(!m_threadStarted) {
+            m_threadStarted = pthread_create(&m_thread, NULL, threadEntry, this) == 0;
+        }
+        pthread_cond_signal(&m_cond);
+        pthread_mutex_unlock(&m_mutex);
+    }
+    
+    /// write received data of a segment, writer takes ownership of data
+    void write(CCDownloadEntry* e, int segment, size_t offset, size_t size, CCByteBuffer* data) {
+        addJob(e, segment, offset, size, data);
+    }
+    
+    /// close entry after its data is written, it is verified and then returned by popClosed
+    void close(CCDownloadEntry* e) {
+        addJob(e, -1, 0, 0, NULL);
+    }
+    
+    /// take closed entries
+    void popClosed(vector<CCDownloadEntry*>& closed) {
+        pthread_mutex_lock(&m_mutex);
+        closed.swap(m_closed);
+        pthread_mutex_unlock(&m_mutex);
+    }
 };
 
+/// get header, name may be lowercase in response
+static string headerOf(CCHttpResponse* response, const string& name) {
+    string value = response->getHeader(name);
+    if(value.empty()) {
+        string lower = name;
+        CCUtils::toLowercase(lower);
+        value = response->getHeader(lower);
+    }
+    return value;
+}
+
+/// first entry of array, or NULL
+static CCDownloadEntry* firstEntry(CCArray& entries) {
+    return entries.count() > 0 ? (CCDownloadEntry*)entries.objectAtIndex(0) : NULL;
+}
+
 static CCFileDownloader* sInstance = NULL;
 
 CCFileDownloader::CCFileDownloader() :
+m_nextTag(0),
+m_dispatching(false),
 m_downloading(false),
 m_totalSize(0),
 m_totalDownloadedSize(0),
-m_fos(NULL) {
+m_maxConcurrentFiles(3),
+m_maxSegments(4),
+m_segmentThreshold(8 * 1024 * 1024),
+m_maxRetries(2),
+m_resumeEnabled(true) {
     m_client = CCHttpClient::create();
     CC_SAFE_RETAIN(m_client);
+    m_writer = new CCDownloadWriter();
     
     // listener
     CCNotificationCenter::sharedNotificationCenter()->addObserver(this, callfuncO_selector(CCFileDownloader::onHttpDone), kCCNotificationHttpRequestCompleted, NULL);
@@ -66,6 +496,8 @@ m_fos(NULL) {
 }
 
 CCFileDownloader::~CCFileDownloader() {
+    // writer finishes queued jobs before it quits
+    delete m_writer;
 	CC_SAFE_RELEASE(m_client);
     sInstance = NULL;
 }
@@ -79,6 +511,13 @@ CCFileDownloader* CCFileDownloader::getInstance() {
 
 void CCFileDownloader::purge() {
     if(sInstance) {
+        // stop
+        sInstance->abort();
+        if(sInstance->m_dispatching) {
+            CCDirector::sharedDirector()->getScheduler()->unscheduleSelector(schedule_selector(CCFileDownloader::dispatchResults), sInstance);
+            sInstance->m_dispatching = false;
+        }
+        
         // remove listener
         CCNotificationCenter::sharedNotificationCenter()->removeObserver(sInstance, kCCNotificationHttpRequestCompleted);
         CCNotificationCenter::sharedNotificationCenter()->removeObserver(sInstance, kCCNotificationHttpDataReceived);
@@ -112,103 +551,352 @@ void CCFileDownloader::addFile(const string& url, const string& dstFilename, siz
     m_entries.addObject(e);
 }
 
+void CCFileDownloader::addFile(const string& url, const string& dstFilename, size_t sizeHint, const string& md5) {
+    addFile(url, dstFilename, sizeHint, false);
+    CCDownloadEntry* e = (CCDownloadEntry*)m_entries.lastObject();
+    e->m_md5 = md5;
+    CCUtils::toLowercase(e->m_md5);
+}
+
 void CCFileDownloader::start() {
     if(!m_downloading) {
         // if has entry, go
         if(m_entries.count() > 0) {
             m_failedEntries.removeAllObjects();
-            downloadNext();
             m_downloading = true;
+            if(!m_dispatching) {
+                CCDirector::sharedDirector()->getScheduler()->scheduleSelector(schedule_selector(CCFileDownloader::dispatchResults), this, 0, false);
+                m_dispatching = true;
+            }
+            downloadNext();
         }
     }
 }
 
 void CCFileDownloader::downloadNext() {
-    // get first entry
-    m_entry = (CCDownloadEntry*)m_entries.objectAtIndex(0);
+    // start entries which are not started, an entry may be finished in startEntry
+    CCObject* obj;
+    CCARRAY_FOREACH(&m_entries, obj) {
+        if((int)m_activeEntries.count() >= m_maxConcurrentFiles)
+            break;
+        CCDownloadEntry* e = (CCDownloadEntry*)obj;
+        if(!e->m_started) {
+            startEntry(e);
+        }
+    }
+}
+
+void CCFileDownloader::startEntry(CCDownloadEntry* e) {
+    e->m_started = true;
+    e->m_path = CCUtils::externalize(m_folder + e->m_dstFilename);
+    e->m_saveState = m_resumeEnabled && !e->m_append;
+    m_activeEntries.addObject(e);
     
-    // create stream
-    string path = m_folder + m_entry->m_dstFilename;
-    m_fos = CCAssetOutputStream::create(CCUtils::externalize(path), m_entry->m_append);
-    CC_SAFE_RETAIN(m_fos);
+    // resume, or split file if it is large
+    bool resumed = e->m_saveState && e->loadState();
+    if(!resumed) {
+        if(e->m_append) {
+            struct stat st;
+            if(stat(e->m_path.c_str(), &st) == 0)
+                e->m_base = st.st_size;
+        }
+        int count = 1;
+        if(!e->m_append && e->m_size > 0 && m_segmentThreshold > 0 && m_maxSegments > 1) {
+            count = (int)MIN((size_t)m_maxSegments, MAX((size_t)1, e->m_size / m_segmentThreshold));
+        }
+        size_t segSize = e->m_size / count;
+        e->m_segments.clear();
+        for(int i = 0; i < count; i++) {
+            ccDownloadSegment seg;
+            memset(&seg, 0, sizeof(seg));
+            seg.start = seg.pos = seg.written = e->m_base + i * segSize;
+            if(i < count - 1)
+                seg.end = seg.start + segSize;
+            else
+                seg.end = e->m_size > 0 ? e->m_base + e->m_size : 0;
+            e->m_segments.push_back(seg);
+        }
+    }
+    e->m_truncate = !resumed && !e->m_append;
+    m_totalDownloadedSize += e->getReceivedSize();
     
-    // start downloading
+    // start segments not done
+    for(int i = 0; i < (int)e->m_segments.size(); i++) {
+        if(!e->m_segments[i].done)
+            startSegment(e, i);
+    }
+    if(e->m_activeRequests == 0) {
+        finishEntry(e, false);
+    }
+}
+
+void CCFileDownloader::startSegment(CCDownloadEntry* e, int index) {
+    ccDownloadSegment& seg = e->m_segments[index];
     CCHttpRequest* request = CCHttpRequest::create();
-    request->setUrl(m_entry->m_url);
+    request->setUrl(e->m_url);
     request->setMethod(kHttpGet);
+    request->setTag(m_nextTag++);
+    
+    // range is in content offsets
+    size_t from = seg.pos - e->m_base;
+    seg.ranged = from > 0 || (seg.end > 0 && e->m_segments.size() > 1);
+    if(seg.ranged) {
+        char buf[96];
+        if(seg.end > 0)
+            sprintf(buf, "Range: bytes=%lu-%lu", (unsigned long)from, (unsigned long)(seg.end - e->m_base - 1));
+        else
+            sprintf(buf, "Range: bytes=%lu-", (unsigned long)from);
+        vector<string> headers;
+        headers.push_back(buf);
+        request->setHeaders(headers);
+    }
+    seg.accepted = false;
+    seg.request = request;
+    m_requests[request] = e;
+    e->m_activeRequests++;
     m_client->asyncExecute(request);
 }
 
+void CCFileDownloader::finishEntry(CCDownloadEntry* e, bool failed) {
+    if(e->m_finishing)
+        return;
+    e->m_finishing = true;
+    e->m_failed = failed;
+    
+    // stop requests still running
+    for(vector<ccDownloadSegment>::iterator iter = e->m_segments.begin(); iter != e->m_segments.end(); iter++) {
+        if(iter->request) {
+            m_requests.erase(iter->request);
+            m_client->cancel(iter->request->getTag());
+            iter->request = NULL;
+        }
+    }
+    e->m_activeRequests = 0;
+    m_writer->close(e);
+}
+
+void CCFileDownloader::restartWithSegment(CCDownloadEntry* e, int index) {
+    // stop other segments
+    for(int i = 0; i < (int)e->m_segments.size(); i++) {
+        ccDownloadSegment& seg = e->m_segments[i];
+        if(i != index && seg.request) {
+            m_requests.erase(seg.request);
+            m_client->cancel(seg.request->getTag());
+            e->m_activeRequests--;
+        }
+    }
+    m_totalDownloadedSize -= e->getReceivedSize();
+    
+    // this response has whole content
+    ccDownloadSegment seg = e->m_segments[index];
+    seg.start = seg.pos = seg.written = e->m_base;
+    seg.end = e->m_size > 0 ? e->m_base + e->m_size : 0;
+    seg.ranged = false;
+    seg.accepted = true;
+    seg.done = false;
+    m_writer->lock();
+    e->m_segments.clear();
+    e->m_segments.push_back(seg);
+    m_writer->unlock();
+}
+
 void CCFileDownloader::abort() {
     if(m_downloading) {
-        m_client->cancelAll();
-        CC_SAFE_RELEASE_NULL(m_fos);
-        m_entry = NULL;
+        // unfinished files keep state for resume
+        CCObject* obj;
+        CCARRAY_FOREACH(&m_activeEntries, obj) {
+            CCDownloadEntry* e = (CCDownloadEntry*)obj;
+            if(!e->m_finishing) {
+                // counted again when it is resumed
+                m_totalDownloadedSize -= e->getReceivedSize();
+                e->m_aborted = true;
+                finishEntry(e, true);
+            }
+        }
         m_entries.removeAllObjects();
         m_downloading = false;
     }
 }
 
 size_t CCFileDownloader::getCurrentDownloadedSize() {
-    return m_fos ? m_fos->getPosition() : 0;
+    CCDownloadEntry* e = firstEntry(m_activeEntries);
+    return e ? e->getReceivedSize() : 0;
 }
 
 string CCFileDownloader::getCurrentDownloadingFileName() {
-    return m_entry ? CCUtils::lastPathComponent(m_entry->m_dstFilename) : "";
+    CCDownloadEntry* e = firstEntry(m_activeEntries);
+    return e ? CCUtils::lastPathComponent(e->m_dstFilename) : "";
 }
 
 string CCFileDownloader::getCurrentDownloadingFileFullPath() {
-    return m_entry ? CCUtils::externalize(m_entry->m_dstFilename) : "";
+    CCDownloadEntry* e = firstEntry(m_activeEntries);
+    return e ? e->m_path : "";
 }
 
 size_t CCFileDownloader::getCurrentDownloadingFileSize() {
-    return m_entry ? m_entry->m_size : 0;
+    CCDownloadEntry* e = firstEntry(m_activeEntries);
+    return e ? e->m_size : 0;
 }
 
 int CCFileDownloader::getFailedEntryCount() {
     return m_failedEntries.count();
 }
 
-void CCFileDownloader::onHttpDone(CCHttpResponse* response) {
-    // if entry is not set, this notification is not for me
-    if(!m_entry)
-        return;
-    
-    // fail?
-    if(!response->isSuccess()) {
-        m_failedEntries.addObject(m_entry);
+void CCFileDownloader::dispatchResults(float delta) {
+    vector<CCDownloadEntry*> closed;
+    m_writer->popClosed(closed);
+    for(vector<CCDownloadEntry*>::iterator iter = closed.begin(); iter != closed.end(); iter++) {
+        CCDownloadEntry* e = *iter;
+        if(!e->m_succeeded && !e->m_aborted) {
+            m_failedEntries.addObject(e);
+        }
+        m_entries.removeObject(e);
+        m_activeEntries.removeObject(e);
     }
     
-    // close stream
-    CC_SAFE_RELEASE_NULL(m_fos);
-    m_entry = NULL;
+    // next
+    if(m_downloading) {
+        if(!closed.empty())
+            downloadNext();
+        if(m_entries.count() == 0)
+            m_downloading = false;
+    }
     
-    // remove first entry
-    m_entries.removeObjectAtIndex(0);
+    // aborted entries are closed too before stop
+    if(!m_downloading && m_activeEntries.count() == 0) {
+        CCDirector::sharedDirector()->getScheduler()->unscheduleSelector(schedule_selector(CCFileDownloader::dispatchResults), this);
+        m_dispatching = false;
+    }
+}
+
+void CCFileDownloader::onHttpDone(CCHttpResponse* response) {
+    // if request is not mine, ignore it
+    CCHttpRequest* request = response->getRequest();
+    map<CCHttpRequest*, CCDownloadEntry*>::iterator iter = m_requests.find(request);
+    if(iter == m_requests.end())
+        return;
+    CCDownloadEntry* e = iter->second;
+    m_requests.erase(iter);
+    int index = e->segmentOf(request);
+    if(index < 0)
+        return;
+    ccDownloadSegment& seg = e->m_segments[index];
+    seg.request = NULL;
+    e->m_activeRequests--;
     
-    // next
-    if(m_entries.count() > 0) {
-        downloadNext();
+    // done, or retry from where it stops
+    if(response->isSuccess() && seg.accepted && (seg.end == 0 || seg.pos == seg.end)) {
+        seg.done = true;
     } else {
-        m_downloading = false;
+        int code = response->getResponseCode();
+        if(code == 416)
+            e->m_discardState = true;
+        if(seg.retries < m_maxRetries && (code < 400 || code >= 500)) {
+            seg.retries++;
+            CCLOG("retry %s from %lu", e->m_url.c_str(), (unsigned long)seg.pos);
+            startSegment(e, index);
+        } else {
+            finishEntry(e, true);
+        }
+        return;
+    }
+    
+    // all done?
+    if(e->m_activeRequests == 0) {
+        finishEntry(e, false);
     }
 }
 
 void CCFileDownloader::onHttpData(CCHttpResponse* response) {
-    if(m_fos) {
-        CCData* data = response->getData();
-        m_fos->write((const char*)data->getBytes(), data->getSize());
-        m_totalDownloadedSize += data->getSize();
-    }
+    CCHttpRequest* request = response->getRequest();
+    map<CCHttpRequest*, CCDownloadEntry*>::iterator iter = m_requests.find(request);
+    if(iter == m_requests.end())
+        return;
+    CCDownloadEntry* e = iter->second;
+    int index = e->segmentOf(request);
+    if(index < 0)
+        return;
+    
+    // data of error response is dropped, extra data is dropped
+    ccDownloadSegment& seg = e->m_segments[index];
+    if(!seg.accepted)
+        return;
+    CCByteBuffer* body = response->getBody();
+    size_t size = body->available();
+    if(seg.end > 0)
+        size = MIN(size, seg.end - seg.pos);
+    if(size == 0)
+        return;
+    
+    // writer takes received chunks, data is not copied
+    CCByteBuffer* data = new CCByteBuffer((size_t)0);
+    data->initChunked();
+    data->moveFrom(body);
+    data->setWritePos(size);
+    m_writer->write(e, index, seg.pos, size, data);
+    seg.pos += size;
+    m_totalDownloadedSize += size;
 }
 
 void CCFileDownloader::onHttpHeaders(CCHttpResponse* response) {
-    if(m_entry) {
-        if(m_entry->m_size == 0) {
-            string contentLength = response->getHeader("Content-Length");
-            m_entry->m_size = atoi(contentLength.c_str());
+    CCHttpRequest* request = response->getRequest();
+    map<CCHttpRequest*, CCDownloadEntry*>::iterator iter = m_requests.find(request);
+    if(iter == m_requests.end())
+        return;
+    CCDownloadEntry* e = iter->second;
+    int index = e->segmentOf(request);
+    if(index < 0)
+        return;
+    ccDownloadSegment& seg = e->m_segments[index];
+    
+    int code = response->getResponseCode();
+    if(code == 206 && seg.ranged) {
+        // Content-Range: bytes first-last/total, server must start where we ask
+        string range = headerOf(response, "Content-Range");
+        unsigned long first = 0, last = 0;
+        char total[32] = { 0 };
+        if(sscanf(range.c_str(), "bytes %lu-%lu/%31s", &first, &last, total) != 3 || first != seg.pos - e->m_base) {
+            CCLOGWARN("%s returns unexpected range: %s", e->m_url.c_str(), range.c_str());
+            e->m_discardState = true;
+            finishEntry(e, true);
+            return;
+        }
+        
+        // file is changed if size is not same
+        if(total[0] != '*') {
+            size_t size = strtoul(total, NULL, 10);
+            if(e->m_size == 0) {
+                e->m_size = size;
+                m_writer->lock();
+                seg.end = e->m_base + size;
+                m_writer->unlock();
+            } else if(size != e->m_size) {
+                CCLOGWARN("%s is changed on server, download it again", e->m_url.c_str());
+                e->m_discardState = true;
+                finishEntry(e, true);
+                return;
+            }
+        }
+        seg.accepted = true;
+    } else if(code == 200) {
+        // server ignores range, whole file is sent
+        if(seg.ranged) {
+            restartWithSegment(e, index);
+        } else {
+            seg.accepted = true;
+        }
+        
+        // size may be unknown
+        if(e->m_size == 0) {
+            e->m_size = atol(headerOf(response, "Content-Length").c_str());
+            if(e->m_size > 0) {
+                ccDownloadSegment& s = e->m_segments[0];
+                m_writer->lock();
+                s.end = s.start + e->m_size;
+                m_writer->unlock();
+            }
         }
     }
 }
 
-NS_CC_END
\ No newline at end of file
+NS_CC_END
@@ -27,20 +27,32 @@
 #include "ccTypes.h"
 #include "ccMacros.h"
 #include "support/network/CCHttpClient.h"
-#include "platform/CCAssetOutputStream.h"
+#include <map>
 
 using namespace std;
 
 NS_CC_BEGIN
 
 class CCDownloadEntry;
+class CCDownloadWriter;
 
 /**
- * a file downloader which uses http protocol, it manages a list of file infos and download them
- * one by one. All files are saved to local. In iOS, they are saved under ~/Library. In Android,
+ * a file downloader which uses http protocol, it manages a list of file infos and download them.
+ * All files are saved to local. In iOS, they are saved under ~/Library. In Android,
  * they are saved to internal storage. You can specify a base folder, for example, "data", then final
  * destination folder in iOS will be "~/Library/data"
  *
+ * \par
+ * Several files are downloaded at same time. A file whose size is known (size hint is given) and is
+ * larger than segment threshold is split by HTTP Range into segments which are downloaded on separated
+ * connections. If server doesn't support range, it falls back to one connection.
+ *
+ * \par
+ * Received data is written by a background thread. Written offsets of an unfinished file are saved
+ * in a state file next to it, so a file interrupted by abort, network failure or app exit is resumed
+ * when it is added again. A dropped connection is retried from where it stops. If md5 is given, file
+ * is verified when it is done, a mismatched file is deleted and treated as failed.
+ *
  * CCFileDownloader is a singleton
  */
 class CCFileDownloader : public CCObject {
@@ -48,11 +60,20 @@ private:
     /// client
     CCHttpClient* m_client;
     
-    /// current file stream
-    CCAssetOutputStream* m_fos;
+    /// entries being downloaded, in the order they are started
+    CCArray m_activeEntries;
+    
+    /// active requests, key is request, value is entry
+    map<CCHttpRequest*, CCDownloadEntry*> m_requests;
     
-    /// current entry
-    CCDownloadEntry* m_entry;
+    /// background writer
+    CCDownloadWriter* m_writer;
+    
+    /// tag of next request
+    int m_nextTag;
+    
+    /// is result dispatcher scheduled
+    bool m_dispatching;
     
 protected:
 	CCFileDownloader();
@@ -65,9 +86,24 @@ protected:
     void onHttpData(CCHttpResponse* response);
     void onHttpHeaders(CCHttpResponse* response);
     
-    /// download next entry
+    /// start entries until concurrent limit is reached
     void downloadNext();
     
+    /// prepare segments of an entry and start them
+    void startEntry(CCDownloadEntry* e);
+    
+    /// send request of a segment
+    void startSegment(CCDownloadEntry* e, int index);
+    
+    /// stop all requests of an entry and let writer close it
+    void finishEntry(CCDownloadEntry* e, bool failed);
+    
+    /// server ignores range, download entry from start with the segment
+    void restartWithSegment(CCDownloadEntry* e, int index);
+    
+    /// entries which are closed by writer
+    void dispatchResults(float delta);
+    
 public:
 	virtual ~CCFileDownloader();
 	static CCFileDownloader* getInstance();
@@ -102,10 +138,21 @@ public:
      */
     void addFile(const string& url, const string& dstFilename, size_t sizeHint, bool append);
     
+    /**
+     * add a download entry which is verified when it is done
+     *
+     * @param url file download url, only http is supported
+     * @param dstFilename destination file name
+     * @param sizeHint size of file to be downloaded, or zero if unknown. A file is split
+     *      into segments only when size is known
+     * @param md5 hex md5 of file, empty means not verified
+     */
+    void addFile(const string& url, const string& dstFilename, size_t sizeHint, const string& md5);
+    
     /// start download
     void start();
     
-    /// abort
+    /// abort, unfinished files can be resumed later
     void abort();
     
     /// get downloaded size of current downloading file
@@ -126,7 +173,7 @@ public:
     /// file folder prefix
     CC_SYNTHESIZE_PASS_BY_REF(string, m_folder, Folder);
     
-    /// download entry list
+    /// download entry list, includes downloading ones
     CC_SYNTHESIZE_PASS_BY_REF(CCArray, m_entries, DownloadEntries);
     
     /// entries which are failed
@@ -138,8 +185,23 @@ public:
     // total bytes
     CC_SYNTHESIZE_READONLY(size_t, m_totalSize, TotalSize);
     
-    // total bytes downloaded
+    // total bytes downloaded, resumed bytes are included
     CC_SYNTHESIZE_READONLY(size_t, m_totalDownloadedSize, TotalDownloadedSize);
+    
+    /// max files downloaded at same time, default is 3
+    CC_SYNTHESIZE(int, m_maxConcurrentFiles, MaxConcurrentFiles);
+    
+    /// max segments of one file, default is 4. Connections to one host are also limited by CCHttpClient
+    CC_SYNTHESIZE(int, m_maxSegments, MaxSegments);
+    
+    /// min size of a segment, file smaller than twice of it is not split. Default is 8MB
+    CC_SYNTHESIZE(size_t, m_segmentThreshold, SegmentThreshold);
+    
+    /// retry count of a dropped segment, default is 2
+    CC_SYNTHESIZE(int, m_maxRetries, MaxRetries);
+    
+    /// save state of unfinished files so they can be resumed, default is true
+    CC_SYNTHESIZE_BOOL(m_resumeEnabled, ResumeEnabled);
 };
 
 NS_CC_END
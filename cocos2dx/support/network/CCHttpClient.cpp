@@ -25,7 +25,12 @@
 
 #include "CCHttpClient.h"
 #include <queue>
+#include <list>
+#include <map>
+#include <algorithm>
 #include <errno.h>
+#include <unistd.h>
+#include <sys/select.h>
 #include "curl/curl.h"
 #include <pthread.h>
 #include "cocoa/CCData.h"
@@ -72,8 +77,8 @@ public:
     /// done flag
     bool m_done;
     
-    /// undelivered data
-    CCData* m_data;
+    /// undelivered data, it is moved to response when notification is posted
+    CCByteBuffer* m_body;
     
     /// is kCCNotificationHttpDidReceiveResponse delivered?
     bool isHttpDidReceiveResponseDelivered;
@@ -91,9 +96,12 @@ public:
     isHeaderAllReceived(false),
     m_headers(NULL) {
         // data
-        m_data = new CCData();
+        m_body = new CCByteBuffer((size_t)0);
+        m_body->initChunked();
         m_ctx = (ccHttpContext*)calloc(1, sizeof(ccHttpContext));
         memcpy(m_ctx, ctx, sizeof(ccHttpContext));
+        m_ctx->response = new CCHttpResponse(m_ctx->request);
+        m_errorBuffer[0] = 0;
         
         // create mutex
         pthread_mutexattr_t attr;
@@ -107,14 +115,13 @@ public:
     }
     
     virtual ~CURLHandler() {
-        if(m_curl)
-            curl_easy_cleanup(m_curl);
+        // curl handle is returned to engine pool before request is done
         if(m_headers)
             curl_slist_free_all(m_headers);
         CC_SAFE_RELEASE(m_ctx->request);
         CC_SAFE_RELEASE(m_ctx->response);
         CC_SAFE_FREE(m_ctx);
-        CC_SAFE_RELEASE(m_data);
+        CC_SAFE_RELEASE(m_body);
         pthread_mutex_destroy(&m_mutex);
     }
     
@@ -125,7 +132,7 @@ public:
         
         // add data to the end of recvBuffer
         pthread_mutex_lock(&handler->m_mutex);
-        handler->m_data->appendBytes((uint8_t*)ptr, sizes);
+        handler->m_body->write((const uint8*)ptr, sizes);
         handler->isHeaderAllReceived = true;
         pthread_mutex_unlock(&handler->m_mutex);
         
@@ -144,8 +151,26 @@ public:
         // lock
         pthread_mutex_lock(&handler->m_mutex);
         
-        // parse pair
+        // status line, so response code is known when header notification is posted. With
+        // redirect, later one wins
         string header((const char*)ptr, sizes);
+        if(!header.compare(0, 5, "HTTP/")) {
+            size_t codeStart = header.find(' ');
+            if(codeStart != string::npos) {
+                handler->m_ctx->response->setResponseCode(atoi(header.c_str() + codeStart + 1));
+            }
+        }
+        
+        // blank line ends headers, so response without body gets header notification too. Another
+        // response follows an informational or redirect one
+        if(header == "\r\n" || header == "\n") {
+            int code = handler->m_ctx->response->getResponseCode();
+            if(code >= 200 && (code < 300 || code >= 400)) {
+                handler->isHeaderAllReceived = true;
+            }
+        }
+        
+        // parse pair
         CCArray* pair = new CCArray();
         if(!header.empty()) {
             // remove head and tailing brace, bracket, parentheses
@@ -210,11 +235,9 @@ public:
             return sizes;
     }
     
-    bool init() {
-        // check
-        m_curl = curl_easy_init();
-        if (!m_curl)
-            return false;
+    /// setup a curl handle from engine pool for this request
+    bool init(CURL* curl) {
+        m_curl = curl;
         if (!configureCURL())
             return false;
         
@@ -230,7 +253,37 @@ public:
                 return false;
         }
         
+        // method
+        CCData* data = m_ctx->request->getRequestData();
+        switch (m_ctx->request->getMethod()) {
+            case kHttpGet:
+                curl_easy_setopt(m_curl, CURLOPT_FOLLOWLOCATION, 1L);
+                break;
+            case kHttpPost:
+                curl_easy_setopt(m_curl, CURLOPT_POST, 1L);
+                if(data) {
+                    curl_easy_setopt(m_curl, CURLOPT_POSTFIELDS, data->getBytes());
+                    curl_easy_setopt(m_curl, CURLOPT_POSTFIELDSIZE, (long)data->getSize());
+                }
+                break;
+            case kHttpPut:
+                curl_easy_setopt(m_curl, CURLOPT_CUSTOMREQUEST, "PUT");
+                if(data) {
+                    curl_easy_setopt(m_curl, CURLOPT_POSTFIELDS, data->getBytes());
+                    curl_easy_setopt(m_curl, CURLOPT_POSTFIELDSIZE, (long)data->getSize());
+                }
+                break;
+            case kHttpDelete:
+                curl_easy_setopt(m_curl, CURLOPT_CUSTOMREQUEST, "DELETE");
+                curl_easy_setopt(m_curl, CURLOPT_FOLLOWLOCATION, 1L);
+                break;
+            default:
+                CCLOGWARN("CCHttpClient: unkown request type, only GET, POST, PUT and DELETE are supported");
+                return false;
+        }
+        
         return curl_easy_setopt(m_curl, CURLOPT_URL, m_ctx->request->getUrl().c_str()) == CURLE_OK &&
+            curl_easy_setopt(m_curl, CURLOPT_PRIVATE, this) == CURLE_OK &&
             curl_easy_setopt(m_curl, CURLOPT_WRITEFUNCTION, writeData) == CURLE_OK &&
             curl_easy_setopt(m_curl, CURLOPT_WRITEDATA, this) == CURLE_OK &&
             curl_easy_setopt(m_curl, CURLOPT_HEADERFUNCTION, writeHeaderData) == CURLE_OK &&
@@ -241,10 +294,10 @@ public:
         if(curl_easy_setopt(m_curl, CURLOPT_ERRORBUFFER, m_errorBuffer) != CURLE_OK) {
             return false;
         }
-        if(curl_easy_setopt(m_curl, CURLOPT_TIMEOUT, m_ctx->readTimeout) != CURLE_OK) {
+        if(curl_easy_setopt(m_curl, CURLOPT_TIMEOUT, (long)m_ctx->readTimeout) != CURLE_OK) {
             return false;
         }
-        if(curl_easy_setopt(m_curl, CURLOPT_CONNECTTIMEOUT, m_ctx->connectTimeout) != CURLE_OK) {
+        if(curl_easy_setopt(m_curl, CURLOPT_CONNECTTIMEOUT, (long)m_ctx->connectTimeout) != CURLE_OK) {
             return false;
         }
         curl_easy_setopt(m_curl, CURLOPT_SSL_VERIFYPEER, 0L);
@@ -257,52 +310,41 @@ public:
         return true;
     }
     
-    bool processGetTask() {
-        curl_easy_setopt(m_curl, CURLOPT_FOLLOWLOCATION, true);
-        return perform();
-    }
-    
-    bool processPostTask() {
-        curl_easy_setopt(m_curl, CURLOPT_POST, 1);
-        CCData* data = m_ctx->request->getRequestData();
-        if(data) {
-            curl_easy_setopt(m_curl, CURLOPT_POSTFIELDS, data->getBytes());
-            curl_easy_setopt(m_curl, CURLOPT_POSTFIELDSIZE, data->getSize());
-        }
-        return perform();
-    }
-    
-    bool processPutTask() {
-        curl_easy_setopt(m_curl, CURLOPT_CUSTOMREQUEST, "PUT");
-        CCData* data = m_ctx->request->getRequestData();
-        if(data) {
-            curl_easy_setopt(m_curl, CURLOPT_POSTFIELDS, data->getBytes());
-            curl_easy_setopt(m_curl, CURLOPT_POSTFIELDSIZE, data->getSize());
-        }
-
-        return perform();
-    }
-    
-    bool processDeleteTask() {
-        curl_easy_setopt(m_curl, CURLOPT_CUSTOMREQUEST, "DELETE");
-        curl_easy_setopt(m_curl, CURLOPT_FOLLOWLOCATION, true);
-        return perform();
-    }
-    
-    bool perform() {
-        // if easy perform not ok, return false
-        CURLcode code = curl_easy_perform(m_curl);
+    /// called by engine when transfer is finished, curl handle is still valid
+    void onTransferDone(CURLcode code) {
+        bool success = false;
         if (code != CURLE_OK) {
-            CCLOG("curl_easy_perform error: %d, request: %s", code, m_ctx->request->getUrl().c_str());
-            return false;
+            CCLOG("curl transfer error: %d, request: %s", code, m_ctx->request->getUrl().c_str());
+        } else {
+            // get return code
+            long responseCode = 0;
+            code = curl_easy_getinfo(m_curl, CURLINFO_RESPONSE_CODE, &responseCode);
+            m_responseCode = (int32_t)responseCode;
+            success = code == CURLE_OK && (m_responseCode == 200 || m_responseCode == 206);
         }
         
-        // get return code
-        code = curl_easy_getinfo(m_curl, CURLINFO_RESPONSE_CODE, &m_responseCode);
-        if (code != CURLE_OK || m_responseCode != 200)
-            return false;
+        // save response
+        m_ctx->response->setResponseCode(m_responseCode);
+        m_ctx->response->setSuccess(success);
+        if(!success) {
+            m_ctx->response->setErrorData(m_errorBuffer);
+        }
         
-        return true;
+        // redirect which is not followed is final response
+        if(code == CURLE_OK) {
+            pthread_mutex_lock(&m_mutex);
+            isHeaderAllReceived = true;
+            pthread_mutex_unlock(&m_mutex);
+        }
+    }
+    
+    /// called when request fails before it is transferred
+    void onTransferFailed(const char* error) {
+        strncpy(m_errorBuffer, error, CURL_ERROR_SIZE - 1);
+        m_errorBuffer[CURL_ERROR_SIZE - 1] = 0;
+        m_ctx->response->setResponseCode(m_responseCode);
+        m_ctx->response->setSuccess(false);
+        m_ctx->response->setErrorData(m_errorBuffer);
     }
     
     /// called when request is done
@@ -327,13 +369,11 @@ public:
         }
         
         // notification
-        if(m_data->getSize() > 0) {
-            m_ctx->response->setData(m_data);
+        if(m_body->available() > 0) {
+            // chunks are moved, not copied
+            m_ctx->response->getBody()->moveFrom(m_body);
             nc->postNotification(kCCNotificationHttpDataReceived, m_ctx->response);
-            
-            // recreate a new data
-            CC_SAFE_RELEASE(m_data);
-            m_data = new CCData();
+            m_ctx->response->resetBody();
         }
         
         // is done?
@@ -341,7 +381,7 @@ public:
             // notification
             nc->postNotification(kCCNotificationHttpRequestCompleted, m_ctx->response);
             
-            // balance retain in httpThreadEntry
+            // balance new in asyncExecute
             autorelease();
             
             // unschedule dispatcher
@@ -352,57 +392,252 @@ public:
     }
 };
 
-void* CCHttpClient::httpThreadEntry(void* arg) {
-    // handler, it is released if init failed or released in dispatchNotification
-    ccHttpContext* ctx = (ccHttpContext*)arg;
-    CURLHandler* curl = ctx->curl;
-    if(!curl->init()) {
-        CC_SAFE_RELEASE_NULL(curl);
+/// shared network thread which runs all requests with curl multi interface
+class CCHttpEngine {
+private:
+    /// lock of pending list and settings
+    pthread_mutex_t m_mutex;
+    pthread_cond_t m_cond;
+    bool m_threadStarted;
+    
+    /// requests not started yet
+    list<CURLHandler*> m_pending;
+    
+    /// settings, applied by network thread
+    int m_maxConnections;
+    int m_maxConnectionsPerHost;
+    bool m_pipelining;
+    bool m_settingsDirty;
+    
+    /// below are only accessed in network thread
+    CURLM* m_multi;
+    vector<CURLHandler*> m_active;
+    vector<CURL*> m_idleHandles;
+    map<string, int> m_hostConnections;
+    
+private:
+    CCHttpEngine() :
+    m_threadStarted(false),
+    m_maxConnections(16),
+    m_maxConnectionsPerHost(4),
+    m_pipelining(false),
+    m_settingsDirty(true),
+    m_multi(NULL) {
+        pthread_mutex_init(&m_mutex, NULL);
+        pthread_cond_init(&m_cond, NULL);
     }
     
-    if(curl) {
-        // create response
-        CCHttpResponse* response = new CCHttpResponse(curl->m_ctx->request);
-        curl->m_ctx->response = response;
-        
-        // process request
-        bool retValue = false;
-        switch (curl->m_ctx->request->getMethod()) {
-            case kHttpGet:
-                retValue = curl->processGetTask();
-                break;
-            case kHttpPost:
-                retValue = curl->processPostTask();
-                break;
-            case kHttpPut:
-                retValue = curl->processPutTask();
-                break;
-            case kHttpDelete:
-                retValue = curl->processDeleteTask();
-                break;
-            default:
-                CCAssert(true, "CCHttpClient: unkown request type, only GET and POST are supported");
+    static void* threadEntry(void* arg) {
+        ((CCHttpEngine*)arg)->run();
+        return NULL;
+    }
+    
+    /// host part of url, key of per host limit
+    static string hostOf(const string& url) {
+        size_t start = url.find("://");
+        start = start == string::npos ? 0 : start + 3;
+        size_t end = url.find_first_of("/?#", start);
+        return url.substr(start, end == string::npos ? string::npos : end - start);
+    }
+    
+    /// get a curl handle, idle one is reused so it keeps its dns and tls session cache
+    CURL* obtainHandle() {
+        if(m_idleHandles.empty())
+            return curl_easy_init();
+        CURL* curl = m_idleHandles.back();
+        m_idleHandles.pop_back();
+        return curl;
+    }
+    
+    /// reset and keep handle for next request
+    void recycleHandle(CURL* curl) {
+        curl_easy_reset(curl);
+        if((int)m_idleHandles.size() < m_maxConnections)
+            m_idleHandles.push_back(curl);
+        else
+            curl_easy_cleanup(curl);
+    }
+    
+    /// start pending requests by priority, must be locked
+    void startPending() {
+        while((int)m_active.size() < m_maxConnections) {
+            // highest priority whose host is not full, first added one wins a tie
+            list<CURLHandler*>::iterator pick = m_pending.end();
+            for(list<CURLHandler*>::iterator iter = m_pending.begin(); iter != m_pending.end(); iter++) {
+                CCHttpRequest* request = (*iter)->m_ctx->request;
+                if(pick != m_pending.end() && request->getPriority() <= (*pick)->m_ctx->request->getPriority())
+                    continue;
+                if(!request->isCancel()) {
+                    map<string, int>::iterator host = m_hostConnections.find(hostOf(request->getUrl()));
+                    if(host != m_hostConnections.end() && host->second >= m_maxConnectionsPerHost)
+                        continue;
+                }
+                pick = iter;
+            }
+            if(pick == m_pending.end())
                 break;
+            CURLHandler* handler = *pick;
+            m_pending.erase(pick);
+            
+            // cancelled before started
+            if(handler->m_ctx->request->isCancel()) {
+                handler->onTransferFailed("cancelled");
+                handler->onRequestDone();
+                continue;
+            }
+            
+            // start
+            CURL* curl = obtainHandle();
+            if(!curl || !handler->init(curl) || curl_multi_add_handle(m_multi, curl) != CURLM_OK) {
+                if(curl)
+                    recycleHandle(curl);
+                handler->m_curl = NULL;
+                handler->onTransferFailed("failed to setup curl");
+                handler->onRequestDone();
+                continue;
+            }
+            m_hostConnections[hostOf(handler->m_ctx->request->getUrl())]++;
+            m_active.push_back(handler);
         }
-        
-        // save response
-        response->setResponseCode(curl->m_responseCode);
-        if (retValue) {
-            response->setSuccess(true);
+    }
+    
+    /// finish an active request, handler can't be touched after it
+    void finish(CURLHandler* handler, CURLcode code) {
+        handler->onTransferDone(code);
+        curl_multi_remove_handle(m_multi, handler->m_curl);
+        recycleHandle(handler->m_curl);
+        handler->m_curl = NULL;
+        m_active.erase(find(m_active.begin(), m_active.end(), handler));
+        string host = hostOf(handler->m_ctx->request->getUrl());
+        if(--m_hostConnections[host] <= 0)
+            m_hostConnections.erase(host);
+        handler->onRequestDone();
+    }
+    
+    /// wait socket activity, it is short so new and cancelled requests are picked up soon
+    void waitActivity() {
+        fd_set readSet, writeSet, errorSet;
+        FD_ZERO(&readSet);
+        FD_ZERO(&writeSet);
+        FD_ZERO(&errorSet);
+        int maxfd = -1;
+        long timeout = -1;
+        curl_multi_fdset(m_multi, &readSet, &writeSet, &errorSet, &maxfd);
+        curl_multi_timeout(m_multi, &timeout);
+        if(timeout < 0 || timeout > 10)
+            timeout = 10;
+        if(maxfd < 0) {
+            usleep(timeout * 1000);
         } else {
-            response->setSuccess(false);
-            response->setErrorData(curl->m_errorBuffer);
+            struct timeval tv;
+            tv.tv_sec = 0;
+            tv.tv_usec = timeout * 1000;
+            select(maxfd + 1, &readSet, &writeSet, &errorSet, &tv);
         }
-        
-        // done
-        curl->onRequestDone();
     }
-
-    // exit
-    pthread_exit(NULL);
     
-    return NULL;
-}
+    void run() {
+        m_multi = curl_multi_init();
+        while(true) {
+            // sleep if nothing to do
+            pthread_mutex_lock(&m_mutex);
+            while(m_pending.empty() && m_active.empty()) {
+                pthread_cond_wait(&m_cond, &m_mutex);
+            }
+            if(m_settingsDirty) {
+                m_settingsDirty = false;
+                curl_multi_setopt(m_multi, CURLMOPT_MAXCONNECTS, (long)m_maxConnections);
+                curl_multi_setopt(m_multi, CURLMOPT_PIPELINING, m_pipelining ? 1L : 0L);
+            }
+            startPending();
+            pthread_mutex_unlock(&m_mutex);
+            
+            // abort cancelled transfers, don't wait for data callback
+            for(int i = (int)m_active.size() - 1; i >= 0; i--) {
+                if(m_active[i]->m_ctx->request->isCancel()) {
+                    finish(m_active[i], CURLE_ABORTED_BY_CALLBACK);
+                }
+            }
+            
+            // transfer
+            int running = 0;
+            while(curl_multi_perform(m_multi, &running) == CURLM_CALL_MULTI_PERFORM);
+            
+            // collect finished
+            int left = 0;
+            CURLMsg* msg = NULL;
+            while((msg = curl_multi_info_read(m_multi, &left)) != NULL) {
+                if(msg->msg == CURLMSG_DONE) {
+                    CURLHandler* handler = NULL;
+                    curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char**)&handler);
+                    if(handler)
+                        finish(handler, msg->data.result);
+                }
+            }
+            
+            if(!m_active.empty())
+                waitActivity();
+        }
+    }
+    
+public:
+    static CCHttpEngine* sharedEngine() {
+        static CCHttpEngine* s_engine = NULL;
+        if(!s_engine) {
+            // multi interface doesn't do global init, and it is not thread safe
+            curl_global_init(CURL_GLOBAL_ALL);
+            s_engine = new CCHttpEngine();
+        }
+        return s_engine;
+    }
+    
+    /// queue a request, network thread is started lazily
+    void enqueue(CURLHandler* handler) {
+        pthread_mutex_lock(&m_mutex);
+        m_pending.push_back(handler);
+        if(!m_threadStarted) {
+            pthread_t thread;
+            m_threadStarted = pthread_create(&thread, NULL, threadEntry, this) == 0;
+            if(m_threadStarted)
+                pthread_detach(thread);
+        }
+        pthread_cond_signal(&m_cond);
+        pthread_mutex_unlock(&m_mutex);
+    }
+    
+    /// wake network thread, for cancel
+    void wakeup() {
+        pthread_mutex_lock(&m_mutex);
+        pthread_cond_signal(&m_cond);
+        pthread_mutex_unlock(&m_mutex);
+    }
+    
+    void setMaxConnections(int max) {
+        pthread_mutex_lock(&m_mutex);
+        m_maxConnections = MAX(1, max);
+        m_settingsDirty = true;
+        pthread_mutex_unlock(&m_mutex);
+    }
+    
+    int getMaxConnections() { return m_maxConnections; }
+    
+    void setMaxConnectionsPerHost(int max) {
+        pthread_mutex_lock(&m_mutex);
+        m_maxConnectionsPerHost = MAX(1, max);
+        pthread_mutex_unlock(&m_mutex);
+    }
+    
+    int getMaxConnectionsPerHost() { return m_maxConnectionsPerHost; }
+    
+    void setPipeliningEnabled(bool enabled) {
+        pthread_mutex_lock(&m_mutex);
+        m_pipelining = enabled;
+        m_settingsDirty = true;
+        pthread_mutex_unlock(&m_mutex);
+    }
+    
+    bool isPipeliningEnabled() { return m_pipelining; }
+};
 
 CCHttpClient::CCHttpClient() :
 m_connectTimeout(30),
@@ -448,10 +683,8 @@ void CCHttpClient::asyncExecute(CCHttpRequest* request) {
     // add to cache and clear useless context
     m_activeContexts.push_back(ctx);
 
-    // start network thread
-    pthread_t thread;
-    pthread_create(&thread, NULL, httpThreadEntry, ctx);
-    pthread_detach(thread);
+    // queue to network thread
+    CCHttpEngine::sharedEngine()->enqueue(ctx->curl);
 }
 
 void CCHttpClient::cancel(int tag) {
@@ -459,6 +692,7 @@ void CCHttpClient::cancel(int tag) {
         ccHttpContext* ctx = (ccHttpContext*)*iter;
         if(ctx->request->getTag() == tag) {
             ctx->request->setCancel(true);
+            CCHttpEngine::sharedEngine()->wakeup();
             break;
         }
     }
@@ -469,6 +703,31 @@ void CCHttpClient::cancelAll() {
         ccHttpContext* ctx = (ccHttpContext*)*iter;
         ctx->request->setCancel(true);
     }
+    CCHttpEngine::sharedEngine()->wakeup();
+}
+
+void CCHttpClient::setMaxConnections(int max) {
+    CCHttpEngine::sharedEngine()->setMaxConnections(max);
+}
+
+int CCHttpClient::getMaxConnections() {
+    return CCHttpEngine::sharedEngine()->getMaxConnections();
+}
+
+void CCHttpClient::setMaxConnectionsPerHost(int max) {
+    CCHttpEngine::sharedEngine()->setMaxConnectionsPerHost(max);
+}
+
+int CCHttpClient::getMaxConnectionsPerHost() {
+    return CCHttpEngine::sharedEngine()->getMaxConnectionsPerHost();
+}
+
+void CCHttpClient::setPipeliningEnabled(bool enabled) {
+    CCHttpEngine::sharedEngine()->setPipeliningEnabled(enabled);
+}
+
+bool CCHttpClient::isPipeliningEnabled() {
+    return CCHttpEngine::sharedEngine()->isPipeliningEnabled();
 }
 
 NS_CC_END
\ No newline at end of file
@@ -53,15 +53,18 @@ NS_CC_BEGIN
  * You don't need hold a http client, the http request will be executed in a thread so retaining a client
  * instance or not doesn't matter.
  *
+ * \par
+ * All clients share one network thread which runs requests with curl multi interface. Connections are
+ * kept alive and reused by later requests to same host, so DNS, TCP and TLS setup is not done again.
+ * Concurrent connections are limited in total and per host, pending requests are started by priority.
+ * Notifications are still posted in main thread.
+ *
  * \note
  * Using CB prefix to avoid name conflict, CB stands for cocos2dx-classical. When you see a class starts with CB,
  * you should know it is a rewriten class which is better than the original.
  */
 class CC_DLL CCHttpClient : public CCObject {
 private:
-    /// thread entry
-    static void* httpThreadEntry(void* arg);
-    
     /// handler map, key is tag
     vector<void*> m_activeContexts;
     
@@ -88,6 +91,21 @@ public:
     
     /// stop all ongoing http operation
     void cancelAll();
+    
+    /// max concurrent connections of all clients, default is 16
+    static void setMaxConnections(int max);
+    static int getMaxConnections();
+    
+    /// max concurrent connections to one host, default is 4
+    static void setMaxConnectionsPerHost(int max);
+    static int getMaxConnectionsPerHost();
+    
+    /**
+     * enable http pipelining, requests to same host can be sent on one connection without
+     * waiting previous response. Server must support it, by default it is disabled
+     */
+    static void setPipeliningEnabled(bool enabled);
+    static bool isPipeliningEnabled();
   
     /// connect timeout
     CC_SYNTHESIZE(float, m_connectTimeout, ConnectTimeout);
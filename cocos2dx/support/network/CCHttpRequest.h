@@ -51,6 +51,7 @@ public:
         m_requestData = NULL;
         m_userData = NULL;
         m_tag = -1;
+        m_priority = 0;
         m_cancel = false;
     }
     
@@ -73,6 +74,9 @@ public:
     /// tag if you want to identify request
     CC_SYNTHESIZE_PASS_BY_REF(int, m_tag, Tag);
     
+    /// priority, pending request with higher priority is started first, default is 0
+    CC_SYNTHESIZE(int, m_priority, Priority);
+    
     /// custom data, request doesn't retain it
     CC_SYNTHESIZE(void*, m_userData, UserData);
     
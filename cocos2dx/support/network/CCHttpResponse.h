@@ -26,6 +26,7 @@
 
 #include "ccTypes.h"
 #include "CCHttpRequest.h"
+#include "CCByteBuffer.h"
 #include "cocoa/CCData.h"
 #include "support/utils/CCUtils.h"
 #include "cocoa/CCDictionary.h"
@@ -41,17 +42,27 @@ class CC_DLL CCHttpResponse : public CCObject {
 private:
     CCData m_errorData;
     
+    /// data segment of last receive
+    CCByteBuffer* m_body;
+    
+    /// copy of body for getData
+    CCData* m_data;
+    
 public:
     CCHttpResponse(CCHttpRequest* request) :
+    m_body(new CCByteBuffer((size_t)0)),
+    m_data(NULL),
+    m_request(request),
     m_success(false),
-    m_request(NULL),
     m_responseCode(0) {
-        m_request = request;
         CC_SAFE_RETAIN(m_request);
+        m_body->initChunked();
     }
     
     virtual ~CCHttpResponse() {
         CC_SAFE_RELEASE(m_request);
+        CC_SAFE_RELEASE(m_data);
+        CC_SAFE_RELEASE(m_body);
     }
     
     /// get error data
@@ -77,8 +88,38 @@ public:
         return value ? value->getCString() : "";
     }
     
-    /// data segment of last receive, it is just used for notification
-    CC_SYNTHESIZE(CCData*, m_data, Data);
+    /**
+     * data segment of last receive, it is just used for notification. It is copied from body
+     * when it is called first time in a notification, use getBody to avoid copy
+     */
+    CCData* getData() {
+        if(!m_data) {
+            m_data = new CCData();
+            struct iovec iov[16];
+            size_t pos = m_body->getReadPos();
+            int n;
+            while((n = m_body->getReadableVectors(iov, 16)) > 0) {
+                for(int i = 0; i < n; i++) {
+                    m_data->appendBytes((uint8_t*)iov[i].iov_base, iov[i].iov_len);
+                    m_body->skip(iov[i].iov_len);
+                }
+            }
+            m_body->setReadPos(pos);
+        }
+        return m_data;
+    }
+    
+    /**
+     * data segment of last receive in a chunked buffer, it is just used for notification. Observer
+     * can take data by CCByteBuffer::moveFrom without copy, then it is gone for other observers
+     */
+    CCByteBuffer* getBody() { return m_body; }
+    
+    /// drop data segment of last notification, called by client
+    void resetBody() {
+        m_body->clear();
+        CC_SAFE_RELEASE_NULL(m_data);
+    }
     
     /// request
     CC_SYNTHESIZE_READONLY(CCHttpRequest*, m_request, Request);
@@ -86,7 +127,7 @@ public:
     /// success flag
     CC_SYNTHESIZE_BOOL(m_success, Success);
     
-    /// response code
+    /// response code, it is available since kCCNotificationHttpDidReceiveResponse
     CC_SYNTHESIZE(int, m_responseCode, ResponseCode);
     
     /// header map
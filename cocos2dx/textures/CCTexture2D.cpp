@@ -45,6 +45,7 @@ THE SOFTWARE.
 #include "shaders/CCGLProgram.h"
 #include "shaders/ccGLStateCache.h"
 #include "shaders/CCShaderCache.h"
+#include <pthread.h>
 
 #if CC_ENABLE_CACHE_TEXTURE_DATA
     #include "CCTextureCache.h"
@@ -505,6 +506,14 @@ bool CCTexture2D::initWithString(const char *text, const char *fontName, float f
 }
 
 bool CCTexture2D::initWithString(const char *text, ccFontDefinition *textDefinition)
+{
+    CCImage* pImage = new CCImage();
+    bool bRet = renderStringImage(pImage, text, textDefinition) && initWithStringImage(text, textDefinition, pImage);
+    CC_SAFE_RELEASE(pImage);
+    return bRet;
+}
+
+bool CCTexture2D::initWithStringImage(const char *text, ccFontDefinition *textDefinition, CCImage *image)
 {
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID) || (CC_TARGET_PLATFORM == CC_PLATFORM_IOS)
     #if CC_ENABLE_CACHE_TEXTURE_DATA
@@ -512,7 +521,30 @@ bool CCTexture2D::initWithString(const char *text, ccFontDefinition *textDefinit
         VolatileTexture::addStringTexture(this, text, *textDefinition);
     #endif
     
-    bool bRet = false;
+    bool bRet = initWithImage(image);
+    
+    // save info needed by rich label
+    m_shadowStrokePadding = image->getShadowStrokePadding();
+    m_linkMetas = image->getLinkMetas();
+    m_imageRects = image->getImageRects();
+    m_realLength = image->getRealLength();
+    m_needTime = image->isNeedTime();
+    
+    return bRet;
+#else
+    CCAssert(false, "Currently only supported on iOS and Android!");
+    return false;
+#endif
+}
+
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID) || (CC_TARGET_PLATFORM == CC_PLATFORM_IOS)
+// platform text renderers use a shared bitmap, so only one string is rendered at a time
+static pthread_mutex_t s_stringImageMutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+bool CCTexture2D::renderStringImage(CCImage *image, const char *text, ccFontDefinition *textDefinition)
+{
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID) || (CC_TARGET_PLATFORM == CC_PLATFORM_IOS)
     CCImage::ETextAlign eAlign;
     
     if (kCCVerticalTextAlignmentTop == textDefinition->m_vertAlignment)
@@ -568,12 +600,8 @@ bool CCTexture2D::initWithString(const char *text, ccFontDefinition *textDefinit
         strokeSize   = textDefinition->m_stroke.m_strokeSize;
     }
     
-    CCImage* pImage = new CCImage();
-    do
-    {
-        CC_BREAK_IF(NULL == pImage);
-        
-        bRet = pImage->initWithStringShadowStroke(text,
+    pthread_mutex_lock(&s_stringImageMutex);
+    bool bRet = image->initWithStringShadowStroke(text,
                                                   (int)textDefinition->m_dimensions.width,
                                                   (int)textDefinition->m_dimensions.height,
                                                   eAlign,
@@ -596,20 +624,7 @@ bool CCTexture2D::initWithString(const char *text, ccFontDefinition *textDefinit
                                                   textDefinition->m_globalImageScaleFactor,
                                                   textDefinition->m_toCharIndex,
                                                   textDefinition->m_elapsed);
-        
-        
-        CC_BREAK_IF(!bRet);
-        bRet = initWithImage(pImage);
-        
-        // save info needed by rich label
-        m_shadowStrokePadding = pImage->getShadowStrokePadding();
-        m_linkMetas = pImage->getLinkMetas();
-        m_imageRects = pImage->getImageRects();
-        m_realLength = pImage->getRealLength();
-        m_needTime = pImage->isNeedTime();
-    } while (0);
-    
-    CC_SAFE_RELEASE(pImage);
+    pthread_mutex_unlock(&s_stringImageMutex);
     
     return bRet;
 #else
@@ -167,6 +167,12 @@ public:
     bool initWithString(const char *text, const char *fontName, float fontSize);
     /** Initializes a texture from a string using a text definition*/
     bool initWithString(const char *text, ccFontDefinition *textDefinition);
+    /** Initializes a texture from an image rendered by renderStringImage, it keeps rich label
+     info of image. It must be called in GL thread */
+    bool initWithStringImage(const char *text, ccFontDefinition *textDefinition, CCImage *image);
+    /** Renders a string into an image using a text definition, without any OpenGL call. It can be
+     called from any thread, rendering is serialized because platform text renderers share state */
+    static bool renderStringImage(CCImage *image, const char *text, ccFontDefinition *textDefinition);
     
     /** Initializes a texture from a PVR file */
     bool initWithPVRFile(const char* file);
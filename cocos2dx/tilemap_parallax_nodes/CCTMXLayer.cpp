@@ -28,21 +28,28 @@
 #include "sprite_nodes/CCSpriteBatchNode.h"
 #include "cocoa/CCPointExtension.h"
 #include "shaders/CCShaderCache.h"
+#include "CCDirector.h"
 
 NS_CC_BEGIN
 
-CCTMXLayer::CCTMXLayer(int layerIndex, CCTMXMapInfo* mapInfo) :
-m_mapInfo(mapInfo),
-m_layerInfo(NULL),
+CCTMXLayer::CCTMXLayer(int layerIndex, CCTMXMapInfo* mapInfo, int chunkSize) :
+m_tiles(NULL),
 m_reusedTile(NULL),
+m_chunkColumns(0),
+m_chunkRows(0),
+m_chunkBounds(NULL),
+m_chunkSlots(NULL),
+m_chunksDirty(true),
+m_chunkSize(chunkSize),
 m_tileWidth(mapInfo->getTileWidth()),
 m_tileHeight(mapInfo->getTileHeight()),
-m_batchNodes(NULL),
-m_tiles(NULL),
-m_atlasInfos(NULL),
-m_useAutomaticVertexZ(false),
 m_minGid(MAX_INT),
 m_maxGid(0),
+m_mapInfo(mapInfo),
+m_layerInfo(NULL),
+m_atlasInfos(NULL),
+m_batchNodes(NULL),
+m_useAutomaticVertexZ(false),
 m_vertexZ(0),
 m_alphaFuncValue(0) {
 	// retain map info
@@ -58,10 +65,20 @@ m_alphaFuncValue(0) {
     m_tiles = m_layerInfo->getTiles();
     setOpacity(m_layerInfo->getAlpha());
     
-    // allocate memory for atlas indices
-    size_t size = m_layerInfo->getLayerWidth() * m_layerInfo->getLayerHeight() * sizeof(TileSetAtlasInfo);
-    m_atlasInfos = (TileSetAtlasInfo*)malloc(size);
-    memset(m_atlasInfos, 0xff, size);
+    // chunk size can be set by layer or map property
+    if(m_chunkSize <= 0) {
+        string cs = m_layerInfo->getProperty("cc_chunk_size");
+        if(cs.empty())
+            cs = m_mapInfo->getProperty("cc_chunk_size");
+        m_chunkSize = MAX(0, atoi(cs.c_str()));
+    }
+    
+    // allocate memory for atlas indices, chunked layer doesn't need it
+    if(m_chunkSize <= 0) {
+        size_t size = m_layerInfo->getLayerWidth() * m_layerInfo->getLayerHeight() * sizeof(TileSetAtlasInfo);
+        m_atlasInfos = (TileSetAtlasInfo*)malloc(size);
+        memset(m_atlasInfos, 0xff, size);
+    }
 	
 	// memory for batch node array
 	m_batchNodes = (CCSpriteBatchNode**)calloc(mapInfo->getTileSets().count(), sizeof(CCSpriteBatchNode*));
@@ -90,7 +107,10 @@ m_alphaFuncValue(0) {
 	setPosition(offset.x, offset.y);
 	
 	// setup tiles
-	setupTiles();
+	if(m_chunkSize > 0)
+		setupChunks();
+	else
+		setupTiles();
 }
 
 CCTMXLayer::~CCTMXLayer() {
@@ -99,10 +119,16 @@ CCTMXLayer::~CCTMXLayer() {
 	CC_SAFE_RELEASE(m_reusedTile);
 	CC_SAFE_FREE(m_batchNodes);
 	CC_SAFE_FREE(m_atlasInfos);
+	CC_SAFE_DELETE_ARRAY(m_chunkBounds);
+	CC_SAFE_FREE(m_chunkSlots);
 }
 
 CCTMXLayer* CCTMXLayer::create(int layerIndex, CCTMXMapInfo* mapInfo) {
-	CCTMXLayer* l = new CCTMXLayer(layerIndex, mapInfo);
+	return create(layerIndex, mapInfo, 0);
+}
+
+CCTMXLayer* CCTMXLayer::create(int layerIndex, CCTMXMapInfo* mapInfo, int chunkSize) {
+	CCTMXLayer* l = new CCTMXLayer(layerIndex, mapInfo, chunkSize);
 	if(l->init()) {
 		CC_SAFE_AUTORELEASE_RETURN(l, CCTMXLayer*);
 	}
@@ -276,6 +302,13 @@ void CCTMXLayer::setTileColorAt(ccColor4B c, int x, int y) {
 	if(gid <= 0)
 		return;
 	
+	// chunked layer remembers color so it survives chunk recycling
+	if(m_chunkSize > 0) {
+		m_tileColors[x + y * m_layerWidth] = c;
+		updateChunkedTileAt(x, y);
+		return;
+	}
+	
 	// get tileset index and rect
 	int tilesetIndex = m_mapInfo->getTileSetIndex(gid);
 	CCTMXTileSetInfo* tileset = (CCTMXTileSetInfo*)m_mapInfo->getTileSets().objectAtIndex(tilesetIndex);
@@ -415,12 +448,7 @@ void CCTMXLayer::setupTiles() {
                 int tilesetIndex = m_mapInfo->getTileSetIndex(gid);
                 
                 // if corresponded batch not is not created, create it and add it
-                if(m_batchNodes[tilesetIndex] == NULL) {
-                    CCTMXTileSetInfo* tileset = (CCTMXTileSetInfo*)m_mapInfo->getTileSets().objectAtIndex(tilesetIndex);
-                    CCSpriteBatchNode* bn = CCSpriteBatchNode::createWithTexture(tileset->getTexture());
-                    m_batchNodes[tilesetIndex] = bn;
-                    addChild(bn, tilesetIndex);
-                }
+                batchNodeForTileset(tilesetIndex);
                 
                 // append tile
 				appendTileForGid(tilesetIndex, gid, x, y);
@@ -429,16 +457,31 @@ void CCTMXLayer::setupTiles() {
 			}
 		}
 	}
-    
-    // set program to batch node
-    if(getShaderProgram()) {
-        int c = m_mapInfo->getTileSets().count();
-        for(int i = 0; i < c; i++) {
-            if(m_batchNodes[i]) {
-                m_batchNodes[i]->setShaderProgram(getShaderProgram());
-            }
+}
+
+CCSpriteBatchNode* CCTMXLayer::batchNodeForTileset(int tilesetIndex) {
+    if(m_batchNodes[tilesetIndex] == NULL) {
+        CCTMXTileSetInfo* tileset = (CCTMXTileSetInfo*)m_mapInfo->getTileSets().objectAtIndex(tilesetIndex);
+        CCSpriteBatchNode* bn = CCSpriteBatchNode::createWithTexture(tileset->getTexture());
+        m_batchNodes[tilesetIndex] = bn;
+        addChild(bn, tilesetIndex);
+        
+        // set program to batch node
+        if(getShaderProgram()) {
+            bn->setShaderProgram(getShaderProgram());
+        }
+        
+        // in chunked mode, every atlas has same slots so tile atlas index doesn't depend on tileset
+        int quads = m_slotChunks.size() * m_chunkSize * m_chunkSize;
+        if(quads > 0) {
+            CCTextureAtlas* atlas = bn->getTextureAtlas();
+            atlas->resizeCapacity(quads);
+            memset(atlas->getQuads(), 0, quads * sizeof(ccV3F_C4B_T2F_Quad));
+            atlas->increaseTotalQuadsWith(quads);
+            atlas->setDirty(true);
         }
     }
+    return m_batchNodes[tilesetIndex];
 }
 
 void CCTMXLayer::setAntiAliasTexParameters() {
@@ -509,6 +552,12 @@ void CCTMXLayer::removeTile(CCSprite* sprite) {
 	if(z < 0 || z >= m_layerWidth * m_layerHeight)
 		return;
 	
+	// chunked layer finds sprite by itself
+	if(m_chunkSize > 0) {
+		removeTileAt(z % m_layerWidth, z / m_layerWidth);
+		return;
+	}
+	
     // get batch node atlas
     CCSpriteBatchNode* bn = m_batchNodes[m_atlasInfos[z].tilesetIndex];
 	
@@ -533,8 +582,23 @@ void CCTMXLayer::removeTileAt(int x, int y) {
 	if(x < 0 || x >= m_layerWidth || y < 0 || y >= m_layerHeight)
 		return;
 	
-	// find index
+	// in chunked mode, detach tile sprite if has and clear quad
 	int z = x + y * m_layerWidth;
+	if(m_chunkSize > 0) {
+		int tilesetIndex = m_tiles[z] != 0 ? m_mapInfo->getTileSetIndex(m_tiles[z]) : -1;
+		if(tilesetIndex < 0)
+			return;
+		CCSpriteBatchNode* bn = m_batchNodes[tilesetIndex];
+		CCSprite* sprite = bn ? (CCSprite*)bn->getChildByTag(z) : NULL;
+		if(sprite)
+			removeChunkedTileSprite(bn, sprite);
+		m_tiles[z] = 0;
+		m_tileColors.erase(z);
+		updateChunkedTileAt(x, y);
+		return;
+	}
+	
+	// find index
 	int index = m_atlasInfos[z].atlasIndex;
 	if(index < 0)
 		return;
@@ -588,14 +652,9 @@ void CCTMXLayer::setTileAt(int tilesetIndex, int gid, int x, int y, int z) {
     CCRect rect = tileset->getRect(gid);
 	
     // if coorespond batch not is not created, create it and add it
-    if(m_batchNodes[tilesetIndex] == NULL) {
-        CCSpriteBatchNode* bn = CCSpriteBatchNode::createWithTexture(tileset->getTexture());
-        m_batchNodes[tilesetIndex] = bn;
-        addChild(bn, tilesetIndex);
-    }
+	CCSpriteBatchNode* bn = batchNodeForTileset(tilesetIndex);
     
     // get atlas and tileset
-	CCSpriteBatchNode* bn = m_batchNodes[tilesetIndex];
     CCTextureAtlas* atlas = bn->getTextureAtlas();
     int index = atlas->getTotalQuads();
 	
@@ -643,6 +702,15 @@ void CCTMXLayer::setTileAt(int gid, int x, int y) {
     if(tilesetIndex < 0)
         return;
     
+    // chunked layer has no atlas index array, just save gid and refresh quad
+    if(m_chunkSize > 0) {
+        removeTileAt(x, y);
+        batchNodeForTileset(tilesetIndex);
+        m_tiles[x + y * m_layerWidth] = gid;
+        updateChunkedTileAt(x, y);
+        return;
+    }
+    
     // if same tileset, and index is not zero, just update it
     // if same tileset, but index is zero, set it
     // if not same tileset, first remove it and then set it
@@ -673,6 +741,12 @@ void CCTMXLayer::updateTileAt(int gid, int x, int y) {
 	if(x < 0 || x >= m_layerWidth || y < 0 || y >= m_layerHeight)
 		return;
 	
+	// no difference between set and update in chunked mode
+	if(m_chunkSize > 0) {
+		setTileAt(gid, x, y);
+		return;
+	}
+	
     // decide tileset index
     int tilesetIndex = m_mapInfo->getTileSetIndex(gid);
     
@@ -727,7 +801,7 @@ CCSprite* CCTMXLayer::tileAt(int x, int y) {
         int tilesetIndex = m_mapInfo->getTileSetIndex(gid);
         
         // get batch node and tileset
-        CCSpriteBatchNode* bn = m_batchNodes[tilesetIndex];
+        CCSpriteBatchNode* bn = batchNodeForTileset(tilesetIndex);
         CCTMXTileSetInfo* tileset = (CCTMXTileSetInfo*)m_mapInfo->getTileSets().objectAtIndex(tilesetIndex);
         CCRect rect = tileset->getRect(gid);
 		
@@ -736,7 +810,11 @@ CCSprite* CCTMXLayer::tileAt(int x, int y) {
 		tile = (CCSprite*)bn->getChildByTag(z);
 		
 		// if not exist, create a new
+		// in chunked mode, tile chunk must have quads and it is pinned until sprite is removed
 		if(!tile) {
+			if(m_chunkSize > 0)
+				materializeChunk(x / m_chunkSize + y / m_chunkSize * m_chunkColumns);
+			
 			CCPoint origin = getPositionAt(x, y);
 			tile = new CCSprite();
             tile->initWithTexture(bn->getTextureAtlas()->getTexture(), rect);
@@ -747,7 +825,7 @@ CCSprite* CCTMXLayer::tileAt(int x, int y) {
 			tile->setColor(getColor());
             tile->setOpacity(m_layerInfo->getAlpha());
 			
-            int index = m_atlasInfos[z].atlasIndex;
+            int index = m_chunkSize > 0 ? chunkedAtlasIndexAt(x, y) : m_atlasInfos[z].atlasIndex;
             bn->addSpriteWithoutQuad(tile, index, z);
             CC_SAFE_RELEASE(tile);
 		}
@@ -756,4 +834,345 @@ CCSprite* CCTMXLayer::tileAt(int x, int y) {
 	return tile;
 }
 
-NS_CC_END
\ No newline at end of file
+void CCTMXLayer::visit() {
+	if(m_chunkSize > 0 && isVisible())
+		updateChunks();
+	CCNodeRGBA::visit();
+}
+
+void CCTMXLayer::setupChunks() {
+	// Parse cocos2d properties
+	parseInternalProperties();
+	
+	// gid range
+	int total = m_layerWidth * m_layerHeight;
+	for(int i = 0; i < total; i++) {
+		if(m_tiles[i] != 0) {
+			m_minGid = MIN(m_minGid, m_tiles[i]);
+			m_maxGid = MAX(m_maxGid, m_tiles[i]);
+		}
+	}
+	
+	// chunk grid
+	m_chunkColumns = (m_layerWidth + m_chunkSize - 1) / m_chunkSize;
+	m_chunkRows = (m_layerHeight + m_chunkSize - 1) / m_chunkSize;
+	int chunkCount = m_chunkColumns * m_chunkRows;
+	m_chunkSlots = (int*)malloc(chunkCount * sizeof(int));
+	memset(m_chunkSlots, 0xff, chunkCount * sizeof(int));
+	m_chunkBounds = new CCRect[chunkCount];
+	
+	// tile image may be larger than map grid
+	float maxTileWidth = m_tileWidth;
+	float maxTileHeight = m_tileHeight;
+	CCObject* obj;
+	CCARRAY_FOREACH(&m_mapInfo->getTileSets(), obj) {
+		CCTMXTileSetInfo* tileset = (CCTMXTileSetInfo*)obj;
+		maxTileWidth = MAX(maxTileWidth, tileset->getTileWidth());
+		maxTileHeight = MAX(maxTileHeight, tileset->getTileHeight());
+	}
+	
+	// bounding box of chunk is decided by its corner tiles, one more tile
+	// is padded for hexagonal offset
+	for(int cy = 0; cy < m_chunkRows; cy++) {
+		for(int cx = 0; cx < m_chunkColumns; cx++) {
+			int x0 = cx * m_chunkSize;
+			int y0 = cy * m_chunkSize;
+			int x1 = MIN(x0 + m_chunkSize, m_layerWidth) - 1;
+			int y1 = MIN(y0 + m_chunkSize, m_layerHeight) - 1;
+			CCPoint corners[] = {
+				getPositionAt(x0, y0),
+				getPositionAt(x1, y0),
+				getPositionAt(x0, y1),
+				getPositionAt(x1, y1)
+			};
+			float minX = corners[0].x, maxX = corners[0].x;
+			float minY = corners[0].y, maxY = corners[0].y;
+			for(int i = 1; i < 4; i++) {
+				minX = MIN(minX, corners[i].x);
+				maxX = MAX(maxX, corners[i].x);
+				minY = MIN(minY, corners[i].y);
+				maxY = MAX(maxY, corners[i].y);
+			}
+			m_chunkBounds[cx + cy * m_chunkColumns] = CCRectMake(minX - m_tileWidth,
+																 minY - m_tileHeight,
+																 maxX - minX + m_tileWidth + maxTileWidth,
+																 maxY - minY + m_tileHeight + maxTileHeight);
+		}
+	}
+}
+
+void CCTMXLayer::updateChunks() {
+	// screen rect in layer space
+	CCDirector* director = CCDirector::sharedDirector();
+	CCRect screen;
+	screen.origin = director->getVisibleOrigin();
+	screen.size = director->getVisibleSize();
+	CCRect viewport = CCRectApplyAffineTransform(screen, worldToNodeTransform());
+	if(!m_chunksDirty && viewport.equals(m_lastViewport))
+		return;
+	m_lastViewport = viewport;
+	m_chunksDirty = false;
+	
+	// keep chunks within half chunk around screen so that small scrolling doesn't thrash slots
+	float marginX = m_chunkSize * m_tileWidth / 2;
+	float marginY = m_chunkSize * m_tileHeight / 2;
+	viewport.origin.x -= marginX;
+	viewport.origin.y -= marginY;
+	viewport.size.width += marginX * 2;
+	viewport.size.height += marginY * 2;
+	
+	// recycle slots of chunks which are out of viewport
+	int slotCount = m_slotChunks.size();
+	for(int i = 0; i < slotCount; i++) {
+		int chunk = m_slotChunks[i];
+		if(chunk >= 0 && !m_chunkBounds[chunk].intersectsRect(viewport) && !isChunkPinned(chunk)) {
+			clearSlot(i);
+			m_slotChunks[i] = -1;
+			m_chunkSlots[chunk] = -1;
+		}
+	}
+	
+	// fill chunks entering viewport
+	int chunkCount = m_chunkColumns * m_chunkRows;
+	for(int i = 0; i < chunkCount; i++) {
+		if(m_chunkSlots[i] < 0 && m_chunkBounds[i].intersectsRect(viewport)) {
+			materializeChunk(i);
+		}
+	}
+}
+
+void CCTMXLayer::materializeChunk(int chunk) {
+	if(m_chunkSlots[chunk] >= 0)
+		return;
+	
+	// find a free slot
+	int slot = -1;
+	int slotCount = m_slotChunks.size();
+	for(int i = 0; i < slotCount; i++) {
+		if(m_slotChunks[i] < 0) {
+			slot = i;
+			break;
+		}
+	}
+	
+	// no free slot, append a slot to every atlas
+	if(slot < 0) {
+		slot = slotCount;
+		m_slotChunks.push_back(-1);
+		unsigned int quads = m_chunkSize * m_chunkSize;
+		unsigned int total = (slot + 1) * quads;
+		int c = m_mapInfo->getTileSets().count();
+		for(int i = 0; i < c; i++) {
+			if(m_batchNodes[i]) {
+				CCTextureAtlas* atlas = m_batchNodes[i]->getTextureAtlas();
+				if(atlas->getCapacity() < total) {
+					atlas->resizeCapacity(MAX(total, atlas->getCapacity() * 3 / 2));
+				}
+				atlas->increaseTotalQuadsWith(quads);
+			}
+		}
+	}
+	
+	// fill
+	m_slotChunks[slot] = chunk;
+	m_chunkSlots[chunk] = slot;
+	fillChunk(chunk);
+}
+
+bool CCTMXLayer::isChunkPinned(int chunk) {
+	int total = m_layerWidth * m_layerHeight;
+	int c = m_mapInfo->getTileSets().count();
+	for(int i = 0; i < c; i++) {
+		if(!m_batchNodes[i])
+			continue;
+	
+		CCObject* obj;
+		CCARRAY_FOREACH(m_batchNodes[i]->getChildren(), obj) {
+			int z = ((CCNode*)obj)->getTag();
+			if(z >= 0 && z < total) {
+				int x = z % m_layerWidth;
+				int y = z / m_layerWidth;
+				if(x / m_chunkSize + y / m_chunkSize * m_chunkColumns == chunk)
+					return true;
+			}
+		}
+	}
+	return false;
+}
+
+void CCTMXLayer::fillChunk(int chunk) {
+	int slot = m_chunkSlots[chunk];
+	clearSlot(slot);
+	
+	// tile range of chunk
+	int startX = chunk % m_chunkColumns * m_chunkSize;
+	int startY = chunk / m_chunkColumns * m_chunkSize;
+	int endX = MIN(startX + m_chunkSize, m_layerWidth);
+	int endY = MIN(startY + m_chunkSize, m_layerHeight);
+	int base = slot * m_chunkSize * m_chunkSize;
+	
+	// default color
+	ccColor3B color = getColor();
+	ccColor4B layerColor = ccc4(color.r, color.g, color.b, m_layerInfo->getAlpha());
+	
+	// write quads
+	CCArray& tilesets = m_mapInfo->getTileSets();
+	for(int y = startY; y < endY; y++) {
+		for(int x = startX; x < endX; x++) {
+			int z = x + y * m_layerWidth;
+			int gid = m_tiles[z];
+			if(gid == 0)
+				continue;
+			int tilesetIndex = m_mapInfo->getTileSetIndex(gid);
+			if(tilesetIndex < 0)
+				continue;
+	
+			CCTMXTileSetInfo* tileset = (CCTMXTileSetInfo*)tilesets.objectAtIndex(tilesetIndex);
+			CCTextureAtlas* atlas = batchNodeForTileset(tilesetIndex)->getTextureAtlas();
+			int index = base + (x - startX) + (y - startY) * m_chunkSize;
+			map<int, ccColor4B>::iterator iter = m_tileColors.find(z);
+			setupTileQuad(atlas->getQuads() + index, tileset->getTexture(), tileset->getRect(gid), ccpos(x, y), gid,
+						  iter == m_tileColors.end() ? layerColor : iter->second);
+		}
+	}
+}
+
+void CCTMXLayer::clearSlot(int slot) {
+	int quads = m_chunkSize * m_chunkSize;
+	int c = m_mapInfo->getTileSets().count();
+	for(int i = 0; i < c; i++) {
+		if(m_batchNodes[i]) {
+			CCTextureAtlas* atlas = m_batchNodes[i]->getTextureAtlas();
+			memset(atlas->getQuads() + slot * quads, 0, quads * sizeof(ccV3F_C4B_T2F_Quad));
+			atlas->setDirty(true);
+		}
+	}
+}
+
+int CCTMXLayer::chunkedAtlasIndexAt(int x, int y) {
+	int slot = m_chunkSlots[x / m_chunkSize + y / m_chunkSize * m_chunkColumns];
+	if(slot < 0)
+		return -1;
+	return slot * m_chunkSize * m_chunkSize + x % m_chunkSize + y % m_chunkSize * m_chunkSize;
+}
+
+void CCTMXLayer::updateChunkedTileAt(int x, int y) {
+	int index = chunkedAtlasIndexAt(x, y);
+	if(index < 0)
+		return;
+	
+	// clear quad in all atlases because tile may come from another tileset
+	int c = m_mapInfo->getTileSets().count();
+	for(int i = 0; i < c; i++) {
+		if(m_batchNodes[i]) {
+			CCTextureAtlas* atlas = m_batchNodes[i]->getTextureAtlas();
+			memset(atlas->getQuads() + index, 0, sizeof(ccV3F_C4B_T2F_Quad));
+			atlas->setDirty(true);
+		}
+	}
+	
+	// write new quad
+	int z = x + y * m_layerWidth;
+	int gid = m_tiles[z];
+	int tilesetIndex = gid != 0 ? m_mapInfo->getTileSetIndex(gid) : -1;
+	if(tilesetIndex < 0)
+		return;
+	CCTMXTileSetInfo* tileset = (CCTMXTileSetInfo*)m_mapInfo->getTileSets().objectAtIndex(tilesetIndex);
+	CCTextureAtlas* atlas = batchNodeForTileset(tilesetIndex)->getTextureAtlas();
+	ccColor4B color;
+	map<int, ccColor4B>::iterator iter = m_tileColors.find(z);
+	if(iter == m_tileColors.end()) {
+		ccColor3B c3 = getColor();
+		color = ccc4(c3.r, c3.g, c3.b, m_layerInfo->getAlpha());
+	} else {
+		color = iter->second;
+	}
+	setupTileQuad(atlas->getQuads() + index, tileset->getTexture(), tileset->getRect(gid), ccpos(x, y), gid, color);
+}
+
+void CCTMXLayer::removeChunkedTileSprite(CCSpriteBatchNode* bn, CCSprite* sprite) {
+	// batch node removes quad of sprite, put an empty quad back so that slot layout is kept
+	unsigned int index = sprite->getAtlasIndex();
+	bn->removeChild(sprite, true);
+	ccV3F_C4B_T2F_Quad quad;
+	memset(&quad, 0, sizeof(quad));
+	bn->getTextureAtlas()->insertQuad(&quad, index);
+	
+	// sprites after removed one are shifted by batch node, shift them back
+	CCObject* obj;
+	CCARRAY_FOREACH(bn->getDescendants(), obj) {
+		CCSprite* s = (CCSprite*)obj;
+		if(s->getAtlasIndex() >= index) {
+			s->setAtlasIndex(s->getAtlasIndex() + 1);
+		}
+	}
+	
+	// chunk may be recyclable now
+	m_chunksDirty = true;
+}
+
+void CCTMXLayer::setupTileQuad(ccV3F_C4B_T2F_Quad* quad, CCTexture2D* tex, const CCRect& rect, ccPosition pos, int gid, ccColor4B c) {
+	// texture coordinates, same as CCSprite
+	CCRect pixelRect = CC_RECT_POINTS_TO_PIXELS(rect);
+	float atlasWidth = (float)tex->getPixelsWide();
+	float atlasHeight = (float)tex->getPixelsHigh();
+#if CC_FIX_ARTIFACTS_BY_STRECHING_TEXEL
+	float left = (2 * pixelRect.origin.x + 1) / (2 * atlasWidth);
+	float right = left + (pixelRect.size.width * 2 - 2) / (2 * atlasWidth);
+	float top = (2 * pixelRect.origin.y + 1) / (2 * atlasHeight);
+	float bottom = top + (pixelRect.size.height * 2 - 2) / (2 * atlasHeight);
+#else
+	float left = pixelRect.origin.x / atlasWidth;
+	float right = (pixelRect.origin.x + pixelRect.size.width) / atlasWidth;
+	float top = pixelRect.origin.y / atlasHeight;
+	float bottom = (pixelRect.origin.y + pixelRect.size.height) / atlasHeight;
+#endif
+	
+	// tiled applies vertical flip, horizontal flip and then diagonal flip, so map every
+	// corner (in top-left origin unit space) to the texture corner it samples
+	static const int corners[4][2] = { { 0, 1 }, { 1, 1 }, { 0, 0 }, { 1, 0 } };
+	ccV3F_C4B_T2F* vertices[4] = { &quad->bl, &quad->br, &quad->tl, &quad->tr };
+	for(int i = 0; i < 4; i++) {
+		int u = corners[i][0];
+		int v = corners[i][1];
+		if(gid & kCCTMXTileFlagFlipV)
+			v = 1 - v;
+		if(gid & kCCTMXTileFlagFlipH)
+			u = 1 - u;
+		if(gid & kCCTMXTileFlagFlipDiagonal) {
+			int t = u;
+			u = v;
+			v = t;
+		}
+		vertices[i]->texCoords.u = u ? right : left;
+		vertices[i]->texCoords.v = v ? bottom : top;
+	}
+	
+	// vertices, diagonal flipped tile is rotated by 90 degree around its center
+	CCPoint origin = getPositionAt(pos.x, pos.y);
+	float halfWidth = rect.size.width / 2;
+	float halfHeight = rect.size.height / 2;
+	float centerX = origin.x + halfWidth;
+	float centerY = origin.y + halfHeight;
+	if(gid & kCCTMXTileFlagFlipDiagonal) {
+		CC_SWAP(halfWidth, halfHeight, float);
+	}
+	float z = getVertexZAt(pos.x, pos.y);
+	quad->bl.vertices = vertex3(centerX - halfWidth, centerY - halfHeight, z);
+	quad->br.vertices = vertex3(centerX + halfWidth, centerY - halfHeight, z);
+	quad->tl.vertices = vertex3(centerX - halfWidth, centerY + halfHeight, z);
+	quad->tr.vertices = vertex3(centerX + halfWidth, centerY + halfHeight, z);
+	
+	// color
+	if(tex->hasPremultipliedAlpha()) {
+		c.r = c.r * c.a / 255;
+		c.g = c.g * c.a / 255;
+		c.b = c.b * c.a / 255;
+	}
+	quad->bl.colors = c;
+	quad->br.colors = c;
+	quad->tl.colors = c;
+	quad->tr.colors = c;
+}
+
+NS_CC_END
@@ -28,6 +28,8 @@
 #include "ccTypes.h"
 #include "ccMacros.h"
 #include "sprite_nodes/CCSprite.h"
+#include <vector>
+#include <map>
 
 using namespace std;
 
@@ -45,6 +47,13 @@ class CCSpriteBatchNode;
  * \note
  * This is a re-implementation for TMX map. Cocos2d-x TMX support is defective, so I write my own.
  * To avoid name conflict, I use CB prefix which stands for cocos2dx-classical
+ *
+ * \note
+ * For very large layer, set "cc_chunk_size" property in layer or map (or pass chunk size
+ * to create method) to enable chunked mode. In chunked mode, the layer is split into square
+ * chunks and only chunks near viewport have quads in atlas. Quads are written into a pool of
+ * chunk slots directly, so no atlas index array is kept and memory scales with screen size.
+ * \c getAtlasInfos returns NULL in chunked mode.
  */
 class CC_DLL CCTMXLayer : public CCNodeRGBA {
 private:
@@ -83,14 +92,94 @@ private:
 	/// return reused tile
 	CCSprite* reusedTile(CCRect rect, CCSpriteBatchNode* bn);
 	
+	/// get batch node of a tileset, create it if not existent
+	CCSpriteBatchNode* batchNodeForTileset(int tilesetIndex);
+	
+private:
+	/// chunk count in x axis
+	int m_chunkColumns;
+	
+	/// chunk count in y axis
+	int m_chunkRows;
+	
+	/// bounding box of every chunk, in layer space
+	CCRect* m_chunkBounds;
+	
+	/// slot index of every chunk, -1 means chunk has no quads now
+	int* m_chunkSlots;
+	
+	/// chunk index of every slot, -1 means slot is free
+	vector<int> m_slotChunks;
+	
+	/// viewport of last chunk update, in layer space
+	CCRect m_lastViewport;
+	
+	/// true means chunks must be checked again even viewport is not changed
+	bool m_chunksDirty;
+	
+	/// tile colors set by setTileColorAt in chunked mode, key is tile index
+	map<int, ccColor4B> m_tileColors;
+	
+	/// init chunk grid
+	void setupChunks();
+	
+	/// materialise chunks near viewport and recycle slots of others
+	void updateChunks();
+	
+	/**
+	 * assign a slot to a chunk and fill quads of it. If chunk already has
+	 * a slot, nothing happens
+	 *
+	 * @param chunk chunk index
+	 */
+	void materializeChunk(int chunk);
+	
+	/// true means some tile sprite of chunk is living so chunk can't be recycled
+	bool isChunkPinned(int chunk);
+	
+	/// write all tile quads of a chunk into its slot
+	void fillChunk(int chunk);
+	
+	/// zero all quads of a slot
+	void clearSlot(int slot);
+	
+	/**
+	 * atlas index of a tile in chunked mode
+	 *
+	 * @param x tile x
+	 * @param y tile y
+	 * @return atlas index, or -1 if chunk of tile has no quads now
+	 */
+	int chunkedAtlasIndexAt(int x, int y);
+	
+	/// rewrite quad of a tile in chunked mode, do nothing if tile chunk has no quads
+	void updateChunkedTileAt(int x, int y);
+	
+	/// remove tile sprite from batch node but keep slot layout of atlas
+	void removeChunkedTileSprite(CCSpriteBatchNode* bn, CCSprite* sprite);
+	
+	/**
+	 * fill quad of a tile, it does same thing as \c setupTileSprite but doesn't
+	 * need a sprite
+	 *
+	 * @param quad quad to be filled
+	 * @param tex texture of tileset
+	 * @param rect tile rect in tileset
+	 * @param pos tile coordinate
+	 * @param gid tile id, flip flags are considered
+	 * @param c tile color, not premultiplied
+	 */
+	void setupTileQuad(ccV3F_C4B_T2F_Quad* quad, CCTexture2D* tex, const CCRect& rect, ccPosition pos, int gid, ccColor4B c);
+	
 protected:
 	/**
-	 * Static constructor
+	 * Constructor
 	 *
 	 * @param layerIndex index of layer, start from zero
 	 * @param mapInfo info of whole map
+	 * @param chunkSize chunk edge length in tiles, zero means check "cc_chunk_size" property
 	 */
-	CCTMXLayer(int layerIndex, CCTMXMapInfo* mapInfo);
+	CCTMXLayer(int layerIndex, CCTMXMapInfo* mapInfo, int chunkSize);
 	
 	/**
 	 * get left-bottom pixel position of tile in a othrogonal map
@@ -181,6 +270,19 @@ public:
 	 * @param mapInfo info of whole map
 	 */
 	static CCTMXLayer* create(int layerIndex, CCTMXMapInfo* mapInfo);
+	
+	/**
+	 * Static constructor
+	 *
+	 * @param layerIndex index of layer, start from zero
+	 * @param mapInfo info of whole map
+	 * @param chunkSize chunk edge length in tiles, zero means check "cc_chunk_size" property
+	 * of layer and map, if property is not set either, layer is not chunked
+	 */
+	static CCTMXLayer* create(int layerIndex, CCTMXMapInfo* mapInfo, int chunkSize);
+	
+	/// in chunked mode, update chunk quads before drawing
+	virtual void visit();
     
     /// set anti alias for all layer textures
     void setAntiAliasTexParameters();
@@ -332,6 +434,12 @@ public:
     /// get layer size in tile
     CCSize getLayerSize() { return CCSizeMake(m_layerWidth, m_layerHeight); }
 	
+	/// true means layer is in chunked mode
+	bool isChunked() { return m_chunkSize > 0; }
+	
+	/// chunk edge length in tiles, zero if layer is not chunked
+	CC_SYNTHESIZE_READONLY(int, m_chunkSize, ChunkSize);
+	
 	/// layer tiles in x axis
 	CC_SYNTHESIZE(int, m_layerWidth, LayerWidth);
 	
@@ -35,6 +35,78 @@
 
 NS_CC_BEGIN
 
+/*
+ * Binary map format. All values are little endian 32 bits, strings are saved as
+ * length and bytes, padded to 4 bytes, so tile gid arrays are 4 bytes aligned and
+ * copied as is. Pixel values are not scaled, content scale factor is applied when loading.
+ *
+ * header: magic, version, orientation, map width, map height, tile width, tile height
+ * map properties
+ * tilesets: count, then for every tileset
+ *     name, first gid, tile width, tile height, spacing, margin, image path
+ * tile properties: count, then for every tile, gid and properties
+ * layers: count, then for every layer
+ *     name, width, height, visible, alpha, x, y, properties, gids (width * height)
+ * object groups: count, then for every group
+ *     name, x, y, color, opacity, properties, object count, then for every object
+ *         name, type, shape, x, y, width, height, point count, points, properties
+ *
+ * properties: count, then key and value strings
+ */
+#define TMB_MAGIC 0x424d5443 // "CTMB"
+#define TMB_VERSION 1
+
+/// cursor of binary map data
+typedef struct _tTMBReader {
+	const char* data;
+	int pos;
+	int length;
+	bool error;
+} tTMBReader;
+
+static bool tmbCheck(tTMBReader& r, int size) {
+	if(r.error || size < 0 || r.length - r.pos < size)
+		r.error = true;
+	return !r.error;
+}
+
+static int tmbReadInt(tTMBReader& r) {
+	if(!tmbCheck(r, 4))
+		return 0;
+	int ret = *(int*)(r.data + r.pos);
+	r.pos += 4;
+	return ret;
+}
+
+static float tmbReadFloat(tTMBReader& r) {
+	if(!tmbCheck(r, 4))
+		return 0;
+	float ret = *(float*)(r.data + r.pos);
+	r.pos += 4;
+	return ret;
+}
+
+static string tmbReadString(tTMBReader& r) {
+	int len = tmbReadInt(r);
+	int padded = (len + 3) & ~3;
+	if(!tmbCheck(r, padded))
+		return "";
+	string ret(r.data + r.pos, len);
+	r.pos += padded;
+	return ret;
+}
+
+// properties are added by a member function of owner
+template<typename T>
+static void tmbReadProperties(tTMBReader& r, T* owner) {
+	int count = tmbReadInt(r);
+	for(int i = 0; i < count && !r.error; i++) {
+		string key = tmbReadString(r);
+		string value = tmbReadString(r);
+		owner->addProperty(key, value);
+	}
+}
+
 CCTMXLoader::CCTMXLoader() :
 m_compressed(false),
 m_lastGid(-1) {
@@ -151,9 +223,16 @@ CCTMXMapInfo* CCTMXLoader::load(const string& tmxFile) {
 	// get dir
 	m_tmxDir = CCUtils::deleteLastPathComponent(tmxFile);
 	
+	// prefer binary map
+	CCFileUtils* fu = CCFileUtils::sharedFileUtils();
+	string path = tmxFile;
+	string binPath = fu->fullPathForFilename((CCUtils::deletePathExtension(tmxFile) + ".tmb").c_str());
+	if(fu->isFileExist(binPath))
+		path = binPath;
+	
 	// start
 	size_t size;
-	unsigned char* data = CCFileUtils::sharedFileUtils()->getFileData(tmxFile.c_str(), "rb", &size);
+	unsigned char* data = fu->getFileData(path.c_str(), "rb", &size);
 	bool success = load((const char*)data, (int)size);
 	free(data);
 	return success ? m_map : NULL;
@@ -171,7 +250,123 @@ CCTMXMapInfo* CCTMXLoader::load(const char* tmxData, int length, const string& r
 	}
 }
 
+bool CCTMXLoader::isBinary(const char* data, int length) {
+	return data && length >= 8 && *(int*)data == TMB_MAGIC;
+}
+
+bool CCTMXLoader::loadBinary(const char* data, int length) {
+	tTMBReader r = { data, 0, length, false };
+	
+	// header
+	tmbReadInt(r);
+	int version = tmbReadInt(r);
+	if(version != TMB_VERSION) {
+		CCLOGERROR("Unsupported binary map version: %d", version);
+		return false;
+	}
+	m_map->setOrientation((cbTMXOrientation)tmbReadInt(r));
+	m_map->setMapWidth(tmbReadInt(r));
+	m_map->setMapHeight(tmbReadInt(r));
+	m_map->setTileWidth(tmbReadFloat(r) / CC_CONTENT_SCALE_FACTOR());
+	m_map->setTileHeight(tmbReadFloat(r) / CC_CONTENT_SCALE_FACTOR());
+	tmbReadProperties(r, m_map);
+	
+	// tilesets
+	int count = tmbReadInt(r);
+	for(int i = 0; i < count && !r.error; i++) {
+		CCTMXTileSetInfo* tileset = CCTMXTileSetInfo::create();
+		m_map->getTileSets().addObject(tileset);
+		tileset->setName(tmbReadString(r));
+		tileset->setFirstGid(tmbReadInt(r));
+		tileset->setTileWidth(tmbReadFloat(r) / CC_CONTENT_SCALE_FACTOR());
+		tileset->setTileHeight(tmbReadFloat(r) / CC_CONTENT_SCALE_FACTOR());
+		tileset->setSpacing(tmbReadFloat(r) / CC_CONTENT_SCALE_FACTOR());
+		tileset->setMargin(tmbReadFloat(r) / CC_CONTENT_SCALE_FACTOR());
+		string imageName = CCUtils::lastPathComponent(tmbReadString(r));
+		tileset->setSourceImagePath(CCUtils::appendPathComponent(m_tmxDir, imageName));
+	}
+	
+	// tile properties
+	count = tmbReadInt(r);
+	for(int i = 0; i < count && !r.error; i++) {
+		int gid = tmbReadInt(r);
+		int propCount = tmbReadInt(r);
+		for(int j = 0; j < propCount && !r.error; j++) {
+			string key = tmbReadString(r);
+			string value = tmbReadString(r);
+			m_map->addTileProperty(gid, key, value);
+		}
+	}
+	
+	// layers
+	count = tmbReadInt(r);
+	for(int i = 0; i < count && !r.error; i++) {
+		CCTMXLayerInfo* layer = CCTMXLayerInfo::create();
+		m_map->getLayers().addObject(layer);
+		layer->setName(tmbReadString(r));
+		layer->setLayerWidth(tmbReadInt(r));
+		layer->setLayerHeight(tmbReadInt(r));
+		layer->setVisible(tmbReadInt(r) != 0);
+		layer->setAlpha(tmbReadInt(r));
+		layer->setOffsetX(tmbReadFloat(r) / CC_CONTENT_SCALE_FACTOR());
+		layer->setOffsetY(tmbReadFloat(r) / CC_CONTENT_SCALE_FACTOR());
+		tmbReadProperties(r, layer);
+		
+		// gids are saved as they are in memory
+		int w = layer->getLayerWidth();
+		int h = layer->getLayerHeight();
+		if(w < 0 || h < 0 || (h > 0 && w > 0x7fffffff / 4 / h) || !tmbCheck(r, w * h * 4)) {
+			r.error = true;
+			break;
+		}
+		int* tiles = (int*)malloc(w * h * sizeof(int));
+		memcpy(tiles, r.data + r.pos, w * h * sizeof(int));
+		r.pos += w * h * sizeof(int);
+		layer->setTiles(tiles);
+	}
+	
+	// object groups
+	count = tmbReadInt(r);
+	for(int i = 0; i < count && !r.error; i++) {
+		CCTMXObjectGroup* group = CCTMXObjectGroup::create();
+		m_map->getObjectGroups().addObject(group);
+		group->setName(tmbReadString(r));
+		group->setOffsetX(tmbReadFloat(r) / CC_CONTENT_SCALE_FACTOR());
+		group->setOffsetY(tmbReadFloat(r) / CC_CONTENT_SCALE_FACTOR());
+		group->setColor(tmbReadInt(r));
+		group->setOpacity(tmbReadFloat(r));
+		tmbReadProperties(r, group);
+		
+		int objectCount = tmbReadInt(r);
+		for(int j = 0; j < objectCount && !r.error; j++) {
+			CCTMXObject* object = group->newObject();
+			object->setName(tmbReadString(r));
+			object->setType(tmbReadString(r));
+			object->setShape((CCTMXObject::Shape)tmbReadInt(r));
+			object->getPosition().x = tmbReadFloat(r) / CC_CONTENT_SCALE_FACTOR();
+			object->getPosition().y = tmbReadFloat(r) / CC_CONTENT_SCALE_FACTOR();
+			object->getSize().width = tmbReadFloat(r) / CC_CONTENT_SCALE_FACTOR();
+			object->getSize().height = tmbReadFloat(r) / CC_CONTENT_SCALE_FACTOR();
+			int pointCount = tmbReadInt(r);
+			for(int k = 0; k < pointCount && !r.error; k++) {
+				float x = tmbReadFloat(r);
+				float y = tmbReadFloat(r);
+				object->getPoints().addPoint(x / CC_CONTENT_SCALE_FACTOR(), y / CC_CONTENT_SCALE_FACTOR());
+			}
+			tmbReadProperties(r, object);
+		}
+	}
+	
+	if(r.error) {
+		CCLOGERROR("Binary map data is truncated or corrupted");
+	}
+	return !r.error;
+}
+
 bool CCTMXLoader::load(const char* data, int length) {
+	if(isBinary(data, length))
+		return loadBinary(data, length);
+	
 	CCSAXParser parser;
     if(!parser.init("UTF-8")) {
         return false;
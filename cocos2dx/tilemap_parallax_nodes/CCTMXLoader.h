@@ -33,7 +33,11 @@ NS_CC_BEGIN
 
 class CCTMXMapInfo;
 
-/// xml parser of tmx file
+/**
+ * Loader of tmx map. It parses xml tmx file, or binary map (.tmb) which is converted
+ * from tmx by tools/tmb/tmx2tmb.py. When loading a tmx file and a .tmb file exists beside
+ * it, the binary map is loaded and no xml parsing, base64 decoding or inflating happens.
+ */
 class CC_DLL CCTMXLoader : public CCObject, public CCSAXDelegator {
 private:
 	/// tag of tmx file
@@ -95,6 +99,12 @@ private:
 	/// internal load method, return false if failed
 	bool load(const char* data, int length);
 	
+	/// internal load method for binary map, return false if failed
+	bool loadBinary(const char* data, int length);
+	
+	/// check data is binary map or not
+	static bool isBinary(const char* data, int length);
+	
 	// tag operation
 	void pushTag(TMXTag tag);
 	void popTag();
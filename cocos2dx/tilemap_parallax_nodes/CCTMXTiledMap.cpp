@@ -45,7 +45,8 @@ m_mapHeight(0),
 m_tileWidth(0),
 m_tileHeight(0),
 m_debugDrawObjects(false),
-m_mapInfo(NULL) {
+m_mapInfo(NULL),
+m_chunkSize(0) {
 }
 
 CCTMXTiledMap* CCTMXTiledMap::create(const string& file) {
@@ -58,6 +59,17 @@ CCTMXTiledMap* CCTMXTiledMap::create(const string& file) {
 	return NULL;
 }
 
+CCTMXTiledMap* CCTMXTiledMap::create(const string& file, int chunkSize) {
+	CCTMXTiledMap* tmx = new CCTMXTiledMap();
+	tmx->setChunkSize(chunkSize);
+	if(tmx->initWithXMLFile(file)) {
+		CC_SAFE_AUTORELEASE_RETURN(tmx, CCTMXTiledMap*);
+	}
+	
+	CC_SAFE_RELEASE(tmx);
+	return NULL;
+}
+
 bool CCTMXTiledMap::initWithXMLFile(const string& file) {
 	if(!CCNodeRGBA::init())
 		return false;
@@ -89,7 +101,7 @@ bool CCTMXTiledMap::initWithXMLFile(const string& file) {
 	// create tmx layer
 	int idx = 0;
 	CCARRAY_FOREACH(&m_mapInfo->getLayers(), obj) {
-		CCTMXLayer* layer = CCTMXLayer::create(idx, m_mapInfo);
+		CCTMXLayer* layer = CCTMXLayer::create(idx, m_mapInfo, m_chunkSize);
 		if(!layer)
 			continue;
 		
@@ -60,6 +60,15 @@ public:
 	 */
 	static CCTMXTiledMap* create(const string& file);
 	
+	/**
+	 * Static constructor, all layers are created in chunked mode
+	 *
+	 * @param file tmx file path
+	 * @param chunkSize chunk edge length in tiles, zero means decided by "cc_chunk_size" property
+	 * @return CCTMXTiledMap instance
+	 */
+	static CCTMXTiledMap* create(const string& file, int chunkSize);
+	
 	/// init with tmx file
 	virtual bool initWithXMLFile(const string& file);
 	
@@ -123,6 +132,9 @@ public:
 	
     /// true means debug draw object outline
     CC_SYNTHESIZE_BOOL_SETTER(m_debugDrawObjects, DebugDrawObjects);
+	
+	/// chunk size passed to layers, must be set before init
+	CC_SYNTHESIZE(int, m_chunkSize, ChunkSize);
 };
 
 NS_CC_END
@@ -30,6 +30,7 @@
 #include <curl/easy.h>
 
 #include <stdio.h>
+#include <ctype.h>
 #include <vector>
 
 #if (CC_TARGET_PLATFORM != CC_PLATFORM_WIN32)
@@ -39,6 +40,9 @@
 #endif
 
 #include "support/zip/unzip.h"
+#include "support/codec/MD5.h"
+#include "zlib.h"
+#include <map>
 
 using namespace cocos2d;
 using namespace std;
@@ -48,6 +52,7 @@ NS_CC_EXT_BEGIN
 #define KEY_OF_VERSION   "current-version-code"
 #define BUFFER_SIZE    8192
 #define MAX_FILENAME   512
+#define TEMP_SUFFIX    ".tmp"
 
 // Message type
 #define ASSETSMANAGER_MESSAGE_UPDATE_SUCCEED                0
@@ -68,6 +73,26 @@ struct ProgressMessage
     AssetsManager* manager;
 };
 
+// entry of package or manifest must be a relative path inside storage path, so it can't be
+// absolute, have drive prefix or have .. component. Name such as a..b.png is fine
+static bool isSafeEntryPath(const string& path)
+{
+    if (path.empty() || path[0] == '/' || path[0] == '\\' || (path.size() > 1 && isalpha((unsigned char)path[0]) && path[1] == ':'))
+        return false;
+    
+    size_t start = 0;
+    while (start <= path.size())
+    {
+        size_t end = path.find_first_of("/\\", start);
+        if (end == string::npos)
+            end = path.size();
+        if (path.compare(start, end - start, "..") == 0)
+            return false;
+        start = end + 1;
+    }
+    return true;
+}
+
 // Implementation of AssetsManager
 
 AssetsManager::AssetsManager(const char* packageUrl/* =NULL */, const char* versionFileUrl/* =NULL */, const char* storagePath/* =NULL */)
@@ -75,11 +100,13 @@ AssetsManager::AssetsManager(const char* packageUrl/* =NULL */, const char* vers
 , _version("")
 , _packageUrl(packageUrl)
 , _versionFileUrl(versionFileUrl)
+, _streaming(true)
 , _curl(NULL)
 , _tid(NULL)
 , _connectionTimeout(0)
 , _delegate(NULL)
 {
+    memset(&m_nfun, 0, sizeof(ccScriptFunction));
     checkStoragePath();
     _schedule = new Helper();
 }
@@ -174,15 +201,31 @@ void* assetsManagerDownloadAndUncompress(void *data)
     
     do
     {
-        // download
-        if (! self->downLoad())
-            break;
-        
-        // Uncompress zip file.
-        if (! self->uncompress())
+        if (self->_manifestUrl.size() > 0)
         {
-            self->sendErrorMessage(AssetsManager::kUncompress);
-            break;
+            // download changed files only
+            if (! self->updateByManifest())
+                break;
+        }
+        else
+        {
+            // uncompress while downloading, package which can't be streamed is downloaded again
+            int streamed = self->_streaming ? self->downLoadStreaming() : -1;
+            if (streamed == 0)
+                break;
+            if (streamed < 0)
+            {
+                // download
+                if (! self->downLoad())
+                    break;
+                
+                // Uncompress zip file.
+                if (! self->uncompress())
+                {
+                    self->sendErrorMessage(AssetsManager::kUncompress);
+                    break;
+                }
+            }
         }
         
         // Record updated version and remove downloaded zip file
@@ -208,10 +251,9 @@ void AssetsManager::update()
     // 1. Urls of package and version should be valid;
     // 2. Package should be a zip file.
     if (_versionFileUrl.size() == 0 ||
-        _packageUrl.size() == 0 ||
-        std::string::npos == _packageUrl.find(".zip"))
+        (_manifestUrl.size() == 0 && (_packageUrl.size() == 0 || std::string::npos == _packageUrl.find(".zip"))))
     {
-        CCLOG("no version file url, or no package url, or the package is not a zip file");
+        CCLOG("no version file url, or no package url and manifest url, or the package is not a zip file");
         return;
     }
     
@@ -270,6 +312,12 @@ bool AssetsManager::uncompress()
             unzClose(zipfile);
             return false;
         }
+        if (! isSafeEntryPath(fileName))
+        {
+            CCLOG("bad zip entry name %s", fileName);
+            unzClose(zipfile);
+            return false;
+        }
         
         string fullPath = _storagePath + fileName;
         
@@ -298,7 +346,8 @@ bool AssetsManager::uncompress()
                 return false;
             }
             
-            // Create a file to store current file.
+            // Create a file to store current file, zip may not have entries of parent directories
+            CCUtils::createIntermediateFolders(fullPath);
             FILE *out = fopen(fullPath.c_str(), "wb");
             if (! out)
             {
@@ -384,15 +433,7 @@ static size_t downLoadPackage(void *ptr, size_t size, size_t nmemb, void *userda
 int assetsManagerProgressFunc(void *ptr, double totalToDownload, double nowDownloaded, double totalToUpLoad, double nowUpLoaded)
 {
     AssetsManager* manager = (AssetsManager*)ptr;
-    AssetsManager::Message *msg = new AssetsManager::Message();
-    msg->what = ASSETSMANAGER_MESSAGE_PROGRESS;
-    
-    ProgressMessage *progressData = new ProgressMessage();
-    progressData->percent = (int)(nowDownloaded/totalToDownload*100);
-    progressData->manager = manager;
-    msg->obj = progressData;
-    
-    manager->_schedule->sendMessage(msg);
+    manager->sendProgressMessage((int)(nowDownloaded/totalToDownload*100));
     
     CCLOG("downloading... %d%%", (int)(nowDownloaded/totalToDownload*100));
     
@@ -436,6 +477,639 @@ bool AssetsManager::downLoad()
     return true;
 }
 
+/*
+ * Uncompresses a zip stream by local file headers, so files are written while
+ * package is downloaded and zip file is never saved. Every file is written to
+ * a temp file and renamed after its crc32 is checked.
+ */
+class ZipStreamInflater
+{
+public:
+    enum Result
+    {
+        kOk,
+        kFailed,
+        kVerifyFailed,
+        // package needs central directory, such as stored file with data descriptor
+        kUnsupported,
+    };
+    
+    ZipStreamInflater(const string& storagePath)
+    : _storagePath(storagePath)
+    , _state(kHeader)
+    , _result(kOk)
+    , _out(NULL)
+    , _inflating(false)
+    , _fileCount(0)
+    {
+        memset(&_stream, 0, sizeof(_stream));
+    }
+    
+    ~ZipStreamInflater()
+    {
+        closeEntry(false);
+    }
+    
+    /* @brief Feeds downloaded bytes.
+     * @return false if stream should be stopped
+     */
+    bool feed(const char* data, size_t size)
+    {
+        if (_result != kOk)
+            return false;
+        if (_state == kEnd)
+            return true;
+        
+        _buffer.append(data, size);
+        size_t pos = 0;
+        while (_result == kOk && _state != kEnd)
+        {
+            // a parser may finish its state without consuming bytes, such as inflate
+            // reaching end of stream with input of last feed, so only stop if it waits
+            State state = _state;
+            size_t used = 0;
+            if (_state == kHeader)
+                used = parseHeader(pos);
+            else if (_state == kData)
+                used = parseData(pos);
+            else
+                used = parseDescriptor(pos);
+            if (used == 0 && _state == state)
+                break;
+            pos += used;
+        }
+        _buffer.erase(0, pos);
+        return _result == kOk;
+    }
+    
+    /* @brief Checks stream is complete after all bytes are fed.
+     */
+    Result finish()
+    {
+        if (_result == kOk && _state != kEnd)
+        {
+            CCLOG("zip stream is truncated");
+            _result = kFailed;
+        }
+        return _result;
+    }
+    
+    Result getResult() const { return _result; }
+    
+    int getFileCount() const { return _fileCount; }
+    
+private:
+    enum State
+    {
+        kHeader,
+        kData,
+        kDescriptor,
+        kEnd,
+    };
+    
+    static uLong readU32(const char* p)
+    {
+        const unsigned char* u = (const unsigned char*)p;
+        return u[0] | (u[1] << 8) | (u[2] << 16) | ((uLong)u[3] << 24);
+    }
+    
+    static uLong readU16(const char* p)
+    {
+        const unsigned char* u = (const unsigned char*)p;
+        return u[0] | (u[1] << 8);
+    }
+    
+    size_t available(size_t pos) const
+    {
+        return _buffer.size() - pos;
+    }
+    
+    void fail(Result result)
+    {
+        _result = result;
+        closeEntry(false);
+    }
+    
+    size_t parseHeader(size_t pos)
+    {
+        if (available(pos) < 4)
+            return 0;
+        const char* p = _buffer.data() + pos;
+        uLong signature = readU32(p);
+        
+        // central directory is reached, all files are done
+        if (signature == 0x02014b50 || signature == 0x06054b50)
+        {
+            _state = kEnd;
+            return 0;
+        }
+        if (signature != 0x04034b50)
+        {
+            CCLOG("bad zip local header signature %08lx", signature);
+            fail(kFailed);
+            return 0;
+        }
+        if (available(pos) < 30)
+            return 0;
+        size_t nameLength = readU16(p + 26);
+        size_t extraLength = readU16(p + 28);
+        if (available(pos) < 30 + nameLength + extraLength)
+            return 0;
+        
+        _flags = readU16(p + 6);
+        _method = readU16(p + 8);
+        _crc = readU32(p + 14);
+        _compressedSize = readU32(p + 18);
+        _fileName.assign(p + 30, nameLength);
+        if ((_flags & 1) || _compressedSize == 0xFFFFFFFF || (_method != 0 && _method != Z_DEFLATED) ||
+            (_method == 0 && (_flags & 8)))
+        {
+            CCLOG("zip entry %s can't be streamed", _fileName.c_str());
+            fail(kUnsupported);
+            return 0;
+        }
+        if (! isSafeEntryPath(_fileName))
+        {
+            CCLOG("bad zip entry name %s", _fileName.c_str());
+            fail(kFailed);
+            return 0;
+        }
+        
+        // directory has no data
+        string fullPath = _storagePath + _fileName;
+        if (_fileName[_fileName.size() - 1] == '/')
+        {
+            CCUtils::createIntermediateFolders(fullPath);
+            return 30 + nameLength + extraLength;
+        }
+        
+        // open file
+        CCUtils::createIntermediateFolders(fullPath);
+        _out = fopen((fullPath + TEMP_SUFFIX).c_str(), "wb");
+        if (! _out)
+        {
+            CCLOG("can not open destination file %s", fullPath.c_str());
+            fail(kFailed);
+            return 0;
+        }
+        _consumed = 0;
+        _actualCrc = crc32(0L, Z_NULL, 0);
+        if (_method == Z_DEFLATED)
+        {
+            memset(&_stream, 0, sizeof(_stream));
+            if (inflateInit2(&_stream, -MAX_WBITS) != Z_OK)
+            {
+                fail(kFailed);
+                return 0;
+            }
+            _inflating = true;
+        }
+        _state = kData;
+        
+        // empty file has no data
+        if (! (_flags & 8) && _compressedSize == 0)
+            endData();
+        return 30 + nameLength + extraLength;
+    }
+    
+    bool writeOut(const char* data, size_t size)
+    {
+        _actualCrc = crc32(_actualCrc, (const Bytef*)data, (uInt)size);
+        if (fwrite(data, 1, size, _out) != size)
+        {
+            CCLOG("can not write file %s", _fileName.c_str());
+            fail(kFailed);
+            return false;
+        }
+        return true;
+    }
+    
+    size_t parseData(size_t pos)
+    {
+        size_t avail = available(pos);
+        if (avail == 0)
+            return 0;
+        const char* p = _buffer.data() + pos;
+        
+        // stored
+        if (_method == 0)
+        {
+            size_t size = MIN(avail, (size_t)(_compressedSize - _consumed));
+            if (! writeOut(p, size))
+                return 0;
+            _consumed += size;
+            if (_consumed == _compressedSize)
+                endData();
+            return size;
+        }
+        
+        // deflated, inflate knows where data ends
+        char out[BUFFER_SIZE];
+        _stream.next_in = (Bytef*)p;
+        _stream.avail_in = (uInt)avail;
+        int err = Z_OK;
+        while (_stream.avail_in > 0 && err != Z_STREAM_END)
+        {
+            _stream.next_out = (Bytef*)out;
+            _stream.avail_out = sizeof(out);
+            err = inflate(&_stream, Z_NO_FLUSH);
+            if (err != Z_OK && err != Z_STREAM_END && err != Z_BUF_ERROR)
+            {
+                CCLOG("can not inflate %s, error code is %d", _fileName.c_str(), err);
+                fail(kFailed);
+                return 0;
+            }
+            if (! writeOut(out, sizeof(out) - _stream.avail_out))
+                return 0;
+        }
+        size_t used = avail - _stream.avail_in;
+        _consumed += used;
+        if (err == Z_STREAM_END)
+        {
+            if (! (_flags & 8) && _consumed != _compressedSize)
+            {
+                CCLOG("compressed size of %s is wrong", _fileName.c_str());
+                fail(kFailed);
+                return 0;
+            }
+            endData();
+        }
+        return used;
+    }
+    
+    void endData()
+    {
+        if (_flags & 8)
+            _state = kDescriptor;
+        else
+            endEntry();
+    }
+    
+    size_t parseDescriptor(size_t pos)
+    {
+        // signature is optional
+        if (available(pos) < 4)
+            return 0;
+        const char* p = _buffer.data() + pos;
+        size_t size = readU32(p) == 0x08074b50 ? 16 : 12;
+        if (available(pos) < size)
+            return 0;
+        _crc = readU32(p + size - 12);
+        endEntry();
+        return size;
+    }
+    
+    void endEntry()
+    {
+        if (_actualCrc != _crc)
+        {
+            CCLOG("crc32 of %s mismatched", _fileName.c_str());
+            fail(kVerifyFailed);
+            return;
+        }
+        if (! closeEntry(true))
+        {
+            fail(kFailed);
+            return;
+        }
+        _fileCount++;
+        _state = kHeader;
+    }
+    
+    bool closeEntry(bool keep)
+    {
+        if (_inflating)
+        {
+            inflateEnd(&_stream);
+            _inflating = false;
+        }
+        if (! _out)
+            return true;
+        bool ok = fclose(_out) == 0;
+        _out = NULL;
+        string fullPath = _storagePath + _fileName;
+        if (keep && ok && rename((fullPath + TEMP_SUFFIX).c_str(), fullPath.c_str()) == 0)
+            return true;
+        remove((fullPath + TEMP_SUFFIX).c_str());
+        return false;
+    }
+    
+private:
+    string _storagePath;
+    State _state;
+    Result _result;
+    
+    // unconsumed bytes
+    string _buffer;
+    
+    // current entry
+    string _fileName;
+    uLong _flags;
+    uLong _method;
+    uLong _crc;
+    uLong _compressedSize;
+    uLong _consumed;
+    uLong _actualCrc;
+    FILE* _out;
+    z_stream _stream;
+    bool _inflating;
+    
+    int _fileCount;
+};
+
+static size_t inflatePackage(void *ptr, size_t size, size_t nmemb, void *userdata)
+{
+    ZipStreamInflater* inflater = (ZipStreamInflater*)userdata;
+    
+    // return a value which is different with size will abort download
+    if (! inflater->feed((const char*)ptr, size * nmemb))
+        return 0;
+    return size * nmemb;
+}
+
+int AssetsManager::downLoadStreaming()
+{
+    ZipStreamInflater inflater(_storagePath);
+    
+    CURLcode res;
+    curl_easy_setopt(_curl, CURLOPT_URL, _packageUrl.c_str());
+    curl_easy_setopt(_curl, CURLOPT_FAILONERROR, 1L);
+    curl_easy_setopt(_curl, CURLOPT_WRITEFUNCTION, inflatePackage);
+    curl_easy_setopt(_curl, CURLOPT_WRITEDATA, &inflater);
+    curl_easy_setopt(_curl, CURLOPT_NOPROGRESS, false);
+    curl_easy_setopt(_curl, CURLOPT_PROGRESSFUNCTION, assetsManagerProgressFunc);
+    curl_easy_setopt(_curl, CURLOPT_PROGRESSDATA, this);
+    res = curl_easy_perform(_curl);
+    
+    // not a streamable zip, download it as before with same curl handle. Entry which is being
+    // written is already removed, uncompress overwrites files streamed before it
+    if (inflater.getResult() == ZipStreamInflater::kUnsupported)
+    {
+        CCLOG("package %s can't be streamed, download it", _packageUrl.c_str());
+        curl_easy_setopt(_curl, CURLOPT_FAILONERROR, 0L);
+        return -1;
+    }
+    
+    curl_easy_cleanup(_curl);
+    ZipStreamInflater::Result result = inflater.getResult();
+    if (res != 0 && result == ZipStreamInflater::kOk)
+    {
+        sendErrorMessage(kNetwork);
+        CCLOG("error when download package, error code is %d", res);
+        return 0;
+    }
+    result = inflater.finish();
+    if (result != ZipStreamInflater::kOk)
+    {
+        sendErrorMessage(result == ZipStreamInflater::kVerifyFailed ? kVerify : kUncompress);
+        return 0;
+    }
+    
+    CCLOG("succeed downloading and uncompressing package %s, %d files", _packageUrl.c_str(), inflater.getFileCount());
+    return 1;
+}
+
+// Manifest
+
+struct ManifestEntry
+{
+    string md5;
+    size_t size;
+};
+
+typedef map<string, ManifestEntry> Manifest;
+
+static void parseManifest(const string& content, Manifest& manifest)
+{
+    size_t lineStart = 0;
+    while (lineStart < content.size())
+    {
+        size_t lineEnd = content.find('\n', lineStart);
+        if (lineEnd == string::npos)
+            lineEnd = content.size();
+        string line = CCUtils::trim(content.substr(lineStart, lineEnd - lineStart));
+        lineStart = lineEnd + 1;
+        
+        // md5 size path, path may have space
+        size_t md5End = line.find(' ');
+        size_t sizeEnd = md5End == string::npos ? string::npos : line.find(' ', md5End + 1);
+        if (sizeEnd == string::npos)
+            continue;
+        ManifestEntry e;
+        e.md5 = line.substr(0, md5End);
+        CCUtils::toLowercase(e.md5);
+        e.size = strtoul(line.c_str() + md5End + 1, NULL, 10);
+        manifest[line.substr(sizeEnd + 1)] = e;
+    }
+}
+
+static bool saveManifest(const string& path, const Manifest& manifest)
+{
+    string tmpPath = path + TEMP_SUFFIX;
+    FILE* fp = fopen(tmpPath.c_str(), "wb");
+    if (! fp)
+        return false;
+    bool ok = true;
+    for (Manifest::const_iterator iter = manifest.begin(); iter != manifest.end(); iter++)
+    {
+        ok = fprintf(fp, "%s %lu %s\n", iter->second.md5.c_str(), (unsigned long)iter->second.size, iter->first.c_str()) > 0 && ok;
+    }
+    ok = fclose(fp) == 0 && ok;
+    if (! ok || rename(tmpPath.c_str(), path.c_str()) != 0)
+    {
+        remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+struct ManifestDownload
+{
+    FILE* fp;
+    MD5 md5;
+    size_t size;
+    
+    // for progress
+    AssetsManager* manager;
+    size_t doneBytes;
+    size_t totalBytes;
+    int percent;
+};
+
+static size_t downLoadManifestFile(void *ptr, size_t size, size_t nmemb, void *userdata)
+{
+    ManifestDownload* download = (ManifestDownload*)userdata;
+    size_t bytes = size * nmemb;
+    if (fwrite(ptr, 1, bytes, download->fp) != bytes)
+        return 0;
+    download->md5.update((const char*)ptr, (MD5::size_type)bytes);
+    download->size += bytes;
+    return bytes;
+}
+
+int assetsManagerManifestProgressFunc(void *ptr, double totalToDownload, double nowDownloaded, double totalToUpLoad, double nowUpLoaded)
+{
+    ManifestDownload* download = (ManifestDownload*)ptr;
+    if (download->totalBytes > 0)
+    {
+        int percent = (int)((download->doneBytes + nowDownloaded) * 100 / download->totalBytes);
+        if (percent != download->percent)
+        {
+            download->percent = percent;
+            download->manager->sendProgressMessage(MIN(percent, 100));
+        }
+    }
+    return 0;
+}
+
+bool AssetsManager::updateByManifest()
+{
+    // remote manifest
+    string content;
+    CURLcode res;
+    curl_easy_setopt(_curl, CURLOPT_URL, _manifestUrl.c_str());
+    curl_easy_setopt(_curl, CURLOPT_FAILONERROR, 1L);
+    curl_easy_setopt(_curl, CURLOPT_WRITEFUNCTION, getVersionCode);
+    curl_easy_setopt(_curl, CURLOPT_WRITEDATA, &content);
+    res = curl_easy_perform(_curl);
+    if (res != 0)
+    {
+        sendErrorMessage(kNetwork);
+        CCLOG("can not get manifest, error code is %d", res);
+        curl_easy_cleanup(_curl);
+        return false;
+    }
+    Manifest remote;
+    parseManifest(content, remote);
+    
+    // local manifest records files of last update
+    string localPath = _storagePath + CCUtils::lastPathComponent(_manifestUrl);
+    Manifest local;
+    FILE* fp = fopen(localPath.c_str(), "rb");
+    if (fp)
+    {
+        char buf[BUFFER_SIZE];
+        size_t n;
+        content.clear();
+        while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
+            content.append(buf, n);
+        fclose(fp);
+        parseManifest(content, local);
+    }
+    
+    // changed or lost files
+    vector<string> changed;
+    ManifestDownload download;
+    download.manager = this;
+    download.doneBytes = 0;
+    download.totalBytes = 0;
+    download.percent = -1;
+    for (Manifest::iterator iter = remote.begin(); iter != remote.end(); iter++)
+    {
+        Manifest::iterator old = local.find(iter->first);
+        if (old == local.end() || old->second.md5 != iter->second.md5 || ! CCUtils::isPathExistent(_storagePath + iter->first))
+        {
+            changed.push_back(iter->first);
+            download.totalBytes += iter->second.size;
+        }
+    }
+    CCLOG("%d of %d files are changed", (int)changed.size(), (int)remote.size());
+    
+    // download one by one with same handle, so connection is reused
+    string baseUrl = _manifestUrl.substr(0, _manifestUrl.rfind('/') + 1);
+    bool ok = true;
+    ErrorCode error = kNetwork;
+    for (vector<string>::iterator iter = changed.begin(); iter != changed.end() && ok; iter++)
+    {
+        const string& path = *iter;
+        const ManifestEntry& entry = remote[path];
+        if (! isSafeEntryPath(path))
+        {
+            CCLOG("bad path in manifest: %s", path.c_str());
+            ok = false;
+            error = kVerify;
+            break;
+        }
+        string fullPath = _storagePath + path;
+        string tmpPath = fullPath + TEMP_SUFFIX;
+        CCUtils::createIntermediateFolders(fullPath);
+        download.fp = fopen(tmpPath.c_str(), "wb");
+        if (! download.fp)
+        {
+            CCLOG("can not create file %s", tmpPath.c_str());
+            ok = false;
+            error = kCreateFile;
+            break;
+        }
+        download.md5 = MD5();
+        download.size = 0;
+        
+        string url = baseUrl + path;
+        curl_easy_setopt(_curl, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(_curl, CURLOPT_WRITEFUNCTION, downLoadManifestFile);
+        curl_easy_setopt(_curl, CURLOPT_WRITEDATA, &download);
+        curl_easy_setopt(_curl, CURLOPT_NOPROGRESS, false);
+        curl_easy_setopt(_curl, CURLOPT_PROGRESSFUNCTION, assetsManagerManifestProgressFunc);
+        curl_easy_setopt(_curl, CURLOPT_PROGRESSDATA, &download);
+        res = curl_easy_perform(_curl);
+        bool closed = fclose(download.fp) == 0;
+        if (res != 0 || ! closed)
+        {
+            CCLOG("error when download %s, error code is %d", url.c_str(), res);
+            remove(tmpPath.c_str());
+            ok = false;
+            break;
+        }
+        
+        // verify and replace
+        download.md5.finalize();
+        if (download.size != entry.size || download.md5.hexdigest() != entry.md5)
+        {
+            CCLOG("md5 of %s mismatched", url.c_str());
+            remove(tmpPath.c_str());
+            ok = false;
+            error = kVerify;
+            break;
+        }
+        if (rename(tmpPath.c_str(), fullPath.c_str()) != 0)
+        {
+            CCLOG("can not replace file %s", fullPath.c_str());
+            remove(tmpPath.c_str());
+            ok = false;
+            error = kCreateFile;
+            break;
+        }
+        local[path] = entry;
+        download.doneBytes += entry.size;
+    }
+    curl_easy_cleanup(_curl);
+    
+    // files removed from manifest
+    if (ok)
+    {
+        for (Manifest::iterator iter = local.begin(); iter != local.end(); iter++)
+        {
+            if (remote.find(iter->first) == remote.end())
+                remove((_storagePath + iter->first).c_str());
+        }
+        local = remote;
+    }
+    
+    // replaced files are recorded even if failed, so they are not downloaded again
+    if (! saveManifest(localPath, local))
+    {
+        CCLOG("can not save manifest %s", localPath.c_str());
+    }
+    if (! ok)
+    {
+        sendErrorMessage(error);
+        return false;
+    }
+    
+    CCLOG("succeed updating %d files by manifest %s", (int)changed.size(), _manifestUrl.c_str());
+    return true;
+}
+
 const char* AssetsManager::getPackageUrl() const
 {
     return _packageUrl.c_str();
@@ -446,6 +1120,26 @@ void AssetsManager::setPackageUrl(const char *packageUrl)
     _packageUrl = packageUrl;
 }
 
+const char* AssetsManager::getManifestUrl() const
+{
+    return _manifestUrl.c_str();
+}
+
+void AssetsManager::setManifestUrl(const char *manifestUrl)
+{
+    _manifestUrl = manifestUrl;
+}
+
+void AssetsManager::setStreamingEnabled(bool enabled)
+{
+    _streaming = enabled;
+}
+
+bool AssetsManager::isStreamingEnabled() const
+{
+    return _streaming;
+}
+
 const char* AssetsManager::getStoragePath() const
 {
     return _storagePath.c_str();
@@ -510,6 +1204,19 @@ void AssetsManager::sendErrorMessage(AssetsManager::ErrorCode code)
     _schedule->sendMessage(msg);
 }
 
+void AssetsManager::sendProgressMessage(int percent)
+{
+    Message *msg = new Message();
+    msg->what = ASSETSMANAGER_MESSAGE_PROGRESS;
+    
+    ProgressMessage *progressData = new ProgressMessage();
+    progressData->percent = percent;
+    progressData->manager = this;
+    msg->obj = progressData;
+    
+    _schedule->sendMessage(msg);
+}
+
 // Implementation of AssetsManagerHelper
 
 AssetsManager::Helper::Helper()
@@ -592,21 +1299,20 @@ void AssetsManager::Helper::handleUpdateSucceed(Message *msg)
     // Record new version code.
     CCUserDefault::sharedUserDefault()->setStringForKey(KEY_OF_VERSION, manager->_version.c_str());
     
-    // Delete unloaded zip file.
+    // Delete unloaded zip file, it is not saved if it is streamed
     string packageFileName = CCUtils::lastPathComponent(manager->_packageUrl);
     string zipfileName = manager->_storagePath + packageFileName;
-    if (remove(zipfileName.c_str()) != 0)
+    if (manager->_manifestUrl.size() == 0 && CCUtils::isPathExistent(zipfileName) && remove(zipfileName.c_str()) != 0)
     {
         CCLOG("can not remove downloaded zip file %s", zipfileName.c_str());
     }
-    if (manager){
+    if (manager->m_nfun.handler){
         CCArray* pArrayArgs = CCArray::createWithCapacity(2);
         pArrayArgs->addObject(CCString::create("done"));
         pArrayArgs->addObject(CCInteger::create(100));
         CCScriptEngineManager::sharedManager()->getScriptEngine()->executeEventWithArgs(manager->m_nfun, pArrayArgs);
-        return;
     }
-    if (manager) manager->_delegate->onSuccess();
+    if (manager->_delegate) manager->_delegate->onSuccess();
 }
 
 NS_CC_EXT_END
@@ -47,7 +47,9 @@ class AssetsManagerDelegateProtocol;
 /*
  *  This class is used to auto update resources, such as pictures or scripts.
  *  The updated package should be a zip file. And there should be a file named
- *  version in the server, which contains version code.
+ *  version in the server, which contains version code. Package is uncompressed
+ *  while it is downloaded. If a manifest is set, only changed files are downloaded
+ *  instead of package.
  *  @js NA
  *  @lua NA
  */
@@ -75,6 +77,11 @@ public:
          -- ...
          */
         kUncompress,
+        /** Downloaded file doesn't match its hash
+         -- crc32 of a file in package is wrong
+         -- md5 of a file in manifest is wrong
+         */
+        kVerify,
     };
     
     /* @brief Creates a AssetsManager with new package url, version code url and storage path.
@@ -122,6 +129,26 @@ public:
      */
     void deleteVersion();
     
+    /* @brief Gets manifest url.
+     */
+    const char* getManifestUrl() const;
+    
+    /* @brief Sets manifest url. If it is set, update() downloads files listed in manifest
+     *        instead of package, only files which are changed since last update are downloaded.
+     *        Every line of manifest is "md5 size path", files are downloaded from the folder
+     *        of manifest url. Files not in manifest any more are deleted.
+     */
+    void setManifestUrl(const char* manifestUrl);
+    
+    /* @brief Enables uncompressing package while it is downloaded, so zip file is not saved.
+     *        Package which can't be streamed falls back to download and uncompress. Default is true.
+     */
+    void setStreamingEnabled(bool enabled);
+    
+    /* @brief Is package uncompressed while it is downloaded.
+     */
+    bool isStreamingEnabled() const;
+    
     /* @brief Gets storage path.
      */
     const char* getStoragePath() const;
@@ -151,6 +178,8 @@ public:
     
     friend int assetsManagerProgressFunc(void *, double, double, double, double);
     
+    friend int assetsManagerManifestProgressFunc(void *, double, double, double, double);
+    
     void registerScriptEventHandler(ccScriptFunction nHandler);
     
     void unregisterScriptEventHandler(void);
@@ -163,6 +192,16 @@ protected:
     bool uncompress();
     bool createDirectory(const char *path);
     void sendErrorMessage(ErrorCode code);
+    void sendProgressMessage(int percent);
+    
+    /* @brief Downloads package and uncompresses it at same time.
+     * @return 1 if succeed, 0 if failed, -1 if package can't be streamed and nothing is written
+     */
+    int downLoadStreaming();
+    
+    /* @brief Downloads files in manifest which are changed
+     */
+    bool updateByManifest();
     
 private:
     typedef struct _Message
@@ -200,6 +239,10 @@ private:
     
     std::string _versionFileUrl;
     
+    std::string _manifestUrl;
+    
+    bool _streaming;
+    
     CURL *_curl;
     Helper *_schedule;
     pthread_t *_tid;
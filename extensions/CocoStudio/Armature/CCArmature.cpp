@@ -28,6 +28,8 @@ THE SOFTWARE.
 #include "utils/CCDataReaderHelper.h"
 #include "datas/CCDatas.h"
 #include "display/CCSkin.h"
+#include "display/CCDisplayFactory.h"
+#include "utils/CCArmatureSystem.h"
 
 #if ENABLE_PHYSICS_BOX2D_DETECT
 #include "Box2D/Box2D.h"
@@ -85,6 +87,7 @@ m_pParentBone(NULL),
 m_bArmatureTransformDirty(true),
 m_pBoneDic(NULL),
 m_pTopBoneList(NULL),
+m_bSortedBonesDirty(true),
 m_pAnimation(NULL),
 m_pTextureAtlasDic(NULL) {
 }
@@ -183,7 +186,7 @@ bool CCArmature::init(const char *name)
                 while (0);
             }
 
-            update(0);
+            updateImmediately(0);
             updateOffsetPoint();
         }
         else
@@ -277,6 +280,8 @@ void CCArmature::addBone(CCBone *bone, const char *parentName)
 
     m_pBoneDic->setObject(bone, bone->getName());
     addChild(bone);
+
+    m_bSortedBonesDirty = true;
 }
 
 
@@ -293,6 +298,8 @@ void CCArmature::removeBone(CCBone *bone, bool recursion)
     }
     m_pBoneDic->removeObjectForKey(bone->getName());
     removeChild(bone, true);
+
+    m_bSortedBonesDirty = true;
 }
 
 
@@ -329,6 +336,8 @@ void CCArmature::changeBoneParent(CCBone *bone, const char *parentName)
             m_pTopBoneList->addObject(bone);
         }
     }
+
+    m_bSortedBonesDirty = true;
 }
 
 CCDictionary *CCArmature::getBoneDic()
@@ -451,16 +460,100 @@ CCArmatureAnimation *CCArmature::getAnimation()
 }
 
 void CCArmature::update(float dt)
+{
+    if (m_pParentBone == NULL && CCArmatureSystem::isEnabled())
+    {
+        CCArmatureSystem::sharedArmatureSystem()->queueArmature(this, dt);
+        return;
+    }
+
+    updateImmediately(dt);
+}
+
+void CCArmature::updateImmediately(float dt)
 {
     m_pAnimation->update(dt);
 
+    //! Baked animation has already applied the pose to bones
+    if (!m_pAnimation->isBaked())
+    {
+        if (m_bSortedBonesDirty)
+        {
+            sortBones();
+        }
+
+        /*
+         *  Parents are before their children, so when a bone is evaluated its parent's world transform
+         *  is ready. Dirty flags are cleared in a second pass, children need to see their parent's flag.
+         */
+        std::vector<CCBone *>::iterator it;
+        for (it = m_sSortedBones.begin(); it != m_sSortedBones.end(); ++it)
+        {
+            (*it)->updateWorldTransform(dt);
+        }
+        for (it = m_sSortedBones.begin(); it != m_sSortedBones.end(); ++it)
+        {
+            (*it)->setTransformDirty(false);
+        }
+    }
+
+    m_bArmatureTransformDirty = false;
+}
+
+void CCArmature::updateBoneTransforms()
+{
+    if (m_bSortedBonesDirty)
+    {
+        sortBones();
+    }
+
+    for (std::vector<CCBone *>::iterator it = m_sSortedBones.begin(); it != m_sSortedBones.end(); ++it)
+    {
+        (*it)->computeWorldTransform();
+    }
+}
+
+void CCArmature::updateBoneDisplays(float dt)
+{
+    if (!m_pAnimation->isBaked())
+    {
+        std::vector<CCBone *>::iterator it;
+        for (it = m_sSortedBones.begin(); it != m_sSortedBones.end(); ++it)
+        {
+            CCBone *bone = *it;
+            CCDisplayFactory::updateDisplay(bone, dt, bone->isTransformDirty() || m_bArmatureTransformDirty);
+        }
+        for (it = m_sSortedBones.begin(); it != m_sSortedBones.end(); ++it)
+        {
+            (*it)->setTransformDirty(false);
+        }
+    }
+
+    m_bArmatureTransformDirty = false;
+}
+
+void CCArmature::sortBones()
+{
+    m_sSortedBones.clear();
+    m_sSortedBones.reserve(m_pBoneDic->count());
+
     CCObject *object = NULL;
     CCARRAY_FOREACH(m_pTopBoneList, object)
     {
-        ((CCBone *)object)->update(dt);
+        m_sSortedBones.push_back((CCBone *)object);
     }
 
-    m_bArmatureTransformDirty = false;
+    //! m_sSortedBones grows while it is walked, every bone appends its children
+    for (size_t i = 0; i < m_sSortedBones.size(); i++)
+    {
+        CCArray *children = m_sSortedBones[i]->getChildren();
+        CCARRAY_FOREACH(children, object)
+        {
+            m_sSortedBones.push_back((CCBone *)object);
+        }
+    }
+
+    m_bSortedBonesDirty = false;
 }
 
 void CCArmature::draw()
@@ -110,6 +110,11 @@ public:
      */
     virtual void removeBone(CCBone *bone, bool recursion);
 
+    /**
+     * Mark bone hierarchy changed, the sorted bone list will be rebuilt in next update
+     */
+    inline void setSortedBonesDirty() { m_bSortedBonesDirty = true; }
+
     /**
      * Get CCArmature's bone dictionary
      * @return CCArmature's bone dictionary
@@ -125,6 +130,25 @@ public:
 
     virtual void visit();
     virtual void update(float dt);
+
+    /**
+     * Evaluate animation and bones right now. update() does the same, except when CCArmatureSystem
+     * is enabled, then it only queues the armature for the system.
+     */
+    virtual void updateImmediately(float dt);
+
+    /**
+     * Compute world transform of every bone. It only touches bones of this armature, so CCArmatureSystem
+     * calls it for several armatures on worker threads.
+     * @js NA
+     */
+    void updateBoneTransforms();
+
+    /**
+     * Push bone transforms to displays and clear dirty flags, main thread only
+     * @js NA
+     */
+    void updateBoneDisplays(float dt);
     virtual void draw();
 
     virtual const CCAffineTransform& nodeToParentTransform();
@@ -177,6 +201,12 @@ protected:
      */
     CCBone *createBone(const char *boneName );
 
+    /*
+     * Rebuild m_sSortedBones from m_pTopBoneList, breadth first so every parent is before its children
+     * @js NA
+     */
+    void sortBones();
+
     CC_SYNTHESIZE(CCArmatureData *, m_pArmatureData, ArmatureData);
 
     CC_SYNTHESIZE(CCBatchNode *, m_pBatchNode, BatchNode);
@@ -195,6 +225,9 @@ protected:
 
     CCArray *m_pTopBoneList;
 
+    std::vector<CCBone *> m_sSortedBones;        //! All bones sorted parent first, update() evaluates them in one linear pass
+    bool m_bSortedBonesDirty;                    //! Whether or not bone hierarchy changed since m_sSortedBones was built
+
     static std::map<int, CCArmature *> m_sArmatureIndexDic;	//! Use to save armature zorder info,
 
     ccBlendFunc m_sBlendFunc;                    
@@ -178,6 +178,27 @@ CCArmature *CCBone::getArmature()
 }
 
 void CCBone::update(float delta)
+{
+    updateWorldTransform(delta);
+
+    CCObject *object = NULL;
+    CCARRAY_FOREACH(m_pChildren, object)
+    {
+        CCBone *childBone = (CCBone *)object;
+        childBone->update(delta);
+    }
+
+    m_bBoneTransformDirty = false;
+}
+
+void CCBone::updateWorldTransform(float delta)
+{
+    computeWorldTransform();
+
+    CCDisplayFactory::updateDisplay(this, delta, m_bBoneTransformDirty || m_pArmature->getArmatureTransformDirty());
+}
+
+void CCBone::computeWorldTransform()
 {
     if (m_pParentBone)
         m_bBoneTransformDirty = m_bBoneTransformDirty || m_pParentBone->isTransformDirty();
@@ -222,17 +243,6 @@ void CCBone::update(float delta)
             m_tWorldTransform = CCAffineTransformConcat(m_tWorldTransform, m_pArmature->nodeToParentTransform());
         }
     }
-
-    CCDisplayFactory::updateDisplay(this, delta, m_bBoneTransformDirty || m_pArmature->getArmatureTransformDirty());
-
-    CCObject *object = NULL;
-    CCARRAY_FOREACH(m_pChildren, object)
-    {
-        CCBone *childBone = (CCBone *)object;
-        childBone->update(delta);
-    }
-
-    m_bBoneTransformDirty = false;
 }
 
 void CCBone::applyParentTransform(CCBone *parent)
@@ -312,6 +322,11 @@ void CCBone::addChildBone(CCBone *child)
     {
         m_pChildren->addObject(child);
         child->setParentBone(this);
+
+        if (m_pArmature)
+        {
+            m_pArmature->setSortedBonesDirty();
+        }
     }
 }
 
@@ -335,6 +350,11 @@ void CCBone::removeChildBone(CCBone *bone, bool recursion)
         bone->getDisplayManager()->setCurrentDecorativeDisplay(NULL);
 
         m_pChildren->removeObject(bone);
+
+        if (m_pArmature)
+        {
+            m_pArmature->setSortedBonesDirty();
+        }
     }
 }
 
@@ -137,6 +137,18 @@ public:
 
     void update(float delta);
 
+    /**
+     * Update world transform and display of this bone only, its parent must be updated before.
+     * The transform dirty flag is kept so children can still see it, CCArmature clears it after all
+     * bones are evaluated.
+     */
+    void updateWorldTransform(float delta);
+
+    /**
+     * The transform part of updateWorldTransform, it doesn't touch displays
+     */
+    void computeWorldTransform();
+
     void updateDisplayedColor(const ccColor3B &parentColor);
     void updateDisplayedOpacity(GLubyte parentOpacity);
 
@@ -172,6 +184,11 @@ public:
     virtual bool isBlendDirty(void) { return m_bBlendDirty; }
 
     virtual CCAffineTransform nodeToArmatureTransform();
+
+    /*
+     * Set the transform in armature space directly, baked animation uses it instead of update()
+     */
+    virtual inline void setNodeToArmatureTransform(const CCAffineTransform &transform) { m_tWorldTransform = transform; }
     virtual CCAffineTransform nodeToWorldTransform();
 
     CCNode *getDisplayRenderNode();
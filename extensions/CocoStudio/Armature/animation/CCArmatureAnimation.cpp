@@ -28,6 +28,9 @@ THE SOFTWARE.
 #include "../utils/CCArmatureDefine.h"
 #include "../utils/CCUtilMath.h"
 #include "../datas/CCDatas.h"
+#include "../display/CCDisplayFactory.h"
+#include "../utils/CCArmatureDataManager.h"
+#include "CCBakedAnimation.h"
 #include "LuaBasicConversions.h"
 
 
@@ -64,6 +67,12 @@ CCArmatureAnimation::CCArmatureAnimation()
 , m_sMovementEventTarget(NULL)
 , m_sFrameEventTarget(NULL)
 , m_pScriptObjectDict(NULL)
+, m_bBaked(false)
+, m_bBakedInterpolation(false)
+, m_pBakedAnimationData(NULL)
+, m_pBakedMovementData(NULL)
+, m_fBakedFrame(0)
+, m_fBakedAppliedFrame(-1)
 {
     memset(&m_movementEventHandler, 0, sizeof(ccScriptFunction));
     memset(&m_frameEventHandler, 0, sizeof(ccScriptFunction));
@@ -76,6 +85,7 @@ CCArmatureAnimation::~CCArmatureAnimation(void)
     
     CC_SAFE_RELEASE_NULL(m_pTweenList);
     CC_SAFE_RELEASE_NULL(m_pAnimationData);
+    CC_SAFE_RELEASE_NULL(m_pBakedAnimationData);
 
     CC_SAFE_RELEASE_NULL(m_pUserObject);
     CC_SAFE_RELEASE_NULL(m_pScriptObjectDict);
@@ -198,6 +208,12 @@ void CCArmatureAnimation::play(const char *animationName, int durationTo, int du
 
     m_bOnMovementList = false;
 
+    if (m_bBaked)
+    {
+        playBaked(loop != 0);
+        return;
+    }
+
     CCProcessBase::play(durationTo, durationTween, loop, tweenEasing);
 
 
@@ -255,7 +271,7 @@ void CCArmatureAnimation::play(const char *animationName, int durationTo, int du
         }
     }
 
-    m_pArmature->update(0);
+    m_pArmature->updateImmediately(0);
 }
 
 bool CCArmatureAnimation::hasFrameEvent(std::string movementId, std::string eventName, bool partial) {
@@ -376,13 +392,18 @@ void CCArmatureAnimation::gotoAndPlay(int frameIndex)
     m_fCurrentPercent = (float)m_iCurFrameIndex / ((float)m_pMovementData->duration - 1);
     m_fCurrentFrame = m_iNextFrameIndex * m_fCurrentPercent;
 
+    if (m_bBaked && m_pBakedMovementData)
+    {
+        m_fBakedFrame = m_fCurrentPercent * (m_pBakedMovementData->frameCount - 1);
+    }
+
     CCObject *object = NULL;
     CCARRAY_FOREACH(m_pTweenList, object)
     {
         ((CCTween *)object)->gotoAndPlay(frameIndex);
     }
 
-    m_pArmature->update(0);
+    m_pArmature->updateImmediately(0);
 
     m_bIgnoreFrameEvent = ignoreFrameEvent;
 }
@@ -400,13 +421,29 @@ int CCArmatureAnimation::getMovementCount()
 
 void CCArmatureAnimation::update(float dt)
 {
-    CCProcessBase::update(dt);
-    CCObject *object = NULL;
-    CCARRAY_FOREACH(m_pTweenList, object)
+    updateMovement(dt);
+    dispatchEvents();
+}
+
+void CCArmatureAnimation::updateMovement(float dt)
+{
+    if (m_bBaked)
+    {
+        updateBaked(dt);
+    }
+    else
     {
-        ((CCTween *)object)->update(dt);
+        CCProcessBase::update(dt);
+        CCObject *object = NULL;
+        CCARRAY_FOREACH(m_pTweenList, object)
+        {
+            ((CCTween *)object)->update(dt);
+        }
     }
+}
 
+void CCArmatureAnimation::dispatchEvents()
+{
     while (m_sFrameEventQueue.size() > 0)
     {
         CCFrameEvent *event = m_sFrameEventQueue.front();
@@ -636,6 +673,228 @@ void CCArmatureAnimation::updateMovementList()
     }
 }
 
+void CCArmatureAnimation::setBaked(bool baked, bool interpolate)
+{
+    m_bBakedInterpolation = interpolate;
+
+    if (baked == m_bBaked)
+    {
+        return;
+    }
+
+    bool playing = m_pMovementData && !m_bIsComplete;
+    float percent = m_fCurrentPercent;
+
+    if (baked)
+    {
+        CCBakedAnimationData *bakedData = CCArmatureDataManager::sharedArmatureDataManager()->getBakedAnimationData(m_pArmature->getName().c_str());
+        if (!bakedData)
+        {
+            CCLOG("armature %s can't be baked, it keeps playing tweens", m_pArmature->getName().c_str());
+            return;
+        }
+
+        CC_SAFE_RETAIN(bakedData);
+        CC_SAFE_RELEASE(m_pBakedAnimationData);
+        m_pBakedAnimationData = bakedData;
+    }
+    else
+    {
+        m_pBakedMovementData = NULL;
+        m_sBakedBones.clear();
+    }
+
+    m_bBaked = baked;
+
+    //! Continue current movement in the new mode
+    if (playing)
+    {
+        bool paused = m_bIsPause;
+        play(m_strMovementID.c_str(), 0);
+        if (m_bBaked && m_pBakedMovementData)
+        {
+            m_fBakedFrame = percent * (m_pBakedMovementData->frameCount - 1);
+        }
+        if (paused)
+        {
+            pause();
+        }
+    }
+}
+
+void CCArmatureAnimation::playBaked(bool loop)
+{
+    m_pBakedMovementData = m_pBakedAnimationData->getMovement(m_strMovementID.c_str());
+    CCAssert(m_pBakedMovementData, "m_pBakedMovementData can not be null");
+
+    m_bIsComplete = false;
+    m_bIsPause = false;
+    m_bIsPlaying = true;
+    m_fCurrentPercent = 0;
+
+    if (m_pBakedMovementData->frameCount <= 1)
+    {
+        m_eLoopType = SINGLE_FRAME;
+    }
+    else
+    {
+        m_eLoopType = loop ? ANIMATION_LOOP_FRONT : ANIMATION_NO_LOOP;
+    }
+
+    CCObject *object = NULL;
+    CCARRAY_FOREACH(m_pTweenList, object)
+    {
+        ((CCTween *)object)->stop();
+    }
+    m_pTweenList->removeAllObjects();
+
+    //! Bind bones every time, bones may be added or removed between two movements
+    std::vector<std::string> &boneNames = m_pBakedAnimationData->boneNames;
+    m_sBakedBones.resize(boneNames.size());
+    for (size_t i = 0; i < boneNames.size(); i++)
+    {
+        m_sBakedBones[i] = m_pArmature->getBone(boneNames[i].c_str());
+    }
+
+    m_fBakedFrame = 0;
+    m_fBakedAppliedFrame = -1;
+
+    movementEvent(m_pArmature, START, m_strMovementID.c_str());
+    bakedFrameEvents(-1, 0);
+
+    m_pArmature->updateImmediately(0);
+}
+
+void CCArmatureAnimation::updateBaked(float dt)
+{
+    CS_RETURN_IF(!m_pBakedMovementData);
+
+    int lastFrame = m_pBakedMovementData->frameCount - 1;
+
+    //! Same filter as CCProcessBase::update, dt > 1 generally means the device was stuck
+    if (!m_bIsComplete && !m_bIsPause && dt <= 1)
+    {
+        int fromFrame = (int)m_fBakedFrame;
+        m_fBakedFrame += m_fProcessScale * (dt / m_fAnimationInternal);
+
+        if (m_fBakedFrame >= lastFrame)
+        {
+            bakedFrameEvents(fromFrame, lastFrame);
+
+            if (m_eLoopType == ANIMATION_LOOP_FRONT)
+            {
+                m_fBakedFrame = fmodf(m_fBakedFrame, lastFrame);
+                movementEvent(m_pArmature, LOOP_COMPLETE, m_strMovementID.c_str());
+                bakedFrameEvents(-1, (int)m_fBakedFrame);
+            }
+            else
+            {
+                m_fBakedFrame = lastFrame;
+                m_fCurrentPercent = 1;
+                m_bIsComplete = true;
+                m_bIsPlaying = false;
+
+                movementEvent(m_pArmature, COMPLETE, m_strMovementID.c_str());
+
+                //! It may play the next movement, which applies its own first frame
+                updateMovementList();
+            }
+        }
+        else
+        {
+            bakedFrameEvents(fromFrame, (int)m_fBakedFrame);
+        }
+
+        if (!m_bIsComplete)
+        {
+            m_fCurrentPercent = lastFrame > 0 ? m_fBakedFrame / lastFrame : 1;
+        }
+    }
+
+    CCBakedMovementData *movement = m_pBakedMovementData;
+    lastFrame = movement->frameCount - 1;
+
+    int frame = MIN((int)m_fBakedFrame, lastFrame);
+    float t = m_bBakedInterpolation && frame < lastFrame ? m_fBakedFrame - frame : 0;
+    float appliedFrame = frame + t;
+
+    bool poseDirty = appliedFrame != m_fBakedAppliedFrame;
+    bool dirty = poseDirty || m_pArmature->getArmatureTransformDirty();
+    m_fBakedAppliedFrame = appliedFrame;
+
+    for (int i = 0; i < movement->boneCount; i++)
+    {
+        CCBone *bone = m_sBakedBones[i];
+        if (!bone)
+        {
+            continue;
+        }
+
+        if (poseDirty)
+        {
+            int index = movement->indexOf(frame, i);
+
+            CCDisplayManager *displayManager = bone->getDisplayManager();
+            bool displayChanged = false;
+            if (displayManager->getCurrentDisplayIndex() != movement->displayIndices[index] && !displayManager->getForceChangeDisplay())
+            {
+                displayManager->changeDisplayWithIndex(movement->displayIndices[index], false);
+                displayChanged = true;
+            }
+
+            bone->setZOrder(movement->zOrders[index]);
+            bone->setBlendFunc(movement->blendFuncs[index]);
+
+            const ccColor4B &color = movement->colors[index];
+            CCFrameData *tweenData = bone->getTweenData();
+            if (displayChanged || tweenData->r != color.r || tweenData->g != color.g || tweenData->b != color.b || tweenData->a != color.a)
+            {
+                tweenData->r = color.r;
+                tweenData->g = color.g;
+                tweenData->b = color.b;
+                tweenData->a = color.a;
+                bone->updateColor();
+            }
+
+            if (t > 0)
+            {
+                const CCAffineTransform &from = movement->transforms[index];
+                const CCAffineTransform &to = movement->transforms[index + movement->boneCount];
+                bone->setNodeToArmatureTransform(CCAffineTransformMake(from.a + (to.a - from.a) * t,
+                                                                       from.b + (to.b - from.b) * t,
+                                                                       from.c + (to.c - from.c) * t,
+                                                                       from.d + (to.d - from.d) * t,
+                                                                       from.tx + (to.tx - from.tx) * t,
+                                                                       from.ty + (to.ty - from.ty) * t));
+            }
+            else
+            {
+                bone->setNodeToArmatureTransform(movement->transforms[index]);
+            }
+        }
+
+        CCDisplayFactory::updateDisplay(bone, dt, dirty);
+    }
+}
+
+void CCArmatureAnimation::bakedFrameEvents(int fromFrame, int toFrame)
+{
+    CS_RETURN_IF(m_bIgnoreFrameEvent || toFrame <= fromFrame);
+
+    std::vector<CCBakedFrameEvent> &events = m_pBakedMovementData->frameEvents;
+    for (std::vector<CCBakedFrameEvent>::iterator it = events.begin(); it != events.end(); ++it)
+    {
+        if (it->frame > toFrame)
+        {
+            break;
+        }
+        if (it->frame > fromFrame && it->boneIndex >= 0 && m_sBakedBones[it->boneIndex])
+        {
+            frameEvent(m_sBakedBones[it->boneIndex], it->name.c_str(), it->originFrameIndex, it->frame);
+        }
+    }
+}
+
 cocos2d::CCDictionary * CCArmatureAnimation::getScriptObjectDict()
 {
     return m_pScriptObjectDict;
@@ -42,6 +42,8 @@ enum MovementEventType
 
 class CCArmature;
 class CCBone;
+class CCBakedAnimationData;
+class CCBakedMovementData;
 
 typedef void (CCObject::*SEL_MovementEventCallFunc)(CCArmature *, MovementEventType, const char *);
 typedef void (CCObject::*SEL_FrameEventCallFunc)(CCBone *, const char *, int, int);
@@ -201,6 +203,13 @@ public:
 
     void update(float dt);
 
+    /**
+     * update() is updateMovement() followed by dispatchEvents(). CCArmatureSystem calls them
+     * separately, events of all armatures are dispatched after all poses are evaluated.
+     */
+    void updateMovement(float dt);
+    void dispatchEvents();
+
     /**
      * Get current movementID
      * @return The name of current movement
@@ -277,7 +286,21 @@ public:
      * @param partial true if event name is just a sub string, not whole string
      */
     bool hasFrameEvent(std::string movementId, std::string eventName, bool partial);
-    
+
+    /**
+     * Play movements from poses baked by CCArmatureDataManager::getBakedAnimationData instead of
+     * running the tweens. The baked poses are shared by all armatures with the same name, so playback
+     * is only a lookup per bone and frame. Baked movements start without durationTo blending and
+     * ignore durationTween and tweenEasing passed to play.
+     *
+     * If the armature can't be baked, the animation stays in the normal mode.
+     *
+     * @param baked Whether or not to play baked poses
+     * @param interpolate Blend the bone transform between two baked frames, smoother when the speed scale is low
+     */
+    virtual void setBaked(bool baked, bool interpolate = false);
+    inline bool isBaked() const { return m_bBaked; }
+
 protected:
 
     /**
@@ -305,9 +328,28 @@ protected:
 
     void updateMovementList();
 
+    /**
+     * Start current movement from baked poses
+     * @js NA
+     */
+    void playBaked(bool loop);
+
+    /**
+     * Advance baked frame, emit events and apply the pose to bones
+     * @js NA
+     */
+    void updateBaked(float dt);
+
+    /**
+     * Emit baked frame events in frames (fromFrame, toFrame]
+     * @js NA
+     */
+    void bakedFrameEvents(int fromFrame, int toFrame);
+
     inline bool isIgnoreFrameEvent() { return m_bIgnoreFrameEvent; }
 
     friend class CCTween;
+    friend class CCBakedAnimationData;
 protected:
     //! CCAnimationData save all MovementDatas this animation used.
     CC_SYNTHESIZE_RETAIN(CCAnimationData *, m_pAnimationData, AnimationData);
@@ -343,6 +385,14 @@ protected:
     // script event handler
     ccScriptFunction m_movementEventHandler;
     ccScriptFunction m_frameEventHandler;
+
+    bool m_bBaked;
+    bool m_bBakedInterpolation;
+    CCBakedAnimationData *m_pBakedAnimationData;
+    CCBakedMovementData *m_pBakedMovementData;  //! A weak reference, owned by m_pBakedAnimationData
+    std::vector<CCBone *> m_sBakedBones;        //! Bones of the armature in the order of CCBakedAnimationData::boneNames
+    float m_fBakedFrame;                        //! Current baked frame
+    float m_fBakedAppliedFrame;                 //! The frame applied to bones, -1 if bones need update
     
 protected:
     /**
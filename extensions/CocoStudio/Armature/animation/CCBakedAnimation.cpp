@@ -0,0 +1,227 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "CCBakedAnimation.h"
+#include "CCArmatureAnimation.h"
+#include "../CCArmature.h"
+#include "../CCBone.h"
+#include "../utils/CCArmatureDataManager.h"
+
+
+NS_CC_EXT_BEGIN
+
+CCBakedMovementData::CCBakedMovementData(void)
+    : name("")
+    , frameCount(0)
+    , boneCount(0)
+    , loop(true)
+{
+}
+
+CCBakedMovementData::~CCBakedMovementData(void)
+{
+}
+
+void CCBakedMovementData::resize(int frames, int bones)
+{
+    frameCount = frames;
+    boneCount = bones;
+
+    size_t size = frames * bones;
+    transforms.resize(size, CCAffineTransformMakeIdentity());
+    colors.resize(size, ccc4(255, 255, 255, 255));
+    displayIndices.resize(size, -1);
+    zOrders.resize(size, 0);
+
+    ccBlendFunc blendFunc = {CC_BLEND_SRC, CC_BLEND_DST};
+    blendFuncs.resize(size, blendFunc);
+}
+
+
+
+CCBakedAnimationData *CCBakedAnimationData::create(const char *name)
+{
+    CCBakedAnimationData *bakedData = new CCBakedAnimationData();
+    if (bakedData && bakedData->init(name))
+    {
+        CC_SAFE_AUTORELEASE(bakedData);
+        return bakedData;
+    }
+    CC_SAFE_DELETE(bakedData);
+    return NULL;
+}
+
+CCBakedAnimationData::CCBakedAnimationData(void)
+    : name("")
+    , m_pBakingMovement(NULL)
+    , m_iBakingFrame(0)
+{
+}
+
+CCBakedAnimationData::~CCBakedAnimationData(void)
+{
+}
+
+bool CCBakedAnimationData::init(const char *name)
+{
+    bool bRet = false;
+    do
+    {
+        CCArmatureDataManager *armatureDataManager = CCArmatureDataManager::sharedArmatureDataManager();
+        CCAnimationData *animationData = armatureDataManager->getAnimationData(name);
+        CC_BREAK_IF(!animationData || !armatureDataManager->getArmatureData(name));
+
+        this->name = name;
+
+        //! Movements are sampled from a temporary armature, it is released with the current autorelease pool
+        CCArmature *armature = CCArmature::create(name);
+        CC_BREAK_IF(!armature);
+
+        std::vector<CCBone *> bones;
+        bool hasChildArmature = false;
+
+        CCDictElement *element = NULL;
+        CCDictionary *boneDic = armature->getBoneDic();
+        CCDICT_FOREACH(boneDic, element)
+        {
+            CCBone *bone = (CCBone *)element->getObject();
+
+            //! A child armature runs its own animation, its pose can't be baked into this one
+            CCObject *object = NULL;
+            CCARRAY_FOREACH(&bone->getBoneData()->displayDataList, object)
+            {
+                if (((CCDisplayData *)object)->displayType == CS_DISPLAY_ARMATURE)
+                {
+                    hasChildArmature = true;
+                }
+            }
+
+            m_sBoneIndices[bone->getName()] = bones.size();
+            boneNames.push_back(bone->getName());
+            bones.push_back(bone);
+        }
+
+        if (hasChildArmature)
+        {
+            CCLOG("armature %s has child armatures, it can't be baked", name);
+            break;
+        }
+
+        armature->getAnimation()->setFrameEventCallFunc(this, frameEvent_selector(CCBakedAnimationData::onBakeFrameEvent));
+
+        std::vector<std::string> &movementNames = animationData->movementNames;
+        for (std::vector<std::string>::iterator it = movementNames.begin(); it != movementNames.end(); ++it)
+        {
+            if (CCMovementData *movementData = animationData->getMovement(it->c_str()))
+            {
+                bakeMovement(armature, movementData, bones);
+            }
+        }
+
+        armature->getAnimation()->setFrameEventCallFunc(NULL, NULL);
+        armature->getAnimation()->stop();
+
+        bRet = true;
+    }
+    while (0);
+
+    return bRet;
+}
+
+void CCBakedAnimationData::bakeMovement(CCArmature *armature, CCMovementData *movementData, const std::vector<CCBone *> &bones)
+{
+    CCArmatureAnimation *animation = armature->getAnimation();
+
+    int durationTween = movementData->durationTween == 0 ? movementData->duration : movementData->durationTween;
+    int frames = (movementData->duration == 0 || durationTween <= 0) ? 1 : durationTween + 1;
+
+    CCBakedMovementData *bakedMovement = CCBakedMovementData::create();
+    bakedMovement->name = movementData->name;
+    bakedMovement->loop = movementData->loop;
+    bakedMovement->resize(frames, bones.size());
+
+    m_pBakingMovement = bakedMovement;
+    m_iBakingFrame = 0;
+
+    /*
+     *  Play without blending from the previous movement and without looping, so frame 0 is the
+     *  first key frame and the last sample is the pose at 100%. Every update advances exactly one frame.
+     */
+    animation->play(movementData->name.c_str(), 0, -1, 0);
+
+    float scale = movementData->scale > 0 ? movementData->scale : 1;
+    float step = animation->m_fAnimationInternal / scale;
+
+    for (int frame = 0; frame < frames; frame++)
+    {
+        if (frame > 0)
+        {
+            m_iBakingFrame = frame;
+            armature->updateImmediately(step);
+        }
+
+        for (size_t i = 0; i < bones.size(); i++)
+        {
+            CCBone *bone = bones[i];
+            CCFrameData *tweenData = bone->getTweenData();
+            int index = bakedMovement->indexOf(frame, i);
+
+            bakedMovement->transforms[index] = bone->nodeToArmatureTransform();
+            bakedMovement->colors[index] = ccc4(tweenData->r, tweenData->g, tweenData->b, tweenData->a);
+            bakedMovement->displayIndices[index] = bone->getDisplayManager()->getCurrentDisplayIndex();
+            bakedMovement->zOrders[index] = bone->getZOrder();
+            bakedMovement->blendFuncs[index] = bone->getBlendFunc();
+        }
+    }
+
+    m_pBakingMovement = NULL;
+
+    movementDataDic.setObject(bakedMovement, bakedMovement->name);
+}
+
+void CCBakedAnimationData::onBakeFrameEvent(CCBone *bone, const char *frameEventName, int originFrameIndex, int currentFrameIndex)
+{
+    CS_RETURN_IF(!m_pBakingMovement);
+
+    CCBakedFrameEvent event;
+    event.frame = m_iBakingFrame;
+    event.boneIndex = getBoneIndex(bone->getName());
+    event.originFrameIndex = originFrameIndex;
+    event.name = frameEventName;
+
+    m_pBakingMovement->frameEvents.push_back(event);
+}
+
+CCBakedMovementData *CCBakedAnimationData::getMovement(const char *movementName)
+{
+    return (CCBakedMovementData *)movementDataDic.objectForKey(movementName);
+}
+
+int CCBakedAnimationData::getBoneIndex(const std::string &boneName)
+{
+    std::map<std::string, int>::iterator it = m_sBoneIndices.find(boneName);
+    return it == m_sBoneIndices.end() ? -1 : it->second;
+}
+
+NS_CC_EXT_END
@@ -0,0 +1,134 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __CCBAKEDANIMATION_H__
+#define __CCBAKEDANIMATION_H__
+
+#include "../utils/CCArmatureDefine.h"
+#include "../datas/CCDatas.h"
+#include <map>
+
+NS_CC_EXT_BEGIN
+
+class CCBone;
+class CCArmature;
+
+/**
+ *  A frame event recorded while baking, it is replayed when playback passes its frame
+ *  @js NA
+ *  @lua NA
+ */
+struct CCBakedFrameEvent
+{
+    int frame;                      //! baked frame the event was emitted at
+    int boneIndex;                  //! index in CCBakedAnimationData::boneNames
+    int originFrameIndex;           //! frame index of the key frame in the flash timeline
+    std::string name;               //! event name
+};
+
+/**
+ *  The pose of every bone of a movement, sampled once per animation frame.
+ *  Tracks are flat arrays indexed by frame * boneCount + boneIndex.
+ *  @js NA
+ *  @lua NA
+ */
+class CC_DLL CCBakedMovementData : public CCObject
+{
+public:
+    CC_CREATE_NO_PARAM_NO_INIT(CCBakedMovementData)
+public:
+    CCBakedMovementData(void);
+    ~CCBakedMovementData(void);
+
+    void resize(int frames, int bones);
+
+    inline int indexOf(int frame, int bone) const { return frame * boneCount + bone; }
+public:
+    std::string name;
+    int frameCount;                 //! durationTween + 1 samples, the last one is the pose at 100%
+    int boneCount;
+    bool loop;                      //! loop value from CCMovementData
+
+    std::vector<CCAffineTransform> transforms;  //! bone transform in armature space
+    std::vector<ccColor4B> colors;              //! tween color, multiplied by the bone color when applied
+    std::vector<short> displayIndices;
+    std::vector<short> zOrders;
+    std::vector<ccBlendFunc> blendFuncs;
+
+    std::vector<CCBakedFrameEvent> frameEvents; //! sorted by frame
+};
+
+/**
+ *  Baked poses of all movements of an armature. It is shared by every CCArmature
+ *  created from the same CCArmatureData, get it from CCArmatureDataManager::getBakedAnimationData.
+ *
+ *  Movements are sampled by playing them on a temporary armature, so the result is exactly
+ *  what the tween pipeline produces at speed scale 1. Armatures whose bones use child armatures,
+ *  or whose frames play movements on child armatures, can't be baked.
+ *  @js NA
+ *  @lua NA
+ */
+class CC_DLL CCBakedAnimationData : public CCObject
+{
+public:
+    /**
+     * Bake all movements of the armature named name.
+     * @return A baked data which is marked as "autorelease", or NULL if the armature can't be baked.
+     */
+    static CCBakedAnimationData *create(const char *name);
+public:
+    CCBakedAnimationData(void);
+    ~CCBakedAnimationData(void);
+
+    virtual bool init(const char *name);
+
+    CCBakedMovementData *getMovement(const char *movementName);
+
+    //! Index of bone name in boneNames, -1 if the bone wasn't baked
+    int getBoneIndex(const std::string &boneName);
+public:
+    std::string name;
+    std::vector<std::string> boneNames;
+
+    /**
+     * @key	const char *
+     * @value	CCBakedMovementData *
+     */
+    CCDictionary movementDataDic;
+
+protected:
+    void bakeMovement(CCArmature *armature, CCMovementData *movementData, const std::vector<CCBone *> &bones);
+
+    void onBakeFrameEvent(CCBone *bone, const char *frameEventName, int originFrameIndex, int currentFrameIndex);
+
+    std::map<std::string, int> m_sBoneIndices;
+
+    //! Movement and frame being sampled, used by onBakeFrameEvent
+    CCBakedMovementData *m_pBakingMovement;
+    int m_iBakingFrame;
+};
+
+NS_CC_EXT_END
+
+#endif /*__CCBAKEDANIMATION_H__*/
@@ -78,6 +78,7 @@ CCSkin *CCSkin::create(const char *pszFileName)
 CCSkin::CCSkin()
     : m_pBone(NULL)
     , m_pArmature(NULL)
+    , m_bQuadDirty(true)
     , m_strDisplayName("")
 {
     m_tSkinTransform = CCAffineTransformIdentity;
@@ -140,6 +141,25 @@ void CCSkin::updateArmatureTransform()
     {
         m_sTransform = CCAffineTransformConcat(m_sTransform, m_pArmature->nodeToParentTransform());
     }
+    m_bQuadDirty = true;
+}
+
+void CCSkin::setTextureRect(const CCRect& rect, bool rotated, const CCSize& untrimmedSize)
+{
+    CCSprite::setTextureRect(rect, rotated, untrimmedSize);
+    m_bQuadDirty = true;
+}
+
+void CCSkin::setVisible(bool bVisible)
+{
+    CCSprite::setVisible(bVisible);
+    m_bQuadDirty = true;
+}
+
+void CCSkin::setVertexZ(float fVertexZ)
+{
+    CCSprite::setVertexZ(fVertexZ);
+    m_bQuadDirty = true;
 }
 
 void CCSkin::updateTransform()
@@ -149,7 +169,8 @@ void CCSkin::updateTransform()
     {
         m_sQuad.br.vertices = m_sQuad.tl.vertices = m_sQuad.tr.vertices = m_sQuad.bl.vertices = vertex3(0, 0, 0);
     }
-    else
+    // Armature draws every frame, vertices are only computed again when transform or rect changed
+    else if (m_bQuadDirty)
     {
         //
         // calculate the Quad based on the Affine Matrix
@@ -186,6 +207,8 @@ void CCSkin::updateTransform()
         SET_VERTEX3F( m_sQuad.br.vertices, RENDER_IN_SUBPIXEL(bx), RENDER_IN_SUBPIXEL(by), m_fVertexZ );
         SET_VERTEX3F( m_sQuad.tl.vertices, RENDER_IN_SUBPIXEL(dx), RENDER_IN_SUBPIXEL(dy), m_fVertexZ );
         SET_VERTEX3F( m_sQuad.tr.vertices, RENDER_IN_SUBPIXEL(cx), RENDER_IN_SUBPIXEL(cy), m_fVertexZ );
+
+        m_bQuadDirty = false;
     }
 
     // MARMALADE CHANGE: ADDED CHECK FOR NULL, TO PERMIT SPRITES WITH NO BATCH NODE / TEXTURE ATLAS
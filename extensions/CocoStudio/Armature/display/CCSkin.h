@@ -50,6 +50,10 @@ public:
     void updateArmatureTransform();
     void updateTransform();
 
+    virtual void setTextureRect(const CCRect& rect, bool rotated, const CCSize& untrimmedSize);
+    virtual void setVisible(bool bVisible);
+    virtual void setVertexZ(float fVertexZ);
+
     CCAffineTransform nodeToWorldTransform();
     CCAffineTransform nodeToWorldTransformAR();
 
@@ -62,6 +66,7 @@ protected:
     CCBaseData m_sSkinData;
     CCArmature *m_pArmature;
     CCAffineTransform m_tSkinTransform;
+    bool m_bQuadDirty;          //! Whether or not quad vertices need to be computed from m_sTransform again
     CC_SYNTHESIZE_READONLY(std::string, m_strDisplayName, DisplayName)
 };
 
@@ -27,6 +27,8 @@ THE SOFTWARE.
 #include "CCTransformHelp.h"
 #include "CCDataReaderHelper.h"
 #include "CCSpriteFrameCacheHelper.h"
+#include "CCArmatureSystem.h"
+#include "../animation/CCBakedAnimation.h"
 
 
 NS_CC_EXT_BEGIN
@@ -48,6 +50,7 @@ CCArmatureDataManager *CCArmatureDataManager::sharedArmatureDataManager()
 
 void CCArmatureDataManager::purge()
 {
+    CCArmatureSystem::purge();
     CCSpriteFrameCacheHelper::purge();
     CCDataReaderHelper::purge();
     CC_SAFE_RELEASE_NULL(s_sharedArmatureDataManager);
@@ -58,6 +61,7 @@ CCArmatureDataManager::CCArmatureDataManager(void)
     m_pArmarureDatas = NULL;
     m_pAnimationDatas = NULL;
     m_pTextureDatas = NULL;
+    m_pBakedAnimationDatas = NULL;
     m_bAutoLoadSpriteFile = false;
 }
 
@@ -78,11 +82,17 @@ CCArmatureDataManager::~CCArmatureDataManager(void)
         m_pTextureDatas->removeAllObjects();
     }
 
+    if( m_pBakedAnimationDatas )
+    {
+        m_pBakedAnimationDatas->removeAllObjects();
+    }
+
     m_sRelativeDatas.clear();
 
     CC_SAFE_DELETE(m_pAnimationDatas);
     CC_SAFE_DELETE(m_pArmarureDatas);
     CC_SAFE_DELETE(m_pTextureDatas);
+    CC_SAFE_DELETE(m_pBakedAnimationDatas);
 }
 
 
@@ -103,6 +113,10 @@ bool CCArmatureDataManager::init()
         CCAssert(m_pTextureDatas, "create CCArmatureDataManager::m_pTextureDatas fail!");
         CC_SAFE_RETAIN(m_pTextureDatas);
 
+        m_pBakedAnimationDatas = CCDictionary::create();
+        CCAssert(m_pBakedAnimationDatas, "create CCArmatureDataManager::m_pBakedAnimationDatas fail!");
+        CC_SAFE_RETAIN(m_pBakedAnimationDatas);
+
         bRet = true;
     }
     while (0);
@@ -169,6 +183,7 @@ void CCArmatureDataManager::removeArmatureData(const char *id)
     {
         m_pArmarureDatas->removeObjectForKey(id);
     }
+    removeBakedAnimationData(id);
 }
 
 void CCArmatureDataManager::addAnimationData(const char *id, CCAnimationData *animationData, const char *configFilePath)
@@ -200,6 +215,7 @@ void CCArmatureDataManager::removeAnimationData(const char *id)
     {
         m_pAnimationDatas->removeObjectForKey(id);
     }
+    removeBakedAnimationData(id);
 }
 
 void CCArmatureDataManager::addTextureData(const char *id, CCTextureData *textureData, const char *configFilePath)
@@ -235,6 +251,32 @@ void CCArmatureDataManager::removeTextureData(const char *id)
     }
 }
 
+CCBakedAnimationData *CCArmatureDataManager::getBakedAnimationData(const char *id)
+{
+    CCBakedAnimationData *bakedData = NULL;
+    if (m_pBakedAnimationDatas)
+    {
+        bakedData = (CCBakedAnimationData *)m_pBakedAnimationDatas->objectForKey(id);
+        if (!bakedData)
+        {
+            bakedData = CCBakedAnimationData::create(id);
+            if (bakedData)
+            {
+                m_pBakedAnimationDatas->setObject(bakedData, id);
+            }
+        }
+    }
+    return bakedData;
+}
+
+void CCArmatureDataManager::removeBakedAnimationData(const char *id)
+{
+    if (m_pBakedAnimationDatas)
+    {
+        m_pBakedAnimationDatas->removeObjectForKey(id);
+    }
+}
+
 void CCArmatureDataManager::addArmatureFileInfo(const char *configFilePath, bool autoLoadSpriteFile)
 {
     addRelativeData(configFilePath);
@@ -269,6 +311,17 @@ void CCArmatureDataManager::addArmatureFileInfoAsync(const char *imagePath, cons
     CCDataReaderHelper::sharedDataReaderHelper()->addDataFromFileAsync(imagePath, plistPath, configFilePath, target, selector);
 }
 
+void CCArmatureDataManager::addArmatureFileInfoAsync(const std::vector<std::string> &configFilePaths, CCObject *target, SEL_CallFunc selector)
+{
+    for (std::vector<std::string>::const_iterator it = configFilePaths.begin(); it != configFilePaths.end(); ++it)
+    {
+        addRelativeData(it->c_str());
+    }
+
+    m_bAutoLoadSpriteFile = true;
+    CCDataReaderHelper::sharedDataReaderHelper()->addDataFromFilesAsync(configFilePaths, target, selector);
+}
+
 void CCArmatureDataManager::addSpriteFrameFromFile(const char *plistPath, const char *imagePath, const char *configFilePath)
 {
     if (CCRelativeData *data = getRelativeData(configFilePath))
@@ -31,6 +31,8 @@ THE SOFTWARE.
 
 NS_CC_EXT_BEGIN
 
+class CCBakedAnimationData;
+
 struct CCRelativeData
 {
     std::vector<std::string> plistFiles;
@@ -125,6 +127,19 @@ public:
      */
     void removeTextureData(const char *id);
 
+    /**
+     *	@brief	get baked poses of the armature, they are baked the first time they are asked for
+     *	@param 	id the id of the armature data and animation data
+     *  @return CCBakedAnimationData *, NULL if the armature can't be baked
+     */
+    CCBakedAnimationData *getBakedAnimationData(const char *id);
+
+    /**
+     *	@brief	remove baked poses, armatures playing them keep their reference
+     *	@param 	id the id of the baked data
+     */
+    void removeBakedAnimationData(const char *id);
+
     /**
      *	@brief	Add ArmatureFileInfo, it is managed by CCArmatureDataManager.
      */
@@ -147,6 +162,13 @@ public:
      */
     void addArmatureFileInfoAsync(const char *imagePath, const char *plistPath, const char *configFilePath, CCObject *target, SEL_SCHEDULE selector);
 
+    /**
+     *	@brief	Add a batch of ArmatureFileInfo, they are decoded on several threads while
+     *			textures of decoded files are loaded by CCTextureCache async.
+     *			selector is called once, when every file and its sprite frames are added.
+     */
+    void addArmatureFileInfoAsync(const std::vector<std::string> &configFilePaths, CCObject *target, SEL_CallFunc selector);
+
 
     virtual void removeArmatureFileInfo(const char *configFilePath);
 
@@ -192,6 +214,13 @@ private:
      */
     CCDictionary *m_pTextureDatas;
 
+    /**
+     *	@brief	save baked animation datas
+     *  @key	std::string
+     *  @value	CCBakedAnimationData *
+     */
+    CCDictionary *m_pBakedAnimationDatas;
+
     bool m_bAutoLoadSpriteFile;
 
     std::map<std::string, CCRelativeData> m_sRelativeDatas;
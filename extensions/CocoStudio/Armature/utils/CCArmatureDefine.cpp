@@ -23,6 +23,11 @@ THE SOFTWARE.
 ****************************************************************************/
 
 #include "CCArmatureDefine.h"
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32) || (CC_TARGET_PLATFORM == CC_PLATFORM_WINRT) || (CC_TARGET_PLATFORM == CC_PLATFORM_WP8)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
 
 NS_CC_EXT_BEGIN
 
@@ -31,4 +36,16 @@ const char *armatureVersion()
     return "1.1.0.0";
 }
 
+int armatureProcessorCount()
+{
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32) || (CC_TARGET_PLATFORM == CC_PLATFORM_WINRT) || (CC_TARGET_PLATFORM == CC_PLATFORM_WP8)
+    SYSTEM_INFO info;
+    GetNativeSystemInfo(&info);
+    return MAX((int)info.dwNumberOfProcessors, 1);
+#else
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    return processors > 1 ? (int)processors : 1;
+#endif
+}
+
 NS_CC_EXT_END
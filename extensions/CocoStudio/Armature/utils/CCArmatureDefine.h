@@ -67,6 +67,9 @@ NS_CC_EXT_BEGIN
 
 CC_DLL const char *armatureVersion();
 
+//! Number of online processors, used to size the armature worker threads
+CC_DLL int armatureProcessorCount();
+
 NS_CC_EXT_END
 
 #endif /*__CCARMATUREDEFINE_H__*/
@@ -0,0 +1,188 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __CCARMATUREFLATBINARY_H__
+#define __CCARMATUREFLATBINARY_H__
+
+#include "CCArmatureDefine.h"
+
+NS_CC_EXT_BEGIN
+
+/**
+ *  Layout of the flat binary armature format (.afb), written by tools/afb/armature2afb.py.
+ *
+ *  The file is a header followed by one table per record type. Every table is a contiguous
+ *  array of fixed size little endian records, so it is read in place from the loaded (or mapped)
+ *  buffer without any parsing. Records reference their children as a [first, first + count) range
+ *  in the child table, and strings as a byte offset in a table of '\0' terminated strings,
+ *  offset 0 is the empty string.
+ *
+ *  The loader still builds CCArmatureData, CCMovementData and one CCFrameData per frame from
+ *  the records, since animations consume those objects. Only the text parsing and copies of the
+ *  file are saved.
+ *
+ *  All version dependent fixes of the exporters (frame indices, rotation range, parent
+ *  transforms of the flash tool, content scale) are applied by the converter, records hold
+ *  the final values of CCDatas, only the position read scale is applied at load time.
+ */
+
+#define AFB_MAGIC   0x42464143      //! "CAFB"
+#define AFB_VERSION 1
+
+//! CCArmatureFlatHeader::flags
+#define AFB_SCALE_SKIN_POSITION     0x1     //! multiply skin positions by position read scale, ExportJson
+#define AFB_SCALE_FRAME_POSITION    0x2     //! multiply frame positions by position read scale, xml
+
+//! CCArmatureFlatNode::flags
+#define AFB_NODE_USE_COLOR          0x1
+
+//! CCArmatureFlatFrame::flags
+#define AFB_FRAME_TWEEN             0x1
+
+typedef struct _CCArmatureFlatTable
+{
+    unsigned int offset;            //! byte offset of the first record from the start of file
+    unsigned int count;
+} CCArmatureFlatTable;
+
+typedef struct _CCArmatureFlatHeader
+{
+    unsigned int magic;
+    int version;
+    unsigned int fileSize;
+    unsigned int flags;
+
+    CCArmatureFlatTable strings;    //! count is the table size in bytes
+    CCArmatureFlatTable armatures;
+    CCArmatureFlatTable bones;
+    CCArmatureFlatTable displays;
+    CCArmatureFlatTable animations;
+    CCArmatureFlatTable movements;
+    CCArmatureFlatTable movementBones;
+    CCArmatureFlatTable frames;
+    CCArmatureFlatTable easingParams; //! float
+    CCArmatureFlatTable textures;
+    CCArmatureFlatTable contours;
+    CCArmatureFlatTable vertices;
+    CCArmatureFlatTable configFiles; //! string offsets, sprite files without extension
+} CCArmatureFlatHeader;
+
+//! CCBaseData
+typedef struct _CCArmatureFlatNode
+{
+    float x, y;
+    float skewX, skewY;
+    float scaleX, scaleY;
+    float tweenRotate;
+    int zOrder;
+    unsigned char a, r, g, b;
+    unsigned int flags;
+} CCArmatureFlatNode;
+
+typedef struct _CCArmatureFlatArmature
+{
+    unsigned int name;
+    float dataVersion;
+    unsigned int firstBone, boneCount;
+} CCArmatureFlatArmature;
+
+typedef struct _CCArmatureFlatBone
+{
+    CCArmatureFlatNode node;
+    unsigned int name;
+    unsigned int parentName;
+    unsigned int firstDisplay, displayCount;
+} CCArmatureFlatBone;
+
+typedef struct _CCArmatureFlatDisplay
+{
+    int displayType;                //! DisplayType
+    unsigned int name;              //! particle plist is relative to the file
+    CCArmatureFlatNode skin;        //! CCSpriteDisplayData::skinData
+} CCArmatureFlatDisplay;
+
+typedef struct _CCArmatureFlatAnimation
+{
+    unsigned int name;
+    unsigned int firstMovement, movementCount;
+} CCArmatureFlatAnimation;
+
+typedef struct _CCArmatureFlatMovement
+{
+    unsigned int name;
+    int duration;
+    int durationTo;
+    int durationTween;
+    int tweenEasing;
+    float scale;
+    unsigned int loop;
+    unsigned int firstMovementBone, movementBoneCount;
+} CCArmatureFlatMovement;
+
+typedef struct _CCArmatureFlatMovementBone
+{
+    unsigned int name;
+    float delay;
+    float scale;
+    float duration;
+    unsigned int firstFrame, frameCount;
+} CCArmatureFlatMovementBone;
+
+typedef struct _CCArmatureFlatFrame
+{
+    CCArmatureFlatNode node;
+    int frameID;
+    int duration;
+    int tweenEasing;
+    int displayIndex;
+    unsigned int blendSrc, blendDst;
+    unsigned int flags;
+    unsigned int firstEasingParam, easingParamCount;
+    unsigned int event;
+    unsigned int movement;
+    unsigned int sound;
+    unsigned int soundEffect;
+} CCArmatureFlatFrame;
+
+typedef struct _CCArmatureFlatTexture
+{
+    unsigned int name;
+    float width, height;
+    float pivotX, pivotY;
+    unsigned int firstContour, contourCount;
+} CCArmatureFlatTexture;
+
+typedef struct _CCArmatureFlatContour
+{
+    unsigned int firstVertex, vertexCount;
+} CCArmatureFlatContour;
+
+typedef struct _CCArmatureFlatVertex
+{
+    float x, y;
+} CCArmatureFlatVertex;
+
+NS_CC_EXT_END
+
+#endif /*__CCARMATUREFLATBINARY_H__*/
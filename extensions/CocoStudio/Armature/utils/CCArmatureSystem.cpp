@@ -0,0 +1,300 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "CCArmatureSystem.h"
+#include "../CCArmature.h"
+#include "../animation/CCArmatureAnimation.h"
+
+
+NS_CC_EXT_BEGIN
+
+//! Runs after armatures' own update, which is scheduled with priority 0
+#define ARMATURE_SYSTEM_PRIORITY 1
+
+static CCArmatureSystem *s_sharedArmatureSystem = NULL;
+
+bool CCArmatureSystem::s_bEnabled = false;
+
+CCArmatureSystem *CCArmatureSystem::sharedArmatureSystem()
+{
+    if (s_sharedArmatureSystem == NULL)
+    {
+        s_sharedArmatureSystem = new CCArmatureSystem();
+    }
+    return s_sharedArmatureSystem;
+}
+
+void CCArmatureSystem::purge()
+{
+    if (s_sharedArmatureSystem)
+    {
+        s_sharedArmatureSystem->setEnabled(false);
+    }
+    CC_SAFE_RELEASE_NULL(s_sharedArmatureSystem);
+}
+
+bool CCArmatureSystem::isEnabled()
+{
+    return s_bEnabled;
+}
+
+CCArmatureSystem::CCArmatureSystem(void)
+    : m_iParallelThreshold(8)
+    , m_iThreadCount(0)
+    , m_uGeneration(0)
+    , m_uStartGeneration(0)
+    , m_iBusyWorkers(0)
+    , m_iNextIndex(0)
+    , m_bQuit(false)
+{
+    m_iThreadCount = armatureProcessorCount() - 1;
+
+    pthread_mutex_init(&m_sMutex, NULL);
+    pthread_cond_init(&m_sWorkCondition, NULL);
+    pthread_cond_init(&m_sDoneCondition, NULL);
+}
+
+CCArmatureSystem::~CCArmatureSystem(void)
+{
+    stopWorkers();
+
+    pthread_cond_destroy(&m_sDoneCondition);
+    pthread_cond_destroy(&m_sWorkCondition);
+    pthread_mutex_destroy(&m_sMutex);
+}
+
+void CCArmatureSystem::setEnabled(bool enabled)
+{
+    if (enabled == s_bEnabled)
+    {
+        return;
+    }
+
+    CCScheduler *scheduler = CCDirector::sharedDirector()->getScheduler();
+    if (enabled)
+    {
+        scheduler->scheduleUpdateForTarget(this, ARMATURE_SYSTEM_PRIORITY, false);
+    }
+    else
+    {
+        scheduler->unscheduleUpdateForTarget(this);
+        evaluateQueue();
+        stopWorkers();
+    }
+
+    s_bEnabled = enabled;
+}
+
+void CCArmatureSystem::setThreadCount(int count)
+{
+    count = MAX(count, 0);
+    if (count != m_iThreadCount)
+    {
+        stopWorkers();
+        m_iThreadCount = count;
+    }
+}
+
+int CCArmatureSystem::getThreadCount() const
+{
+    return m_iThreadCount;
+}
+
+void CCArmatureSystem::queueArmature(CCArmature *armature, float dt)
+{
+    //! An armature is evaluated once a frame, later calls add their delta
+    for (std::vector<QueuedArmature>::iterator it = m_sQueue.begin(); it != m_sQueue.end(); ++it)
+    {
+        if (it->armature == armature)
+        {
+            it->dt += dt;
+            return;
+        }
+    }
+
+    QueuedArmature queued = {armature, dt};
+    m_sQueue.push_back(queued);
+    armature->retain();
+}
+
+void CCArmatureSystem::update(float dt)
+{
+    evaluateQueue();
+}
+
+void CCArmatureSystem::evaluateQueue()
+{
+    CS_RETURN_IF(m_sQueue.empty());
+
+    //! Step 1, tweens change displays and zorders of bones, so they stay on the main thread
+    std::vector<QueuedArmature>::iterator it;
+    for (it = m_sQueue.begin(); it != m_sQueue.end(); ++it)
+    {
+        it->armature->getAnimation()->updateMovement(it->dt);
+    }
+
+    //! Step 2, bone world transforms only read and write bones of their own armature
+    if (m_iThreadCount > 0 && (int)m_sQueue.size() >= m_iParallelThreshold)
+    {
+        runWorkers();
+    }
+    else
+    {
+        m_iNextIndex = 0;
+        evaluateTransforms();
+    }
+
+    //! Step 3
+    for (it = m_sQueue.begin(); it != m_sQueue.end(); ++it)
+    {
+        it->armature->updateBoneDisplays(it->dt);
+    }
+
+    /*
+     *  Step 4, callbacks may play movements, remove armatures or queue armatures again,
+     *  so the queue is swapped out before events are dispatched.
+     */
+    std::vector<QueuedArmature> queue;
+    queue.swap(m_sQueue);
+    for (it = queue.begin(); it != queue.end(); ++it)
+    {
+        it->armature->getAnimation()->dispatchEvents();
+    }
+    for (it = queue.begin(); it != queue.end(); ++it)
+    {
+        it->armature->release();
+    }
+}
+
+void CCArmatureSystem::evaluateTransforms()
+{
+    int count = m_sQueue.size();
+    while (true)
+    {
+        int index = __sync_fetch_and_add(&m_iNextIndex, 1);
+        if (index >= count)
+        {
+            break;
+        }
+
+        CCArmature *armature = m_sQueue[index].armature;
+        if (!armature->getAnimation()->isBaked())
+        {
+            armature->updateBoneTransforms();
+        }
+    }
+}
+
+void CCArmatureSystem::runWorkers()
+{
+    if (m_sThreads.empty())
+    {
+        startWorkers();
+    }
+
+    m_iNextIndex = 0;
+
+    pthread_mutex_lock(&m_sMutex);
+    m_iBusyWorkers = m_sThreads.size();
+    m_uGeneration++;
+    pthread_cond_broadcast(&m_sWorkCondition);
+    pthread_mutex_unlock(&m_sMutex);
+
+    //! The main thread takes jobs too
+    evaluateTransforms();
+
+    pthread_mutex_lock(&m_sMutex);
+    while (m_iBusyWorkers > 0)
+    {
+        pthread_cond_wait(&m_sDoneCondition, &m_sMutex);
+    }
+    pthread_mutex_unlock(&m_sMutex);
+}
+
+void CCArmatureSystem::startWorkers()
+{
+    m_bQuit = false;
+    m_uStartGeneration = m_uGeneration;
+    for (int i = 0; i < m_iThreadCount; i++)
+    {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, workerMain, this) == 0)
+        {
+            m_sThreads.push_back(thread);
+        }
+    }
+}
+
+void CCArmatureSystem::stopWorkers()
+{
+    CS_RETURN_IF(m_sThreads.empty());
+
+    pthread_mutex_lock(&m_sMutex);
+    m_bQuit = true;
+    pthread_cond_broadcast(&m_sWorkCondition);
+    pthread_mutex_unlock(&m_sMutex);
+
+    for (std::vector<pthread_t>::iterator it = m_sThreads.begin(); it != m_sThreads.end(); ++it)
+    {
+        pthread_join(*it, NULL);
+    }
+    m_sThreads.clear();
+}
+
+void *CCArmatureSystem::workerMain(void *data)
+{
+    CCArmatureSystem *system = (CCArmatureSystem *)data;
+
+    //! Not m_uGeneration, the first batch may already be posted when the thread starts
+    unsigned int generation = system->m_uStartGeneration;
+
+    while (true)
+    {
+        pthread_mutex_lock(&system->m_sMutex);
+        while (!system->m_bQuit && generation == system->m_uGeneration)
+        {
+            pthread_cond_wait(&system->m_sWorkCondition, &system->m_sMutex);
+        }
+        if (system->m_bQuit)
+        {
+            pthread_mutex_unlock(&system->m_sMutex);
+            break;
+        }
+        generation = system->m_uGeneration;
+        pthread_mutex_unlock(&system->m_sMutex);
+
+        system->evaluateTransforms();
+
+        pthread_mutex_lock(&system->m_sMutex);
+        if (--system->m_iBusyWorkers == 0)
+        {
+            pthread_cond_signal(&system->m_sDoneCondition);
+        }
+        pthread_mutex_unlock(&system->m_sMutex);
+    }
+
+    return NULL;
+}
+
+NS_CC_EXT_END
@@ -0,0 +1,123 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __CCARMATURESYSTEM_H__
+#define __CCARMATURESYSTEM_H__
+
+#include "CCArmatureDefine.h"
+#include <pthread.h>
+
+NS_CC_EXT_BEGIN
+
+class CCArmature;
+
+/**
+ *	@brief	Updates all running armatures of a frame together.
+ *
+ *  When it is enabled, CCArmature::update only queues the armature. After the scheduler's update
+ *  pass, the system evaluates the queue in four steps:
+ *  1. tweens of every armature, on the main thread, because key frames change displays and zorders
+ *  2. bone world transforms, spread over worker threads, one armature per job
+ *  3. displays of every bone, on the main thread
+ *  4. frame and movement events, on the main thread, in the order armatures were queued
+ *
+ *  Only top level armatures are queued, child armatures are still updated by their parent bone.
+ *  Calls to CCArmature::update from your own code are queued too, use updateImmediately if the
+ *  pose is needed right away.
+ *  @js NA
+ *  @lua NA
+ */
+class CC_DLL CCArmatureSystem : public CCObject
+{
+public:
+    static CCArmatureSystem *sharedArmatureSystem();
+
+    static void purge();
+
+    //! Whether or not armatures are updated by the system, it doesn't create the system
+    static bool isEnabled();
+public:
+    ~CCArmatureSystem(void);
+
+    /**
+     * Enable or disable the system. Armatures queued in current frame are evaluated at once when it is disabled.
+     */
+    void setEnabled(bool enabled);
+
+    /**
+     * Number of worker threads, the main thread also evaluates armatures while they run.
+     * 0 evaluates everything on the main thread. Default is processor count - 1.
+     */
+    void setThreadCount(int count);
+    int getThreadCount() const;
+
+    /**
+     * Armatures are only spread over workers when at least this many are queued,
+     * small batches are cheaper on one thread. Default is 8.
+     */
+    CC_SYNTHESIZE(int, m_iParallelThreshold, ParallelThreshold);
+
+    //! Queue an armature for this frame, called by CCArmature::update
+    void queueArmature(CCArmature *armature, float dt);
+
+    virtual void update(float dt);
+
+private:
+    CCArmatureSystem(void);
+
+    void evaluateQueue();
+    void evaluateTransforms();
+    void runWorkers();
+    void startWorkers();
+    void stopWorkers();
+
+    static void *workerMain(void *data);
+
+private:
+    struct QueuedArmature
+    {
+        CCArmature *armature;
+        float dt;
+    };
+
+    static bool s_bEnabled;
+
+    std::vector<QueuedArmature> m_sQueue;
+
+    int m_iThreadCount;
+    std::vector<pthread_t> m_sThreads;
+
+    pthread_mutex_t m_sMutex;
+    pthread_cond_t m_sWorkCondition;            //! A new batch is ready
+    pthread_cond_t m_sDoneCondition;            //! All workers finished the batch
+    unsigned int m_uGeneration;                 //! Batch counter, workers wait until it changes
+    unsigned int m_uStartGeneration;            //! m_uGeneration when workers were started
+    int m_iBusyWorkers;
+    volatile int m_iNextIndex;                  //! Next queued armature to evaluate, taken atomically
+    bool m_bQuit;
+};
+
+NS_CC_EXT_END
+
+#endif /*__CCARMATURESYSTEM_H__*/
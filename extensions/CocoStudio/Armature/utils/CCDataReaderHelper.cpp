@@ -28,6 +28,7 @@ THE SOFTWARE.
 #include "CCTransformHelp.h"
 #include "CCUtilMath.h"
 #include "CCArmatureDefine.h"
+#include "CCArmatureFlatBinary.h"
 #include "cocoa/CCData.h"
 #include "../datas/CCDatas.h"
 #include <errno.h>
@@ -36,6 +37,7 @@ THE SOFTWARE.
 #include <cctype>
 #include <queue>
 #include <list>
+#include <map>
 #if (CC_TARGET_PLATFORM != CC_PLATFORM_WINRT) && (CC_TARGET_PLATFORM != CC_PLATFORM_WP8)
 #include <pthread.h>
 #else
@@ -157,15 +159,25 @@ enum ConfigType
 {
     DragonBone_XML,
     CocoStudio_JSON,
-	CocoStudio_Binary
+	CocoStudio_Binary,
+    CocoStudio_FlatBinary
 };
 
 
 //! Async load
 
+//! Files added by one addDataFromFilesAsync call
+typedef struct _AsyncBatch
+{
+    int            pendingFiles;
+    CCObject       *target;
+    SEL_CallFunc   selector;
+} AsyncBatch;
+
 typedef struct _AsyncStruct
 {
     std::string    filename;
+    std::string    fullPath;                //! resolved on main thread, path cache of CCFileUtils is not locked
     std::string    fileContent;
     ConfigType     configType;
     std::string    baseFilePath;
@@ -175,6 +187,9 @@ typedef struct _AsyncStruct
     
     std::string    imagePath;
     std::string    plistPath;
+
+    std::vector<AsyncBatch *> batches;      //! batches which wait for this file
+    int            pendingSpriteFiles;      //! textures still loading in CCTextureCache
 } AsyncStruct;
 
 typedef struct _DataInfo
@@ -189,9 +204,9 @@ typedef struct _DataInfo
 } DataInfo;
 
 
-static pthread_t s_loadingThread;
+static int s_nLoadingThreadCount = 0;
+static int s_nRunningLoadingThreads = 0;
 
-static pthread_mutex_t		s_SleepMutex;
 static pthread_cond_t		s_SleepCondition;
 
 static pthread_mutex_t      s_asyncStructQueueMutex;
@@ -205,6 +220,7 @@ static pthread_mutex_t      s_GetFileDataMutex;
 #ifdef EMSCRIPTEN
 // Hack to get ASM.JS validation (no undefined symbols allowed).
 #define pthread_cond_signal(_)
+#define pthread_cond_broadcast(_)
 #endif // EMSCRIPTEN
 
 static unsigned long s_nAsyncRefCount = 0;
@@ -215,19 +231,18 @@ static bool need_quit = false;
 static std::queue<AsyncStruct *> *s_pAsyncStructQueue = NULL;
 static std::queue<DataInfo *>   *s_pDataQueue = NULL;
 
+//! files queued but not finished yet, by file path. Only used in main thread
+static std::map<std::string, AsyncStruct *> s_loadingFiles;
+
 static void addData(AsyncStruct *pAsyncStruct)
 {
-    std::string fullPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(pAsyncStruct->filename.c_str());
     size_t size;
     pthread_mutex_lock(&s_GetFileDataMutex);
 	std::string readmode = "r";
 	bool isbinary = pAsyncStruct->configType == CocoStudio_Binary;
-	if(isbinary)
+	if(isbinary || pAsyncStruct->configType == CocoStudio_FlatBinary)
 		readmode += "b";
-	unsigned char *pBytes = CCFileUtils::sharedFileUtils()->getFileData(fullPath.c_str() , readmode.c_str(), &size);
-	CCData data(pBytes, size);
-    CC_SAFE_DELETE_ARRAY(pBytes);
-	pAsyncStruct->fileContent = std::string((const char*)data.getBytes(), data.getSize());
+	unsigned char *pBytes = CCFileUtils::sharedFileUtils()->getFileData(pAsyncStruct->fullPath.c_str() , readmode.c_str(), &size);
     pthread_mutex_unlock(&s_GetFileDataMutex);
 
     // generate data info
@@ -236,6 +251,24 @@ static void addData(AsyncStruct *pAsyncStruct)
     pDataInfo->filename = pAsyncStruct->filename;
     pDataInfo->baseFilePath = pAsyncStruct->baseFilePath;
 
+    if (pAsyncStruct->configType == CocoStudio_FlatBinary)
+    {
+        //! read in place, without the copies the text formats need
+        CCDataReaderHelper::addDataFromFlatBinaryCache((const char *)pBytes, size, pDataInfo);
+        CC_SAFE_DELETE_ARRAY(pBytes);
+
+        pthread_mutex_lock(&s_DataInfoMutex);
+        s_pDataQueue->push(pDataInfo);
+        pthread_mutex_unlock(&s_DataInfoMutex);
+        return;
+    }
+
+    pthread_mutex_lock(&s_GetFileDataMutex);
+	CCData data(pBytes, size);
+    CC_SAFE_DELETE_ARRAY(pBytes);
+	pAsyncStruct->fileContent = std::string((const char*)data.getBytes(), data.getSize());
+    pthread_mutex_unlock(&s_GetFileDataMutex);
+
     if (pAsyncStruct->configType == DragonBone_XML)
     {
         CCDataReaderHelper::addDataFromCache(pAsyncStruct->fileContent.c_str(), pDataInfo);
@@ -263,31 +296,31 @@ static void *loadData(void *)
         CCThread thread;
         thread.createAutoreleasePool();
 
-        std::queue<AsyncStruct *> *pQueue = s_pAsyncStructQueue;
-        pthread_mutex_lock(&s_asyncStructQueueMutex);// get async struct from queue
-        if (pQueue->empty())
+        //! all loading threads take files from the same queue, so files are decoded in parallel
+        pthread_mutex_lock(&s_asyncStructQueueMutex);
+        while (s_pAsyncStructQueue->empty() && !need_quit)
         {
-            pthread_mutex_unlock(&s_asyncStructQueueMutex);
-            if (need_quit)
-            {
-                break;
-            }
-            else
-            {
-                pthread_cond_wait(&s_SleepCondition, &s_SleepMutex);
-                continue;
-            }
+            pthread_cond_wait(&s_SleepCondition, &s_asyncStructQueueMutex);
         }
-        else
+        if (s_pAsyncStructQueue->empty())
         {
-            AsyncStruct *pAsyncStruct = pQueue->front();
-            pQueue->pop();
             pthread_mutex_unlock(&s_asyncStructQueueMutex);
-            addData(pAsyncStruct);
-       }
+            break;
+        }
+
+        AsyncStruct *pAsyncStruct = s_pAsyncStructQueue->front();
+        s_pAsyncStructQueue->pop();
+        pthread_mutex_unlock(&s_asyncStructQueueMutex);
+
+        addData(pAsyncStruct);
     }
 
-    if( s_pAsyncStructQueue != NULL )
+    //! the last thread to quit releases the queues
+    pthread_mutex_lock(&s_asyncStructQueueMutex);
+    bool last = --s_nRunningLoadingThreads == 0;
+    pthread_mutex_unlock(&s_asyncStructQueueMutex);
+
+    if( last && s_pAsyncStructQueue != NULL )
     {
         delete s_pAsyncStructQueue;
         s_pAsyncStructQueue = NULL;
@@ -296,7 +329,6 @@ static void *loadData(void *)
 
         pthread_mutex_destroy(&s_asyncStructQueueMutex);
         pthread_mutex_destroy(&s_DataInfoMutex);
-        pthread_mutex_destroy(&s_SleepMutex);
         pthread_mutex_destroy(&s_addDataMutex);
         pthread_mutex_destroy(&s_ReadFileMutex);
         pthread_mutex_destroy(&s_GetFileDataMutex);
@@ -306,6 +338,106 @@ static void *loadData(void *)
     return NULL;
 }
 
+static void finishAsyncStruct(AsyncStruct *pAsyncStruct);
+
+/**
+ *  A sprite file of an async loaded config file. Its texture is decoded by CCTextureCache's
+ *  loading thread while the data loading threads go on with the next config files, sprite frames
+ *  are added when the texture is ready.
+ */
+class CCAsyncSpriteFile : public CCObject
+{
+public:
+    CCAsyncSpriteFile(AsyncStruct *asyncStruct, const std::string &plistPath, const std::string &imagePath)
+        : m_pAsyncStruct(asyncStruct)
+        , m_strPlistPath(plistPath)
+        , m_strImagePath(imagePath)
+    {
+    }
+
+    void load()
+    {
+        m_pAsyncStruct->pendingSpriteFiles++;
+
+        //! CCTextureCache never calls back for a missing image, let the sprite frame cache report it
+        std::string fullPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(m_strImagePath.c_str());
+        if (!CCFileUtils::sharedFileUtils()->isFileExist(fullPath))
+        {
+            onTextureLoaded(NULL);
+            return;
+        }
+
+        CCTextureCache::sharedTextureCache()->addImageAsync(m_strImagePath.c_str(), this, callfuncO_selector(CCAsyncSpriteFile::onTextureLoaded));
+    }
+
+    void onTextureLoaded(CCObject *texture)
+    {
+        pthread_mutex_lock(&s_GetFileDataMutex);
+        CCArmatureDataManager::sharedArmatureDataManager()->addSpriteFrameFromFile(m_strPlistPath.c_str(), m_strImagePath.c_str());
+        pthread_mutex_unlock(&s_GetFileDataMutex);
+
+        if (--m_pAsyncStruct->pendingSpriteFiles == 0)
+        {
+            finishAsyncStruct(m_pAsyncStruct);
+        }
+    }
+
+private:
+    AsyncStruct *m_pAsyncStruct;
+    std::string m_strPlistPath;
+    std::string m_strImagePath;
+};
+
+static void loadSpriteFileAsync(AsyncStruct *pAsyncStruct, const std::string &plistPath, const std::string &imagePath)
+{
+    CCAsyncSpriteFile *spriteFile = new CCAsyncSpriteFile(pAsyncStruct, plistPath, imagePath);
+    spriteFile->load();
+    spriteFile->release();
+}
+
+static void finishAsyncStruct(AsyncStruct *pAsyncStruct)
+{
+    CCObject *target = pAsyncStruct->target;
+    SEL_SCHEDULE selector = pAsyncStruct->selector;
+
+    --s_nAsyncRefCount;
+
+    if (target && selector)
+    {
+        (target->*selector)((s_nAsyncRefTotalCount - s_nAsyncRefCount) / (float)s_nAsyncRefTotalCount);
+    }
+    CC_SAFE_RELEASE(target);
+
+    //! file may be queued again after purge, keep the new one
+    std::map<std::string, AsyncStruct *>::iterator loading = s_loadingFiles.find(pAsyncStruct->filename);
+    if (loading != s_loadingFiles.end() && loading->second == pAsyncStruct)
+    {
+        s_loadingFiles.erase(loading);
+    }
+
+    for (std::vector<AsyncBatch *>::iterator it = pAsyncStruct->batches.begin(); it != pAsyncStruct->batches.end(); ++it)
+    {
+        AsyncBatch *batch = *it;
+        if (--batch->pendingFiles == 0)
+        {
+            if (batch->target && batch->selector)
+            {
+                (batch->target->*batch->selector)();
+            }
+            CC_SAFE_RELEASE(batch->target);
+            delete batch;
+        }
+    }
+
+    delete pAsyncStruct;
+
+    if (0 == s_nAsyncRefCount)
+    {
+        s_nAsyncRefTotalCount = 0;
+        CCDirector::sharedDirector()->getScheduler()->unscheduleSelector(schedule_selector(CCDataReaderHelper::addDataAsyncCallBack), CCDataReaderHelper::sharedDataReaderHelper());
+    }
+}
+
 
 CCDataReaderHelper *CCDataReaderHelper::sharedDataReaderHelper()
 {
@@ -335,10 +467,30 @@ void CCDataReaderHelper::purge()
 }
 
 
+void CCDataReaderHelper::setLoadingThreadCount(int count)
+{
+    s_nLoadingThreadCount = MAX(count, 0);
+}
+
+int CCDataReaderHelper::getLoadingThreadCount()
+{
+    if (s_nLoadingThreadCount > 0)
+    {
+        return s_nLoadingThreadCount;
+    }
+
+    return MAX(armatureProcessorCount() - 1, 1);
+}
+
 CCDataReaderHelper::~CCDataReaderHelper()
 {
-    need_quit = true;
-    pthread_cond_signal(&s_SleepCondition);
+    if (s_pAsyncStructQueue)
+    {
+        pthread_mutex_lock(&s_asyncStructQueueMutex);
+        need_quit = true;
+        pthread_cond_broadcast(&s_SleepCondition);
+        pthread_mutex_unlock(&s_asyncStructQueueMutex);
+    }
 }
 
 void CCDataReaderHelper::addDataFromFile(const char *filePath)
@@ -376,7 +528,7 @@ void CCDataReaderHelper::addDataFromFile(const char *filePath)
     size_t size;
     std::string fullPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(filePath);
     unsigned char *pBytes = NULL;
-    if ( 0 == str.compare(".csb"))
+    if ( 0 == str.compare(".csb") || 0 == str.compare(".afb"))
 	{
 		pBytes = CCFileUtils::sharedFileUtils()->getFileData(fullPath.c_str() , "rb", &size);
 		
@@ -392,6 +544,14 @@ void CCDataReaderHelper::addDataFromFile(const char *filePath)
     dataInfo.asyncStruct = NULL;
     dataInfo.baseFilePath = basefilePath;
 
+    if (str.compare(".afb") == 0)
+    {
+        //! records are read in place from the file buffer
+        CCDataReaderHelper::addDataFromFlatBinaryCache((const char *)pBytes, size, &dataInfo);
+        CC_SAFE_DELETE_ARRAY(pBytes);
+        return;
+    }
+
 	std::string load_str = std::string((const char*)pBytes, size);
     if (str.compare(".xml") == 0)
     {
@@ -409,10 +569,44 @@ void CCDataReaderHelper::addDataFromFile(const char *filePath)
 }
 
 void CCDataReaderHelper::addDataFromFileAsync(const char *imagePath, const char *plistPath, const char *filePath, CCObject *target, SEL_SCHEDULE selector)
+{
+    addDataFromFileAsync(imagePath, plistPath, filePath, target, selector, NULL);
+}
+
+void CCDataReaderHelper::addDataFromFilesAsync(const std::vector<std::string> &filePaths, CCObject *target, SEL_CallFunc selector)
+{
+    AsyncBatch *batch = new AsyncBatch();
+    batch->target = target;
+    batch->selector = selector;
+    CC_SAFE_RETAIN(target);
+
+    //! held until every file is queued, files which are already loaded are not waited for
+    batch->pendingFiles = 1;
+
+    for (std::vector<std::string>::const_iterator it = filePaths.begin(); it != filePaths.end(); ++it)
+    {
+        if (addDataFromFileAsync("", "", it->c_str(), NULL, NULL, batch))
+        {
+            batch->pendingFiles++;
+        }
+    }
+
+    if (--batch->pendingFiles == 0)
+    {
+        if (target && selector)
+        {
+            (target->*selector)();
+        }
+        CC_SAFE_RELEASE(target);
+        delete batch;
+    }
+}
+
+bool CCDataReaderHelper::addDataFromFileAsync(const char *imagePath, const char *plistPath, const char *filePath, CCObject *target, SEL_SCHEDULE selector, AsyncBatch *batch)
 {
 #ifdef EMSCRIPTEN
     CCLOGWARN("Cannot load data %s asynchronously in Emscripten builds.", filePath);
-    return;
+    return false;
 #endif // EMSCRIPTEN
 
     /*
@@ -422,6 +616,14 @@ void CCDataReaderHelper::addDataFromFileAsync(const char *imagePath, const char
     {
         if (s_arrConfigFileList[i].compare(filePath) == 0)
         {
+            //! still loading for an earlier call, batch waits for it too
+            std::map<std::string, AsyncStruct *>::iterator loading = s_loadingFiles.find(filePath);
+            if (batch && loading != s_loadingFiles.end())
+            {
+                loading->second->batches.push_back(batch);
+                return true;
+            }
+
             if (target && selector)
             {
                 if (s_nAsyncRefTotalCount == 0 && s_nAsyncRefCount == 0)
@@ -433,7 +635,7 @@ void CCDataReaderHelper::addDataFromFileAsync(const char *imagePath, const char
                     (target->*selector)((s_nAsyncRefTotalCount - s_nAsyncRefCount) / (float)s_nAsyncRefTotalCount);
                 }
             }
-            return;
+            return false;
         }
     }
     s_arrConfigFileList.push_back(filePath);
@@ -459,15 +661,31 @@ void CCDataReaderHelper::addDataFromFileAsync(const char *imagePath, const char
 
         pthread_mutex_init(&s_asyncStructQueueMutex, NULL);
         pthread_mutex_init(&s_DataInfoMutex, NULL);
-        pthread_mutex_init(&s_SleepMutex, NULL);
         pthread_mutex_init(&s_addDataMutex, NULL);
         pthread_mutex_init(&s_ReadFileMutex, NULL);
         pthread_mutex_init(&s_GetFileDataMutex, NULL);
         pthread_cond_init(&s_SleepCondition, NULL);
+        need_quit = false;
+
+        //! create shared helpers before the loading threads use them
+        DICTOOL;
+
  #if (CC_TARGET_PLATFORM != CC_PLATFORM_WINRT) && (CC_TARGET_PLATFORM != CC_PLATFORM_WP8)
-        pthread_create(&s_loadingThread, NULL, loadData, NULL);
+        s_nRunningLoadingThreads = 0;
+
+        int threadCount = getLoadingThreadCount();
+        for (int i = 0; i < threadCount; i++)
+        {
+            pthread_t thread;
+            pthread_mutex_lock(&s_asyncStructQueueMutex);
+            if (pthread_create(&thread, NULL, loadData, NULL) == 0)
+            {
+                pthread_detach(thread);
+                s_nRunningLoadingThreads++;
+            }
+            pthread_mutex_unlock(&s_asyncStructQueueMutex);
+        }
 #endif
-        need_quit = false;
     }
 
     if (0 == s_nAsyncRefCount)
@@ -486,6 +704,7 @@ void CCDataReaderHelper::addDataFromFileAsync(const char *imagePath, const char
     // generate async struct
     AsyncStruct *data = new AsyncStruct();
     data->filename = filePath;
+    data->fullPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(filePath);
     data->baseFilePath = basefilePath;
     data->target = target;
     data->selector = selector;
@@ -494,6 +713,13 @@ void CCDataReaderHelper::addDataFromFileAsync(const char *imagePath, const char
     data->imagePath = imagePath;
     data->plistPath = plistPath;
 
+    if (batch)
+    {
+        data->batches.push_back(batch);
+    }
+    data->pendingSpriteFiles = 0;
+    s_loadingFiles[filePath] = data;
+
     std::string filePathStr =  filePath;
     size_t startPos = filePathStr.find_last_of(".");
     std::string str = &filePathStr[startPos];
@@ -510,79 +736,73 @@ void CCDataReaderHelper::addDataFromFileAsync(const char *imagePath, const char
 	{
 		data->configType = CocoStudio_Binary;
 	}
+    else if (str.compare(".afb") == 0)
+    {
+        data->configType = CocoStudio_FlatBinary;
+    }
 
 #if (CC_TARGET_PLATFORM != CC_PLATFORM_WINRT) && (CC_TARGET_PLATFORM != CC_PLATFORM_WP8)
     // add async struct into queue
     pthread_mutex_lock(&s_asyncStructQueueMutex);
     s_pAsyncStructQueue->push(data);
-    pthread_mutex_unlock(&s_asyncStructQueueMutex);
-
     pthread_cond_signal(&s_SleepCondition);
+    pthread_mutex_unlock(&s_asyncStructQueueMutex);
 #else
     // WinRT uses an Async Task to load the image since the ThreadPool has a limited number of threads
     create_task([this, data] {
         addData(data);
     });
 #endif
+
+    return true;
 }
 
 
 
 void CCDataReaderHelper::addDataAsyncCallBack(float dt)
 {
-    // the data is generated in loading thread
+    // the data is generated in loading threads
     std::queue<DataInfo *> *dataQueue = s_pDataQueue;
 
-    pthread_mutex_lock(&s_DataInfoMutex);
-    if (dataQueue->empty())
-    {
-        pthread_mutex_unlock(&s_DataInfoMutex);
-    }
-    else
+    //! take every file decoded since last frame, their textures are loaded together
+    while (dataQueue)
     {
+        pthread_mutex_lock(&s_DataInfoMutex);
+        if (dataQueue->empty())
+        {
+            pthread_mutex_unlock(&s_DataInfoMutex);
+            break;
+        }
+
         DataInfo *pDataInfo = dataQueue->front();
         dataQueue->pop();
         pthread_mutex_unlock(&s_DataInfoMutex);
 
         AsyncStruct *pAsyncStruct = pDataInfo->asyncStruct;
 
+        //! held while sprite files are added, a cached texture calls back at once
+        pAsyncStruct->pendingSpriteFiles++;
+
         if (pAsyncStruct->imagePath != "" && pAsyncStruct->plistPath != "")
         {
-            pthread_mutex_lock(&s_GetFileDataMutex);
-            CCArmatureDataManager::sharedArmatureDataManager()->addSpriteFrameFromFile(pAsyncStruct->plistPath.c_str(), pAsyncStruct->imagePath.c_str());
-            pthread_mutex_unlock(&s_GetFileDataMutex);
+            loadSpriteFileAsync(pAsyncStruct, pAsyncStruct->plistPath, pAsyncStruct->imagePath);
         }
 
         while (!pDataInfo->configFileQueue.empty())
         {
             std::string configPath = pDataInfo->configFileQueue.front();
-            pthread_mutex_lock(&s_GetFileDataMutex);
-            CCArmatureDataManager::sharedArmatureDataManager()->addSpriteFrameFromFile((pAsyncStruct->baseFilePath + configPath + ".plist").c_str(), (pAsyncStruct->baseFilePath + configPath + ".png").c_str());
-            pthread_mutex_unlock(&s_GetFileDataMutex);
+            loadSpriteFileAsync(pAsyncStruct, pAsyncStruct->baseFilePath + configPath + ".plist", pAsyncStruct->baseFilePath + configPath + ".png");
             pDataInfo->configFileQueue.pop();
         }
 
-
-        CCObject *target = pAsyncStruct->target;
-        SEL_SCHEDULE selector = pAsyncStruct->selector;
-
-        --s_nAsyncRefCount;
-
-        if (target && selector)
-        {
-            (target->*selector)((s_nAsyncRefTotalCount - s_nAsyncRefCount) / (float)s_nAsyncRefTotalCount);
-            CC_SAFE_RELEASE(target);
-        }
-
-
-        delete pAsyncStruct;
         delete pDataInfo;
 
-        if (0 == s_nAsyncRefCount)
+        if (--pAsyncStruct->pendingSpriteFiles == 0)
         {
-            s_nAsyncRefTotalCount = 0;
-            CCDirector::sharedDirector()->getScheduler()->unscheduleSelector(schedule_selector(CCDataReaderHelper::addDataAsyncCallBack), this);
+            finishAsyncStruct(pAsyncStruct);
         }
+
+        dataQueue = s_pDataQueue;
     }
 }
 
@@ -805,7 +1025,16 @@ CCAnimationData *CCDataReaderHelper::decodeAnimation(tinyxml2::XMLElement *anima
 
     const char	*name = animationXML->Attribute(A_NAME);
 
+    //! other loading threads may add datas at the same time
+    if (dataInfo->asyncStruct)
+    {
+        pthread_mutex_lock(&s_addDataMutex);
+    }
     CCArmatureData *armatureData = CCArmatureDataManager::sharedArmatureDataManager()->getArmatureData(name);
+    if (dataInfo->asyncStruct)
+    {
+        pthread_mutex_unlock(&s_addDataMutex);
+    }
 
     aniData->name = name;
 
@@ -2641,4 +2870,485 @@ void CCDataReaderHelper::decodeNode(CCBaseData *node, CocoLoader *pCocoLoader, s
 	}
 }
 
+
+//! Flat binary
+
+typedef struct _FlatFile
+{
+    const char *base;
+    const CCArmatureFlatHeader *header;
+    float positionScale;
+
+    template <typename T>
+    const T *table(const CCArmatureFlatTable &table) const
+    {
+        return (const T *)(base + table.offset);
+    }
+
+    const char *string(unsigned int offset) const
+    {
+        return base + header->strings.offset + offset;
+    }
+} FlatFile;
+
+static bool checkFlatTable(const CCArmatureFlatTable &table, size_t recordSize, unsigned long size)
+{
+    //! records are read in place, so tables must be aligned
+    if (table.offset % 4 != 0 || table.offset > size)
+    {
+        return false;
+    }
+    return table.count <= (size - table.offset) / recordSize;
+}
+
+static bool checkFlatRange(unsigned int first, unsigned int count, const CCArmatureFlatTable &table)
+{
+    return first <= table.count && count <= table.count - first;
+}
+
+static bool checkFlatFile(const char *fileContent, unsigned long size)
+{
+    if (size < sizeof(CCArmatureFlatHeader) || ((size_t)fileContent) % 4 != 0)
+    {
+        return false;
+    }
+
+    const CCArmatureFlatHeader *header = (const CCArmatureFlatHeader *)fileContent;
+    if (header->magic != AFB_MAGIC || header->version != AFB_VERSION || header->fileSize != size)
+    {
+        return false;
+    }
+
+    bool valid = checkFlatTable(header->strings, 1, size)
+        && checkFlatTable(header->armatures, sizeof(CCArmatureFlatArmature), size)
+        && checkFlatTable(header->bones, sizeof(CCArmatureFlatBone), size)
+        && checkFlatTable(header->displays, sizeof(CCArmatureFlatDisplay), size)
+        && checkFlatTable(header->animations, sizeof(CCArmatureFlatAnimation), size)
+        && checkFlatTable(header->movements, sizeof(CCArmatureFlatMovement), size)
+        && checkFlatTable(header->movementBones, sizeof(CCArmatureFlatMovementBone), size)
+        && checkFlatTable(header->frames, sizeof(CCArmatureFlatFrame), size)
+        && checkFlatTable(header->easingParams, sizeof(float), size)
+        && checkFlatTable(header->textures, sizeof(CCArmatureFlatTexture), size)
+        && checkFlatTable(header->contours, sizeof(CCArmatureFlatContour), size)
+        && checkFlatTable(header->vertices, sizeof(CCArmatureFlatVertex), size)
+        && checkFlatTable(header->configFiles, sizeof(unsigned int), size);
+
+    //! every string offset is below the table size, so a terminated table keeps reads inside the file
+    valid = valid && header->strings.count > 0 && fileContent[header->strings.offset + header->strings.count - 1] == '\0';
+
+    return valid;
+}
+
+static void decodeFlatNode(CCBaseData *node, const CCArmatureFlatNode &flatNode)
+{
+    node->x = flatNode.x;
+    node->y = flatNode.y;
+    node->skewX = flatNode.skewX;
+    node->skewY = flatNode.skewY;
+    node->scaleX = flatNode.scaleX;
+    node->scaleY = flatNode.scaleY;
+    node->tweenRotate = flatNode.tweenRotate;
+    node->zOrder = flatNode.zOrder;
+    node->a = flatNode.a;
+    node->r = flatNode.r;
+    node->g = flatNode.g;
+    node->b = flatNode.b;
+    node->isUseColorInfo = (flatNode.flags & AFB_NODE_USE_COLOR) != 0;
+}
+
+static bool checkFlatRecords(const FlatFile &file)
+{
+    const CCArmatureFlatHeader *header = file.header;
+    unsigned int limit = header->strings.count;
+
+    const CCArmatureFlatArmature *armatures = file.table<CCArmatureFlatArmature>(header->armatures);
+    for (unsigned int i = 0; i < header->armatures.count; i++)
+    {
+        if (armatures[i].name >= limit || !checkFlatRange(armatures[i].firstBone, armatures[i].boneCount, header->bones))
+        {
+            return false;
+        }
+    }
+
+    const CCArmatureFlatBone *bones = file.table<CCArmatureFlatBone>(header->bones);
+    for (unsigned int i = 0; i < header->bones.count; i++)
+    {
+        const CCArmatureFlatBone &bone = bones[i];
+        if (bone.name >= limit || bone.parentName >= limit || !checkFlatRange(bone.firstDisplay, bone.displayCount, header->displays))
+        {
+            return false;
+        }
+    }
+
+    const CCArmatureFlatDisplay *displays = file.table<CCArmatureFlatDisplay>(header->displays);
+    for (unsigned int i = 0; i < header->displays.count; i++)
+    {
+        if (displays[i].name >= limit || displays[i].displayType < CS_DISPLAY_SPRITE || displays[i].displayType >= CS_DISPLAY_MAX)
+        {
+            return false;
+        }
+    }
+
+    const CCArmatureFlatAnimation *animations = file.table<CCArmatureFlatAnimation>(header->animations);
+    for (unsigned int i = 0; i < header->animations.count; i++)
+    {
+        if (animations[i].name >= limit || !checkFlatRange(animations[i].firstMovement, animations[i].movementCount, header->movements))
+        {
+            return false;
+        }
+    }
+
+    const CCArmatureFlatMovement *movements = file.table<CCArmatureFlatMovement>(header->movements);
+    for (unsigned int i = 0; i < header->movements.count; i++)
+    {
+        const CCArmatureFlatMovement &movement = movements[i];
+        if (movement.name >= limit || !checkFlatRange(movement.firstMovementBone, movement.movementBoneCount, header->movementBones))
+        {
+            return false;
+        }
+    }
+
+    const CCArmatureFlatMovementBone *movementBones = file.table<CCArmatureFlatMovementBone>(header->movementBones);
+    for (unsigned int i = 0; i < header->movementBones.count; i++)
+    {
+        const CCArmatureFlatMovementBone &movementBone = movementBones[i];
+        if (movementBone.name >= limit || !checkFlatRange(movementBone.firstFrame, movementBone.frameCount, header->frames))
+        {
+            return false;
+        }
+    }
+
+    const CCArmatureFlatFrame *frames = file.table<CCArmatureFlatFrame>(header->frames);
+    for (unsigned int i = 0; i < header->frames.count; i++)
+    {
+        const CCArmatureFlatFrame &frame = frames[i];
+        if (frame.event >= limit || frame.movement >= limit || frame.sound >= limit || frame.soundEffect >= limit)
+        {
+            return false;
+        }
+        if (!checkFlatRange(frame.firstEasingParam, frame.easingParamCount, header->easingParams))
+        {
+            return false;
+        }
+    }
+
+    const CCArmatureFlatTexture *textures = file.table<CCArmatureFlatTexture>(header->textures);
+    for (unsigned int i = 0; i < header->textures.count; i++)
+    {
+        if (textures[i].name >= limit || !checkFlatRange(textures[i].firstContour, textures[i].contourCount, header->contours))
+        {
+            return false;
+        }
+    }
+
+    const CCArmatureFlatContour *contours = file.table<CCArmatureFlatContour>(header->contours);
+    for (unsigned int i = 0; i < header->contours.count; i++)
+    {
+        if (!checkFlatRange(contours[i].firstVertex, contours[i].vertexCount, header->vertices))
+        {
+            return false;
+        }
+    }
+
+    const unsigned int *configFiles = file.table<unsigned int>(header->configFiles);
+    for (unsigned int i = 0; i < header->configFiles.count; i++)
+    {
+        if (configFiles[i] >= limit)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static CCArmatureData *decodeFlatArmature(const FlatFile &file, const CCArmatureFlatArmature &flatArmature, DataInfo *dataInfo)
+{
+    CCArmatureData *armatureData = new CCArmatureData();
+    armatureData->init();
+
+    armatureData->name = file.string(flatArmature.name);
+    dataInfo->cocoStudioVersion = armatureData->dataVersion = flatArmature.dataVersion;
+
+    const CCArmatureFlatBone *bones = file.table<CCArmatureFlatBone>(file.header->bones) + flatArmature.firstBone;
+    const CCArmatureFlatDisplay *displays = file.table<CCArmatureFlatDisplay>(file.header->displays);
+
+    for (unsigned int i = 0; i < flatArmature.boneCount; i++)
+    {
+        const CCArmatureFlatBone &flatBone = bones[i];
+
+        CCBoneData *boneData = new CCBoneData();
+        boneData->init();
+
+        decodeFlatNode(boneData, flatBone.node);
+        if (file.header->flags & AFB_SCALE_FRAME_POSITION)
+        {
+            boneData->x *= file.positionScale;
+            boneData->y *= file.positionScale;
+        }
+        boneData->name = file.string(flatBone.name);
+        boneData->parentName = file.string(flatBone.parentName);
+
+        for (unsigned int j = 0; j < flatBone.displayCount; j++)
+        {
+            const CCArmatureFlatDisplay &flatDisplay = displays[flatBone.firstDisplay + j];
+
+            CCDisplayData *displayData = NULL;
+            switch (flatDisplay.displayType)
+            {
+            case CS_DISPLAY_ARMATURE:
+                displayData = new CCArmatureDisplayData();
+                displayData->displayName = file.string(flatDisplay.name);
+                break;
+            case CS_DISPLAY_PARTICLE:
+                displayData = new CCParticleDisplayData();
+                displayData->displayName = dataInfo->baseFilePath + file.string(flatDisplay.name);
+                break;
+            default:    //! CS_DISPLAY_SPRITE, type is checked with the records
+            {
+                CCSpriteDisplayData *spriteDisplayData = new CCSpriteDisplayData();
+                spriteDisplayData->displayName = file.string(flatDisplay.name);
+
+                decodeFlatNode(&spriteDisplayData->skinData, flatDisplay.skin);
+                if (file.header->flags & AFB_SCALE_SKIN_POSITION)
+                {
+                    spriteDisplayData->skinData.x *= file.positionScale;
+                    spriteDisplayData->skinData.y *= file.positionScale;
+                }
+                displayData = spriteDisplayData;
+            }
+            break;
+            }
+            displayData->displayType = (DisplayType)flatDisplay.displayType;
+
+            boneData->addDisplayData(displayData);
+            CC_SAFE_RELEASE(displayData);
+        }
+
+        armatureData->addBoneData(boneData);
+        CC_SAFE_RELEASE(boneData);
+    }
+
+    return armatureData;
+}
+
+static CCFrameData *decodeFlatFrame(const FlatFile &file, const CCArmatureFlatFrame &flatFrame)
+{
+    CCFrameData *frameData = new CCFrameData();
+
+    decodeFlatNode(frameData, flatFrame.node);
+    if (file.header->flags & AFB_SCALE_FRAME_POSITION)
+    {
+        frameData->x *= file.positionScale;
+        frameData->y *= file.positionScale;
+    }
+
+    frameData->frameID = flatFrame.frameID;
+    frameData->duration = flatFrame.duration;
+    frameData->tweenEasing = (CCTweenType)flatFrame.tweenEasing;
+    frameData->displayIndex = flatFrame.displayIndex;
+    frameData->blendFunc.src = (GLenum)flatFrame.blendSrc;
+    frameData->blendFunc.dst = (GLenum)flatFrame.blendDst;
+    frameData->isTween = (flatFrame.flags & AFB_FRAME_TWEEN) != 0;
+
+    if (flatFrame.easingParamCount > 0)
+    {
+        const float *easingParams = file.table<float>(file.header->easingParams) + flatFrame.firstEasingParam;
+        frameData->easingParamNumber = flatFrame.easingParamCount;
+        frameData->easingParams = new float[flatFrame.easingParamCount];
+        memcpy(frameData->easingParams, easingParams, sizeof(float) * flatFrame.easingParamCount);
+    }
+
+    frameData->strEvent = file.string(flatFrame.event);
+    frameData->strMovement = file.string(flatFrame.movement);
+    frameData->strSound = file.string(flatFrame.sound);
+    frameData->strSoundEffect = file.string(flatFrame.soundEffect);
+
+    return frameData;
+}
+
+static CCAnimationData *decodeFlatAnimation(const FlatFile &file, const CCArmatureFlatAnimation &flatAnimation)
+{
+    CCAnimationData *aniData = new CCAnimationData();
+    aniData->name = file.string(flatAnimation.name);
+
+    const CCArmatureFlatMovement *movements = file.table<CCArmatureFlatMovement>(file.header->movements) + flatAnimation.firstMovement;
+    const CCArmatureFlatMovementBone *movementBones = file.table<CCArmatureFlatMovementBone>(file.header->movementBones);
+    const CCArmatureFlatFrame *frames = file.table<CCArmatureFlatFrame>(file.header->frames);
+
+    for (unsigned int i = 0; i < flatAnimation.movementCount; i++)
+    {
+        const CCArmatureFlatMovement &flatMovement = movements[i];
+
+        CCMovementData *movementData = new CCMovementData();
+        movementData->name = file.string(flatMovement.name);
+        movementData->duration = flatMovement.duration;
+        movementData->durationTo = flatMovement.durationTo;
+        movementData->durationTween = flatMovement.durationTween;
+        movementData->tweenEasing = (CCTweenType)flatMovement.tweenEasing;
+        movementData->scale = flatMovement.scale;
+        movementData->loop = flatMovement.loop != 0;
+
+        for (unsigned int j = 0; j < flatMovement.movementBoneCount; j++)
+        {
+            const CCArmatureFlatMovementBone &flatMovementBone = movementBones[flatMovement.firstMovementBone + j];
+
+            //! frames of a bone are contiguous, so the frame list is allocated once. CCTween consumes
+            //! CCFrameData objects, so frames are still copied out of the track, one object each
+            CCMovementBoneData *movementBoneData = new CCMovementBoneData();
+            movementBoneData->frameList.initWithCapacity(MAX(flatMovementBone.frameCount, 1));
+            movementBoneData->name = file.string(flatMovementBone.name);
+            movementBoneData->delay = flatMovementBone.delay;
+            movementBoneData->scale = flatMovementBone.scale;
+            movementBoneData->duration = flatMovementBone.duration;
+
+            for (unsigned int k = 0; k < flatMovementBone.frameCount; k++)
+            {
+                CCFrameData *frameData = decodeFlatFrame(file, frames[flatMovementBone.firstFrame + k]);
+                movementBoneData->addFrameData(frameData);
+                CC_SAFE_RELEASE(frameData);
+            }
+
+            movementData->addMovementBoneData(movementBoneData);
+            CC_SAFE_RELEASE(movementBoneData);
+        }
+
+        aniData->addMovement(movementData);
+        CC_SAFE_RELEASE(movementData);
+    }
+
+    return aniData;
+}
+
+static CCTextureData *decodeFlatTexture(const FlatFile &file, const CCArmatureFlatTexture &flatTexture)
+{
+    CCTextureData *textureData = new CCTextureData();
+    textureData->init();
+
+    textureData->name = file.string(flatTexture.name);
+    textureData->width = flatTexture.width;
+    textureData->height = flatTexture.height;
+    textureData->pivotX = flatTexture.pivotX;
+    textureData->pivotY = flatTexture.pivotY;
+
+    const CCArmatureFlatContour *contours = file.table<CCArmatureFlatContour>(file.header->contours) + flatTexture.firstContour;
+    const CCArmatureFlatVertex *vertices = file.table<CCArmatureFlatVertex>(file.header->vertices);
+
+    for (unsigned int i = 0; i < flatTexture.contourCount; i++)
+    {
+        CCContourData *contourData = new CCContourData();
+        contourData->init();
+
+        for (unsigned int j = 0; j < contours[i].vertexCount; j++)
+        {
+            const CCArmatureFlatVertex &flatVertex = vertices[contours[i].firstVertex + j];
+            CCContourVertex2 *vertex = new CCContourVertex2(flatVertex.x, flatVertex.y);
+            contourData->vertexList.addObject(vertex);
+            CC_SAFE_RELEASE(vertex);
+        }
+
+        textureData->addContourData(contourData);
+        CC_SAFE_RELEASE(contourData);
+    }
+
+    return textureData;
+}
+
+void CCDataReaderHelper::addDataFromFlatBinaryCache(const char *fileContent, unsigned long size, DataInfo *dataInfo)
+{
+    if (!fileContent || !checkFlatFile(fileContent, size))
+    {
+        CCLOG("%s is not a valid flat binary armature file", dataInfo->filename.c_str());
+        return;
+    }
+
+    FlatFile file;
+    file.base = fileContent;
+    file.header = (const CCArmatureFlatHeader *)fileContent;
+    file.positionScale = s_PositionReadScale;
+
+    if (!checkFlatRecords(file))
+    {
+        CCLOG("%s has records out of range", dataInfo->filename.c_str());
+        return;
+    }
+
+    const CCArmatureFlatHeader *header = file.header;
+    CCArmatureDataManager *armatureDataManager = CCArmatureDataManager::sharedArmatureDataManager();
+
+    const CCArmatureFlatArmature *armatures = file.table<CCArmatureFlatArmature>(header->armatures);
+    for (unsigned int i = 0; i < header->armatures.count; i++)
+    {
+        CCArmatureData *armatureData = decodeFlatArmature(file, armatures[i], dataInfo);
+
+        if (dataInfo->asyncStruct)
+        {
+            pthread_mutex_lock(&s_addDataMutex);
+        }
+        armatureDataManager->addArmatureData(armatureData->name.c_str(), armatureData, dataInfo->filename.c_str());
+        CC_SAFE_RELEASE(armatureData);
+        if (dataInfo->asyncStruct)
+        {
+            pthread_mutex_unlock(&s_addDataMutex);
+        }
+    }
+
+    const CCArmatureFlatAnimation *animations = file.table<CCArmatureFlatAnimation>(header->animations);
+    for (unsigned int i = 0; i < header->animations.count; i++)
+    {
+        CCAnimationData *animationData = decodeFlatAnimation(file, animations[i]);
+
+        if (dataInfo->asyncStruct)
+        {
+            pthread_mutex_lock(&s_addDataMutex);
+        }
+        armatureDataManager->addAnimationData(animationData->name.c_str(), animationData, dataInfo->filename.c_str());
+        CC_SAFE_RELEASE(animationData);
+        if (dataInfo->asyncStruct)
+        {
+            pthread_mutex_unlock(&s_addDataMutex);
+        }
+    }
+
+    const CCArmatureFlatTexture *textures = file.table<CCArmatureFlatTexture>(header->textures);
+    for (unsigned int i = 0; i < header->textures.count; i++)
+    {
+        CCTextureData *textureData = decodeFlatTexture(file, textures[i]);
+
+        if (dataInfo->asyncStruct)
+        {
+            pthread_mutex_lock(&s_addDataMutex);
+        }
+        armatureDataManager->addTextureData(textureData->name.c_str(), textureData, dataInfo->filename.c_str());
+        CC_SAFE_RELEASE(textureData);
+        if (dataInfo->asyncStruct)
+        {
+            pthread_mutex_unlock(&s_addDataMutex);
+        }
+    }
+
+    // Auto load sprite file
+    bool autoLoad = dataInfo->asyncStruct == NULL ? armatureDataManager->isAutoLoadSpriteFile() : dataInfo->asyncStruct->autoLoadSpriteFile;
+    if (autoLoad)
+    {
+        const unsigned int *configFiles = file.table<unsigned int>(header->configFiles);
+        for (unsigned int i = 0; i < header->configFiles.count; i++)
+        {
+            std::string filePath = file.string(configFiles[i]);
+
+            if (dataInfo->asyncStruct)
+            {
+                dataInfo->configFileQueue.push(filePath);
+            }
+            else
+            {
+                std::string plistPath = filePath + ".plist";
+                std::string pngPath =  filePath + ".png";
+
+                armatureDataManager->addSpriteFrameFromFile((dataInfo->baseFilePath + plistPath).c_str(), (dataInfo->baseFilePath + pngPath).c_str(), dataInfo->filename.c_str());
+            }
+        }
+    }
+}
+
 NS_CC_EXT_END
@@ -41,6 +41,7 @@ namespace tinyxml2
 NS_CC_EXT_BEGIN
 
 typedef struct _DataInfo DataInfo;
+typedef struct _AsyncBatch AsyncBatch;
 /**
 *   @js NA
 *   @lua NA
@@ -58,13 +59,26 @@ public:
     static float getPositionReadScale();
 
     static void purge();
-    
+
+    /**
+     * Number of threads decoding async added files, it is used when the threads are created by
+     * the first async load. 0 uses processor count - 1, at least one. Default is 0.
+     */
+    static void setLoadingThreadCount(int count);
+    static int getLoadingThreadCount();
+
 public:
     ~CCDataReaderHelper();
 
     void addDataFromFile(const char *filePath);
     void addDataFromFileAsync(const char *imagePath, const char *plistPath, const char *filePath, CCObject *target, SEL_SCHEDULE selector);
 
+    /**
+     * Decode files on the loading threads, and load textures of their sprite files with CCTextureCache async.
+     * selector is called once, when data and sprite frames of every file are added.
+     */
+    void addDataFromFilesAsync(const std::vector<std::string> &filePaths, CCObject *target, SEL_CallFunc selector);
+
     void addDataAsyncCallBack(float dt);
 
     void removeConfigFile(const char *configFile);
@@ -140,7 +154,18 @@ public:
 
 	static void decodeNode(CCBaseData *node, CocoLoader *pCocoLoader, stExpCocoNode *pCocoNode, DataInfo *dataInfo);
 
+public:
+    /**
+     * Add datas from a flat binary armature file (.afb), see CCArmatureFlatBinary.h.
+     * Records are read in place from fileContent, so it may be a loaded or a mapped file,
+     * it is not modified nor kept after return.
+     */
+    static void addDataFromFlatBinaryCache(const char *fileContent, unsigned long size, DataInfo *dataInfo);
+
 private:
+    //! return false if the file is already added
+    bool addDataFromFileAsync(const char *imagePath, const char *plistPath, const char *filePath, CCObject *target, SEL_SCHEDULE selector, AsyncBatch *batch);
+
     static std::vector<std::string> s_arrConfigFileList;
 
     static CCDataReaderHelper *s_DataReaderHelper;
@@ -33,63 +33,53 @@ CCAffineTransform CCTransformHelp::helpMatrix2;
 CCPoint CCTransformHelp::helpPoint1;
 CCPoint CCTransformHelp::helpPoint2;
 
-CCBaseData helpParentNode;
-
 CCTransformHelp::CCTransformHelp()
 {
 }
 
+//! Transforms use local matrices, armature datas are decoded on several loading threads
+
 void CCTransformHelp::transformFromParent(CCBaseData &node, const CCBaseData &parentNode)
 {
-    nodeToMatrix(node, helpMatrix1);
-    nodeToMatrix(parentNode, helpMatrix2);
+    CCAffineTransform matrix, parentMatrix;
+    nodeToMatrix(node, matrix);
+    nodeToMatrix(parentNode, parentMatrix);
 
-    helpMatrix2 = CCAffineTransformInvert(helpMatrix2);
-    helpMatrix1 = CCAffineTransformConcat(helpMatrix1, helpMatrix2);
+    parentMatrix = CCAffineTransformInvert(parentMatrix);
+    matrix = CCAffineTransformConcat(matrix, parentMatrix);
 
-    matrixToNode(helpMatrix1, node);
+    matrixToNode(matrix, node);
 }
 
 void CCTransformHelp::transformToParent(CCBaseData &node, const CCBaseData &parentNode)
 {
+    CCAffineTransform matrix, parentMatrix;
+    nodeToMatrix(node, matrix);
+    nodeToMatrix(parentNode, parentMatrix);
 
-    nodeToMatrix(node, helpMatrix1);
-    nodeToMatrix(parentNode, helpMatrix2);
-
-    helpMatrix1 = CCAffineTransformConcat(helpMatrix1, helpMatrix2);
+    matrix = CCAffineTransformConcat(matrix, parentMatrix);
 
-    matrixToNode(helpMatrix1, node);
+    matrixToNode(matrix, node);
 }
 
 void CCTransformHelp::transformFromParentWithoutScale(CCBaseData &node, const CCBaseData &parentNode)
 {
+    CCBaseData parentNodeWithoutScale;
+    parentNodeWithoutScale.copy(&parentNode);
+    parentNodeWithoutScale.scaleX = 1;
+    parentNodeWithoutScale.scaleY = 1;
 
-    helpParentNode.copy(&parentNode);
-    helpParentNode.scaleX = 1;
-    helpParentNode.scaleY = 1;
-
-    nodeToMatrix(node, helpMatrix1);
-    nodeToMatrix(helpParentNode, helpMatrix2);
-
-    helpMatrix2 = CCAffineTransformInvert(helpMatrix2);
-    helpMatrix1 = CCAffineTransformConcat(helpMatrix1, helpMatrix2);
-
-    matrixToNode(helpMatrix1, node);
+    transformFromParent(node, parentNodeWithoutScale);
 }
 
 void CCTransformHelp::transformToParentWithoutScale(CCBaseData &node, const CCBaseData &parentNode)
 {
+    CCBaseData parentNodeWithoutScale;
+    parentNodeWithoutScale.copy(&parentNode);
+    parentNodeWithoutScale.scaleX = 1;
+    parentNodeWithoutScale.scaleY = 1;
 
-    helpParentNode.copy(&parentNode);
-    helpParentNode.scaleX = 1;
-    helpParentNode.scaleY = 1;
-
-    nodeToMatrix(node, helpMatrix1);
-    nodeToMatrix(helpParentNode, helpMatrix2);
-
-    helpMatrix1 = CCAffineTransformConcat(helpMatrix1, helpMatrix2);
-
-    matrixToNode(helpMatrix1, node);
+    transformToParent(node, parentNodeWithoutScale);
 }
 
 void CCTransformHelp::nodeToMatrix(const CCBaseData &node, CCAffineTransform &matrix)
@@ -122,20 +112,16 @@ void CCTransformHelp::matrixToNode(const CCAffineTransform &matrix, CCBaseData &
      *  In as3 language, there is a function called "deltaTransformPoint", it calculate a point used give Transform
      *  but not used the tx, ty value. we simulate the function here
      */
-    helpPoint1.x = 0;
-    helpPoint1.y = 1;
-    helpPoint1 = CCPointApplyAffineTransform(helpPoint1, matrix);
-    helpPoint1.x -= matrix.tx;
-    helpPoint1.y -= matrix.ty;
-
-    helpPoint2.x = 1;
-    helpPoint2.y = 0;
-    helpPoint2 = CCPointApplyAffineTransform(helpPoint2, matrix);
-    helpPoint2.x -= matrix.tx;
-    helpPoint2.y -= matrix.ty;
-
-    node.skewX = -(atan2f(helpPoint1.y, helpPoint1.x) - 1.5707964f);
-    node.skewY = atan2f(helpPoint2.y, helpPoint2.x);
+    CCPoint point1 = CCPointApplyAffineTransform(ccp(0, 1), matrix);
+    point1.x -= matrix.tx;
+    point1.y -= matrix.ty;
+
+    CCPoint point2 = CCPointApplyAffineTransform(ccp(1, 0), matrix);
+    point2.x -= matrix.tx;
+    point2.y -= matrix.ty;
+
+    node.skewX = -(atan2f(point1.y, point1.x) - 1.5707964f);
+    node.skewY = atan2f(point2.y, point2.x);
     node.scaleX = sqrt(matrix.a * matrix.a + matrix.b * matrix.b);
     node.scaleY = sqrt(matrix.c * matrix.c + matrix.d * matrix.d);
     node.x = matrix.tx;
@@ -11,14 +11,16 @@
 
 #include "CocoStudio/Armature/CCArmature.h"
 #include "CocoStudio/Armature/CCBone.h"
-#include "CocoStudio/Armature/animation/CCArmatureAnimation.h"
+#include "CocoStudio/Armature/animation/CCArmatureAnimation.h"
+#include "CocoStudio/Armature/animation/CCBakedAnimation.h"
 #include "CocoStudio/Armature/datas/CCDatas.h"
 #include "CocoStudio/Armature/display/CCBatchNode.h"
 #include "CocoStudio/Armature/display/CCDecorativeDisplay.h"
 #include "CocoStudio/Armature/display/CCDisplayManager.h"
 #include "CocoStudio/Armature/display/CCSkin.h"
 #include "CocoStudio/Armature/physics/CCColliderDetector.h"
-#include "CocoStudio/Armature/utils/CCArmatureDataManager.h"
+#include "CocoStudio/Armature/utils/CCArmatureDataManager.h"
+#include "CocoStudio/Armature/utils/CCArmatureSystem.h"
 #include "CocoStudio/Armature/utils/CCDataReaderHelper.h"
 #include "CocoStudio/Armature/utils/CCTweenFunction.h"
 #include "CocoStudio/Armature/utils/CCTransformHelp.h"
@@ -0,0 +1,516 @@
+#include "NetworkTest.h"
+#include "../testResource.h"
+#include "cocos2d.h"
+
+#define DEFAULT_SERVER "http://127.0.0.1:8000"
+
+TESTLAYER_CREATE_FUNC(HttpClientHostLimitTest);
+TESTLAYER_CREATE_FUNC(HttpClientPriorityTest);
+TESTLAYER_CREATE_FUNC(HttpClientCancelTest);
+TESTLAYER_CREATE_FUNC(AssetsManagerPackageTest);
+TESTLAYER_CREATE_FUNC(AssetsManagerTraversalTest);
+TESTLAYER_CREATE_FUNC(AssetsManagerTraversalFallbackTest);
+
+static NEWTESTFUNC createFunctions[] = {
+    CF(HttpClientHostLimitTest),
+    CF(HttpClientPriorityTest),
+    CF(HttpClientCancelTest),
+    CF(AssetsManagerPackageTest),
+    CF(AssetsManagerTraversalTest),
+    CF(AssetsManagerTraversalFallbackTest)
+};
+
+static int sceneIdx=-1;
+#define MAX_LAYER (sizeof(createFunctions) / sizeof(createFunctions[0]))
+
+static CCLayer* nextAction()
+{
+    sceneIdx++;
+    sceneIdx = sceneIdx % MAX_LAYER;
+
+    CCLayer* pLayer = (createFunctions[sceneIdx])();
+    pLayer->init();
+    pLayer->autorelease();
+
+    return pLayer;
+}
+
+static CCLayer* backAction()
+{
+    sceneIdx--;
+    int total = MAX_LAYER;
+    if( sceneIdx < 0 )
+        sceneIdx += total;
+
+    CCLayer* pLayer = (createFunctions[sceneIdx])();
+    pLayer->init();
+    pLayer->autorelease();
+
+    return pLayer;
+}
+
+static CCLayer* restartAction()
+{
+    CCLayer* pLayer = (createFunctions[sceneIdx])();
+    pLayer->init();
+    pLayer->autorelease();
+
+    return pLayer;
+}
+
+void NetworkTestScene::runThisTest()
+{
+    sceneIdx = -1;
+    addChild(nextAction());
+
+    CCDirector::sharedDirector()->replaceScene(this);
+}
+
+//------------------------------------------------------------------
+//
+// NetworkTestBase
+//
+//------------------------------------------------------------------
+NetworkTestBase::NetworkTestBase()
+: m_pStatus(NULL)
+{
+}
+
+std::string NetworkTestBase::title()
+{
+    return "Network Test";
+}
+
+std::string NetworkTestBase::subtitle()
+{
+    return "";
+}
+
+std::string NetworkTestBase::serverUrl(const char* path)
+{
+    return CCUserDefault::sharedUserDefault()->getStringForKey("NetworkTestServer", DEFAULT_SERVER) + path;
+}
+
+void NetworkTestBase::setStatus(const char* format, ...)
+{
+    char buf[512];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    m_pStatus->setString(buf);
+    CCLOG("%s: %s", subtitle().c_str(), buf);
+}
+
+void NetworkTestBase::onEnter()
+{
+    CCLayer::onEnter();
+
+    // add title and subtitle
+    std::string str = title();
+    const char * pTitle = str.c_str();
+    CCLabelTTF* label = CCLabelTTF::create(pTitle, "Arial", 32);
+    addChild(label, 1);
+    label->setPosition( ccp(VisibleRect::center().x, VisibleRect::top().y - 30) );
+
+    std::string strSubtitle = subtitle();
+    if( ! strSubtitle.empty() )
+    {
+        CCLabelTTF* l = CCLabelTTF::create(strSubtitle.c_str(), "Thonburi", 16);
+        addChild(l, 1);
+        l->setPosition( ccp(VisibleRect::center().x, VisibleRect::top().y - 60) );
+    }
+
+    // status
+    m_pStatus = CCLabelTTF::create(("server: " + serverUrl("")).c_str(), "Arial", 20);
+    addChild(m_pStatus, 1);
+    m_pStatus->setPosition(VisibleRect::center());
+
+    // add menu
+    CCMenuItemImage *item1 = CCMenuItemImage::create(s_pPathB1, s_pPathB2, this, menu_selector(NetworkTestBase::backCallback) );
+    CCMenuItemImage *item2 = CCMenuItemImage::create(s_pPathR1, s_pPathR2, this, menu_selector(NetworkTestBase::restartCallback) );
+    CCMenuItemImage *item3 = CCMenuItemImage::create(s_pPathF1, s_pPathF2, this, menu_selector(NetworkTestBase::nextCallback) );
+
+    CCMenu *menu = CCMenu::create(item1, item2, item3, NULL);
+
+    menu->setPosition(CCPointZero);
+    item1->setPosition(ccp(VisibleRect::center().x - item2->getContentSize().width*2, VisibleRect::bottom().y+item2->getContentSize().height/2));
+    item2->setPosition(ccp(VisibleRect::center().x, VisibleRect::bottom().y+item2->getContentSize().height/2));
+    item3->setPosition(ccp(VisibleRect::center().x + item2->getContentSize().width*2, VisibleRect::bottom().y+item2->getContentSize().height/2));
+
+    addChild(menu, 1);
+}
+
+void NetworkTestBase::onExit()
+{
+    CCLayer::onExit();
+}
+
+void NetworkTestBase::restartCallback(CCObject* pSender)
+{
+    CCScene* s = new NetworkTestScene();
+    s->addChild( restartAction() );
+    CCDirector::sharedDirector()->replaceScene(s);
+    s->release();
+}
+
+void NetworkTestBase::nextCallback(CCObject* pSender)
+{
+    CCScene* s = new NetworkTestScene();
+    s->addChild( nextAction() );
+    CCDirector::sharedDirector()->replaceScene(s);
+    s->release();
+}
+
+void NetworkTestBase::backCallback(CCObject* pSender)
+{
+    CCScene* s = new NetworkTestScene();
+    s->addChild( backAction() );
+    CCDirector::sharedDirector()->replaceScene(s);
+    s->release();
+}
+
+//------------------------------------------------------------------
+//
+// HttpClientTestBase
+//
+//------------------------------------------------------------------
+HttpClientTestBase::HttpClientTestBase()
+: m_pClient(NULL)
+, m_nOldMaxPerHost(0)
+{
+}
+
+std::string HttpClientTestBase::title()
+{
+    return "CCHttpClient Test";
+}
+
+void HttpClientTestBase::onEnter()
+{
+    NetworkTestBase::onEnter();
+
+    m_pClient = CCHttpClient::create();
+    m_pClient->retain();
+    m_nOldMaxPerHost = CCHttpClient::getMaxConnectionsPerHost();
+    CCNotificationCenter::sharedNotificationCenter()->addObserver(this, callfuncO_selector(HttpClientTestBase::httpDataReceived), kCCNotificationHttpDataReceived, NULL);
+    CCNotificationCenter::sharedNotificationCenter()->addObserver(this, callfuncO_selector(HttpClientTestBase::httpRequestCompleted), kCCNotificationHttpRequestCompleted, NULL);
+}
+
+void HttpClientTestBase::onExit()
+{
+    CCNotificationCenter::sharedNotificationCenter()->removeObserver(this, kCCNotificationHttpDataReceived);
+    CCNotificationCenter::sharedNotificationCenter()->removeObserver(this, kCCNotificationHttpRequestCompleted);
+    m_pClient->cancelAll();
+    CC_SAFE_RELEASE_NULL(m_pClient);
+    CCHttpClient::setMaxConnectionsPerHost(m_nOldMaxPerHost);
+
+    NetworkTestBase::onExit();
+}
+
+CCHttpRequest* HttpClientTestBase::sendRequest(const std::string& url, int tag, int priority)
+{
+    CCHttpRequest* request = CCHttpRequest::create();
+    request->setMethod(kHttpGet);
+    request->setUrl(url);
+    request->setTag(tag);
+    request->setPriority(priority);
+    request->setUserData(this);
+    m_pClient->asyncExecute(request);
+    return request;
+}
+
+int HttpClientTestBase::parseField(const std::string& body, const char* name)
+{
+    std::string key = std::string(name) + "=";
+    size_t pos = body.find(key);
+    return pos == std::string::npos ? -1 : atoi(body.c_str() + pos + key.length());
+}
+
+void HttpClientTestBase::httpDataReceived(CCObject* obj)
+{
+    CCHttpResponse* response = (CCHttpResponse*)obj;
+    if(response->getRequest()->getUserData() != this)
+        return;
+    CCData* data = response->getData();
+    m_bodies[response->getRequest()->getTag()].append((const char*)data->getBytes(), data->getSize());
+    onHttpData(response);
+}
+
+void HttpClientTestBase::httpRequestCompleted(CCObject* obj)
+{
+    CCHttpResponse* response = (CCHttpResponse*)obj;
+    if(response->getRequest()->getUserData() != this)
+        return;
+    onHttpDone(response);
+}
+
+//------------------------------------------------------------------
+//
+// HttpClientHostLimitTest
+//
+//------------------------------------------------------------------
+#define HOST_LIMIT 2
+#define HOST_LIMIT_REQUESTS 6
+
+void HttpClientHostLimitTest::onEnter()
+{
+    HttpClientTestBase::onEnter();
+
+    // server reports how many requests are running when one arrives
+    m_nDone = 0;
+    m_nFailed = 0;
+    m_nMaxActive = 0;
+    CCHttpClient::setMaxConnectionsPerHost(HOST_LIMIT);
+    for(int i = 0; i < HOST_LIMIT_REQUESTS; i++)
+    {
+        char path[64];
+        sprintf(path, "/http/slow?id=%d&ms=500", i);
+        sendRequest(serverUrl(path), i);
+    }
+    setStatus("running");
+}
+
+std::string HttpClientHostLimitTest::subtitle()
+{
+    return "6 slow requests, at most 2 connections to host";
+}
+
+void HttpClientHostLimitTest::onHttpDone(CCHttpResponse* response)
+{
+    m_nDone++;
+    if(!response->isSuccess())
+    {
+        m_nFailed++;
+    }
+    else
+    {
+        m_nMaxActive = MAX(m_nMaxActive, parseField(m_bodies[response->getRequest()->getTag()], "active"));
+    }
+    if(m_nDone < HOST_LIMIT_REQUESTS)
+        return;
+
+    if(m_nFailed > 0)
+        setStatus("FAIL: %d requests failed, is stub server running?", m_nFailed);
+    else if(m_nMaxActive > HOST_LIMIT)
+        setStatus("FAIL: %d requests were running at once", m_nMaxActive);
+    else
+        setStatus("PASS: at most %d requests were running at once", m_nMaxActive);
+}
+
+//------------------------------------------------------------------
+//
+// HttpClientPriorityTest
+//
+//------------------------------------------------------------------
+#define PRIORITY_REQUESTS 5
+
+void HttpClientPriorityTest::onEnter()
+{
+    HttpClientTestBase::onEnter();
+
+    // blocker takes the only connection, others are pending and must start by priority
+    m_nDone = 0;
+    m_nFailed = 0;
+    m_priorityByOrder.clear();
+    CCHttpClient::setMaxConnectionsPerHost(1);
+    sendRequest(serverUrl("/http/slow?id=0&ms=500"), 0, 100);
+    const int priorities[PRIORITY_REQUESTS] = { 3, 1, 5, 2, 4 };
+    for(int i = 0; i < PRIORITY_REQUESTS; i++)
+    {
+        char path[64];
+        sprintf(path, "/http/slow?id=%d", priorities[i]);
+        sendRequest(serverUrl(path), priorities[i], priorities[i]);
+    }
+    setStatus("running");
+}
+
+std::string HttpClientPriorityTest::subtitle()
+{
+    return "One connection to host, pending requests start by priority";
+}
+
+void HttpClientPriorityTest::onHttpDone(CCHttpResponse* response)
+{
+    m_nDone++;
+    int tag = response->getRequest()->getTag();
+    if(!response->isSuccess())
+        m_nFailed++;
+    else if(tag != 0)
+        m_priorityByOrder[parseField(m_bodies[tag], "order")] = response->getRequest()->getPriority();
+    if(m_nDone < PRIORITY_REQUESTS + 1)
+        return;
+
+    if(m_nFailed > 0)
+    {
+        setStatus("FAIL: %d requests failed, is stub server running?", m_nFailed);
+        return;
+    }
+    std::string order;
+    int last = INT_MAX;
+    bool sorted = true;
+    for(std::map<int, int>::iterator iter = m_priorityByOrder.begin(); iter != m_priorityByOrder.end(); iter++)
+    {
+        char buf[16];
+        sprintf(buf, " %d", iter->second);
+        order += buf;
+        sorted = sorted && iter->second < last;
+        last = iter->second;
+    }
+    setStatus("%s: server got priorities%s", sorted ? "PASS" : "FAIL", order.c_str());
+}
+
+//------------------------------------------------------------------
+//
+// HttpClientCancelTest
+//
+//------------------------------------------------------------------
+#define CANCEL_STREAM_KB 512
+
+void HttpClientCancelTest::onEnter()
+{
+    HttpClientTestBase::onEnter();
+
+    // stream takes 10 seconds, it is cancelled when first data arrives
+    m_bCancelled = false;
+    char path[64];
+    sprintf(path, "/http/stream?kb=%d&ms=20", CANCEL_STREAM_KB);
+    sendRequest(serverUrl(path), 1);
+    setStatus("running");
+}
+
+std::string HttpClientCancelTest::subtitle()
+{
+    return "Cancel a transfer when its first data arrives";
+}
+
+void HttpClientCancelTest::onHttpData(CCHttpResponse* response)
+{
+    if(m_bCancelled)
+        return;
+    m_bCancelled = true;
+    CCTime::gettimeofdayCocos2d(&m_tCancelTime, NULL);
+    m_pClient->cancel(1);
+    setStatus("cancelled after %u bytes", (unsigned int)m_bodies[1].size());
+}
+
+void HttpClientCancelTest::onHttpDone(CCHttpResponse* response)
+{
+    size_t received = m_bodies[1].size();
+    if(!m_bCancelled)
+    {
+        setStatus("FAIL: no data is received, is stub server running?");
+        return;
+    }
+
+    struct cc_timeval now;
+    CCTime::gettimeofdayCocos2d(&now, NULL);
+    double elapsed = CCTime::timersubCocos2d(&m_tCancelTime, &now);
+    if(response->isSuccess() || received >= CANCEL_STREAM_KB * 1024)
+        setStatus("FAIL: transfer is not stopped, %u bytes received", (unsigned int)received);
+    else if(elapsed > 1000)
+        setStatus("FAIL: transfer is stopped %.0f ms after cancel", elapsed);
+    else
+        setStatus("PASS: stopped %.0f ms after cancel, %u bytes received", elapsed, (unsigned int)received);
+}
+
+//------------------------------------------------------------------
+//
+// AssetsManagerTestBase
+//
+//------------------------------------------------------------------
+AssetsManagerTestBase::AssetsManagerTestBase()
+: m_pManager(NULL)
+{
+}
+
+AssetsManagerTestBase::~AssetsManagerTestBase()
+{
+    CC_SAFE_DELETE(m_pManager);
+}
+
+std::string AssetsManagerTestBase::title()
+{
+    return "AssetsManager Test";
+}
+
+std::string AssetsManagerTestBase::evilFilePath()
+{
+    return CCFileUtils::sharedFileUtils()->getWritablePath() + "evil.txt";
+}
+
+void AssetsManagerTestBase::onEnter()
+{
+    NetworkTestBase::onEnter();
+
+    // version of stub server is always 1, forget recorded one so package is always updated
+    m_storagePath = CCFileUtils::sharedFileUtils()->getWritablePath() + "NetworkTest/";
+    CCUtils::createFolder(m_storagePath);
+    CCUtils::deleteFile(evilFilePath());
+    m_pManager = new AssetsManager(serverUrl(packagePath()).c_str(), serverUrl("/assets/version").c_str(), m_storagePath.c_str());
+    m_pManager->setDelegate(this);
+    m_pManager->deleteVersion();
+    m_pManager->update();
+    setStatus("running");
+}
+
+void AssetsManagerTestBase::onExit()
+{
+    m_pManager->setDelegate(NULL);
+
+    NetworkTestBase::onExit();
+}
+
+void AssetsManagerTestBase::onError(AssetsManager::ErrorCode errorCode)
+{
+    // package with bad entry must fail without writing outside of storage path
+    if(CCUtils::isPathExistent(evilFilePath()))
+        setStatus("FAIL: %s is written", evilFilePath().c_str());
+    else if(errorCode == AssetsManager::kUncompress)
+        setStatus("PASS: package is rejected");
+    else
+        setStatus("FAIL: error %d, is stub server running?", errorCode);
+}
+
+void AssetsManagerTestBase::onSuccess()
+{
+    setStatus("FAIL: package is accepted");
+}
+
+//------------------------------------------------------------------
+//
+// AssetsManagerPackageTest
+//
+//------------------------------------------------------------------
+std::string AssetsManagerPackageTest::subtitle()
+{
+    return "Update a package while it is downloaded";
+}
+
+void AssetsManagerPackageTest::onSuccess()
+{
+    if(CCUtils::isPathExistent(m_storagePath + "net_test/sub/b.txt"))
+        setStatus("PASS: package is updated");
+    else
+        setStatus("FAIL: net_test/sub/b.txt is not found");
+}
+
+//------------------------------------------------------------------
+//
+// AssetsManagerTraversalTest
+//
+//------------------------------------------------------------------
+std::string AssetsManagerTraversalTest::subtitle()
+{
+    return "Reject streamed package with entry ../evil.txt";
+}
+
+//------------------------------------------------------------------
+//
+// AssetsManagerTraversalFallbackTest
+//
+//------------------------------------------------------------------
+std::string AssetsManagerTraversalFallbackTest::subtitle()
+{
+    return "Reject package with entry ../evil.txt which can't be streamed";
+}
@@ -0,0 +1,176 @@
+#ifndef __NETWORKTEST_H__
+#define __NETWORKTEST_H__
+
+#include "../testBasic.h"
+#include "support/network/CCHttpClient.h"
+#include "AssetsManager/AssetsManager.h"
+#include <map>
+
+USING_NS_CC;
+USING_NS_CC_EXT;
+
+// the tests talk to stub_server.py in this folder, run it before starting tests. Server url
+// is read from UserDefault key "NetworkTestServer", default is http://127.0.0.1:8000
+class NetworkTestScene : public TestScene
+{
+public:
+    virtual void runThisTest();
+};
+
+class NetworkTestBase : public CCLayer
+{
+public:
+    NetworkTestBase();
+
+    virtual void onEnter();
+    virtual void onExit();
+
+    virtual std::string title();
+    virtual std::string subtitle();
+
+    void restartCallback(CCObject* pSender);
+    void nextCallback(CCObject* pSender);
+    void backCallback(CCObject* pSender);
+
+protected:
+    // url of a path in stub server
+    static std::string serverUrl(const char* path);
+
+    // show progress or result of test
+    void setStatus(const char* format, ...);
+
+    CCLabelTTF* m_pStatus;
+};
+
+// base of CCHttpClient tests, notifications of other requests are ignored
+class HttpClientTestBase : public NetworkTestBase
+{
+public:
+    HttpClientTestBase();
+
+    virtual void onEnter();
+    virtual void onExit();
+    virtual std::string title();
+
+protected:
+    // send a GET request, tag identifies it in callbacks
+    CCHttpRequest* sendRequest(const std::string& url, int tag, int priority = 0);
+
+    virtual void onHttpData(CCHttpResponse* response) {}
+    virtual void onHttpDone(CCHttpResponse* response) {}
+
+    // parse a field of slow response body, such as order or active
+    static int parseField(const std::string& body, const char* name);
+
+    CCHttpClient* m_pClient;
+    int m_nOldMaxPerHost;
+
+    // body received by tag
+    std::map<int, std::string> m_bodies;
+
+private:
+    void httpDataReceived(CCObject* obj);
+    void httpRequestCompleted(CCObject* obj);
+};
+
+class HttpClientHostLimitTest : public HttpClientTestBase
+{
+public:
+    virtual void onEnter();
+    virtual std::string subtitle();
+
+protected:
+    virtual void onHttpDone(CCHttpResponse* response);
+
+private:
+    int m_nDone;
+    int m_nFailed;
+    int m_nMaxActive;
+};
+
+class HttpClientPriorityTest : public HttpClientTestBase
+{
+public:
+    virtual void onEnter();
+    virtual std::string subtitle();
+
+protected:
+    virtual void onHttpDone(CCHttpResponse* response);
+
+private:
+    int m_nDone;
+    int m_nFailed;
+
+    // priority by server arrival order
+    std::map<int, int> m_priorityByOrder;
+};
+
+class HttpClientCancelTest : public HttpClientTestBase
+{
+public:
+    virtual void onEnter();
+    virtual std::string subtitle();
+
+protected:
+    virtual void onHttpData(CCHttpResponse* response);
+    virtual void onHttpDone(CCHttpResponse* response);
+
+private:
+    bool m_bCancelled;
+    struct cc_timeval m_tCancelTime;
+};
+
+// base of AssetsManager tests, package is updated to NetworkTest folder of writable path
+class AssetsManagerTestBase : public NetworkTestBase, public AssetsManagerDelegateProtocol
+{
+public:
+    AssetsManagerTestBase();
+    virtual ~AssetsManagerTestBase();
+
+    virtual void onEnter();
+    virtual void onExit();
+    virtual std::string title();
+
+    virtual void onError(AssetsManager::ErrorCode errorCode);
+    virtual void onSuccess();
+
+protected:
+    // package path in stub server
+    virtual const char* packagePath() = 0;
+
+    // file which package tries to write outside of storage path
+    std::string evilFilePath();
+
+    AssetsManager* m_pManager;
+    std::string m_storagePath;
+};
+
+class AssetsManagerPackageTest : public AssetsManagerTestBase
+{
+public:
+    virtual std::string subtitle();
+    virtual void onSuccess();
+
+protected:
+    virtual const char* packagePath() { return "/assets/good.zip"; }
+};
+
+class AssetsManagerTraversalTest : public AssetsManagerTestBase
+{
+public:
+    virtual std::string subtitle();
+
+protected:
+    virtual const char* packagePath() { return "/assets/evil.zip"; }
+};
+
+class AssetsManagerTraversalFallbackTest : public AssetsManagerTestBase
+{
+public:
+    virtual std::string subtitle();
+
+protected:
+    virtual const char* packagePath() { return "/assets/evil_fallback.zip"; }
+};
+
+#endif // __NETWORKTEST_H__
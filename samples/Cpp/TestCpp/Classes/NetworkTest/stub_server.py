@@ -0,0 +1,96 @@
+#!/usr/bin/env python3
+# Stub server of NetworkTest in TestCpp.
+#
+# Usage: python3 stub_server.py [port], default port is 8000. Device must reach the host, set
+# UserDefault key "NetworkTestServer" to the url if it is not http://127.0.0.1:8000, for example
+# http://10.0.2.2:8000 in android emulator.
+#
+# /http/slow?id=N&ms=M      waits M ms, body is "id=N order=K active=A". K is arrival order of all
+#                           slow requests, A is count of slow requests running when it arrives
+# /http/stream?kb=N&ms=M    sends N KB, one KB every M ms
+# /assets/version           version of packages, it is always 1 and test deletes recorded version
+# /assets/good.zip          package of two files
+# /assets/evil.zip          package with entry ../evil.txt, it is streamed
+# /assets/evil_fallback.zip package with entry ../evil.txt, stored with data descriptor so it can't
+#                           be streamed and is uncompressed after download
+
+import http.server, socketserver, threading, time, sys, io, zipfile
+from urllib.parse import urlparse, parse_qs
+
+lock = threading.Lock()
+state = { "order": 0, "active": 0 }
+
+class Unseekable(io.RawIOBase):
+    # zipfile writes data descriptors if output can't seek
+    def __init__(self):
+        self.data = bytearray()
+    def writable(self):
+        return True
+    def write(self, b):
+        self.data += b
+        return len(b)
+
+def make_zip(entries, compression, seekable):
+    out = io.BytesIO() if seekable else Unseekable()
+    with zipfile.ZipFile(out, "w", compression) as z:
+        for name, data in entries:
+            z.writestr(name, data)
+    return bytes(out.getvalue() if seekable else out.data)
+
+PACKAGES = {
+    "/assets/good.zip": make_zip([("net_test/a.txt", b"hello" * 1000), ("net_test/sub/b.txt", b"world")], zipfile.ZIP_DEFLATED, True),
+    "/assets/evil.zip": make_zip([("net_test/a.txt", b"hello"), ("../evil.txt", b"evil")], zipfile.ZIP_DEFLATED, True),
+    "/assets/evil_fallback.zip": make_zip([("net_test/a.txt", b"hello"), ("../evil.txt", b"evil")], zipfile.ZIP_STORED, False),
+}
+
+class Handler(http.server.BaseHTTPRequestHandler):
+    def log_message(self, fmt, *args):
+        sys.stderr.write("%s\n" % (fmt % args))
+
+    def send_body(self, body, code=200):
+        self.send_response(code)
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def do_GET(self):
+        url = urlparse(self.path)
+        args = dict((k, v[0]) for k, v in parse_qs(url.query).items())
+        if url.path == "/http/slow":
+            with lock:
+                state["order"] += 1
+                state["active"] += 1
+                body = "id=%s order=%d active=%d" % (args.get("id", "0"), state["order"], state["active"])
+            try:
+                time.sleep(int(args.get("ms", "0")) / 1000.0)
+                self.send_body(body.encode())
+            finally:
+                with lock:
+                    state["active"] -= 1
+        elif url.path == "/http/stream":
+            kb = int(args.get("kb", "64"))
+            self.send_response(200)
+            self.send_header("Content-Length", str(kb * 1024))
+            self.end_headers()
+            try:
+                for i in range(kb):
+                    self.wfile.write(b"x" * 1024)
+                    self.wfile.flush()
+                    time.sleep(int(args.get("ms", "10")) / 1000.0)
+            except (BrokenPipeError, ConnectionResetError):
+                sys.stderr.write("stream is closed by client after %d KB\n" % i)
+        elif url.path == "/assets/version":
+            self.send_body(b"1")
+        elif url.path in PACKAGES:
+            self.send_body(PACKAGES[url.path])
+        else:
+            self.send_body(b"not found", 404)
+
+class Server(socketserver.ThreadingMixIn, http.server.HTTPServer):
+    daemon_threads = True
+    allow_reuse_address = True
+
+if __name__ == "__main__":
+    port = int(sys.argv[1]) if len(sys.argv) > 1 else 8000
+    print("network test stub server is listening on port %d" % port)
+    Server(("0.0.0.0", port), Handler).serve_forever()
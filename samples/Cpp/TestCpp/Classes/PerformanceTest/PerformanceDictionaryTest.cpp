@@ -0,0 +1,438 @@
+/*
+ *
+ */
+#include "PerformanceDictionaryTest.h"
+#include "cocoa/uthash.h"
+
+// Enable profiles for this file
+#undef CC_PROFILER_DISPLAY_TIMERS
+#define CC_PROFILER_DISPLAY_TIMERS() CCProfiler::sharedProfiler()->displayTimers()
+#undef CC_PROFILER_PURGE_ALL
+#define CC_PROFILER_PURGE_ALL() CCProfiler::sharedProfiler()->releaseAllTimers()
+
+#undef CC_PROFILER_START
+#define CC_PROFILER_START(__name__) CCProfilingBeginTimingBlock(__name__)
+#undef CC_PROFILER_STOP
+#define CC_PROFILER_STOP(__name__) CCProfilingEndTimingBlock(__name__)
+
+#define MAX_LAYER  3
+
+enum {
+    kTagInfoLayer = 1,
+};
+
+enum {
+    kMaxKeys = 100000,
+    kKeysIncrease = 2000,
+};
+
+static int s_nCurCase = 0;
+
+////////////////////////////////////////////////////////
+//
+// legacy dictionary, element layout of uthash based CCDictionary
+//
+////////////////////////////////////////////////////////
+typedef struct _tLegacyElement {
+    char key[256];
+    intptr_t iKey;
+    CCObject* object;
+    UT_hash_handle hh;
+} tLegacyElement;
+
+static void legacySet(tLegacyElement** head, const char* key, CCObject* obj) {
+    tLegacyElement* e = NULL;
+    HASH_FIND_STR(*head, key, e);
+    if(e) {
+        obj->retain();
+        e->object->release();
+        e->object = obj;
+    } else {
+        e = (tLegacyElement*)calloc(1, sizeof(tLegacyElement));
+        strcpy(e->key, key);
+        e->object = obj;
+        obj->retain();
+        HASH_ADD_STR(*head, key, e);
+    }
+}
+
+static CCObject* legacyGet(tLegacyElement* head, const char* key) {
+    tLegacyElement* e = NULL;
+    HASH_FIND_STR(head, key, e);
+    return e ? e->object : NULL;
+}
+
+static void legacyClear(tLegacyElement** head) {
+    tLegacyElement* e, *tmp;
+    HASH_ITER(hh, *head, e, tmp) {
+        HASH_DEL(*head, e);
+        e->object->release();
+        free(e);
+    }
+}
+
+////////////////////////////////////////////////////////
+//
+// DictionaryBasicLayer
+//
+////////////////////////////////////////////////////////
+
+DictionaryBasicLayer::DictionaryBasicLayer(bool bControlMenuVisible, int nMaxCases, int nCurCase)
+: PerformBasicLayer(bControlMenuVisible, nMaxCases, nCurCase)
+{
+}
+
+void DictionaryBasicLayer::showCurrentTest()
+{
+    PerformceDictionaryScene* scene = NULL;
+    switch (m_nCurCase) {
+        case 0:
+            scene = new DictionaryInsertTest;
+            break;
+        case 1:
+            scene = new DictionaryLookupTest;
+            break;
+        case 2:
+            scene = new DictionaryIterateTest;
+            break;
+        default:
+            scene = NULL;
+    }
+
+    s_nCurCase = m_nCurCase;
+
+    int keys = ((PerformceDictionaryScene*)getParent())->getQuantityOfKeys();
+
+    if (scene)
+    {
+        scene->initWithQuantityOfKeys(keys);
+
+        CCDirector::sharedDirector()->replaceScene(scene);
+        scene->release();
+    }
+}
+
+////////////////////////////////////////////////////////
+//
+// PerformceDictionaryScene
+//
+////////////////////////////////////////////////////////
+PerformceDictionaryScene::PerformceDictionaryScene()
+: value(NULL)
+{
+}
+
+PerformceDictionaryScene::~PerformceDictionaryScene()
+{
+    CC_SAFE_RELEASE(value);
+}
+
+void PerformceDictionaryScene::initWithQuantityOfKeys(unsigned int nKeys)
+{
+    CCSize s = CCDirector::sharedDirector()->getWinSize();
+
+    // Title
+    CCLabelTTF* label = CCLabelTTF::create(title().c_str(), "Arial", 40);
+    addChild(label, 1);
+    label->setPosition(CCPoint(s.width/2, s.height-32));
+    label->setColor(ccc3(255,255,40));
+
+    // Subtitle
+    std::string strSubTitle = subtitle();
+    if(strSubTitle.length())
+    {
+        CCLabelTTF* l = CCLabelTTF::create(strSubTitle.c_str(), "Thonburi", 16);
+        addChild(l, 1);
+        l->setPosition(CCPoint(s.width/2, s.height-80));
+    }
+
+    lastRenderedCount = 0;
+    quantityOfKeys = nKeys;
+    value = new CCString("value");
+
+    CCMenuItemFont::setFontSize(65);
+    CCMenuItem* decrease = CCMenuItemFont::create(" - ", this, menu_selector(PerformceDictionaryScene::onDecrease));
+    decrease->setColor(ccc3(0,200,20));
+    CCMenuItem* increase = CCMenuItemFont::create(" + ", this, menu_selector(PerformceDictionaryScene::onIncrease));
+    increase->setColor(ccc3(0,200,20));
+
+    CCMenu* menu = CCMenu::create(decrease, increase, NULL);
+    menu->alignItemsHorizontally();
+    menu->setPosition(CCPoint(s.width/2, s.height/2+15));
+    addChild(menu, 1);
+
+    CCLabelTTF* infoLabel = CCLabelTTF::create("0 keys", "Marker Felt", 30);
+    infoLabel->setColor(ccc3(0,200,20));
+    infoLabel->setPosition(CCPoint(s.width/2, s.height/2-15));
+    addChild(infoLabel, 1, kTagInfoLayer);
+
+    DictionaryBasicLayer* menuLayer = new DictionaryBasicLayer(true, MAX_LAYER, s_nCurCase);
+    addChild(menuLayer);
+    menuLayer->release();
+
+    updateQuantityLabel();
+    updateKeys();
+    scheduleUpdate();
+}
+
+std::string PerformceDictionaryScene::title()
+{
+    return "No title";
+}
+
+std::string PerformceDictionaryScene::subtitle()
+{
+    return "";
+}
+
+void PerformceDictionaryScene::update(float dt)
+{
+    CC_PROFILER_START(_currentName);
+    runCurrent();
+    CC_PROFILER_STOP(_currentName);
+    
+    CC_PROFILER_START(_legacyName);
+    runLegacy();
+    CC_PROFILER_STOP(_legacyName);
+}
+
+void PerformceDictionaryScene::onDecrease(CCObject* pSender)
+{
+    quantityOfKeys -= kKeysIncrease;
+    if( quantityOfKeys < 0 )
+        quantityOfKeys = 0;
+
+    updateQuantityLabel();
+    updateKeys();
+
+    CC_PROFILER_PURGE_ALL();
+}
+
+void PerformceDictionaryScene::onIncrease(CCObject* pSender)
+{
+    quantityOfKeys += kKeysIncrease;
+    if( quantityOfKeys > kMaxKeys )
+        quantityOfKeys = kMaxKeys;
+
+    updateQuantityLabel();
+    updateKeys();
+
+    CC_PROFILER_PURGE_ALL();
+}
+
+void PerformceDictionaryScene::updateQuantityLabel()
+{
+    if( quantityOfKeys != lastRenderedCount )
+    {
+        CCLabelTTF* infoLabel = static_cast<CCLabelTTF*>( getChildByTag(kTagInfoLayer) );
+        char str[20] = {0};
+        sprintf(str, "%u keys", quantityOfKeys);
+        infoLabel->setString(str);
+
+        lastRenderedCount = quantityOfKeys;
+    }
+}
+
+void PerformceDictionaryScene::updateKeys()
+{
+    // keys look like sprite frame names in a plist
+    keys.clear();
+    keys.reserve(quantityOfKeys);
+    char buf[64];
+    for(int i = 0; i < quantityOfKeys; i++) {
+        sprintf(buf, "character_%d_frame_%04d.png", i / 32, i % 32);
+        keys.push_back(buf);
+    }
+    
+    snprintf(_currentName, sizeof(_currentName)-1, "CCDictionary %s(%d)", testName(), quantityOfKeys);
+    snprintf(_legacyName, sizeof(_legacyName)-1, "uthash %s(%d)", testName(), quantityOfKeys);
+}
+
+void PerformceDictionaryScene::onExitTransitionDidStart()
+{
+    CCScene::onExitTransitionDidStart();
+    
+    CCDirector* director = CCDirector::sharedDirector();
+    CCScheduler* sched = director->getScheduler();
+
+    sched->unscheduleSelector(SEL_SCHEDULE(&PerformceDictionaryScene::dumpProfilerInfo), this);
+}
+
+void PerformceDictionaryScene::onEnterTransitionDidFinish()
+{
+    CCScene::onEnterTransitionDidFinish();
+
+    CCDirector* director = CCDirector::sharedDirector();
+    CCScheduler* sched = director->getScheduler();
+
+    CC_PROFILER_PURGE_ALL();
+    sched->scheduleSelector(SEL_SCHEDULE(&PerformceDictionaryScene::dumpProfilerInfo), this, 2, false);
+}
+
+void PerformceDictionaryScene::dumpProfilerInfo(float dt)
+{
+	CC_PROFILER_DISPLAY_TIMERS();
+}
+
+////////////////////////////////////////////////////////
+//
+// DictionaryInsertTest
+//
+////////////////////////////////////////////////////////
+void DictionaryInsertTest::runCurrent()
+{
+    CCDictionary* dict = new CCDictionary();
+    for(std::vector<std::string>::iterator iter = keys.begin(); iter != keys.end(); iter++) {
+        dict->setObject(value, *iter);
+    }
+    dict->release();
+}
+
+void DictionaryInsertTest::runLegacy()
+{
+    tLegacyElement* head = NULL;
+    for(std::vector<std::string>::iterator iter = keys.begin(); iter != keys.end(); iter++) {
+        legacySet(&head, iter->c_str(), value);
+    }
+    legacyClear(&head);
+}
+
+std::string DictionaryInsertTest::title()
+{
+    return "Dictionary Insert Perf test.";
+}
+
+std::string DictionaryInsertTest::subtitle()
+{
+    return "Create, fill and destroy. See console";
+}
+
+const char* DictionaryInsertTest::testName()
+{
+    return "insert";
+}
+
+////////////////////////////////////////////////////////
+//
+// DictionaryLookupTest
+//
+////////////////////////////////////////////////////////
+DictionaryLookupTest::DictionaryLookupTest()
+: dict(NULL)
+, legacy(NULL)
+{
+}
+
+DictionaryLookupTest::~DictionaryLookupTest()
+{
+    CC_SAFE_RELEASE(dict);
+    tLegacyElement* head = (tLegacyElement*)legacy;
+    legacyClear(&head);
+}
+
+void DictionaryLookupTest::updateKeys()
+{
+    PerformceDictionaryScene::updateKeys();
+    
+    CC_SAFE_RELEASE(dict);
+    tLegacyElement* head = (tLegacyElement*)legacy;
+    legacyClear(&head);
+    
+    dict = new CCDictionary();
+    for(std::vector<std::string>::iterator iter = keys.begin(); iter != keys.end(); iter++) {
+        dict->setObject(value, *iter);
+        legacySet(&head, iter->c_str(), value);
+    }
+    legacy = head;
+}
+
+void DictionaryLookupTest::runCurrent()
+{
+    int found = 0;
+    for(std::vector<std::string>::iterator iter = keys.begin(); iter != keys.end(); iter++) {
+        if(dict->objectForKey(*iter))
+            found++;
+    }
+    CCAssert(found == quantityOfKeys, "lookup failed");
+}
+
+void DictionaryLookupTest::runLegacy()
+{
+    int found = 0;
+    tLegacyElement* head = (tLegacyElement*)legacy;
+    for(std::vector<std::string>::iterator iter = keys.begin(); iter != keys.end(); iter++) {
+        if(legacyGet(head, iter->c_str()))
+            found++;
+    }
+    CCAssert(found == quantityOfKeys, "lookup failed");
+}
+
+std::string DictionaryLookupTest::title()
+{
+    return "Dictionary Lookup Perf test.";
+}
+
+std::string DictionaryLookupTest::subtitle()
+{
+    return "Look up every key. See console";
+}
+
+const char* DictionaryLookupTest::testName()
+{
+    return "lookup";
+}
+
+////////////////////////////////////////////////////////
+//
+// DictionaryIterateTest
+//
+////////////////////////////////////////////////////////
+void DictionaryIterateTest::runCurrent()
+{
+    int count = 0;
+    CCDictElement* pElement = NULL;
+    CCDICT_FOREACH(dict, pElement)
+    {
+        if(pElement->getObject())
+            count++;
+    }
+    CCAssert(count == quantityOfKeys, "iterate failed");
+}
+
+void DictionaryIterateTest::runLegacy()
+{
+    int count = 0;
+    tLegacyElement* head = (tLegacyElement*)legacy;
+    tLegacyElement* e, *tmp;
+    HASH_ITER(hh, head, e, tmp)
+    {
+        if(e->object)
+            count++;
+    }
+    CCAssert(count == quantityOfKeys, "iterate failed");
+}
+
+std::string DictionaryIterateTest::title()
+{
+    return "Dictionary Iterate Perf test.";
+}
+
+std::string DictionaryIterateTest::subtitle()
+{
+    return "Traverse all elements. See console";
+}
+
+const char* DictionaryIterateTest::testName()
+{
+    return "iterate";
+}
+
+///----------------------------------------
+void runDictionaryPerformanceTest()
+{
+    PerformceDictionaryScene* scene = new DictionaryInsertTest;
+    scene->initWithQuantityOfKeys(kKeysIncrease);
+
+    CCDirector::sharedDirector()->replaceScene(scene);
+    scene->release();
+}
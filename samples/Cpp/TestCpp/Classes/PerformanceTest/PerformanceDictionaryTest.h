@@ -0,0 +1,110 @@
+/*
+ *
+ */
+#ifndef __PERFORMANCE_DICTIONARY_TEST_H__
+#define __PERFORMANCE_DICTIONARY_TEST_H__
+
+#include <string>
+#include <vector>
+
+#include "PerformanceTest.h"
+#include "support/profile/CCProfiling.h"
+
+
+class DictionaryBasicLayer : public PerformBasicLayer
+{
+public:
+    DictionaryBasicLayer(bool bControlMenuVisible, int nMaxCases = 0, int nCurCase = 0);
+
+    virtual void showCurrentTest();
+};
+
+/**
+ * Every test runs same operation on CCDictionary and on a uthash map which has
+ * the element layout CCDictionary used before, and profiles both
+ */
+class PerformceDictionaryScene : public CCScene
+{
+public:
+    PerformceDictionaryScene();
+    virtual ~PerformceDictionaryScene();
+    
+    virtual void initWithQuantityOfKeys(unsigned int nKeys);
+    virtual std::string title();
+    virtual std::string subtitle();
+    virtual void update(float dt);
+
+    void onDecrease(CCObject* pSender);
+    void onIncrease(CCObject* pSender);
+
+    // for the profiler
+    virtual const char* testName() = 0;
+    
+    // run operation on both dictionary implementations
+    virtual void runCurrent() = 0;
+    virtual void runLegacy() = 0;
+
+    void updateQuantityLabel();
+    virtual void updateKeys();
+
+    int getQuantityOfKeys() { return quantityOfKeys; }
+
+    void dumpProfilerInfo(float dt);
+
+    // overrides
+    virtual void onExitTransitionDidStart();
+    virtual void onEnterTransitionDidFinish();
+
+protected:
+    char   _currentName[256];
+    char   _legacyName[256];
+    int    lastRenderedCount;
+    int    quantityOfKeys;
+    std::vector<std::string> keys;
+    CCString* value;
+};
+
+class DictionaryInsertTest : public PerformceDictionaryScene
+{
+public:
+    virtual void runCurrent();
+    virtual void runLegacy();
+    virtual const char* testName();
+
+    std::string title();
+    std::string subtitle();
+};
+
+class DictionaryLookupTest : public PerformceDictionaryScene
+{
+public:
+    DictionaryLookupTest();
+    virtual ~DictionaryLookupTest();
+    
+    virtual void updateKeys();
+    virtual void runCurrent();
+    virtual void runLegacy();
+    virtual const char* testName();
+
+    std::string title();
+    std::string subtitle();
+    
+protected:
+    CCDictionary* dict;
+    void* legacy;
+};
+
+class DictionaryIterateTest : public DictionaryLookupTest
+{
+public:
+    virtual void runCurrent();
+    virtual void runLegacy();
+    virtual const char* testName();
+
+    std::string title();
+    std::string subtitle();
+};
+
+void runDictionaryPerformanceTest();
+
+#endif // __PERFORMANCE_DICTIONARY_TEST_H__
@@ -6,10 +6,11 @@
 #include "PerformanceTextureTest.h"
 #include "PerformanceTouchesTest.h"
 #include "PerformanceAllocTest.h"
+#include "PerformanceDictionaryTest.h"
 
 enum
 {
-    MAX_COUNT = 6,
+    MAX_COUNT = 7,
     LINE_SPACE = 40,
     kItemTagBasic = 1000,
 };
@@ -22,6 +23,7 @@ const std::string testsName[MAX_COUNT] =
     "Perf Texture Test",
     "Perf Touches Test",
     "Perf Alloc Test",
+    "Perf Dictionary Test",
 };
 
 ////////////////////////////////////////////////////////
@@ -75,6 +77,9 @@ void PerformanceMainLayer::menuCallback(CCObject* pSender)
     case 5:
         runAllocPerformanceTest();
         break;
+    case 6:
+        runDictionaryPerformanceTest();
+        break;
     default:
         break;
     }
@@ -1271,7 +1271,7 @@ enum
 
 static int sceneIdx = -1; 
 
-#define MAX_LAYER 27
+#define MAX_LAYER 28
 
 CCLayer* createTileMapLayer(int nIndex)
 {
@@ -1304,6 +1304,7 @@ CCLayer* createTileMapLayer(int nIndex)
         case 24: return new TMXBug987();
         case 25: return new TMXBug787();
         case 26: return new TMXGIDObjectsTest();
+        case 27: return new TMXOrthoChunkedTest();
     }
 
     return NULL;
@@ -1504,3 +1505,44 @@ string TMXGIDObjectsTest::subtitle()
 {
     return "Tiles are created from an object group";
 }
+
+//------------------------------------------------------------------
+//
+// TMXOrthoChunkedTest
+//
+//------------------------------------------------------------------
+TMXOrthoChunkedTest::TMXOrthoChunkedTest()
+{
+    CCTMXTiledMap* map = CCTMXTiledMap::create("TileMaps/orthogonal-test2.tmx", 8);
+    addChild(map, 0, kTagTileMap);
+
+    CCSize s = map->getContentSize();
+    CCLOG("ContentSize: %f, %f", s.width,s.height);
+
+    // scroll so that chunks are recycled
+    CCSize winSize = CCDirector::sharedDirector()->getWinSize();
+    CCActionInterval* move = CCMoveBy::create(10, ccp(winSize.width - s.width, 0));
+    map->runAction(CCRepeatForever::create(CCSequence::create(move, move->reverse(), NULL)));
+
+    schedule(schedule_selector(TMXOrthoChunkedTest::removeTiles), 1.0f);
+}
+
+void TMXOrthoChunkedTest::removeTiles(float dt)
+{
+    // tile sprite pins its chunk, removing it gives the chunk back to the pool
+    CCTMXTiledMap* map = (CCTMXTiledMap*)getChildByTag(kTagTileMap);
+    CCTMXLayer* layer = map->getLayerAt(0);
+    CCSprite* tile = layer->tileAt(CCRANDOM_0_1() * (layer->getLayerWidth() - 1), 0);
+    if(tile)
+        layer->removeTile(tile);
+}
+
+std::string TMXOrthoChunkedTest::title()
+{
+    return "TMX Chunked Layer";
+}
+
+std::string TMXOrthoChunkedTest::subtitle()
+{
+    return "Only chunks near screen have quads";
+}
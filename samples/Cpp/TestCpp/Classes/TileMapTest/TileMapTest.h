@@ -277,6 +277,16 @@ public:
     virtual void draw();
 };
 
+class TMXOrthoChunkedTest : public TileDemo
+{
+public:
+    TMXOrthoChunkedTest();
+    virtual std::string title();
+    virtual std::string subtitle();
+
+    void removeTiles(float dt);
+};
+
 class TileMapTestScene : public TestScene
 {
 public:
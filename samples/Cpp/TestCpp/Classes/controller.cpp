@@ -114,6 +114,8 @@ static TestScene* CreateTestScene(int nIdx)
 #if (CC_TARGET_PLATFORM != CC_PLATFORM_BADA && CC_TARGET_PLATFORM != CC_PLATFORM_NACL && CC_TARGET_PLATFORM != CC_PLATFORM_MARMALADE && CC_TARGET_PLATFORM != CC_PLATFORM_EMSCRIPTEN && CC_TARGET_PLATFORM != CC_PLATFORM_WINRT)
     case TEST_CURL:
         pScene = new CurlTestScene(); break;
+    case TEST_NETWORK:
+        pScene = new NetworkTestScene(); break;
 #endif
     case TEST_USERDEFAULT:
         pScene = new UserDefaultTestScene(); break;
@@ -37,6 +37,7 @@
 // bada don't support libcurl
 #if (CC_TARGET_PLATFORM != CC_PLATFORM_BADA)
 #include "CurlTest/CurlTest.h"
+#include "NetworkTest/NetworkTest.h"
 #endif
 #endif
 #endif
@@ -99,6 +100,7 @@ enum
 #if (CC_TARGET_PLATFORM != CC_PLATFORM_MARMALADE)
 #if (CC_TARGET_PLATFORM != CC_PLATFORM_BADA)
     TEST_CURL,
+    TEST_NETWORK,
 #endif
 #endif
     TEST_USERDEFAULT,
@@ -162,6 +164,7 @@ const std::string g_aTestNames[TESTS_COUNT] = {
 #if (CC_TARGET_PLATFORM != CC_PLATFORM_MARMALADE)
 #if (CC_TARGET_PLATFORM != CC_PLATFORM_BADA)
     "CurlTest",
+    "NetworkTest",
 #endif
 #endif
 #endif
@@ -28,6 +28,9 @@
 #include "CCScheduler.h"
 #include "cocos-ext.h"
 #include "LuaBasicConversions.h"
+#include "CCLuaScriptCache.h"
+#include "CCLuaProfiler.h"
+#include "tolua_fix.h"
 
 NS_CC_BEGIN
 
@@ -45,7 +48,10 @@ CCLuaEngine* CCLuaEngine::defaultEngine(void)
 
 CCLuaEngine::~CCLuaEngine(void)
 {
+    clearScheduleBatch();
     CC_SAFE_RELEASE(m_stack);
+    CCLuaScriptCache::purgeSharedScriptCache();
+    CCLuaProfiler::purgeSharedProfiler();
     m_defaultEngine = NULL;
 }
 
@@ -151,6 +157,7 @@ int CCLuaEngine::executeCallFuncActionEvent(CCCallFunc* pAction, CCObject* pTarg
             m_stack->pushCCObject(pTarget, getLuaTypeNameByTypeId(typeid(*pTarget).name()));
         } while(false);
     }
+    CC_LUA_PROFILE_HANDLER("action");
     int ret = m_stack->executeFunctionByHandler(func.handler, (pTarget ? 1 : 0) + (func.target ? 1 : 0));
     m_stack->clean();
     return ret;
@@ -160,16 +167,226 @@ int CCLuaEngine::executeSchedule(ccScriptFunction& func, float dt)
 {
     if (!func.handler) return 0;
     
+    // queue it, scheduler will flush at the end of update
+    if (m_scheduleBatchEnabled)
+    {
+        ScheduleBatchEntry e = { func.handler, func.target, CCDirector::sharedDirector()->getScheduler()->getCurrentScriptEntry(), dt };
+        CC_SAFE_RETAIN(e.target);
+        CC_SAFE_RETAIN(e.entry);
+        m_scheduleBatch.push_back(e);
+        return 0;
+    }
+    
     if(func.target) {
         m_stack->pushCCObject(func.target, getLuaTypeNameByTypeId(typeid(*func.target).name()));
     }
     m_stack->pushFloat(dt);
     
+    CC_LUA_PROFILE_HANDLER("schedule");
     int ret = m_stack->executeFunctionByHandler(func.handler, func.target ? 2 : 1);
     m_stack->clean();
     return ret;
 }
 
+void CCLuaEngine::flushScheduleBatch()
+{
+    if (m_scheduleBatch.empty()) return;
+    
+    // take queue, functions may schedule others while they are running
+    std::vector<ScheduleBatchEntry> batch;
+    batch.swap(m_scheduleBatch);
+    
+    lua_State* L = m_stack->getLuaState();
+    lua_getglobal(L, "__G__DISPATCH_SCHEDULES__");                      /* L: dispatcher */
+    if (lua_isfunction(L, -1))
+    {
+        // skip function unscheduled after it is queued, it is only marked until next update. Previous
+        // function in list may also unschedule it, so dispatcher checks it again by alive function
+        std::vector<ScheduleBatchEntry*> dispatching;
+        std::vector<ScheduleBatchEntry*>* lastDispatching = m_dispatchingBatch;
+        m_dispatchingBatch = &dispatching;
+        lua_createtable(L, (int)batch.size() * 3, 0);                    /* L: dispatcher list */
+        int index = 1;
+        for (std::vector<ScheduleBatchEntry>::iterator iter = batch.begin(); iter != batch.end(); iter++)
+        {
+            if (!isScheduleBatchEntryAlive(*iter))
+            {
+                continue;
+            }
+            dispatching.push_back(&(*iter));
+            toluafix_get_function_by_refid(L, iter->handler);          /* L: dispatcher list func */
+            lua_rawseti(L, -2, index++);
+            if (iter->target)
+            {
+                m_stack->pushCCObject(iter->target, getLuaTypeNameByTypeId(typeid(*iter->target).name()));
+            }
+            else
+            {
+                lua_pushboolean(L, 0);
+            }
+            lua_rawseti(L, -2, index++);
+            lua_pushnumber(L, iter->dt);
+            lua_rawseti(L, -2, index++);
+        }
+        lua_pushlightuserdata(L, this);                                 /* L: dispatcher list engine */
+        lua_pushcclosure(L, isScheduleBatchFunctionAlive, 1);           /* L: dispatcher list alive */
+        CC_LUA_PROFILE_HANDLER("schedule batch");
+        m_stack->executeFunction(2);
+        m_stack->clean();
+        m_dispatchingBatch = lastDispatching;
+    }
+    else
+    {
+        // no dispatcher, call one by one
+        lua_pop(L, 1);
+        for (std::vector<ScheduleBatchEntry>::iterator iter = batch.begin(); iter != batch.end(); iter++)
+        {
+            // previous function may unschedule this one
+            if (!isScheduleBatchEntryAlive(*iter))
+            {
+                continue;
+            }
+            if (iter->target)
+            {
+                m_stack->pushCCObject(iter->target, getLuaTypeNameByTypeId(typeid(*iter->target).name()));
+            }
+            m_stack->pushFloat(iter->dt);
+            CC_LUA_PROFILE_HANDLER("schedule");
+            m_stack->executeFunctionByHandler(iter->handler, iter->target ? 2 : 1);
+            m_stack->clean();
+        }
+    }
+    
+    for (std::vector<ScheduleBatchEntry>::iterator iter = batch.begin(); iter != batch.end(); iter++)
+    {
+        CC_SAFE_RELEASE(iter->target);
+        CC_SAFE_RELEASE(iter->entry);
+    }
+}
+
+bool CCLuaEngine::isScheduleBatchEntryAlive(const ScheduleBatchEntry& e)
+{
+    if (e.entry && e.entry->isMarkedForDeletion())
+    {
+        return false;
+    }
+    
+    // handler is removed if entry is released, check it without logging error
+    lua_State* L = m_stack->getLuaState();
+    toluafix_get_function_by_refid(L, e.handler);
+    bool alive = lua_isfunction(L, -1);
+    lua_pop(L, 1);
+    return alive;
+}
+
+int CCLuaEngine::isScheduleBatchFunctionAlive(lua_State* L)
+{
+    // argument is index of function in dispatched list
+    CCLuaEngine* engine = (CCLuaEngine*)lua_touserdata(L, lua_upvalueindex(1));
+    int i = ((int)luaL_checkinteger(L, 1) - 1) / 3;
+    bool alive = false;
+    if (engine->m_dispatchingBatch && i >= 0 && i < (int)engine->m_dispatchingBatch->size())
+    {
+        alive = engine->isScheduleBatchEntryAlive(*(*engine->m_dispatchingBatch)[i]);
+    }
+    lua_pushboolean(L, alive);
+    return 1;
+}
+
+void CCLuaEngine::setScheduleBatchEnabled(bool enabled)
+{
+    if (m_scheduleBatchEnabled == enabled) return;
+    m_scheduleBatchEnabled = enabled;
+    if (!enabled)
+    {
+        flushScheduleBatch();
+    }
+}
+
+void CCLuaEngine::setGCPacingEnabled(bool enabled)
+{
+    if (m_gcPacingEnabled == enabled) return;
+    m_gcPacingEnabled = enabled;
+    
+    lua_State* L = m_stack->getLuaState();
+    if (enabled)
+    {
+        // read pause of collector, it is used to idle after a cycle
+        m_gcPause = lua_gc(L, LUA_GCSETPAUSE, 200);
+        lua_gc(L, LUA_GCSETPAUSE, m_gcPause);
+        m_gcLastHeap = lua_gc(L, LUA_GCCOUNT, 0);
+        m_gcIdleUntil = 0;
+        deferAutomaticGC();
+    }
+    else
+    {
+        lua_gc(L, LUA_GCRESTART, 0);
+    }
+    m_gcTime = 0;
+}
+
+void CCLuaEngine::onFrameEnd(float timeLeft)
+{
+    if (!m_gcPacingEnabled) return;
+    
+    // idle after a cycle, until heap grows as automatic collector waits
+    lua_State* L = m_stack->getLuaState();
+    int heap = lua_gc(L, LUA_GCCOUNT, 0);
+    if (heap < m_gcIdleUntil)
+    {
+        m_gcLastHeap = heap;
+        m_gcTime = 0;
+        return;
+    }
+    
+    // a step pays for 1KB allocation in automatic mode, so do at least as many steps
+    // as KB allocated in this frame, then use spare time until cycle is finished
+    int64_t start = CCLuaProfiler::now();
+    int64_t budget = (int64_t)(MIN(timeLeft, m_gcMaxStepTime) * 1000000);
+    int steps = MAX(1, heap - m_gcLastHeap);
+    bool finished = false;
+    while (!finished && (steps-- > 0 || CCLuaProfiler::now() - start < budget))
+    {
+        finished = lua_gc(L, LUA_GCSTEP, 0) != 0;
+    }
+    
+    // stepping restarts automatic collection, defer it again
+    deferAutomaticGC();
+    m_gcLastHeap = lua_gc(L, LUA_GCCOUNT, 0);
+    if (finished)
+    {
+        m_gcIdleUntil = m_gcLastHeap * m_gcPause / 100;
+    }
+    m_gcTime = (CCLuaProfiler::now() - start) / 1000000.0f;
+}
+
+void CCLuaEngine::deferAutomaticGC()
+{
+    // don't stop collector, a frame allocating a lot may run out of memory before it ends. Move
+    // threshold of automatic collector to twice the pause, so it only runs if heap grows that far
+    lua_State* L = m_stack->getLuaState();
+    lua_gc(L, LUA_GCSETPAUSE, m_gcPause * 2);
+    lua_gc(L, LUA_GCRESTART, -1);
+    lua_gc(L, LUA_GCSETPAUSE, m_gcPause);
+}
+
+bool CCLuaEngine::getGCStats(float* gcTime, unsigned int* heapSize)
+{
+    *gcTime = m_gcTime;
+    *heapSize = (unsigned int)lua_gc(m_stack->getLuaState(), LUA_GCCOUNT, 0);
+    return true;
+}
+
+void CCLuaEngine::clearScheduleBatch()
+{
+    for (std::vector<ScheduleBatchEntry>::iterator iter = m_scheduleBatch.begin(); iter != m_scheduleBatch.end(); iter++)
+    {
+        CC_SAFE_RELEASE(iter->target);
+        CC_SAFE_RELEASE(iter->entry);
+    }
+    m_scheduleBatch.clear();
+}
+
 int CCLuaEngine::executeLayerTouchEvent(CCLayer* pLayer, const char* pEventName, CCTouch *pTouch)
 {
     CCTouchScriptHandlerEntry* pScriptHandlerEntry = pLayer->getScriptTouchHandlerEntry();
@@ -186,6 +403,7 @@ int CCLuaEngine::executeLayerTouchEvent(CCLayer* pLayer, const char* pEventName,
     m_stack->pushFloat(pt.x);
     m_stack->pushFloat(pt.y);
     m_stack->pushInt(pTouch->getID());
+    CC_LUA_PROFILE_HANDLER("touch");
     int ret = m_stack->executeFunctionByHandler(func.handler, func.target ? 5 : 4);
     m_stack->clean();
     return ret;
@@ -218,6 +436,7 @@ int CCLuaEngine::executeLayerTouchesEvent(CCLayer* pLayer, const char* pEventNam
         lua_pushinteger(L, pTouch->getID());
         lua_rawseti(L, -2, i++);
     }
+    CC_LUA_PROFILE_HANDLER("touch");
     int ret = m_stack->executeFunctionByHandler(func.handler, func.target ? 3 : 2);
     m_stack->clean();
     return ret;
@@ -235,6 +454,7 @@ int CCLuaEngine::executeAccelerometerEvent(ccScriptFunction& func, CCAcceleratio
     m_stack->pushFloat(pAccelerationValue->y);
     m_stack->pushFloat(pAccelerationValue->z);
     m_stack->pushFloat(pAccelerationValue->timestamp);
+    CC_LUA_PROFILE_HANDLER("accelerometer");
     int ret = m_stack->executeFunctionByHandler(func.handler, func.target ? 5 : 4);
     m_stack->clean();
     return ret;
@@ -245,6 +465,7 @@ int CCLuaEngine::executeEvent(ccScriptFunction& func, const char* pEventName, CC
         m_stack->pushCCObject(func.target, getLuaTypeNameByTypeId(typeid(*func.target).name()));
     }
     m_stack->pushString(pEventName);
+    CC_LUA_PROFILE_HANDLER("event");
     int ret = m_stack->executeFunctionByHandler(func.handler, func.target ? 2 : 1, collector, sel);
     m_stack->clean();
     return ret;
@@ -317,6 +538,7 @@ int CCLuaEngine::executeEventWithArgs(ccScriptFunction& func, CCArray* pArgs, CC
         }
     }
     
+    CC_LUA_PROFILE_HANDLER("event");
     return  m_stack->executeFunctionByHandler(func.handler, nArgNums, collector, sel);
 }
 
@@ -126,6 +126,9 @@ public:
 
     virtual int executeCallFuncActionEvent(CCCallFunc* pAction, CCObject* pTarget = NULL);
     virtual int executeSchedule(ccScriptFunction& func, float dt);
+    virtual void flushScheduleBatch();
+    virtual void onFrameEnd(float timeLeft);
+    virtual bool getGCStats(float* gcTime, unsigned int* heapSize);
     virtual int executeLayerTouchesEvent(CCLayer* pLayer, const char* pEventName, CCSet *pTouches);
     virtual int executeLayerTouchEvent(CCLayer* pLayer, const char* pEventName, CCTouch *pTouch);
     
@@ -142,16 +145,82 @@ public:
     virtual bool handleAssert(const char *msg);
     virtual bool parseConfig(CCScriptEngineProtocol::ConfigType type, const std::string& str);
     
+    /**
+     @brief Enable or disable schedule batch mode. In batch mode, schedule functions due in a frame
+     are queued and delivered to global lua function __G__DISPATCH_SCHEDULES__ in one call, at the end
+     of scheduler update. The arguments are a flat array of function, target (false if none) and dt, and
+     a function which returns false if function at given index of array is unscheduled by a previous
+     one. If dispatcher is not defined, queued functions are called one by one. Disabling flushes queue.
+     */
+    void setScheduleBatchEnabled(bool enabled);
+    bool isScheduleBatchEnabled() { return m_scheduleBatchEnabled; }
+    
+    /**
+     @brief Enable or disable gc pacing. When enabled, automatic garbage collection is deferred and
+     collector is stepped at the end of every frame instead. It does at least the work automatic
+     collector would do for memory allocated in the frame, and keeps stepping while frame has spare
+     time, up to max step time. A finished cycle pauses collection like automatic collector does.
+     Automatic collection still runs if heap grows to twice the pause within frames.
+     */
+    void setGCPacingEnabled(bool enabled);
+    bool isGCPacingEnabled() { return m_gcPacingEnabled; }
+    
+    /// max seconds spent in collection at the end of a frame, default is 0.002
+    void setGCMaxStepTime(float t) { m_gcMaxStepTime = t; }
+    float getGCMaxStepTime() { return m_gcMaxStepTime; }
+    
 private:
     CCLuaEngine(void)
     : m_stack(NULL)
+    , m_scheduleBatchEnabled(false)
+    , m_dispatchingBatch(NULL)
+    , m_gcPacingEnabled(false)
+    , m_gcMaxStepTime(0.002f)
+    , m_gcPause(200)
+    , m_gcLastHeap(0)
+    , m_gcIdleUntil(0)
+    , m_gcTime(0)
     {
     }
     
     bool init(void);
     
+    /// release queued schedule functions
+    void clearScheduleBatch();
+    
+    /// move threshold of automatic gc far from current heap size, frame end steps collector instead
+    void deferAutomaticGC();
+    
     static CCLuaEngine* m_defaultEngine;
     CCLuaStack *m_stack;
+    
+    /// queued schedule function, target and scheduler entry are retained until it is delivered
+    typedef struct {
+        unsigned int handler;
+        CCObject* target;
+        CCSchedulerScriptHandlerEntry* entry;
+        float dt;
+    } ScheduleBatchEntry;
+    
+    /// false if queued schedule function is unscheduled or released
+    bool isScheduleBatchEntryAlive(const ScheduleBatchEntry& e);
+    
+    /// alive function passed to dispatcher, upvalue is engine
+    static int isScheduleBatchFunctionAlive(lua_State* L);
+    
+    bool m_scheduleBatchEnabled;
+    std::vector<ScheduleBatchEntry> m_scheduleBatch;
+    
+    /// entries in list of running dispatcher, by order
+    std::vector<ScheduleBatchEntry*>* m_dispatchingBatch;
+    
+    /// gc pacing, heap sizes are in KB
+    bool m_gcPacingEnabled;
+    float m_gcMaxStepTime;
+    int m_gcPause;
+    int m_gcLastHeap;
+    int m_gcIdleUntil;
+    float m_gcTime;
 };
 
 NS_CC_END
@@ -0,0 +1,226 @@
+/****************************************************************************
+ Author: Luma (stubma@gmail.com)
+
+ https://github.com/stubma/cocos2dx-classical
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+#include "CCLuaProfiler.h"
+#include "cocos2d.h"
+#include <sys/time.h>
+#include <stdio.h>
+#include <vector>
+#include <algorithm>
+
+extern "C" {
+#include "luajit.h"
+}
+
+NS_CC_BEGIN
+
+/// max depth of a sampled stack
+#define MAX_SAMPLE_DEPTH 64
+
+static CCLuaProfiler* s_sharedProfiler = NULL;
+
+/// sort counters by total time, longest first
+typedef pair<string, CCLuaProfiler::Counter> NamedCounter;
+static bool compareTotalTime(const NamedCounter& a, const NamedCounter& b) {
+    return a.second.totalTime > b.second.totalTime;
+}
+
+/// relative path is in writable path
+static string profilePath(const string& path) {
+    if(CCFileUtils::sharedFileUtils()->isAbsolutePath(path))
+        return path;
+    return CCFileUtils::sharedFileUtils()->getWritablePath() + path;
+}
+
+CCLuaProfiler::CCLuaProfiler() :
+m_handlerCategory(NULL),
+m_countersEnabled(false),
+m_sampledState(NULL) {
+}
+
+CCLuaProfiler::~CCLuaProfiler() {
+    stopSampling();
+}
+
+CCLuaProfiler* CCLuaProfiler::sharedProfiler() {
+    if(!s_sharedProfiler) {
+        s_sharedProfiler = new CCLuaProfiler();
+    }
+    return s_sharedProfiler;
+}
+
+void CCLuaProfiler::purgeSharedProfiler() {
+    CC_SAFE_RELEASE_NULL(s_sharedProfiler);
+}
+
+int64_t CCLuaProfiler::now() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+void CCLuaProfiler::addTime(Counter& c, int64_t time) {
+    c.calls++;
+    c.totalTime += time;
+    c.maxTime = MAX(c.maxTime, time);
+}
+
+void CCLuaProfiler::addBindingCall(const char* name, int64_t time) {
+    BindingCounterMap::iterator iter = m_bindingCounters.find(name);
+    if(iter == m_bindingCounters.end()) {
+        Counter c = { 0, 0, 0 };
+        iter = m_bindingCounters.insert(make_pair(name, c)).first;
+    }
+    addTime(iter->second, time);
+}
+
+string CCLuaProfiler::handlerName(lua_State* L, int funcIndex) {
+    lua_Debug ar;
+    lua_pushvalue(L, funcIndex);
+    lua_getinfo(L, ">S", &ar);
+    char buf[512];
+    snprintf(buf, sizeof(buf), "%s|%s:%d", m_handlerCategory ? m_handlerCategory : "handler", ar.short_src, ar.linedefined);
+    m_handlerCategory = NULL;
+    return buf;
+}
+
+void CCLuaProfiler::addHandlerCall(const string& name, int64_t time) {
+    HandlerCounterMap::iterator iter = m_handlerCounters.find(name);
+    if(iter == m_handlerCounters.end()) {
+        Counter c = { 0, 0, 0 };
+        iter = m_handlerCounters.insert(make_pair(name, c)).first;
+    }
+    addTime(iter->second, time);
+}
+
+void CCLuaProfiler::resetCounters() {
+    m_bindingCounters.clear();
+    m_handlerCounters.clear();
+}
+
+bool CCLuaProfiler::dumpCounters(const string& path) {
+    // merge and sort
+    vector<NamedCounter> counters;
+    for(BindingCounterMap::iterator iter = m_bindingCounters.begin(); iter != m_bindingCounters.end(); iter++) {
+        counters.push_back(NamedCounter(string("binding|") + iter->first, iter->second));
+    }
+    for(HandlerCounterMap::iterator iter = m_handlerCounters.begin(); iter != m_handlerCounters.end(); iter++) {
+        counters.push_back(*iter);
+    }
+    sort(counters.begin(), counters.end(), compareTotalTime);
+
+    // write
+    string fullPath = profilePath(path);
+    FILE* f = fopen(fullPath.c_str(), "wb");
+    if(!f) {
+        CCLOGWARN("can't write lua counters to %s", fullPath.c_str());
+        return false;
+    }
+    fprintf(f, "# name\tcalls\ttotal(us)\tavg(us)\tmax(us)\n");
+    for(vector<NamedCounter>::iterator iter = counters.begin(); iter != counters.end(); iter++) {
+        Counter& c = iter->second;
+        fprintf(f, "%s\t%u\t%lld\t%lld\t%lld\n",
+                iter->first.c_str(),
+                c.calls,
+                (long long)c.totalTime,
+                (long long)(c.calls > 0 ? c.totalTime / c.calls : 0),
+                (long long)c.maxTime);
+    }
+    fclose(f);
+    return true;
+}
+
+void CCLuaProfiler::sampleHook(lua_State* L, lua_Debug* ar) {
+    if(s_sharedProfiler) {
+        s_sharedProfiler->sample(L);
+    }
+}
+
+void CCLuaProfiler::sample(lua_State* L) {
+    // collect frames from top to bottom
+    string frames[MAX_SAMPLE_DEPTH];
+    int depth = 0;
+    lua_Debug ar;
+    char buf[512];
+    while(depth < MAX_SAMPLE_DEPTH && lua_getstack(L, depth, &ar)) {
+        lua_getinfo(L, "Sn", &ar);
+        if(ar.what && !strcmp(ar.what, "C")) {
+            snprintf(buf, sizeof(buf), "[C] %s", ar.name ? ar.name : "?");
+        } else if(ar.what && !strcmp(ar.what, "main")) {
+            snprintf(buf, sizeof(buf), "main %s", ar.short_src);
+        } else {
+            snprintf(buf, sizeof(buf), "%s %s:%d", ar.name ? ar.name : "?", ar.short_src, ar.linedefined);
+        }
+
+        // semicolon separates frames in folded format
+        for(char* p = buf; *p; p++) {
+            if(*p == ';')
+                *p = ':';
+        }
+        frames[depth++] = buf;
+    }
+    if(depth == 0)
+        return;
+
+    // folded stack is from root to leaf
+    string stack = frames[depth - 1];
+    for(int i = depth - 2; i >= 0; i--) {
+        stack += ';';
+        stack += frames[i];
+    }
+    m_samples[stack]++;
+}
+
+void CCLuaProfiler::startSampling(lua_State* L, int instructions) {
+    stopSampling();
+    m_sampledState = L;
+
+    // hooks are not called in compiled code
+    luaJIT_setmode(L, 0, LUAJIT_MODE_ENGINE | LUAJIT_MODE_FLUSH);
+    luaJIT_setmode(L, 0, LUAJIT_MODE_ENGINE | LUAJIT_MODE_OFF);
+    lua_sethook(L, sampleHook, LUA_MASKCOUNT, MAX(1, instructions));
+}
+
+void CCLuaProfiler::stopSampling() {
+    if(m_sampledState) {
+        lua_sethook(m_sampledState, NULL, 0, 0);
+        luaJIT_setmode(m_sampledState, 0, LUAJIT_MODE_ENGINE | LUAJIT_MODE_ON);
+        m_sampledState = NULL;
+    }
+}
+
+bool CCLuaProfiler::dumpSamples(const string& path) {
+    string fullPath = profilePath(path);
+    FILE* f = fopen(fullPath.c_str(), "wb");
+    if(!f) {
+        CCLOGWARN("can't write lua samples to %s", fullPath.c_str());
+        return false;
+    }
+    for(SampleMap::iterator iter = m_samples.begin(); iter != m_samples.end(); iter++) {
+        fprintf(f, "%s %u\n", iter->first.c_str(), iter->second);
+    }
+    fclose(f);
+    return true;
+}
+
+NS_CC_END
@@ -0,0 +1,201 @@
+/****************************************************************************
+ Author: Luma (stubma@gmail.com)
+
+ https://github.com/stubma/cocos2dx-classical
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+#ifndef __CCLuaProfiler__
+#define __CCLuaProfiler__
+
+extern "C" {
+#include "lua.h"
+}
+
+#include "ccConfig.h"
+#include "cocoa/CCObject.h"
+#include <string>
+#include <map>
+#include <stdint.h>
+
+using namespace std;
+
+NS_CC_BEGIN
+
+/**
+ * Profiler of lua scripts, it has two parts:
+ *
+ * \par
+ * Call counters: count calls and time of every bound native function and every script handler,
+ * such as schedule, touch and notification handlers. Bindings are instrumented only when
+ * CC_LUA_PROFILER is enabled in ccConfig.h, and counting starts when counters are enabled.
+ *
+ * \par
+ * Sampling profiler: a count hook samples lua call stack every N vm instructions. Samples are
+ * dumped in folded format, one stack per line with sample count, which can be rendered by
+ * flamegraph.pl or speedscope. JIT is turned off while sampling because hooks are not called
+ * in compiled code, so sampling slows script down.
+ */
+class CCLuaProfiler : public CCObject {
+public:
+    /// counter of a function
+    struct Counter {
+        unsigned int calls;
+        int64_t totalTime;
+        int64_t maxTime;
+    };
+
+private:
+    /// counters of bound functions, key is a string literal in binding code
+    typedef map<const char*, Counter> BindingCounterMap;
+    BindingCounterMap m_bindingCounters;
+
+    /// counters of script handlers, key is category and location of lua function
+    typedef map<string, Counter> HandlerCounterMap;
+    HandlerCounterMap m_handlerCounters;
+
+    /// sampled stacks and their count
+    typedef map<string, unsigned int> SampleMap;
+    SampleMap m_samples;
+
+    /// category of next script handler
+    const char* m_handlerCategory;
+
+    /// counters enabled or not
+    bool m_countersEnabled;
+
+    /// lua state being sampled, or NULL
+    lua_State* m_sampledState;
+
+protected:
+    CCLuaProfiler();
+
+    /// count hook
+    static void sampleHook(lua_State* L, lua_Debug* ar);
+
+    /// record current lua stack as a sample
+    void sample(lua_State* L);
+
+    /// add time to a counter
+    static void addTime(Counter& c, int64_t time);
+
+public:
+    virtual ~CCLuaProfiler();
+
+    /// get shared instance
+    static CCLuaProfiler* sharedProfiler();
+
+    /// stop sampling and release shared instance
+    static void purgeSharedProfiler();
+
+    /// current time in microseconds
+    static int64_t now();
+
+    /// enable or disable call counters, disabled by default
+    void setCountersEnabled(bool flag) { m_countersEnabled = flag; }
+    bool isCountersEnabled() { return m_countersEnabled; }
+
+    /// add a call of bound function, name must be a string literal
+    void addBindingCall(const char* name, int64_t time);
+
+    /// set category of next script handler call, such as schedule or touch
+    void setHandlerCategory(const char* category) { m_handlerCategory = category; }
+
+    /**
+     * get name of a script handler, it is category set by setHandlerCategory and location of
+     * handler function. Category is reset after it is used
+     *
+     * @param L lua state
+     * @param funcIndex stack index of handler function
+     */
+    string handlerName(lua_State* L, int funcIndex);
+
+    /// add a call of script handler, time is in microseconds
+    void addHandlerCall(const string& name, int64_t time);
+
+    /// clear all counters
+    void resetCounters();
+
+    /**
+     * save counters as text, one function per line, sorted by total time
+     *
+     * @param path file path, relative path is appended to writable path
+     * @return true if saved
+     */
+    bool dumpCounters(const string& path = "lua_counters.txt");
+
+    /**
+     * start sampling a lua state
+     *
+     * @param L lua state
+     * @param instructions sample once every this count of vm instructions
+     */
+    void startSampling(lua_State* L, int instructions = 1000);
+
+    /// stop sampling, samples are kept until cleared
+    void stopSampling();
+
+    /// is sampling or not
+    bool isSampling() { return m_sampledState != NULL; }
+
+    /// clear all samples
+    void resetSamples() { m_samples.clear(); }
+
+    /**
+     * save samples in folded stack format
+     *
+     * @param path file path, relative path is appended to writable path
+     * @return true if saved
+     */
+    bool dumpSamples(const string& path = "lua_samples.folded");
+};
+
+/// count time of a bound function call in current scope
+class CCLuaProfileScope {
+private:
+    const char* m_name;
+    int64_t m_start;
+
+public:
+    CCLuaProfileScope(const char* name) : m_name(NULL) {
+        if(CCLuaProfiler::sharedProfiler()->isCountersEnabled()) {
+            m_name = name;
+            m_start = CCLuaProfiler::now();
+        }
+    }
+
+    ~CCLuaProfileScope() {
+        if(m_name) {
+            CCLuaProfiler::sharedProfiler()->addBindingCall(m_name, CCLuaProfiler::now() - m_start);
+        }
+    }
+};
+
+NS_CC_END
+
+/// profiling macros, they are empty if profiler is not enabled
+#if CC_LUA_PROFILER
+    #define CC_LUA_PROFILE_BINDING(name) cocos2d::CCLuaProfileScope __luaProfileScope(name)
+    #define CC_LUA_PROFILE_HANDLER(category) cocos2d::CCLuaProfiler::sharedProfiler()->setHandlerCategory(category)
+#else
+    #define CC_LUA_PROFILE_BINDING(name)
+    #define CC_LUA_PROFILE_HANDLER(category)
+#endif
+
+#endif /* defined(__CCLuaProfiler__) */
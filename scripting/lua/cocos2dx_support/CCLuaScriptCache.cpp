@@ -0,0 +1,410 @@
+/****************************************************************************
+ Author: Luma (stubma@gmail.com)
+
+ https://github.com/stubma/cocos2dx-classical
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+#include "CCLuaScriptCache.h"
+#include "cocos2d.h"
+#include "support/utils/CCUtils.h"
+#include "support/codec/hash_bob_jenkins_v2.h"
+#include <dirent.h>
+#include <set>
+#include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+extern "C" {
+#include "lauxlib.h"
+#include "luajit.h"
+}
+
+NS_CC_BEGIN
+
+/// magic and version of script bundle, see tools/luabundle
+#define BUNDLE_MAGIC "CCLB"
+#define BUNDLE_VERSION 1
+
+static CCLuaScriptCache* s_sharedScriptCache = NULL;
+
+static uint32_t readU32(const unsigned char* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t readU16(const unsigned char* p) {
+    return p[0] | (p[1] << 8);
+}
+
+/// length of chunk name hash at start of bytecode file name
+#define CHUNK_KEY_LENGTH 8
+
+/// delete a cache folder, it only has files
+static void deleteCacheFolder(const string& path) {
+    DIR* dir = opendir(path.c_str());
+    if(dir) {
+        struct dirent* entry;
+        while((entry = readdir(dir)) != NULL) {
+            if(strcmp(entry->d_name, ".") && strcmp(entry->d_name, "..")) {
+                CCUtils::deleteFile(path + "/" + entry->d_name);
+            }
+        }
+        closedir(dir);
+    }
+    rmdir(path.c_str());
+}
+
+/// lua_dump writer, appends to a string
+static int writeChunk(lua_State* L, const void* p, size_t sz, void* ud) {
+    ((string*)ud)->append((const char*)p, sz);
+    return 0;
+}
+
+CCLuaScriptCache::CCLuaScriptCache() :
+m_cacheOpened(false),
+m_bytecodeCacheEnabled(true),
+m_cacheDecryptedScripts(false),
+m_cacheHitCount(0),
+m_cacheMissCount(0) {
+    // bytecode is not compatible between LuaJIT versions
+    char buf[64];
+    sprintf(buf, "%d/", LUAJIT_VERSION_NUM);
+    m_cacheRoot = CCFileUtils::sharedFileUtils()->getWritablePath() + "luacache/";
+    m_cacheDir = m_cacheRoot + buf;
+}
+
+CCLuaScriptCache::~CCLuaScriptCache() {
+    removeAllBundles();
+}
+
+CCLuaScriptCache* CCLuaScriptCache::sharedScriptCache() {
+    if(!s_sharedScriptCache) {
+        s_sharedScriptCache = new CCLuaScriptCache();
+    }
+    return s_sharedScriptCache;
+}
+
+void CCLuaScriptCache::purgeSharedScriptCache() {
+    CC_SAFE_RELEASE_NULL(s_sharedScriptCache);
+}
+
+string CCLuaScriptCache::scriptKey(const string& path) {
+    size_t len = path.length();
+    if(len > 4 && !path.compare(len - 4, 4, ".lua"))
+        return path.substr(0, len - 4);
+    else if(len > 3 && !path.compare(len - 3, 3, ".lc"))
+        return path.substr(0, len - 3);
+    else
+        return path;
+}
+
+string CCLuaScriptCache::findExternalScript(const string& path) {
+    if(CCFileUtils::sharedFileUtils()->isAbsolutePath(path))
+        return "";
+    string key = scriptKey(path);
+    string external = CCUtils::externalize(key + ".lc");
+    if(CCUtils::isPathExistent(external))
+        return external;
+    external = CCUtils::externalize(key + ".lua");
+    if(CCUtils::isPathExistent(external))
+        return external;
+    return "";
+}
+
+bool CCLuaScriptCache::addBundle(const string& path) {
+    // load whole bundle, scripts are loaded from memory later
+    string fullPath = CCUtils::getExternalOrFullPath(path);
+    size_t size = 0;
+    unsigned char* data = CCFileUtils::sharedFileUtils()->getFileData(fullPath.c_str(), "rb", &size);
+    if(!data)
+        return false;
+
+    // header
+    if(size < 12 || memcmp(data, BUNDLE_MAGIC, 4) || readU32(data + 4) != BUNDLE_VERSION) {
+        CCLOGWARN("invalid lua script bundle: %s", fullPath.c_str());
+        delete[] data;
+        return false;
+    }
+
+    // index
+    Bundle* b = new Bundle();
+    b->path = path;
+    b->data = data;
+    uint32_t count = readU32(data + 8);
+    const unsigned char* p = data + 12;
+    const unsigned char* end = data + size;
+    for(uint32_t i = 0; i < count; i++) {
+        if(p + 2 > end)
+            break;
+        uint16_t nameLen = readU16(p);
+        p += 2;
+        if(p + nameLen + 8 > end)
+            break;
+        string name((const char*)p, nameLen);
+        p += nameLen;
+        uint32_t offset = readU32(p);
+        uint32_t len = readU32(p + 4);
+        p += 8;
+        if(offset > size || len > size - offset)
+            break;
+        BundleEntry& e = b->index[name];
+        e.data = (const char*)data + offset;
+        e.size = len;
+    }
+    if(b->index.size() != count) {
+        CCLOGWARN("lua script bundle %s is truncated", fullPath.c_str());
+        delete[] data;
+        delete b;
+        return false;
+    }
+
+    // replace bundle of same path
+    removeBundle(path);
+    m_bundles.push_back(b);
+    return true;
+}
+
+void CCLuaScriptCache::removeBundle(const string& path) {
+    for(vector<Bundle*>::iterator iter = m_bundles.begin(); iter != m_bundles.end(); iter++) {
+        Bundle* b = *iter;
+        if(b->path == path) {
+            delete[] b->data;
+            delete b;
+            m_bundles.erase(iter);
+            break;
+        }
+    }
+}
+
+void CCLuaScriptCache::removeAllBundles() {
+    for(vector<Bundle*>::iterator iter = m_bundles.begin(); iter != m_bundles.end(); iter++) {
+        delete[] (*iter)->data;
+        delete *iter;
+    }
+    m_bundles.clear();
+}
+
+const CCLuaScriptCache::BundleEntry* CCLuaScriptCache::findBundleEntry(const string& path) {
+    if(m_bundles.empty())
+        return NULL;
+    string key = scriptKey(path);
+    for(vector<Bundle*>::reverse_iterator iter = m_bundles.rbegin(); iter != m_bundles.rend(); iter++) {
+        BundleIndex::iterator e = (*iter)->index.find(key);
+        if(e != (*iter)->index.end())
+            return &e->second;
+    }
+    return NULL;
+}
+
+bool CCLuaScriptCache::hasBundledScript(const string& path) {
+    return findBundleEntry(path) != NULL;
+}
+
+vector<string> CCLuaScriptCache::listBundledScripts(const string& folder) {
+    // index is sorted, so entries of a folder are adjacent
+    string prefix = folder;
+    if(!prefix.empty() && prefix[prefix.length() - 1] != '/')
+        prefix += '/';
+    set<string> names;
+    for(vector<Bundle*>::iterator iter = m_bundles.begin(); iter != m_bundles.end(); iter++) {
+        BundleIndex& index = (*iter)->index;
+        for(BundleIndex::iterator e = index.lower_bound(prefix); e != index.end(); e++) {
+            if(e->first.compare(0, prefix.length(), prefix))
+                break;
+            if(e->first.find('/', prefix.length()) == string::npos)
+                names.insert(e->first.substr(prefix.length()));
+        }
+    }
+    return vector<string>(names.begin(), names.end());
+}
+
+int CCLuaScriptCache::loadBundledScript(lua_State* L, const string& path) {
+    const BundleEntry* e = findBundleEntry(path);
+    if(!e) {
+        lua_pushfstring(L, "script %s is not in any bundle", path.c_str());
+        return LUA_ERRFILE;
+    }
+    return loadBuffer(L, e->data, e->size, path.c_str());
+}
+
+int CCLuaScriptCache::loadScriptFile(lua_State* L, const string& fullPath) {
+    // load file, if has decrypt function, decrypt it
+    size_t len = 0;
+    CC_FILE_DECRYPT_FUNC decFunc = CCScriptEngineManager::sharedManager()->getScriptDecryptFunc();
+    char* buf = NULL;
+    bool decrypted = false;
+    if(decFunc) {
+        buf = (char*)(*decFunc)(fullPath.c_str(), &len);
+        decrypted = buf != NULL;
+    }
+    if(!buf) {
+        buf = (char*)CCFileUtils::sharedFileUtils()->getFileData(fullPath.c_str(), "rb", &len);
+    }
+    if(!buf) {
+        lua_pushfstring(L, "can not get file data of %s", fullPath.c_str());
+        return LUA_ERRFILE;
+    }
+
+    int status = loadBuffer(L, buf, len, fullPath.c_str(), !decrypted || m_cacheDecryptedScripts);
+    delete[] buf;
+    return status;
+}
+
+string CCLuaScriptCache::cacheNameForSource(const char* buf, size_t len, const char* chunkName) {
+    // chunk name is saved in bytecode, so it is a part of key
+    uint32_t pc = 0, pb = 0;
+    hashlittle2(buf, len, &pc, &pb);
+    hashlittle2(chunkName, strlen(chunkName), &pc, &pb);
+    char name[64];
+    sprintf(name, "%08x-%08x%08x_%u.lc", hashlittle(chunkName, strlen(chunkName), 0), pc, pb, (unsigned int)len);
+    return name;
+}
+
+void CCLuaScriptCache::openBytecodeCache() {
+    if(m_cacheOpened)
+        return;
+    m_cacheOpened = true;
+
+    // bytecode of other LuaJIT versions is useless
+    DIR* dir = opendir(m_cacheRoot.c_str());
+    if(dir) {
+        struct dirent* entry;
+        while((entry = readdir(dir)) != NULL) {
+            string path = m_cacheRoot + entry->d_name;
+            if(entry->d_name[0] != '.' && path + "/" != m_cacheDir) {
+                deleteCacheFolder(path);
+            }
+        }
+        closedir(dir);
+    }
+
+    // keep newest bytecode of a chunk, others are left by changed scripts
+    dir = opendir(m_cacheDir.c_str());
+    if(!dir)
+        return;
+    map<string, time_t> mtimes;
+    struct dirent* entry;
+    while((entry = readdir(dir)) != NULL) {
+        string name = entry->d_name;
+        if(name[0] == '.')
+            continue;
+        string path = m_cacheDir + name;
+        struct stat st;
+        if(name.length() < CHUNK_KEY_LENGTH + 4 || name[CHUNK_KEY_LENGTH] != '-' || name.compare(name.length() - 3, 3, ".lc") ||
+           stat(path.c_str(), &st) != 0) {
+            CCUtils::deleteFile(path);
+            continue;
+        }
+        string key = name.substr(0, CHUNK_KEY_LENGTH);
+        map<string, string>::iterator iter = m_cacheEntries.find(key);
+        if(iter == m_cacheEntries.end()) {
+            m_cacheEntries[key] = name;
+            mtimes[key] = st.st_mtime;
+        } else if(st.st_mtime > mtimes[key]) {
+            CCUtils::deleteFile(m_cacheDir + iter->second);
+            iter->second = name;
+            mtimes[key] = st.st_mtime;
+        } else {
+            CCUtils::deleteFile(path);
+        }
+    }
+    closedir(dir);
+}
+
+void CCLuaScriptCache::setCacheEntry(const string& name) {
+    string& current = m_cacheEntries[name.substr(0, CHUNK_KEY_LENGTH)];
+    if(!current.empty() && current != name) {
+        CCUtils::deleteFile(m_cacheDir + current);
+    }
+    current = name;
+}
+
+int CCLuaScriptCache::loadBuffer(lua_State* L, const char* buf, size_t len, const char* chunkName, bool cacheable) {
+    // already bytecode, or cache is not used
+    if(len == 0 || buf[0] == LUA_SIGNATURE[0] || !cacheable || !m_bytecodeCacheEnabled) {
+        return luaL_loadbuffer(L, buf, len, chunkName);
+    }
+
+    // try cached bytecode, a bad one is deleted and rebuilt
+    openBytecodeCache();
+    string cacheName = cacheNameForSource(buf, len, chunkName);
+    string cachePath = m_cacheDir + cacheName;
+    if(CCUtils::isPathExistent(cachePath)) {
+        size_t cachedLen = 0;
+        char* cached = (char*)CCFileUtils::sharedFileUtils()->getFileData(cachePath.c_str(), "rb", &cachedLen);
+        if(cached) {
+            int status = LUA_ERRSYNTAX;
+            if(cachedLen > 0 && cached[0] == LUA_SIGNATURE[0]) {
+                status = luaL_loadbuffer(L, cached, cachedLen, chunkName);
+                if(status != 0)
+                    lua_pop(L, 1);
+            }
+            delete[] cached;
+            if(status == 0) {
+                m_cacheHitCount++;
+                setCacheEntry(cacheName);
+                return 0;
+            }
+        }
+        CCUtils::deleteFile(cachePath);
+    }
+
+    // compile source
+    m_cacheMissCount++;
+    int status = luaL_loadbuffer(L, buf, len, chunkName);
+    if(status != 0)
+        return status;
+
+    // save bytecode, write to a temp file first so a partial file is never loaded
+    string bytecode;
+    if(lua_dump(L, writeChunk, &bytecode) == 0 && !bytecode.empty()) {
+        CCUtils::createIntermediateFolders(cachePath);
+        string tmpPath = cachePath + ".tmp";
+        FILE* f = fopen(tmpPath.c_str(), "wb");
+        if(f) {
+            bool ok = fwrite(bytecode.data(), 1, bytecode.length(), f) == bytecode.length();
+            ok = fclose(f) == 0 && ok;
+            if(!ok || rename(tmpPath.c_str(), cachePath.c_str()) != 0) {
+                CCLOGWARN("failed to save lua bytecode cache %s, errno %d", cachePath.c_str(), errno);
+                CCUtils::deleteFile(tmpPath);
+            } else {
+                setCacheEntry(cacheName);
+            }
+        }
+    }
+    return 0;
+}
+
+void CCLuaScriptCache::removeBytecodeCache() {
+    DIR* dir = opendir(m_cacheDir.c_str());
+    if(!dir)
+        return;
+    struct dirent* entry;
+    while((entry = readdir(dir)) != NULL) {
+        if(entry->d_name[0] != '.') {
+            CCUtils::deleteFile(m_cacheDir + entry->d_name);
+        }
+    }
+    closedir(dir);
+    m_cacheEntries.clear();
+    m_cacheHitCount = 0;
+    m_cacheMissCount = 0;
+}
+
+NS_CC_END
@@ -0,0 +1,204 @@
+/****************************************************************************
+ Author: Luma (stubma@gmail.com)
+
+ https://github.com/stubma/cocos2dx-classical
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+#ifndef __CCLuaScriptCache__
+#define __CCLuaScriptCache__
+
+extern "C" {
+#include "lua.h"
+}
+
+#include "cocoa/CCObject.h"
+#include <string>
+#include <vector>
+#include <map>
+
+using namespace std;
+
+NS_CC_BEGIN
+
+/**
+ * Loads lua chunks without compiling sources again on every launch.
+ *
+ * \par
+ * Script bundles: a bundle is one file which packs many scripts, built by tools/luabundle. Its
+ * index is read once when bundle is added, then a script in bundle is loaded from memory without
+ * any file lookup. Bundle added later overrides earlier ones, so a patch bundle can be added
+ * after the base one.
+ *
+ * \par
+ * Bytecode cache: when a source file is compiled, its bytecode is saved in writable path, named
+ * by hash of source and chunk name. Next launch finds bytecode by the same hash and loads it
+ * without parsing. A changed script has a different hash so stale bytecode is never used, cache
+ * folder is also versioned by LuaJIT version. Only one bytecode file is kept for a chunk name, so
+ * bytecode of a script replaced by hot update is deleted when new one is loaded, and folders of
+ * other LuaJIT versions are deleted when cache is first used. Scripts decrypted by script decrypt
+ * function are not cached by default, because cached bytecode is not encrypted.
+ */
+class CCLuaScriptCache : public CCObject {
+private:
+    /// a script in bundle
+    struct BundleEntry {
+        const char* data;
+        size_t size;
+    };
+    typedef map<string, BundleEntry> BundleIndex;
+
+    /// a loaded bundle
+    struct Bundle {
+        string path;
+        unsigned char* data;
+        BundleIndex index;
+    };
+
+    /// bundles, in adding order
+    vector<Bundle*> m_bundles;
+
+    /// parent folder of bytecode cache folders of all LuaJIT versions, ends with slash
+    string m_cacheRoot;
+
+    /// folder of bytecode cache, ends with slash
+    string m_cacheDir;
+
+    /// is cache folder scanned?
+    bool m_cacheOpened;
+
+    /// bytecode file name of every chunk, key is hash of chunk name
+    map<string, string> m_cacheEntries;
+
+    /// flags
+    bool m_bytecodeCacheEnabled;
+    bool m_cacheDecryptedScripts;
+
+    /// counters
+    unsigned int m_cacheHitCount;
+    unsigned int m_cacheMissCount;
+
+protected:
+    CCLuaScriptCache();
+
+    /// find script in bundles, later bundle first
+    const BundleEntry* findBundleEntry(const string& path);
+
+    /// file name of cached bytecode for a source, it starts with hash of chunk name
+    string cacheNameForSource(const char* buf, size_t len, const char* chunkName);
+
+    /// scan cache folder when cache is first used, remove stale files
+    void openBytecodeCache();
+
+    /// remember current bytecode of a chunk, old one of same chunk is deleted
+    void setCacheEntry(const string& name);
+
+public:
+    virtual ~CCLuaScriptCache();
+
+    /// get shared instance
+    static CCLuaScriptCache* sharedScriptCache();
+
+    /// release shared instance and all bundles
+    static void purgeSharedScriptCache();
+
+    /// strip .lua or .lc extension, scripts are indexed without extension
+    static string scriptKey(const string& path);
+
+    /**
+     * find hot update of a script in external storage, compiled one first. Hot update overrides
+     * bundled script and script in app
+     *
+     * @param path relative path of script, extension is optional
+     * @return full path of external .lc or .lua file, or empty string if there is none
+     */
+    static string findExternalScript(const string& path);
+
+    /**
+     * add a script bundle, its index is loaded and kept in memory with bundle data
+     *
+     * @param path path of bundle file, relative path is resolved by CCFileUtils
+     * @return true if bundle is valid and added
+     */
+    bool addBundle(const string& path);
+
+    /// remove a bundle
+    void removeBundle(const string& path);
+
+    /// remove all bundles
+    void removeAllBundles();
+
+    /// check a script is in any bundle, path is relative, such as script/main.lua
+    bool hasBundledScript(const string& path);
+
+    /**
+     * names of bundled scripts directly in a folder, without extension
+     *
+     * @param folder relative folder, such as script/cocos
+     */
+    vector<string> listBundledScripts(const string& folder);
+
+    /**
+     * load a script from bundles and push it as a function. If failed, error message is pushed
+     *
+     * @param path relative path of script, such as script/main.lua, extension is optional
+     * @return 0 if successful, or error code of luaL_loadbuffer
+     */
+    int loadBundledScript(lua_State* L, const string& path);
+
+    /**
+     * load a script file, decrypted by script decrypt function if it is set, and push it as
+     * a function. If failed, error message is pushed
+     *
+     * @param fullPath full path of script
+     * @return 0 if successful, or error code of luaL_loadbuffer
+     */
+    int loadScriptFile(lua_State* L, const string& fullPath);
+
+    /**
+     * load a script buffer and push it as a function. If it is source and cache is allowed,
+     * bytecode cache is used
+     *
+     * @param buf script source or bytecode
+     * @param len length of buffer
+     * @param chunkName chunk name, used in error messages
+     * @param cacheable false if bytecode of this script should not be cached
+     * @return 0 if successful, or error code of luaL_loadbuffer
+     */
+    int loadBuffer(lua_State* L, const char* buf, size_t len, const char* chunkName, bool cacheable = true);
+
+    /// delete all cached bytecode files
+    void removeBytecodeCache();
+
+    /// enable or disable bytecode cache, enabled by default
+    void setBytecodeCacheEnabled(bool flag) { m_bytecodeCacheEnabled = flag; }
+    bool isBytecodeCacheEnabled() { return m_bytecodeCacheEnabled; }
+
+    /// cache bytecode of decrypted scripts too, false by default
+    void setCacheDecryptedScripts(bool flag) { m_cacheDecryptedScripts = flag; }
+    bool isCacheDecryptedScripts() { return m_cacheDecryptedScripts; }
+
+    /// hit and miss count of bytecode cache
+    unsigned int getCacheHitCount() { return m_cacheHitCount; }
+    unsigned int getCacheMissCount() { return m_cacheMissCount; }
+};
+
+NS_CC_END
+
+#endif /* defined(__CCLuaScriptCache__) */
@@ -38,6 +38,8 @@ extern "C" {
 #include "lua_cocos2dx_auto.h"
 #include "lua_cocos2dx_manual.h"
 #include "Cocos2dxLuaLoader.h"
+#include "CCLuaScriptCache.h"
+#include "CCLuaProfiler.h"
 #include "LuaBasicConversions.h"
 
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_IOS || CC_TARGET_PLATFORM == CC_PLATFORM_MAC)
@@ -184,7 +186,7 @@ void CCLuaStack::addLuaLoader(lua_CFunction func)
 
 void CCLuaStack::removeScriptObjectByCCObject(CCObject* pObj)
 {
-    toluafix_remove_ccobject_by_refid(m_state, pObj->m_nLuaID);
+    toluafix_remove_ccobject(m_state, pObj);
 }
 
 void CCLuaStack::removeScriptUserData(int nRefId) {
@@ -204,37 +206,23 @@ int CCLuaStack::executeString(const char *codes)
 
 int CCLuaStack::executeScriptFile(const char* filename)
 {
-    // get full path of file
-    std::string fullPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(filename);
-    
-    // load file, if has decrypt function, decrypt it
-    size_t codeBufferSize = 0;
-    CC_FILE_DECRYPT_FUNC decFunc = CCScriptEngineManager::sharedManager()->getScriptDecryptFunc();
-    unsigned char* codeBuffer = NULL;
-    if(decFunc) {
-        codeBuffer = (unsigned char*)(*decFunc)(fullPath.c_str(), &codeBufferSize);
-    }
-    if(!codeBuffer) {
-        codeBuffer = CCFileUtils::sharedFileUtils()->getFileData(fullPath.c_str(), "rb", &codeBufferSize);
+    // hot update in external storage overrides bundle, as in lua loader. Compiled chunk is cached
+    CCLuaScriptCache* cache = CCLuaScriptCache::sharedScriptCache();
+    std::string externalPath = CCLuaScriptCache::findExternalScript(filename);
+    int nRet;
+    if (externalPath.empty() && cache->hasBundledScript(filename)) {
+        nRet = cache->loadBundledScript(m_state, filename);
+    } else {
+        std::string fullPath = externalPath.empty() ? CCFileUtils::sharedFileUtils()->fullPathForFilename(filename) : externalPath;
+        nRet = cache->loadScriptFile(m_state, fullPath);
     }
     
-    // copy buffer to ensure zero terminated
-    char* tmp = (char*)malloc(sizeof(char) * (codeBufferSize + 1));
-    memcpy(tmp, codeBuffer, codeBufferSize);
-    tmp[codeBufferSize] = 0;
-    
-    // do string
-    ++m_callFromLua;
-    int nRet = luaL_dostring(m_state, tmp);
-    --m_callFromLua;
-    CC_ASSERT(m_callFromLua >= 0);
-    
-    // release
-    if(codeBuffer) {
-        delete[] codeBuffer;
-    }
-    if(tmp) {
-        free(tmp);
+    // run chunk
+    if (nRet == 0) {
+        ++m_callFromLua;
+        nRet = lua_pcall(m_state, 0, LUA_MULTRET, 0);
+        --m_callFromLua;
+        CC_ASSERT(m_callFromLua >= 0);
     }
     
     // check return
@@ -436,10 +424,28 @@ int CCLuaStack::executeFunction(int numArgs, CCObject* collector, SEL_ScriptRetu
         traceback = functionIndex - 1;
     }
     
+#if CC_LUA_PROFILER
+    // name handler before it is popped by call
+    CCLuaProfiler* profiler = CCLuaProfiler::sharedProfiler();
+    std::string profileName;
+    int64_t profileStart = 0;
+    if (profiler->isCountersEnabled())
+    {
+        profileName = profiler->handlerName(m_state, -(numArgs + 1));
+        profileStart = CCLuaProfiler::now();
+    }
+#endif
+    
     int error = 0;
     ++m_callFromLua;
     error = lua_pcall(m_state, numArgs, 1, traceback);                  /* L: ... [G] ret */
     --m_callFromLua;
+#if CC_LUA_PROFILER
+    if (!profileName.empty())
+    {
+        profiler->addHandlerCall(profileName, CCLuaProfiler::now() - profileStart);
+    }
+#endif
     if (error)
     {
         if (traceback == 0)
@@ -25,6 +25,7 @@ THE SOFTWARE.
 #include <string>
 #include <algorithm>
 #include "support/utils/CCUtils.h"
+#include "CCLuaScriptCache.h"
 
 using namespace cocos2d;
 
@@ -58,33 +59,27 @@ extern "C"
             filepathWithoutExt = filepathWithoutExt.substr(pos);
         }
         
-        // try find compiled lua first
-        // then try find lua source
-        filepath = filepathWithoutExt + ".lc";
-        filepath = CCUtils::getExternalOrFullPath(filepath);
-        if(!CCUtils::isPathExistent(filepath)) {
-            filepath = filepathWithoutExt + ".lua";
+        // scripts in external storage are hot updates, they override bundled scripts
+        // try find compiled lua first, then try find lua source
+        CCLuaScriptCache* cache = CCLuaScriptCache::sharedScriptCache();
+        int status;
+        if(cache->hasBundledScript(filepathWithoutExt) && CCLuaScriptCache::findExternalScript(filepathWithoutExt).empty()) {
+            filepath = filepathWithoutExt;
+            status = cache->loadBundledScript(L, filepath);
+        } else {
+            filepath = filepathWithoutExt + ".lc";
             filepath = CCUtils::getExternalOrFullPath(filepath);
-        }
-        
-        // load lua file
-        size_t codeBufferSize = 0;
-        CC_FILE_DECRYPT_FUNC decFunc = CCScriptEngineManager::sharedManager()->getScriptDecryptFunc();
-        unsigned char* codeBuffer = NULL;
-        if(decFunc) {
-            codeBuffer = (unsigned char*)(*decFunc)(filepath.c_str(), &codeBufferSize);
-        }
-        if(!codeBuffer) {
-            codeBuffer = CCFileUtils::sharedFileUtils()->getFileData(filepath.c_str(), "rb", &codeBufferSize);
-        }
-        if (codeBuffer) {
-            if (luaL_loadbuffer(L, (char*)codeBuffer, codeBufferSize, filepath.c_str()) != 0) {
-                CCLOG("error loading module %s from file %s :\n\t%s",
-                      lua_tostring(L, 1), filepath.c_str(), lua_tostring(L, -1));
+            if(!CCUtils::isPathExistent(filepath)) {
+                filepath = filepathWithoutExt + ".lua";
+                filepath = CCUtils::getExternalOrFullPath(filepath);
             }
-            delete[] codeBuffer;
-        } else {
-            CCLOG("can not get file data of %s", filepath.c_str());
+            
+            // load lua file, compiled chunk is cached
+            status = cache->loadScriptFile(L, filepath);
+        }
+        if (status != 0) {
+            CCLOG("error loading module %s from file %s :\n\t%s",
+                  lua_tostring(L, 1), filepath.c_str(), lua_tostring(L, -1));
         }
         
         return 1;
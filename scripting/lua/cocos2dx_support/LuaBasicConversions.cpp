@@ -25,6 +25,29 @@
 #include "LuaBasicConversions.h"
 #include "tolua_fix.h"
 
+#if CC_LUA_FFI_VALUE_TYPES
+extern "C" {
+#include "lj_obj.h"
+}
+
+// lua_type of LuaJIT cdata, it is not exported in lua.h
+#ifndef LUA_TCDATA
+#define LUA_TCDATA 10
+#endif
+
+// is value a cdata of a value type declared by valuetypes.lua? It saves ctype ids in registry
+// with ctype name as key, a cdata of other type must not be read as a value type
+static bool luaval_is_ffi_value(lua_State* L, int lo, const char* ctypeName)
+{
+    if (lua_type(L, lo) != LUA_TCDATA)
+        return false;
+    lua_getfield(L, LUA_REGISTRYINDEX, ctypeName);
+    lua_Integer id = lua_tointeger(L, -1);
+    lua_pop(L, 1);
+    const GCcdata* cd = (const GCcdata*)lua_topointer(L, lo) - 1;
+    return id > 0 && cd->ctypeid == id;
+}
+#endif
 
 
 std::map<std::string, std::string>  g_luaType;
@@ -1092,6 +1115,14 @@ bool luaval_to_point(lua_State* L,int lo,cocos2d::CCPoint* outValue, const char*
         lo = lua_gettop(L) + lo + 1;
     }
     
+#if CC_LUA_FFI_VALUE_TYPES
+    if (luaval_is_ffi_value(L, lo, "cc_point"))
+    {
+        *outValue = *(const cocos2d::CCPoint*)lua_topointer(L, lo);
+        return true;
+    }
+#endif
+
     tolua_Error tolua_err;
     if (!tolua_istable(L, lo, 0, &tolua_err) )
     {
@@ -1216,6 +1247,14 @@ bool luaval_to_size(lua_State* L,int lo, CCSize* outValue, const char* funcName)
         lo = lua_gettop(L) + lo + 1;
     }
 
+#if CC_LUA_FFI_VALUE_TYPES
+    if (luaval_is_ffi_value(L, lo, "cc_size"))
+    {
+        *outValue = *(const CCSize*)lua_topointer(L, lo);
+        return true;
+    }
+#endif
+
     tolua_Error tolua_err;
     if (!tolua_istable(L, lo, 0, &tolua_err) )
     {
@@ -1383,6 +1422,14 @@ bool luaval_to_rect(lua_State* L,int lo, CCRect* outValue, const char* funcName)
         lo = lua_gettop(L) + lo + 1;
     }
 
+#if CC_LUA_FFI_VALUE_TYPES
+    if (luaval_is_ffi_value(L, lo, "cc_rect"))
+    {
+        *outValue = *(const CCRect*)lua_topointer(L, lo);
+        return true;
+    }
+#endif
+
     tolua_Error tolua_err;
     if (!tolua_istable(L, lo, 0, &tolua_err) )
     {
@@ -1429,6 +1476,14 @@ bool luaval_to_color4b(lua_State* L,int lo,ccColor4B* outValue, const char* func
         lo = lua_gettop(L) + lo + 1;
     }
 
+#if CC_LUA_FFI_VALUE_TYPES
+    if (luaval_is_ffi_value(L, lo, "cc_color4b"))
+    {
+        *outValue = *(const ccColor4B*)lua_topointer(L, lo);
+        return true;
+    }
+#endif
+
     tolua_Error tolua_err;
     if (!tolua_istable(L, lo, 0, &tolua_err) )
     {
@@ -1515,6 +1570,14 @@ bool luaval_to_color4f(lua_State* L,int lo,ccColor4F* outValue, const char* func
         lo = lua_gettop(L) + lo + 1;
     }
 
+#if CC_LUA_FFI_VALUE_TYPES
+    if (luaval_is_ffi_value(L, lo, "cc_color4f"))
+    {
+        *outValue = *(const ccColor4F*)lua_topointer(L, lo);
+        return true;
+    }
+#endif
+
     tolua_Error tolua_err;
     if (!tolua_istable(L, lo, 0, &tolua_err) )
     {
@@ -1561,6 +1624,14 @@ bool luaval_to_color3b(lua_State* L,int lo,ccColor3B* outValue, const char* func
         lo = lua_gettop(L) + lo + 1;
     }
 
+#if CC_LUA_FFI_VALUE_TYPES
+    if (luaval_is_ffi_value(L, lo, "cc_color3b"))
+    {
+        *outValue = *(const ccColor3B*)lua_topointer(L, lo);
+        return true;
+    }
+#endif
+
     tolua_Error tolua_err;
     if (!tolua_istable(L, lo, 0, &tolua_err) )
     {
@@ -2696,7 +2767,7 @@ void point_to_luaval(lua_State* L,const cocos2d::CCPoint& vec2)
 {
     if (NULL == L)
         return;
-    lua_newtable(L);                                    /* L: table */
+    lua_createtable(L, 0, 2);                          /* L: table */
     lua_pushstring(L, "x");                             /* L: table key */
     lua_pushnumber(L, (lua_Number) vec2.x);               /* L: table key value*/
     lua_rawset(L, -3);                                  /* table[key] = value, L: table */
@@ -2709,7 +2780,7 @@ void size_to_luaval(lua_State* L,const CCSize& sz)
 {
     if (NULL == L)
         return;
-    lua_newtable(L);                                    /* L: table */
+    lua_createtable(L, 0, 2);                          /* L: table */
     lua_pushstring(L, "width");                         /* L: table key */
     lua_pushnumber(L, (lua_Number) sz.width);           /* L: table key value*/
     lua_rawset(L, -3);                                  /* table[key] = value, L: table */
@@ -2776,7 +2847,7 @@ void rect_to_luaval(lua_State* L,const CCRect& rt)
 {
     if (NULL  == L)
         return;
-    lua_newtable(L);                                    /* L: table */
+    lua_createtable(L, 0, 4);                          /* L: table */
     lua_pushstring(L, "x");                             /* L: table key */
     lua_pushnumber(L, (lua_Number) rt.origin.x);               /* L: table key value*/
     lua_rawset(L, -3);                                  /* table[key] = value, L: table */
@@ -2795,7 +2866,7 @@ void color4b_to_luaval(lua_State* L,const ccColor4B& cc)
 {
     if (NULL  == L)
         return;
-    lua_newtable(L);                                    /* L: table */
+    lua_createtable(L, 0, 4);                          /* L: table */
     lua_pushstring(L, "r");                             /* L: table key */
     lua_pushnumber(L, (lua_Number) cc.r);               /* L: table key value*/
     lua_rawset(L, -3);                                  /* table[key] = value, L: table */
@@ -2829,7 +2900,7 @@ void color4f_to_luaval(lua_State* L,const ccColor4F& cc)
 {
     if (NULL  == L)
         return;
-    lua_newtable(L);                                    /* L: table */
+    lua_createtable(L, 0, 4);                          /* L: table */
     lua_pushstring(L, "r");                             /* L: table key */
     lua_pushnumber(L, (lua_Number) cc.r);               /* L: table key value*/
     lua_rawset(L, -3);                                  /* table[key] = value, L: table */
@@ -2848,7 +2919,7 @@ void color3b_to_luaval(lua_State* L,const ccColor3B& cc)
 {
     if (NULL  == L)
         return;
-    lua_newtable(L);                                    /* L: table */
+    lua_createtable(L, 0, 3);                          /* L: table */
     lua_pushstring(L, "r");                             /* L: table key */
     lua_pushnumber(L, (lua_Number) cc.r);               /* L: table key value*/
     lua_rawset(L, -3);                                  /* table[key] = value, L: table */
@@ -3396,4 +3467,134 @@ const char* getLuaTypeNameByTypeId(const string& typeName) {
     } else {
         return "CCObject";
     }
-}
\ No newline at end of file
+}
+
+static bool luavals_to_floats(lua_State* L, int lo, float* outValues, int count, const char* funcName)
+{
+    if (NULL == L || NULL == outValues)
+        return false;
+    
+    // convert negative index to positive
+    if(lo < 0) {
+        lo = lua_gettop(L) + lo + 1;
+    }
+    
+    for (int i = 0; i < count; i++)
+    {
+        tolua_Error tolua_err;
+        if (!tolua_isnumber(L, lo + i, 0, &tolua_err))
+        {
+#if COCOS2D_DEBUG >=1
+            luaval_to_native_err(L,"#ferror:",&tolua_err,funcName);
+#endif
+            return false;
+        }
+        outValues[i] = (float)lua_tonumber(L, lo + i);
+    }
+    return true;
+}
+
+bool luavals_to_point(lua_State* L, int lo, cocos2d::CCPoint* outValue, const char* funcName)
+{
+    float v[2];
+    if (NULL == outValue || !luavals_to_floats(L, lo, v, 2, funcName))
+        return false;
+    outValue->x = v[0];
+    outValue->y = v[1];
+    return true;
+}
+
+bool luavals_to_size(lua_State* L, int lo, CCSize* outValue, const char* funcName)
+{
+    float v[2];
+    if (NULL == outValue || !luavals_to_floats(L, lo, v, 2, funcName))
+        return false;
+    outValue->width = v[0];
+    outValue->height = v[1];
+    return true;
+}
+
+bool luavals_to_rect(lua_State* L, int lo, CCRect* outValue, const char* funcName)
+{
+    float v[4];
+    if (NULL == outValue || !luavals_to_floats(L, lo, v, 4, funcName))
+        return false;
+    outValue->setRect(v[0], v[1], v[2], v[3]);
+    return true;
+}
+
+bool luavals_to_color3b(lua_State* L, int lo, ccColor3B* outValue, const char* funcName)
+{
+    float v[3];
+    if (NULL == outValue || !luavals_to_floats(L, lo, v, 3, funcName))
+        return false;
+    *outValue = ccc3((GLubyte)v[0], (GLubyte)v[1], (GLubyte)v[2]);
+    return true;
+}
+
+bool luavals_to_color4b(lua_State* L, int lo, ccColor4B* outValue, const char* funcName)
+{
+    float v[4];
+    if (NULL == outValue || !luavals_to_floats(L, lo, v, 4, funcName))
+        return false;
+    *outValue = ccc4((GLubyte)v[0], (GLubyte)v[1], (GLubyte)v[2], (GLubyte)v[3]);
+    return true;
+}
+
+bool luavals_to_color4f(lua_State* L, int lo, ccColor4F* outValue, const char* funcName)
+{
+    float v[4];
+    if (NULL == outValue || !luavals_to_floats(L, lo, v, 4, funcName))
+        return false;
+    *outValue = ccc4f(v[0], v[1], v[2], v[3]);
+    return true;
+}
+
+int point_to_luavals(lua_State* L, const cocos2d::CCPoint& p)
+{
+    lua_pushnumber(L, (lua_Number)p.x);
+    lua_pushnumber(L, (lua_Number)p.y);
+    return 2;
+}
+
+int size_to_luavals(lua_State* L, const CCSize& sz)
+{
+    lua_pushnumber(L, (lua_Number)sz.width);
+    lua_pushnumber(L, (lua_Number)sz.height);
+    return 2;
+}
+
+int rect_to_luavals(lua_State* L, const CCRect& rt)
+{
+    lua_pushnumber(L, (lua_Number)rt.origin.x);
+    lua_pushnumber(L, (lua_Number)rt.origin.y);
+    lua_pushnumber(L, (lua_Number)rt.size.width);
+    lua_pushnumber(L, (lua_Number)rt.size.height);
+    return 4;
+}
+
+int color3b_to_luavals(lua_State* L, const ccColor3B& cc)
+{
+    lua_pushnumber(L, (lua_Number)cc.r);
+    lua_pushnumber(L, (lua_Number)cc.g);
+    lua_pushnumber(L, (lua_Number)cc.b);
+    return 3;
+}
+
+int color4b_to_luavals(lua_State* L, const ccColor4B& cc)
+{
+    lua_pushnumber(L, (lua_Number)cc.r);
+    lua_pushnumber(L, (lua_Number)cc.g);
+    lua_pushnumber(L, (lua_Number)cc.b);
+    lua_pushnumber(L, (lua_Number)cc.a);
+    return 4;
+}
+
+int color4f_to_luavals(lua_State* L, const ccColor4F& cc)
+{
+    lua_pushnumber(L, (lua_Number)cc.r);
+    lua_pushnumber(L, (lua_Number)cc.g);
+    lua_pushnumber(L, (lua_Number)cc.b);
+    lua_pushnumber(L, (lua_Number)cc.a);
+    return 4;
+}
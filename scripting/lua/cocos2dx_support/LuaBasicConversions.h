@@ -212,4 +212,19 @@ void vector_ushort_to_luaval(lua_State* L, const std::vector<unsigned short>& in
 void vector_rect_to_luaval(lua_State* L, const std::vector<cocos2d::CCRect>& inValue);
 void vector_point_to_luaval(lua_State* L, const std::vector<cocos2d::CCPoint>& inValue);
 
+// value types as consecutive numbers, without a table. to native converts
+// values at lo, lo + 1, ..., from native pushes values and returns count of them
+extern bool luavals_to_point(lua_State* L, int lo, cocos2d::CCPoint* outValue, const char* funcName = "");
+extern bool luavals_to_size(lua_State* L, int lo, CCSize* outValue, const char* funcName = "");
+extern bool luavals_to_rect(lua_State* L, int lo, CCRect* outValue, const char* funcName = "");
+extern bool luavals_to_color3b(lua_State* L, int lo, ccColor3B* outValue, const char* funcName = "");
+extern bool luavals_to_color4b(lua_State* L, int lo, ccColor4B* outValue, const char* funcName = "");
+extern bool luavals_to_color4f(lua_State* L, int lo, ccColor4F* outValue, const char* funcName = "");
+extern int point_to_luavals(lua_State* L, const cocos2d::CCPoint& p);
+extern int size_to_luavals(lua_State* L, const CCSize& sz);
+extern int rect_to_luavals(lua_State* L, const CCRect& rt);
+extern int color3b_to_luavals(lua_State* L, const ccColor3B& cc);
+extern int color4b_to_luavals(lua_State* L, const ccColor4B& cc);
+extern int color4f_to_luavals(lua_State* L, const ccColor4F& cc);
+
 #endif //__COCOS2DX_SCRIPTING_LUA_COCOS2DXSUPPORT_LUABAISCCONVERSIONS_H__
@@ -24,6 +24,9 @@
 #include "lua_cocos2dx_manual.h"
 #include "tolua_fix.h"
 #include "LuaBasicConversions.h"
+#include "CCLuaScriptCache.h"
+#include "CCLuaProfiler.h"
+#include "CCLuaEngine.h"
 
 static int lua_cocos2dx_manual_CCObject_setScriptUserData(lua_State* tolua_S) {
     // variables
@@ -135,10 +138,101 @@ static int lua_register_cocos2dx_manual_CCObject(lua_State* tolua_S) {
     return 1;
 }
 
+static int lua_cocos2dx_manual_listBundledScripts(lua_State* tolua_S) {
+    // get argument count
+    int argc = lua_gettop(tolua_S);
+    
+    // if argument count matched, call
+    if (argc == 1) {
+        std::string folder;
+        if (!luaval_to_std_string(tolua_S, 1, &folder, "listBundledScripts")) {
+            tolua_error(tolua_S, "invalid arguments in function 'lua_cocos2dx_manual_listBundledScripts'", nullptr);
+            return 0;
+        }
+        std::vector<std::string> names = cocos2d::CCLuaScriptCache::sharedScriptCache()->listBundledScripts(folder);
+        vector_string_to_luaval(tolua_S, names);
+        return 1;
+    }
+    
+    // if to here, means argument count is not correct
+    luaL_error(tolua_S, "%s has wrong number of arguments: %d, was expecting %d \n", "listBundledScripts", argc, 1);
+    return 0;
+}
+
+static int lua_cocos2dx_manual_setScheduleBatchEnabled(lua_State* tolua_S) {
+    cocos2d::CCLuaEngine::defaultEngine()->setScheduleBatchEnabled(lua_toboolean(tolua_S, 1) != 0);
+    return 0;
+}
+
+static int lua_cocos2dx_manual_setGCPacingEnabled(lua_State* tolua_S) {
+    cocos2d::CCLuaEngine* engine = cocos2d::CCLuaEngine::defaultEngine();
+    if (lua_isnumber(tolua_S, 2)) {
+        engine->setGCMaxStepTime((float)lua_tonumber(tolua_S, 2));
+    }
+    engine->setGCPacingEnabled(lua_toboolean(tolua_S, 1) != 0);
+    return 0;
+}
+
+static int lua_cocos2dx_manual_luaprofiler_setCountersEnabled(lua_State* tolua_S) {
+    cocos2d::CCLuaProfiler::sharedProfiler()->setCountersEnabled(lua_toboolean(tolua_S, 1) != 0);
+    return 0;
+}
+
+static int lua_cocos2dx_manual_luaprofiler_resetCounters(lua_State* tolua_S) {
+    cocos2d::CCLuaProfiler::sharedProfiler()->resetCounters();
+    return 0;
+}
+
+static int lua_cocos2dx_manual_luaprofiler_dumpCounters(lua_State* tolua_S) {
+    const char* path = luaL_optstring(tolua_S, 1, "lua_counters.txt");
+    lua_pushboolean(tolua_S, cocos2d::CCLuaProfiler::sharedProfiler()->dumpCounters(path));
+    return 1;
+}
+
+static int lua_cocos2dx_manual_luaprofiler_startSampling(lua_State* tolua_S) {
+    int instructions = (int)luaL_optinteger(tolua_S, 1, 1000);
+    cocos2d::CCLuaProfiler::sharedProfiler()->startSampling(tolua_S, instructions);
+    return 0;
+}
+
+static int lua_cocos2dx_manual_luaprofiler_stopSampling(lua_State* tolua_S) {
+    cocos2d::CCLuaProfiler::sharedProfiler()->stopSampling();
+    return 0;
+}
+
+static int lua_cocos2dx_manual_luaprofiler_resetSamples(lua_State* tolua_S) {
+    cocos2d::CCLuaProfiler::sharedProfiler()->resetSamples();
+    return 0;
+}
+
+static int lua_cocos2dx_manual_luaprofiler_dumpSamples(lua_State* tolua_S) {
+    const char* path = luaL_optstring(tolua_S, 1, "lua_samples.folded");
+    lua_pushboolean(tolua_S, cocos2d::CCLuaProfiler::sharedProfiler()->dumpSamples(path));
+    return 1;
+}
+
+static int lua_register_cocos2dx_manual_luaprofiler(lua_State* tolua_S) {
+    tolua_module(tolua_S, "luaprofiler", 0);
+    tolua_beginmodule(tolua_S, "luaprofiler");
+        tolua_function(tolua_S, "setCountersEnabled", lua_cocos2dx_manual_luaprofiler_setCountersEnabled);
+        tolua_function(tolua_S, "resetCounters", lua_cocos2dx_manual_luaprofiler_resetCounters);
+        tolua_function(tolua_S, "dumpCounters", lua_cocos2dx_manual_luaprofiler_dumpCounters);
+        tolua_function(tolua_S, "startSampling", lua_cocos2dx_manual_luaprofiler_startSampling);
+        tolua_function(tolua_S, "stopSampling", lua_cocos2dx_manual_luaprofiler_stopSampling);
+        tolua_function(tolua_S, "resetSamples", lua_cocos2dx_manual_luaprofiler_resetSamples);
+        tolua_function(tolua_S, "dumpSamples", lua_cocos2dx_manual_luaprofiler_dumpSamples);
+    tolua_endmodule(tolua_S);
+    return 1;
+}
+
 int register_all_cocos2dx_manual(lua_State* tolua_S) {
     tolua_open(tolua_S);
     tolua_beginmodule(tolua_S, nullptr);
         lua_register_cocos2dx_manual_CCObject(tolua_S);
+        tolua_function(tolua_S, "listBundledScripts", lua_cocos2dx_manual_listBundledScripts);
+        tolua_function(tolua_S, "setScheduleBatchEnabled", lua_cocos2dx_manual_setScheduleBatchEnabled);
+        tolua_function(tolua_S, "setGCPacingEnabled", lua_cocos2dx_manual_setGCPacingEnabled);
+        lua_register_cocos2dx_manual_luaprofiler(tolua_S);
     tolua_endmodule(tolua_S);
     return 1;
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include <typeinfo>
 #include "cocoa/CCObject.h"
 #include "platform/platform.h"
+#include "LuaBasicConversions.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -12,15 +13,22 @@ extern "C" {
     
 static int s_function_ref_id = 0;
 static int s_table_ref_id = 0;
-static std::map<unsigned int, char*> hash_type_mapping;
     
 TOLUA_API void toluafix_open(lua_State* L)
 {
-    lua_pushstring(L, TOLUA_REFID_PTR_MAPPING);
+    // ptr -> userdata of pushed CCObject, value is weak so mapping never keeps userdata
+    // alive, it is kept by value root until object is released
+    lua_pushstring(L, TOLUA_PTR_USERDATA_MAPPING);
     lua_newtable(L);
+    lua_newtable(L);
+    lua_pushliteral(L, "__mode");
+    lua_pushliteral(L, "v");
+    lua_rawset(L, -3);                                              /* stack: string ptr_ud mt */
+    lua_setmetatable(L, -2);                                        /* stack: string ptr_ud */
     lua_rawset(L, LUA_REGISTRYINDEX);
     
-    lua_pushstring(L, TOLUA_REFID_TYPE_MAPPING);
+    // type_info -> metatable of lua class, or false if class is not bound
+    lua_pushstring(L, TOLUA_TYPE_METATABLE_MAPPING);
     lua_newtable(L);
     lua_rawset(L, LUA_REGISTRYINDEX);
 
@@ -33,10 +41,43 @@ TOLUA_API void toluafix_open(lua_State* L)
     lua_rawset(L, LUA_REGISTRYINDEX);
 }
     
-TOLUA_API void toluafix_add_type_mapping(unsigned int type, const char *clsName) {
-    if (hash_type_mapping.find(type) == hash_type_mapping.end()) {
-        hash_type_mapping[type] = strdup(clsName);
+// push metatable of object's dynamic class, class is resolved only once
+// return false and push nothing if class is not bound
+static bool toluafix_push_class_metatable(lua_State* L, cocos2d::CCObject* ptr)
+{
+    const std::type_info& info = typeid(*ptr);
+    lua_pushstring(L, TOLUA_TYPE_METATABLE_MAPPING);
+    lua_rawget(L, LUA_REGISTRYINDEX);                               /* stack: type_mt */
+    lua_pushlightuserdata(L, (void*)&info);                         /* stack: type_mt info */
+    lua_rawget(L, -2);                                              /* stack: type_mt mt */
+    if (lua_isnil(L, -1))
+    {
+        lua_pop(L, 1);                                              /* stack: type_mt */
+        std::map<std::string, std::string>::iterator iter = g_luaType.find(info.name());
+        if (iter != g_luaType.end())
+        {
+            luaL_getmetatable(L, iter->second.c_str());             /* stack: type_mt mt */
+        }
+        else
+        {
+            lua_pushnil(L);                                         /* stack: type_mt nil */
+        }
+        if (lua_isnil(L, -1))
+        {
+            lua_pop(L, 1);
+            lua_pushboolean(L, 0);                                  /* stack: type_mt false */
+        }
+        lua_pushlightuserdata(L, (void*)&info);                     /* stack: type_mt mt info */
+        lua_pushvalue(L, -2);                                       /* stack: type_mt mt info mt */
+        lua_rawset(L, -4);                      /* type_mt[info] = mt, stack: type_mt mt */
     }
+    lua_remove(L, -2);                                              /* stack: mt */
+    if (!lua_istable(L, -1))
+    {
+        lua_pop(L, 1);                                              /* stack: - */
+        return false;
+    }
+    return true;
 }
 
 TOLUA_API int toluafix_pushusertype_ccobject(lua_State *L,
@@ -50,135 +91,125 @@ TOLUA_API int toluafix_pushusertype_ccobject(lua_State *L,
     }
     
     cocos2d::CCObject *ptr = static_cast<cocos2d::CCObject*>(vptr);
-    unsigned int hash = cocos2d::CLASS_HASH_CODE(typeid(*ptr));
-    char* type = hash_type_mapping[hash];
-    if (type == NULL) {
-        // CCLOG("[TOLUA] Unable to find type map for object %s:%p,", vtype, vptr);
+    lua_pushstring(L, TOLUA_PTR_USERDATA_MAPPING);
+    lua_rawget(L, LUA_REGISTRYINDEX);                               /* stack: ptr_ud */
+    
+    // object is known to lua, it already has metatable of its dynamic class
+    if (*p_refid != 0) {
+        lua_pushlightuserdata(L, ptr);                              /* stack: ptr_ud ptr */
+        lua_rawget(L, -2);                                          /* stack: ptr_ud ud */
+        if (!lua_isnil(L, -1)) {
+            lua_remove(L, -2);                                      /* stack: ud */
+            return 0;
+        }
+        lua_pop(L, 1);                                              /* stack: ptr_ud */
     }
+    *p_refid = refid;
     
-    if (*p_refid == 0) {
-        *p_refid = refid;
-        
-        lua_pushstring(L, TOLUA_REFID_PTR_MAPPING);
-        lua_rawget(L, LUA_REGISTRYINDEX);                           /* stack: refid_ptr */
-        lua_pushinteger(L, refid);                                  /* stack: refid_ptr refid */
-        lua_pushlightuserdata(L, ptr);                              /* stack: refid_ptr refid ptr */
-        
-        lua_rawset(L, -3);                  /* refid_ptr[refid] = ptr, stack: refid_ptr */
+    // class is not bound, use static type and let tolua specialize it in later push
+    if (!toluafix_push_class_metatable(L, ptr)) {
         lua_pop(L, 1);                                              /* stack: - */
-        
-        lua_pushstring(L, TOLUA_REFID_TYPE_MAPPING);
-        lua_rawget(L, LUA_REGISTRYINDEX);                           /* stack: refid_type */
-        lua_pushinteger(L, refid);                                  /* stack: refid_type refid */
-        lua_pushstring(L, type ? type : vtype);                     /* stack: refid_type refid type */
-        lua_rawset(L, -3);                /* refid_type[refid] = type, stack: refid_type */
-        lua_pop(L, 1);                                              /* stack: - */
-        
-        //printf("[LUA] push CCObject OK - refid: %d, ptr: %x, type: %s\n", *p_refid, (int)ptr, type);
+        tolua_pushusertype_and_addtoroot(L, ptr, vtype);
+        return 0;
+    }
+                                                                    /* stack: ptr_ud mt */
+    // get ubox, userdata may be there if object is pushed by tolua_pushusertype
+    lua_pushstring(L, "tolua_ubox");
+    lua_rawget(L, -2);                                              /* stack: ptr_ud mt ubox */
+    if (lua_isnil(L, -1)) {
+        // use global ubox
+        lua_pop(L, 1);                                              /* stack: ptr_ud mt */
+        lua_pushstring(L, "tolua_ubox");
+        lua_rawget(L, LUA_REGISTRYINDEX);                           /* stack: ptr_ud mt ubox */
+    }
+    lua_pushlightuserdata(L, ptr);                                  /* stack: ptr_ud mt ubox ptr */
+    lua_rawget(L, -2);                                              /* stack: ptr_ud mt ubox ud */
+    if (lua_isnil(L, -1)) {
+        lua_pop(L, 1);                                              /* stack: ptr_ud mt ubox */
+        *(void**)lua_newuserdata(L, sizeof(void*)) = ptr;           /* stack: ptr_ud mt ubox ud */
+        lua_pushvalue(L, TOLUA_NOPEER);
+        lua_setfenv(L, -2);
+        lua_pushlightuserdata(L, ptr);                              /* stack: ptr_ud mt ubox ud ptr */
+        lua_pushvalue(L, -2);                                       /* stack: ptr_ud mt ubox ud ptr ud */
+        lua_rawset(L, -4);                        /* ubox[ptr] = ud, stack: ptr_ud mt ubox ud */
     }
     
-    tolua_pushusertype_and_addtoroot(L, ptr, type ? type : vtype);
+    // dynamic class is the most specialized one
+    lua_pushvalue(L, -3);                                           /* stack: ptr_ud mt ubox ud mt */
+    lua_setmetatable(L, -2);                                        /* stack: ptr_ud mt ubox ud */
+    lua_replace(L, -3);                                             /* stack: ptr_ud ud ubox */
+    lua_pop(L, 1);                                                  /* stack: ptr_ud ud */
+    
+    // map and keep it in root until object is released
+    lua_pushlightuserdata(L, ptr);                                  /* stack: ptr_ud ud ptr */
+    lua_pushvalue(L, -2);                                           /* stack: ptr_ud ud ptr ud */
+    lua_rawset(L, -4);                          /* ptr_ud[ptr] = ud, stack: ptr_ud ud */
+    lua_remove(L, -2);                                              /* stack: ud */
+    lua_pushvalue(L, -1);                                           /* stack: ud ud */
+    tolua_add_value_to_root(L, ptr);                                /* stack: ud */
+    
+    //printf("[LUA] push CCObject OK - refid: %d, ptr: %x\n", *p_refid, (int)ptr);
     return 0;
 }
     
-TOLUA_API int toluafix_remove_ccobject_by_refid(lua_State* L, int refid)
+TOLUA_API int toluafix_remove_ccobject(lua_State* L, void* vptr)
 {
-	void* ptr = NULL;
-    const char* type = NULL;
     void** ud = NULL;
-    if (refid == 0) return -1;
-    
-    // get ptr from tolua_refid_ptr_mapping
-    lua_pushstring(L, TOLUA_REFID_PTR_MAPPING);
-    lua_rawget(L, LUA_REGISTRYINDEX);                               /* stack: refid_ptr */
-    lua_pushinteger(L, refid);                                      /* stack: refid_ptr refid */
-    lua_rawget(L, -2);                                              /* stack: refid_ptr ptr */
-    ptr = lua_touserdata(L, -1);
-    lua_pop(L, 1);                                                  /* stack: refid_ptr */
-    if (ptr == NULL)
+    if (vptr == NULL) return -1;
+    
+    // pushed object is kept in root until it is removed
+    lua_pushstring(L, TOLUA_VALUE_ROOT);
+    lua_rawget(L, LUA_REGISTRYINDEX);                               /* stack: root */
+    lua_pushlightuserdata(L, vptr);                                 /* stack: root ptr */
+    lua_rawget(L, -2);                                              /* stack: root ud */
+    if (!lua_isuserdata(L, -1))
     {
-        lua_pop(L, 1);
         // Lua stack has closed, C++ object not in Lua.
-        // printf("[LUA ERROR] remove CCObject with NULL ptr, refid: %d\n", refid);
-        return -2;
-    }
-    
-    // remove ptr from tolua_refid_ptr_mapping
-    lua_pushinteger(L, refid);                                      /* stack: refid_ptr refid */
-    lua_pushnil(L);                                                 /* stack: refid_ptr refid nil */
-    lua_rawset(L, -3);                     /* delete refid_ptr[refid], stack: refid_ptr */
-    lua_pop(L, 1);                                                  /* stack: - */
-    
-    
-    // get type from tolua_refid_type_mapping
-    lua_pushstring(L, TOLUA_REFID_TYPE_MAPPING);
-    lua_rawget(L, LUA_REGISTRYINDEX);                               /* stack: refid_type */
-    lua_pushinteger(L, refid);                                      /* stack: refid_type refid */
-    lua_rawget(L, -2);                                              /* stack: refid_type type */
-    if (lua_isnil(L, -1))
-    {
         lua_pop(L, 2);
-        printf("[LUA ERROR] remove CCObject with NULL type, refid: %d, ptr: %p\n", refid, ptr);
-        return -1;
+        return -2;
     }
     
-    type = lua_tostring(L, -1);
-    lua_pop(L, 1);                                                  /* stack: refid_type */
-    
-    // remove type from tolua_refid_type_mapping
-    lua_pushinteger(L, refid);                                      /* stack: refid_type refid */
-    lua_pushnil(L);                                                 /* stack: refid_type refid nil */
-    lua_rawset(L, -3);                    /* delete refid_type[refid], stack: refid_type */
-    lua_pop(L, 1);                                                  /* stack: - */
-    
-    // get ubox
-    luaL_getmetatable(L, type);                                     /* stack: mt */
-    lua_pushstring(L, "tolua_ubox");                                /* stack: mt key */
-    lua_rawget(L, -2);                                              /* stack: mt ubox */
-    if (lua_isnil(L, -1))
-    {
-        // use global ubox
-        lua_pop(L, 1);                                              /* stack: mt */
-        lua_pushstring(L, "tolua_ubox");                            /* stack: mt key */
-        lua_rawget(L, LUA_REGISTRYINDEX);                           /* stack: mt ubox */
-    };
-    
-    
     // cleanup root
-    tolua_remove_value_from_root(L, ptr);
-    
-    lua_pushlightuserdata(L, ptr);                                  /* stack: mt ubox ptr */
-    lua_rawget(L,-2);                                               /* stack: mt ubox ud */
-    if (lua_isnil(L, -1))
+    lua_pushlightuserdata(L, vptr);                                 /* stack: root ud ptr */
+    lua_pushnil(L);                                                 /* stack: root ud ptr nil */
+    lua_rawset(L, -4);                             /* root[ptr] = nil, stack: root ud */
+    lua_remove(L, -2);                                              /* stack: ud */
+    
+    // cleanup mapping
+    lua_pushstring(L, TOLUA_PTR_USERDATA_MAPPING);
+    lua_rawget(L, LUA_REGISTRYINDEX);                               /* stack: ud ptr_ud */
+    lua_pushlightuserdata(L, vptr);                                 /* stack: ud ptr_ud ptr */
+    lua_pushnil(L);                                                 /* stack: ud ptr_ud ptr nil */
+    lua_rawset(L, -3);                           /* ptr_ud[ptr] = nil, stack: ud ptr_ud */
+    lua_pop(L, 1);                                                  /* stack: ud */
+    
+    // cleanup ubox
+    if (lua_getmetatable(L, -1))                                    /* stack: ud mt */
     {
-        // Lua object has released (GC), C++ object not in ubox.
-        //printf("[LUA ERROR] remove CCObject with NULL ubox, refid: %d, ptr: %x, type: %s\n", refid, (int)ptr, type);
-        lua_pop(L, 3);
-        return -3;
+        lua_pushstring(L, "tolua_ubox");
+        lua_rawget(L, -2);                                          /* stack: ud mt ubox */
+        if (lua_isnil(L, -1))
+        {
+            // use global ubox
+            lua_pop(L, 1);                                          /* stack: ud mt */
+            lua_pushstring(L, "tolua_ubox");
+            lua_rawget(L, LUA_REGISTRYINDEX);                       /* stack: ud mt ubox */
+        }
+        lua_pushlightuserdata(L, vptr);                             /* stack: ud mt ubox ptr */
+        lua_pushnil(L);                                             /* stack: ud mt ubox ptr nil */
+        lua_rawset(L, -3);                         /* ubox[ptr] = nil, stack: ud mt ubox */
+        lua_pop(L, 2);                                              /* stack: ud */
     }
-
+    
     // cleanup peertable
-    lua_pushvalue(L, LUA_REGISTRYINDEX);
+    lua_pushvalue(L, TOLUA_NOPEER);
     lua_setfenv(L, -2);
-
-    ud = (void**)lua_touserdata(L, -1);
-    lua_pop(L, 1);                                                  /* stack: mt ubox */
-    if (ud == NULL)
-    {
-        printf("[LUA ERROR] remove CCObject with NULL userdata, refid: %d, ptr: %p, type: %s\n", refid, ptr, type);
-        lua_pop(L, 2);
-        return -1;
-    }
     
     // clean userdata
+    ud = (void**)lua_touserdata(L, -1);
     *ud = NULL;
-    
-    lua_pushlightuserdata(L, ptr);                                  /* stack: mt ubox ptr */
-    lua_pushnil(L);                                                 /* stack: mt ubox ptr nil */
-    lua_rawset(L, -3);                             /* ubox[ptr] = nil, stack: mt ubox */
-    
-    lua_pop(L, 2);
-    //printf("[LUA] remove CCObject, refid: %d, ptr: %x, type: %s\n", refid, (int)ptr, type);
+    lua_pop(L, 1);                                                  /* stack: - */
+    //printf("[LUA] remove CCObject, ptr: %x\n", (int)vptr);
     return 0;
 }
     
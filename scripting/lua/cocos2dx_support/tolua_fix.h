@@ -8,8 +8,8 @@
 extern "C" {
 #endif
     
-#define TOLUA_REFID_PTR_MAPPING "toluafix_refid_ptr_mapping"
-#define TOLUA_REFID_TYPE_MAPPING "toluafix_refid_type_mapping"
+#define TOLUA_PTR_USERDATA_MAPPING "toluafix_ptr_userdata_mapping"
+#define TOLUA_TYPE_METATABLE_MAPPING "toluafix_type_metatable_mapping"
 #define TOLUA_REFID_FUNCTION_MAPPING "toluafix_refid_function_mapping"
 #define TOLUA_REFID_TABLE_MAPPING "toluafix_refid_table_mapping"
     
@@ -19,7 +19,7 @@ TOLUA_API int toluafix_pushusertype_ccobject(lua_State *L,
                                              int *p_refid,
                                              void *vptr,
                                              const char *vtype);
-TOLUA_API int toluafix_remove_ccobject_by_refid(lua_State* L, int refid);
+TOLUA_API int toluafix_remove_ccobject(lua_State* L, void* vptr);
 TOLUA_API int toluafix_ref_function(lua_State* L, int lo, int def);
 TOLUA_API void toluafix_get_function_by_refid(lua_State* L, int refid);
 TOLUA_API void toluafix_remove_function_by_refid(lua_State* L, int refid);
@@ -27,7 +27,6 @@ TOLUA_API int toluafix_isfunction(lua_State* L, int lo, const char* type, int de
 TOLUA_API int toluafix_totable(lua_State* L, int lo, int def);
 TOLUA_API int toluafix_istable(lua_State* L, int lo, const char* type, int def, tolua_Error* err);
 TOLUA_API void toluafix_stack_dump(lua_State* L, const char* label);
-TOLUA_API void toluafix_add_type_mapping(unsigned int type, const char* clsName);
 TOLUA_API int toluafix_ref_table(lua_State* L, int lo, int def);
 TOLUA_API void toluafix_get_table_by_refid(lua_State* L, int refid);
 TOLUA_API void toluafix_remove_table_by_refid(lua_State* L, int refid);
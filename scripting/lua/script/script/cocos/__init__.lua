@@ -47,6 +47,24 @@ function __G__TRACKBACK__(msg)
     end
 end
 
+-- for CCLuaEngine schedule batch mode, list is flat array of function, target and dt
+-- target is false if function has no target. An error doesn't stop other functions. alive(i)
+-- is false if function at i is unscheduled by previous one
+function __G__DISPATCH_SCHEDULES__(list, alive)
+    local xpcall = xpcall
+    local traceback = __G__TRACKBACK__
+    for i = 1, #list, 3 do
+        if alive(i) then
+            local target = list[i + 1]
+            if target then
+                xpcall(list[i], traceback, target, list[i + 2])
+            else
+                xpcall(list[i], traceback, list[i + 2])
+            end
+        end
+    end
+end
+
 -- load lua file under a folder, include subfolders
 function loadLua(name)
     -- internal and external path
@@ -72,7 +90,7 @@ function loadLua(name)
                 entries[tostring(s)] = internalPath
             end
         end
-    else
+    elseif CCUtils:isPathExistent(internalPath) then
         internalEntries = lfs.dir(internalPath)
         for entry in internalEntries do
             local isLua = entry ~= "__init__.lua" and string.find(entry, ".lua") ~= nil
@@ -96,6 +114,13 @@ function loadLua(name)
         end
     end
     
+    -- scripts in bundles, if script file is also existent, loader decides which one is used
+    for _,entry in ipairs(listBundledScripts("script/" .. name)) do
+        if entry ~= "__init__" and entries[entry] == nil then
+            entries[entry] = "script/" .. name
+        end
+    end
+    
     -- load
     for file,path in pairs(entries) do
         local fullpath = path .. "/" .. file
@@ -0,0 +1,70 @@
+debug = debug or {}
+
+-- time a function, returns milliseconds
+local function timeit(iterations, func)
+    collectgarbage("collect")
+    local start = os.clock()
+    func(iterations)
+    return (os.clock() - start) * 1000
+end
+
+-- compare ways to pass value types between lua and native: table, numbers and
+-- ffi cdata. It prints time of every way, cdata is skipped if engine doesn't
+-- accept it, see CC_LUA_FFI_VALUE_TYPES
+function debug.benchValueTypes(iterations)
+    iterations = iterations or 100000
+    local node = CCNode:create()
+    local results = {}
+
+    results[#results + 1] = { "set point, table", timeit(iterations, function(n)
+        for i = 1, n do
+            node:setAnchorPoint(cc.p(i, i))
+        end
+    end) }
+    results[#results + 1] = { "set point, numbers", timeit(iterations, function(n)
+        for i = 1, n do
+            node:setAnchorPoint(i, i)
+        end
+    end) }
+    if cc.fp and pcall(node.setAnchorPoint, node, cc.fp(0, 0)) then
+        results[#results + 1] = { "set point, cdata", timeit(iterations, function(n)
+            local p = cc.fp(0, 0)
+            for i = 1, n do
+                p.x = i
+                p.y = i
+                node:setAnchorPoint(p)
+            end
+        end) }
+    end
+    results[#results + 1] = { "get point, table", timeit(iterations, function(n)
+        local sum = 0
+        for i = 1, n do
+            local p = node:getAnchorPoint()
+            sum = sum + p.x + p.y
+        end
+    end) }
+    results[#results + 1] = { "get point, numbers", timeit(iterations, function(n)
+        local sum = 0
+        for i = 1, n do
+            local x, y = node:getAnchorPointUnpacked()
+            sum = sum + x + y
+        end
+    end) }
+    results[#results + 1] = { "set color, table", timeit(iterations, function(n)
+        local sprite = CCSprite:create()
+        for i = 1, n do
+            sprite:setColor(cc.c3b(i % 256, 0, 0))
+        end
+    end) }
+    results[#results + 1] = { "set color, numbers", timeit(iterations, function(n)
+        local sprite = CCSprite:create()
+        for i = 1, n do
+            sprite:setColor(i % 256, 0, 0)
+        end
+    end) }
+
+    for _,r in ipairs(results) do
+        cc.log("%-20s %8.2f ms, %d calls", r[1], r[2], iterations)
+    end
+    return results
+end
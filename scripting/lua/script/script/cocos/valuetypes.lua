@@ -0,0 +1,63 @@
+cc = cc or {}
+
+-- LuaJIT FFI value types, they have same layout as CCPoint, CCSize, CCRect, ccColor3B,
+-- ccColor4B and ccColor4F. If engine is built with CC_LUA_FFI_VALUE_TYPES, bindings accept
+-- them wherever a table is accepted, and read them without table lookup
+local ok, ffi = pcall(require, "ffi")
+if not ok then
+    return
+end
+
+-- cdef can't be run twice, check it in case script is reloaded
+if not pcall(ffi.typeof, "cc_point") then
+    ffi.cdef[[
+        typedef struct { float x, y; } cc_point;
+        typedef struct { float width, height; } cc_size;
+        typedef struct { cc_point origin; cc_size size; } cc_rect;
+        typedef struct { uint8_t r, g, b; } cc_color3b;
+        typedef struct { uint8_t r, g, b, a; } cc_color4b;
+        typedef struct { float r, g, b, a; } cc_color4f;
+    ]]
+end
+
+local point_t = ffi.typeof("cc_point")
+local size_t = ffi.typeof("cc_size")
+local rect_t = ffi.typeof("cc_rect")
+local color3b_t = ffi.typeof("cc_color3b")
+local color4b_t = ffi.typeof("cc_color4b")
+local color4f_t = ffi.typeof("cc_color4f")
+
+-- bindings only read cdata of these ctypes, ids are saved in registry with ctype name as key
+if debug and debug.getregistry then
+    local registry = debug.getregistry()
+    registry.cc_point = tonumber(point_t)
+    registry.cc_size = tonumber(size_t)
+    registry.cc_rect = tonumber(rect_t)
+    registry.cc_color3b = tonumber(color3b_t)
+    registry.cc_color4b = tonumber(color4b_t)
+    registry.cc_color4f = tonumber(color4f_t)
+end
+
+function cc.fp(x, y)
+    return point_t(x, y)
+end
+
+function cc.fsize(width, height)
+    return size_t(width, height)
+end
+
+function cc.frect(x, y, width, height)
+    return rect_t({ x, y }, { width, height })
+end
+
+function cc.fc3b(r, g, b)
+    return color3b_t(r, g, b)
+end
+
+function cc.fc4b(r, g, b, a)
+    return color4b_t(r, g, b, a)
+end
+
+function cc.fc4f(r, g, b, a)
+    return color4f_t(r, g, b, a)
+end
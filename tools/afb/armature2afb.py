@@ -0,0 +1,636 @@
+# coding:utf8
+#!/usr/bin/python
+
+import sys
+import os
+import getopt
+import struct
+import json
+import math
+import xml.etree.ElementTree as ET
+
+# see extensions/CocoStudio/Armature/utils/CCArmatureFlatBinary.h
+AFB_MAGIC = 0x42464143
+AFB_VERSION = 1
+
+AFB_SCALE_SKIN_POSITION = 0x1
+AFB_SCALE_FRAME_POSITION = 0x2
+AFB_NODE_USE_COLOR = 0x1
+AFB_FRAME_TWEEN = 0x1
+
+TABLES = ['strings', 'armatures', 'bones', 'displays', 'animations', 'movements', 'movementBones',
+          'frames', 'easingParams', 'textures', 'contours', 'vertices', 'configFiles']
+HEADER_SIZE = 16 + 8 * len(TABLES)
+
+# same as CCArmatureDefine.h
+VERSION_COMBINED = 0.30
+VERSION_CHANGE_ROTATION_RANGE = 1.0
+VERSION_COLOR_READING = 1.1
+VERSION_2_0 = 2.0
+
+CS_DISPLAY_SPRITE = 0
+CS_DISPLAY_ARMATURE = 1
+CS_DISPLAY_PARTICLE = 2
+
+LINEAR = 0
+SINE_EASE_IN_OUT = 3
+
+GL_ONE = 1
+GL_SRC_ALPHA = 0x0302
+GL_ONE_MINUS_SRC_ALPHA = 0x0303
+GL_ONE_MINUS_SRC_COLOR = 0x0301
+GL_DST_COLOR = 0x0306
+CC_BLEND_SRC = GL_ONE
+CC_BLEND_DST = GL_ONE_MINUS_SRC_ALPHA
+
+# CCBlendType used by the flash tool
+XML_BLEND_FUNCS = {0: (CC_BLEND_SRC, CC_BLEND_DST), 8: (GL_SRC_ALPHA, GL_ONE),
+                   3: (GL_DST_COLOR, GL_ONE_MINUS_SRC_ALPHA), 5: (GL_ONE, GL_ONE_MINUS_SRC_COLOR)}
+
+
+def help():
+    print('#####################################################')
+    print('# Usage of flat binary armature converter')
+    print('# armature2afb [options] file...')
+    print('# Convert CocoStudio ExportJson/json or flash tool xml to')
+    print('# flat binary armature file (.afb), which is loaded by')
+    print('# CCArmatureDataManager::addArmatureFileInfo in place,')
+    print('# without parsing. Sprite files listed in the source are')
+    print('# loaded from the same folder as before')
+    print('# Options:')
+    print('# [-s|--source] folder')
+    print('#     convert all ExportJson and xml files in folder, recursively')
+    print('# [-o|--output] folder')
+    print('#     output directory, if not set, afb is saved beside the source')
+    print('# [-h|--help]')
+    print('#     show command usage, or just don\'t specify any arguments')
+
+
+class Node:
+    """ same fields and defaults as CCBaseData """
+    def __init__(self):
+        self.x = 0.0
+        self.y = 0.0
+        self.skewX = 0.0
+        self.skewY = 0.0
+        self.scaleX = 1.0
+        self.scaleY = 1.0
+        self.tweenRotate = 0.0
+        self.zOrder = 0
+        self.useColor = False
+        self.a = self.r = self.g = self.b = 255
+
+    def pack(self):
+        return struct.pack('<7fi4BI', self.x, self.y, self.skewX, self.skewY, self.scaleX, self.scaleY,
+                           self.tweenRotate, int(self.zOrder), clamp_byte(self.a), clamp_byte(self.r),
+                           clamp_byte(self.g), clamp_byte(self.b), AFB_NODE_USE_COLOR if self.useColor else 0)
+
+
+class Frame(Node):
+    """ same fields and defaults as CCFrameData """
+    def __init__(self):
+        Node.__init__(self)
+        self.frameID = 0
+        self.duration = 1
+        self.tweenEasing = LINEAR
+        self.easingParams = []
+        self.isTween = True
+        self.displayIndex = 0
+        self.blendSrc = CC_BLEND_SRC
+        self.blendDst = CC_BLEND_DST
+        self.event = ''
+        self.movement = ''
+        self.sound = ''
+        self.soundEffect = ''
+
+    def copy(self):
+        frame = Frame()
+        frame.__dict__.update(self.__dict__)
+        frame.easingParams = list(self.easingParams)
+        return frame
+
+
+class Data:
+    """ CCDatas of one source file """
+    def __init__(self):
+        self.flags = 0
+        self.armatures = []         # (name, dataVersion, [bone])
+        self.animations = []        # (name, [movement])
+        self.textures = []          # dict
+        self.configFiles = []
+
+
+def clamp_byte(v):
+    return max(0, min(255, int(v)))
+
+
+def fix_rotation(frames):
+    """ change rotation range from (-180 -- 180) to (-infinity -- infinity) """
+    for i in range(len(frames) - 1, 0, -1):
+        difSkewX = frames[i].skewX - frames[i - 1].skewX
+        difSkewY = frames[i].skewY - frames[i - 1].skewY
+        if difSkewX < -math.pi or difSkewX > math.pi:
+            frames[i - 1].skewX += -2 * math.pi if difSkewX < 0 else 2 * math.pi
+        if difSkewY < -math.pi or difSkewY > math.pi:
+            frames[i - 1].skewY += -2 * math.pi if difSkewY < 0 else 2 * math.pi
+
+
+# ExportJson
+
+def jget(dic, key, default):
+    """ null values are read as default, as DictionaryHelper does """
+    v = dic.get(key)
+    return default if v is None else v
+
+
+def json_node(node, dic, contentScale, version):
+    node.x = jget(dic, 'x', 0.0) * contentScale
+    node.y = jget(dic, 'y', 0.0) * contentScale
+    node.zOrder = jget(dic, 'z', 0)
+    node.skewX = jget(dic, 'kX', 0.0)
+    node.skewY = jget(dic, 'kY', 0.0)
+    node.scaleX = jget(dic, 'cX', 1.0)
+    node.scaleY = jget(dic, 'cY', 1.0)
+    color = dic.get('color')
+    if version >= VERSION_COLOR_READING and isinstance(color, dict):
+        node.a = jget(color, 'a', 255)
+        node.r = jget(color, 'r', 255)
+        node.g = jget(color, 'g', 255)
+        node.b = jget(color, 'b', 255)
+        node.useColor = True
+
+
+def json_display(dic, contentScale):
+    displayType = jget(dic, 'displayType', CS_DISPLAY_SPRITE)
+    skin = Node()
+    name = ''
+    if displayType == CS_DISPLAY_SPRITE:
+        name = dic.get('name') or ''
+        skins = dic.get('skin_data') or []
+        if skins:
+            s = skins[0]
+            # position read scale is applied at load time
+            skin.x = jget(s, 'x', 0.0) * contentScale
+            skin.y = jget(s, 'y', 0.0) * contentScale
+            skin.scaleX = jget(s, 'cX', 1.0)
+            skin.scaleY = jget(s, 'cY', 1.0)
+            skin.skewX = jget(s, 'kX', 0.0)
+            skin.skewY = jget(s, 'kY', 0.0)
+    elif displayType == CS_DISPLAY_ARMATURE:
+        name = dic.get('name') or ''
+    elif displayType == CS_DISPLAY_PARTICLE:
+        name = dic.get('plist') or ''
+    return (displayType, name, skin)
+
+
+def json_frame(dic, contentScale, version):
+    frame = Frame()
+    json_node(frame, dic, contentScale, version)
+    frame.tweenEasing = jget(dic, 'twE', LINEAR)
+    frame.displayIndex = jget(dic, 'dI', 0)
+    frame.blendSrc = jget(dic, 'bd_src', CC_BLEND_SRC)
+    frame.blendDst = jget(dic, 'bd_dst', CC_BLEND_DST)
+    frame.isTween = jget(dic, 'tweenFrame', True)
+    frame.event = dic.get('evt') or ''
+    if version < VERSION_COMBINED:
+        frame.duration = jget(dic, 'dr', 1)
+    else:
+        frame.frameID = jget(dic, 'fi', 0)
+    frame.easingParams = [float(v) for v in (dic.get('twEP') or [])]
+    return frame
+
+
+def json_movement_bone(dic, contentScale, version):
+    bone = {'name': dic.get('name') or '', 'delay': jget(dic, 'dl', 0.0), 'scale': 1.0, 'duration': 0.0}
+    frames = []
+    for f in dic.get('frame_data') or []:
+        frame = json_frame(f, contentScale, version)
+        frames.append(frame)
+        if version < VERSION_COMBINED:
+            frame.frameID = bone['duration']
+            bone['duration'] += frame.duration
+
+    if version < VERSION_CHANGE_ROTATION_RANGE:
+        fix_rotation(frames)
+
+    if version < VERSION_COMBINED and frames:
+        frame = frames[-1].copy()
+        frame.frameID = bone['duration']
+        frames.append(frame)
+
+    bone['frames'] = frames
+    return bone
+
+
+def json_movement(dic, contentScale, version):
+    movement = {
+        'name': dic.get('name') or '',
+        'loop': jget(dic, 'lp', True),
+        'durationTween': jget(dic, 'drTW', 0),
+        'durationTo': jget(dic, 'to', 0),
+        'duration': jget(dic, 'dr', 0),
+        'scale': jget(dic, 'sc', 1.0) if 'dr' in dic else 1.0,
+        'tweenEasing': jget(dic, 'twE', LINEAR),
+        'bones': [json_movement_bone(b, contentScale, version) for b in dic.get('mov_bone_data') or []],
+    }
+    return movement
+
+
+def load_json(path):
+    with open(path, 'rb') as f:
+        root = json.loads(f.read().decode('utf-8'))
+
+    data = Data()
+    data.flags = AFB_SCALE_SKIN_POSITION
+    contentScale = jget(root, 'content_scale', 1.0)
+
+    # animations are decoded with the version of the last armature, as CCDataReaderHelper does
+    version = 0.1
+    for a in root.get('armature_data') or []:
+        version = jget(a, 'version', 0.1)
+        bones = []
+        for b in a.get('bone_data') or []:
+            node = Node()
+            json_node(node, b, contentScale, version)
+            displays = [json_display(d, contentScale) for d in b.get('display_data') or []]
+            bones.append((b.get('name') or '', b.get('parent') or '', node, displays))
+        data.armatures.append((a.get('name') or '', version, bones))
+
+    for a in root.get('animation_data') or []:
+        movements = [json_movement(m, contentScale, version) for m in a.get('mov_data') or []]
+        data.animations.append((a.get('name') or '', movements))
+
+    for t in root.get('texture_data') or []:
+        contours = []
+        for c in t.get('contour_data') or []:
+            contours.append([(jget(v, 'x', 0.0), jget(v, 'y', 0.0)) for v in reversed(c.get('vertex') or [])])
+        data.textures.append({'name': t.get('name') or '', 'width': jget(t, 'width', 0.0), 'height': jget(t, 'height', 0.0),
+                              'pivotX': jget(t, 'pX', 0.0), 'pivotY': jget(t, 'pY', 0.0), 'contours': contours})
+
+    for p in root.get('config_file_path') or []:
+        data.configFiles.append(os.path.splitext(p)[0])
+
+    return data
+
+
+# flash tool xml
+
+def node_to_matrix(node):
+    if node.skewX == -node.skewY:
+        sine = math.sin(node.skewX)
+        cosine = math.cos(node.skewX)
+        m = [node.scaleX * cosine, node.scaleX * -sine, node.scaleY * sine, node.scaleY * cosine]
+    else:
+        m = [node.scaleX * math.cos(node.skewY), node.scaleX * math.sin(node.skewY),
+             node.scaleY * math.sin(node.skewX), node.scaleY * math.cos(node.skewX)]
+    return m + [node.x, node.y]
+
+
+def matrix_concat(t1, t2):
+    a1, b1, c1, d1, tx1, ty1 = t1
+    a2, b2, c2, d2, tx2, ty2 = t2
+    return [a1 * a2 + b1 * c2, a1 * b2 + b1 * d2, c1 * a2 + d1 * c2, c1 * b2 + d1 * d2,
+            tx1 * a2 + ty1 * c2 + tx2, tx1 * b2 + ty1 * d2 + ty2]
+
+
+def matrix_invert(t):
+    a, b, c, d, tx, ty = t
+    det = 1.0 / (a * d - b * c)
+    return [det * d, -det * b, -det * c, det * a, det * (c * ty - d * tx), det * (b * tx - a * ty)]
+
+
+def transform_from_parent(node, parent):
+    """ CCTransformHelp::transformFromParent """
+    a, b, c, d, tx, ty = matrix_concat(node_to_matrix(node), matrix_invert(node_to_matrix(parent)))
+    node.skewX = -(math.atan2(d, c) - 1.5707964)
+    node.skewY = math.atan2(b, a)
+    node.scaleX = math.sqrt(a * a + b * b)
+    node.scaleY = math.sqrt(c * c + d * d)
+    node.x = tx
+    node.y = ty
+
+
+def xml_float(elem, key, default=0.0):
+    v = elem.get(key)
+    return float(v) if v is not None else default
+
+
+def xml_int(elem, key, default=0):
+    v = elem.get(key)
+    return int(float(v)) if v is not None else default
+
+
+def xml_easing(elem, default):
+    easing = elem.get('twE')
+    if easing is None:
+        return default
+    if easing == 'NaN':
+        return LINEAR
+    easing = int(float(easing))
+    return SINE_EASE_IN_OUT if easing == 2 else easing
+
+
+def xml_frame(elem, parentElem, flashVersion):
+    xKey, yKey = ('cocos2d_x', 'cocos2d_y') if flashVersion >= VERSION_2_0 else ('x', 'y')
+
+    frame = Frame()
+    frame.movement = elem.get('mov') or ''
+    frame.event = elem.get('evt') or ''
+    frame.sound = elem.get('sd') or ''
+    frame.soundEffect = elem.get('sdE') or ''
+    if elem.get('tweenFrame') is not None:
+        frame.isTween = elem.get('tweenFrame') in ('true', '1')
+
+    # position read scale is applied at load time
+    frame.x = xml_float(elem, xKey)
+    frame.y = -xml_float(elem, yKey)
+    frame.scaleX = xml_float(elem, 'cX', 1.0)
+    frame.scaleY = xml_float(elem, 'cY', 1.0)
+    frame.skewX = math.radians(xml_float(elem, 'kX'))
+    frame.skewY = math.radians(-xml_float(elem, 'kY'))
+    frame.duration = xml_int(elem, 'dr', 1)
+    frame.displayIndex = xml_int(elem, 'dI', 0)
+    frame.zOrder = xml_int(elem, 'z', 0)
+    frame.tweenRotate = xml_float(elem, 'twR')
+    if elem.get('bd') is not None:
+        frame.blendSrc, frame.blendDst = XML_BLEND_FUNCS.get(xml_int(elem, 'bd'), (CC_BLEND_SRC, CC_BLEND_DST))
+
+    color = elem.find('colorTransform')
+    if color is not None:
+        frame.a = int(2.55 * xml_int(color, 'aM') + xml_int(color, 'a', 100))
+        frame.r = int(2.55 * xml_int(color, 'rM') + xml_int(color, 'r', 100))
+        frame.g = int(2.55 * xml_int(color, 'gM') + xml_int(color, 'g', 100))
+        frame.b = int(2.55 * xml_int(color, 'bM') + xml_int(color, 'b', 100))
+        frame.useColor = True
+
+    frame.tweenEasing = xml_easing(elem, frame.tweenEasing)
+
+    if parentElem is not None:
+        parent = Node()
+        parent.x = xml_float(parentElem, xKey)
+        parent.y = -xml_float(parentElem, yKey)
+        parent.skewX = math.radians(xml_float(parentElem, 'kX'))
+        parent.skewY = math.radians(-xml_float(parentElem, 'kY'))
+        transform_from_parent(frame, parent)
+
+    return frame
+
+
+def xml_movement_bone(elem, parentElem, flashVersion):
+    bone = {'name': elem.get('name') or '', 'scale': xml_float(elem, 'sc', 1.0), 'delay': 0.0}
+    delay = xml_float(elem, 'dl')
+    bone['delay'] = delay - 1 if delay > 0 else delay
+
+    parentFrames = parentElem.findall('f') if parentElem is not None else []
+    parentFrame = None
+    parentTotalDuration = 0
+    currentDuration = 0
+    i = 0
+
+    frames = []
+    totalDuration = 0
+    for f in elem.findall('f'):
+        # find the parent frame which is playing at this frame
+        while i < len(parentFrames) and (parentFrame is None or totalDuration < parentTotalDuration
+                                         or totalDuration >= parentTotalDuration + currentDuration):
+            parentFrame = parentFrames[i]
+            parentTotalDuration += currentDuration
+            currentDuration = xml_int(parentFrame, 'dr', currentDuration)
+            i += 1
+
+        frame = xml_frame(f, parentFrame, flashVersion)
+        frame.frameID = totalDuration
+        totalDuration += frame.duration
+        frames.append(frame)
+
+    fix_rotation(frames)
+
+    if frames:
+        frame = frames[-1].copy()
+        frame.frameID = totalDuration
+        frames.append(frame)
+
+    bone['duration'] = float(totalDuration)
+    bone['frames'] = frames
+    return bone
+
+
+def load_xml(path):
+    root = ET.parse(path).getroot()
+    flashVersion = xml_float(root, 'version')
+
+    data = Data()
+    data.flags = AFB_SCALE_FRAME_POSITION
+
+    parents = {}
+    armaturesElem = root.find('armatures')
+    for a in armaturesElem.findall('armature') if armaturesElem is not None else []:
+        bones = []
+        boneParents = {}
+        for b in a.findall('b'):
+            node = Node()
+            node.zOrder = xml_int(b, 'z', 0)
+            displays = []
+            for d in b.findall('d'):
+                displayType = CS_DISPLAY_ARMATURE if xml_int(d, 'isArmature', 0) else CS_DISPLAY_SPRITE
+                displays.append((displayType, d.get('name') or '', Node()))
+            boneParents[b.get('name')] = b.get('parent') or ''
+            bones.append((b.get('name') or '', b.get('parent') or '', node, displays))
+        parents[a.get('name')] = boneParents
+        # flash tool xml has no per armature version
+        data.armatures.append((a.get('name') or '', 0.1, bones))
+
+    animationsElem = root.find('animations')
+    for a in animationsElem.findall('animation') if animationsElem is not None else []:
+        boneParents = parents.get(a.get('name'), {})
+        movements = []
+        for m in a.findall('mov'):
+            movement = {
+                'name': m.get('name') or '',
+                'duration': xml_int(m, 'dr'),
+                'durationTo': xml_int(m, 'to'),
+                'durationTween': xml_int(m, 'drTW'),
+                'loop': bool(xml_int(m, 'lp', 1)),
+                'scale': 1.0,
+                'tweenEasing': xml_easing(m, LINEAR),
+                'bones': [],
+            }
+            boneElems = m.findall('b')
+            names = set()
+            for b in boneElems:
+                name = b.get('name')
+                if name in names:
+                    continue
+                names.add(name)
+
+                parentElem = None
+                parentName = boneParents.get(name, '')
+                if parentName:
+                    for p in boneElems:
+                        if p.get('name') == parentName:
+                            parentElem = p
+                            break
+                movement['bones'].append(xml_movement_bone(b, parentElem, flashVersion))
+            movements.append(movement)
+        data.animations.append((a.get('name') or '', movements))
+
+    pivotKeys = ('cocos2d_pX', 'cocos2d_pY') if flashVersion >= VERSION_2_0 else ('pX', 'pY')
+    texturesElem = root.find('TextureAtlas')
+    for t in texturesElem.findall('SubTexture') if texturesElem is not None else []:
+        width = xml_float(t, 'width')
+        height = xml_float(t, 'height')
+        px = xml_float(t, pivotKeys[0])
+        py = xml_float(t, pivotKeys[1])
+        contours = []
+        for c in t.findall('con'):
+            contours.append([(xml_float(v, 'x'), -xml_float(v, 'y')) for v in c.findall('con_vt')])
+        # size isn't kept by the xml reader either, only the anchor point
+        data.textures.append({'name': t.get('name') or '', 'width': 0.0, 'height': 0.0,
+                              'pivotX': px / width if width else 0.0,
+                              'pivotY': (height - py) / height if height else 0.0, 'contours': contours})
+
+    return data
+
+
+# writer
+
+class Strings:
+    def __init__(self):
+        self.data = bytearray(b'\0')
+        self.offsets = {'': 0}
+
+    def add(self, s):
+        s = s or ''
+        if s not in self.offsets:
+            self.offsets[s] = len(self.data)
+            self.data += s.encode('utf-8') + b'\0'
+        return self.offsets[s]
+
+
+def write(data, out):
+    strings = Strings()
+    tables = dict((name, bytearray()) for name in TABLES)
+    counts = dict((name, 0) for name in TABLES)
+
+    def add(table, record):
+        tables[table] += record
+        counts[table] += 1
+
+    for name, version, bones in data.armatures:
+        add('armatures', struct.pack('<IfII', strings.add(name), version, counts['bones'], len(bones)))
+        for boneName, parentName, node, displays in bones:
+            add('bones', node.pack() + struct.pack('<4I', strings.add(boneName), strings.add(parentName),
+                                                   counts['displays'], len(displays)))
+            for displayType, displayName, skin in displays:
+                add('displays', struct.pack('<iI', displayType, strings.add(displayName)) + skin.pack())
+
+    for name, movements in data.animations:
+        add('animations', struct.pack('<3I', strings.add(name), counts['movements'], len(movements)))
+        for m in movements:
+            add('movements', struct.pack('<I4ifIII', strings.add(m['name']), m['duration'], m['durationTo'],
+                                         m['durationTween'], m['tweenEasing'], m['scale'], 1 if m['loop'] else 0,
+                                         counts['movementBones'], len(m['bones'])))
+            for b in m['bones']:
+                add('movementBones', struct.pack('<I3fII', strings.add(b['name']), b['delay'], b['scale'],
+                                                 b['duration'], counts['frames'], len(b['frames'])))
+                for f in b['frames']:
+                    add('frames', f.pack() + struct.pack('<4i3I2I4I', int(f.frameID), int(f.duration),
+                                                         int(f.tweenEasing), int(f.displayIndex),
+                                                         f.blendSrc, f.blendDst, AFB_FRAME_TWEEN if f.isTween else 0,
+                                                         counts['easingParams'], len(f.easingParams),
+                                                         strings.add(f.event), strings.add(f.movement),
+                                                         strings.add(f.sound), strings.add(f.soundEffect)))
+                    for v in f.easingParams:
+                        add('easingParams', struct.pack('<f', v))
+
+    for t in data.textures:
+        add('textures', struct.pack('<I4fII', strings.add(t['name']), t['width'], t['height'],
+                                    t['pivotX'], t['pivotY'], counts['contours'], len(t['contours'])))
+        for contour in t['contours']:
+            add('contours', struct.pack('<II', counts['vertices'], len(contour)))
+            for x, y in contour:
+                add('vertices', struct.pack('<2f', x, y))
+
+    for path in data.configFiles:
+        add('configFiles', struct.pack('<I', strings.add(path)))
+
+    tables['strings'] = strings.data
+    counts['strings'] = len(strings.data)
+
+    # tables are 4 bytes aligned, records are read in place
+    body = bytearray()
+    entries = []
+    for name in TABLES:
+        while (HEADER_SIZE + len(body)) % 4 != 0:
+            body += b'\0'
+        entries.append((HEADER_SIZE + len(body), counts[name]))
+        body += tables[name]
+    while len(body) % 4 != 0:
+        body += b'\0'
+
+    header = struct.pack('<IiII', AFB_MAGIC, AFB_VERSION, HEADER_SIZE + len(body), data.flags)
+    for offset, count in entries:
+        header += struct.pack('<II', offset, count)
+
+    with open(out, 'wb') as f:
+        f.write(header + body)
+    return counts
+
+
+def convert(path, out):
+    if path.endswith('.xml'):
+        data = load_xml(path)
+    else:
+        data = load_json(path)
+    counts = write(data, out)
+    print('%s -> %s, %d armatures, %d movements, %d frames' % (path, out, counts['armatures'],
+                                                              counts['movements'], counts['frames']))
+
+
+def output_path(path, outDir):
+    name = os.path.splitext(path)[0] + '.afb'
+    if outDir:
+        name = os.path.join(outDir, os.path.basename(name))
+    return name
+
+
+def main():
+    if len(sys.argv) <= 1:
+        help()
+        sys.exit(0)
+
+    try:
+        opts, args = getopt.getopt(sys.argv[1:], 's:o:h', ['source=', 'output=', 'help'])
+    except getopt.GetoptError:
+        help()
+        sys.exit(1)
+
+    outDir = None
+    files = list(args)
+    for opt, value in opts:
+        if opt in ('-s', '--source'):
+            for root, dirs, names in os.walk(value):
+                for f in names:
+                    if f.endswith('.ExportJson') or f.endswith('.xml'):
+                        files.append(os.path.join(root, f))
+        elif opt in ('-o', '--output'):
+            outDir = value
+        elif opt in ('-h', '--help'):
+            help()
+            sys.exit(0)
+
+    if outDir and not os.path.exists(outDir):
+        os.makedirs(outDir)
+
+    failed = 0
+    for path in files:
+        try:
+            convert(path, output_path(path, outDir))
+        except Exception as e:
+            print('failed to convert %s: %s' % (path, e))
+            failed += 1
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == '__main__':
+    main()
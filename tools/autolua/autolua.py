@@ -495,6 +495,16 @@ class NativeType(object):
             return str(tpl).rstrip()
         return "#pragma warning NO CONVERSION TO NATIVE FOR " + self.name + "\n" + convert_opts['level'] * "\t\t" + "ok = false"
 
+    def unpacked_conversion(self, generator):
+        # conversion of a value type which can be passed as numbers, see 'unpacked' in conversions.yaml
+        if self.is_pointer or (self.is_ref and not self.is_const):
+            return None
+        keys = []
+        if self.canonical_type != None:
+            keys.append(self.canonical_type.name)
+        keys.append(self.name)
+        return dict_get_value_re(generator.tpl_opt['conversions']['unpacked'], keys)
+
 class NativeTypedef(object):
     def __init__(self, node, generator):
         self.node = node
@@ -574,6 +584,9 @@ class NativeOverloadedFunction(object):
         self.min_args = min(self.min_args, func.min_args)
         self.implementations.append(func)
 
+    def has_unpacked_getter(self, generator):
+        return False
+
     def generate_code(self, hfile, cppfile, clazz):
         static = self.implementations[0].static
         override = self.implementations[0].is_override
@@ -669,6 +682,21 @@ class NativeFunction(object):
                 return True
         return False
 
+    def unpacked_arg(self, generator):
+        # if the only argument is a value type, it can also be passed as numbers
+        if self.static or self.is_constructor or len(self.arguments) != 1:
+            return None
+        return self.arguments[0].unpacked_conversion(generator)
+
+    def unpacked_ret(self, generator):
+        # if a getter returns a value type, it also has a variant which returns numbers
+        if self.static or self.is_constructor or len(self.arguments) != 0:
+            return None
+        return self.ret_type.unpacked_conversion(generator)
+
+    def has_unpacked_getter(self, generator):
+        return self.unpacked_ret(generator) is not None
+
     def generate_code(self, hfile, cppfile, clazz):
         # if override method, no need generate
         if self.is_override:
@@ -6,6 +6,9 @@
     #set lua_type = $class_name
 #end if
 int ${signature}(lua_State* tolua_S) {
+    // count calls and time, if CC_LUA_PROFILER is enabled
+    CC_LUA_PROFILE_BINDING("${lua_type}:${func_name}");
+
     // variables
     int argc = 0;
     ${qualified_name}* cobj = nullptr;
@@ -114,10 +117,78 @@ int ${signature}(lua_State* tolua_S) {
     }
         #set $arg_idx = $arg_idx + 1
     #end while
+    #set $arg_unpacked = $unpacked_arg($generator)
+    #if $arg_unpacked
+        #set $arg = $arguments[0]
+
+    // the only argument can also be passed as numbers, without a table
+    if (argc == ${arg_unpacked['count']}) {
+        ${arg.decl_in_tpl($generator)} arg0;
+        ok &= ${arg_unpacked['to_native']}(tolua_S, 2, &arg0, "${lua_type}:${func_name}");
+        if(!ok) {
+            tolua_error(tolua_S,"invalid arguments in function '${signature}'", nullptr);
+            return 0;
+        }
+
+        // call function
+        #if $ret_type.name != "void"
+            #if $ret_type.is_enum
+        int ret = (int)cobj->${func_name}(arg0);
+            #else
+        ${ret_type.whole_decl_in_tpl($generator)} ret = cobj->${func_name}(arg0);
+            #end if
+        ${ret_type.lua_from_native({"generator": $generator,
+                                    "in_value": "ret",
+                                    "out_value": "ret",
+                                    "type_name": $ret_type.qualified_name.replace("*", ""),
+                                    "ntype": $ret_type.whole_decl_in_tpl($generator),
+                                    "class_name": $class_name,
+                                    "level": 2,
+                                    "arg_lua_type": $generator.to_lua_type($ret_type.qualified_name, $ret_type.qualified_ns)})};
+        return 1;
+        #else
+        cobj->${func_name}(arg0);
+        return 0;
+        #end if
+    }
+    #end if
 #end if
 
     // if to here, means argument count is not correct
     luaL_error(tolua_S, "%s has wrong number of arguments: %d, was expecting %d \n", "${lua_type}:${func_name}", argc, ${min_args});
     return 0;
 }
+#set $ret_unpacked = $unpacked_ret($generator)
+#if $ret_unpacked
+
+// same as ${func_name}, but returns numbers instead of a table
+int ${signature}Unpacked(lua_State* tolua_S) {
+    CC_LUA_PROFILE_BINDING("${lua_type}:${func_name}Unpacked");
+    ${qualified_name}* cobj = nullptr;
+\#if COCOS2D_DEBUG >= 1
+    tolua_Error tolua_err;
+    if (!tolua_isusertype(tolua_S, 1, "${lua_type}", 0, &tolua_err)) {
+        tolua_error(tolua_S, "#ferror in function '${signature}Unpacked'.", &tolua_err);
+        return 0;
+    }
+\#endif
+    cobj = (${qualified_name}*)tolua_tousertype(tolua_S, 1, 0);
+\#if COCOS2D_DEBUG >= 1
+    if (!cobj) {
+        tolua_error(tolua_S, "invalid 'cobj' in function '${signature}Unpacked'", nullptr);
+        return 0;
+    }
+\#endif
+
+    int argc = lua_gettop(tolua_S) - 1;
+    if (argc == 0) {
+        ${ret_type.whole_decl_in_tpl($generator)} ret = cobj->${func_name}();
+        return ${ret_unpacked['from_native']}(tolua_S, ret);
+    }
+
+    // if to here, means argument count is not correct
+    luaL_error(tolua_S, "%s has wrong number of arguments: %d, was expecting %d \n", "${lua_type}:${func_name}Unpacked", argc, 0);
+    return 0;
+}
+#end if
 
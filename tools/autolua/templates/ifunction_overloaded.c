@@ -6,6 +6,9 @@
     #set lua_type = $class_name
 #end if
 int ${signature}(lua_State* tolua_S) {
+    // count calls and time, if CC_LUA_PROFILER is enabled
+    CC_LUA_PROFILE_BINDING("${lua_type}:${func_name}");
+
     // variables
     int argc = 0;
     ${qualified_name}* cobj = nullptr;
@@ -4,4 +4,5 @@
 #end for
 \#include "tolua_fix.h"
 \#include "LuaBasicConversions.h"
+\#include "CCLuaProfiler.h"
 
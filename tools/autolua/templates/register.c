@@ -18,6 +18,9 @@ int lua_register_${target_module_fullname}_${class_name}(lua_State* tolua_S) {
         tolua_function(tolua_S, "new", lua_${target_module_fullname}_${class_name}_${class_name});
     #else if not $m.is_destructor
         tolua_function(tolua_S, "${m.func_name}", lua_${target_module_fullname}_${class_name}_${m.func_name});
+        #if $m.has_unpacked_getter($generator)
+        tolua_function(tolua_S, "${m.func_name}Unpacked", lua_${target_module_fullname}_${class_name}_${m.func_name}Unpacked);
+        #end if
     #end if
 #end for
 #for name, m in $static_methods.items()
@@ -0,0 +1,157 @@
+# coding:utf8
+#!/usr/bin/python
+
+import sys
+import os
+import re
+import getopt
+import struct
+
+BMF_VERSION = 3
+
+
+def help():
+    print('#####################################################')
+    print('# Usage of binary bitmap font converter')
+    print('# fnt2bmf [options] fnt...')
+    print('# Convert text BMFont .fnt to AngelCode binary format')
+    print('# (version 3) which is loaded by CCLabelBMFont without')
+    print('# text parsing. Binary file keeps .fnt extension and')
+    print('# refers the same page image, so it must be placed in')
+    print('# the same folder as page image')
+    print('# Options:')
+    print('# [-s|--source] folder')
+    print('#     convert all fnt files in folder, recursively')
+    print('# [-o|--output] folder')
+    print('#     output directory, if not set, fnt file is replaced')
+    print('# [-h|--help]')
+    print('#     show command usage, or just don\'t specify any arguments')
+
+
+def parse_line(line):
+    tag = line.split(' ', 1)[0]
+    attrs = {}
+    for key, quoted, plain in re.findall(r'(\w+)=(?:"([^"]*)"|(\S*))', line):
+        attrs[key] = quoted if quoted or plain == '' else plain
+    return tag, attrs
+
+
+def ints(s):
+    return [int(n) for n in s.split(',') if n != '']
+
+
+def block(type, data):
+    return struct.pack('<BI', type, len(data)) + data
+
+
+def convert(fnt, out):
+    with open(fnt, 'rb') as f:
+        raw = f.read()
+    if raw[:3] == b'BMF':
+        print('already binary: %s' % fnt)
+        return True
+
+    info = None
+    common = None
+    pages = {}
+    chars = []
+    kernings = []
+    for line in raw.decode('utf-8').splitlines():
+        tag, attrs = parse_line(line.strip())
+        if tag == 'info':
+            info = attrs
+        elif tag == 'common':
+            common = attrs
+        elif tag == 'page':
+            pages[int(attrs['id'])] = attrs['file']
+        elif tag == 'char':
+            chars.append(attrs)
+        elif tag == 'kerning':
+            kernings.append(attrs)
+    if info is None or common is None:
+        print('not a BMFont file: %s' % fnt)
+        return False
+
+    # info, font name is last
+    padding = ints(info.get('padding', '0,0,0,0'))
+    spacing = ints(info.get('spacing', '0,0'))
+    bits = (int(info.get('smooth', 0)) << 7) | (int(info.get('unicode', 0)) << 6) | \
+           (int(info.get('italic', 0)) << 5) | (int(info.get('bold', 0)) << 4)
+    data = struct.pack('<hBBHBBBBBBBB', int(info.get('size', 0)), bits, 0, int(info.get('stretchH', 100)),
+                       int(info.get('aa', 1)), padding[0], padding[1], padding[2], padding[3],
+                       spacing[0], spacing[1], int(info.get('outline', 0)))
+    data += info.get('face', '').encode('utf-8') + b'\0'
+    body = bytearray(b'BMF' + struct.pack('<B', BMF_VERSION))
+    body += block(1, data)
+
+    # common
+    data = struct.pack('<HHHHHBBBBB', int(common['lineHeight']), int(common.get('base', 0)),
+                       int(common.get('scaleW', 0)), int(common.get('scaleH', 0)), int(common.get('pages', 1)),
+                       int(common.get('packed', 0)), int(common.get('alphaChnl', 0)),
+                       int(common.get('redChnl', 0)), int(common.get('greenChnl', 0)), int(common.get('blueChnl', 0)))
+    body += block(2, data)
+
+    # pages
+    data = b''.join(pages[i].encode('utf-8') + b'\0' for i in sorted(pages.keys()))
+    body += block(3, data)
+
+    # chars
+    data = b''.join(struct.pack('<IHHHHhhhBB', int(c['id']), int(c['x']), int(c['y']), int(c['width']),
+                                int(c['height']), int(c['xoffset']), int(c['yoffset']), int(c['xadvance']),
+                                int(c.get('page', 0)), int(c.get('chnl', 15))) for c in chars)
+    body += block(4, data)
+
+    # kerning pairs
+    if kernings:
+        data = b''.join(struct.pack('<IIh', int(k['first']), int(k['second']), int(k['amount'])) for k in kernings)
+        body += block(5, data)
+
+    with open(out, 'wb') as f:
+        f.write(body)
+    print('%s -> %s, %d chars, %d kernings' % (fnt, out, len(chars), len(kernings)))
+    return True
+
+
+def output_path(fnt, outDir):
+    if outDir:
+        return os.path.join(outDir, os.path.basename(fnt))
+    return fnt
+
+
+def main():
+    if len(sys.argv) <= 1:
+        help()
+        sys.exit(0)
+
+    try:
+        opts, args = getopt.getopt(sys.argv[1:], 's:o:h', ['source=', 'output=', 'help'])
+    except getopt.GetoptError:
+        help()
+        sys.exit(1)
+
+    outDir = None
+    fnts = list(args)
+    for opt, value in opts:
+        if opt in ('-s', '--source'):
+            for root, dirs, files in os.walk(value):
+                for f in files:
+                    if f.endswith('.fnt'):
+                        fnts.append(os.path.join(root, f))
+        elif opt in ('-o', '--output'):
+            outDir = value
+        elif opt in ('-h', '--help'):
+            help()
+            sys.exit(0)
+
+    if outDir and not os.path.exists(outDir):
+        os.makedirs(outDir)
+
+    failed = 0
+    for fnt in fnts:
+        if not convert(fnt, output_path(fnt, outDir)):
+            failed += 1
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == '__main__':
+    main()
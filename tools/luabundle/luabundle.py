@@ -0,0 +1,130 @@
+# coding:utf8
+#!/usr/bin/python
+
+import sys
+import os
+import getopt
+import struct
+import subprocess
+import tempfile
+
+BUNDLE_MAGIC = b'CCLB'
+BUNDLE_VERSION = 1
+
+
+def help():
+    print('#####################################################')
+    print('# Usage of lua script bundle packer')
+    print('# luabundle [options] folder...')
+    print('# Pack lua scripts in folders into one bundle file which')
+    print('# is loaded by CCLuaScriptCache::addBundle. Entry name is')
+    print('# path relative to parent of folder, without extension,')
+    print('# for example script/cocos/CCNode, so packing folder')
+    print('# script matches require paths used by game')
+    print('# Options:')
+    print('# [-o|--output] file')
+    print('#     bundle file to write, required')
+    print('# [-c|--compile] luajit')
+    print('#     compile sources to bytecode with this luajit binary.')
+    print('#     It must be same version and same GC64 mode as the')
+    print('#     LuaJIT linked in game, otherwise sources are packed')
+    print('# [-h|--help]')
+    print('#     show command usage, or just don\'t specify any arguments')
+
+
+def compile_source(luajit, path, name):
+    fd, out = tempfile.mkstemp(suffix='.lc')
+    os.close(fd)
+    try:
+        # -g keeps debug info so errors still have line numbers
+        subprocess.check_call([luajit, '-bg', '-n', name, path, out])
+        with open(out, 'rb') as f:
+            return f.read()
+    finally:
+        os.remove(out)
+
+
+def collect(folder):
+    entries = {}
+    base = os.path.dirname(os.path.abspath(folder))
+    for root, dirs, files in os.walk(folder):
+        for f in sorted(files):
+            name, ext = os.path.splitext(f)
+            if ext not in ('.lua', '.lc'):
+                continue
+            path = os.path.join(root, f)
+            key = os.path.relpath(os.path.join(os.path.abspath(root), name), base).replace(os.sep, '/')
+
+            # precompiled file wins, same as lua loader
+            if key in entries and ext == '.lua':
+                continue
+            entries[key] = path
+    return entries
+
+
+def pack(folders, out, luajit):
+    entries = {}
+    for folder in folders:
+        entries.update(collect(folder))
+
+    names = sorted(entries.keys())
+    blobs = []
+    for name in names:
+        path = entries[name]
+        if luajit and path.endswith('.lua'):
+            blobs.append(compile_source(luajit, path, name))
+        else:
+            with open(path, 'rb') as f:
+                blobs.append(f.read())
+
+    # header and index, offsets are from start of file
+    index_size = 12
+    for name in names:
+        index_size += 2 + len(name.encode('utf-8')) + 8
+    header = BUNDLE_MAGIC + struct.pack('<II', BUNDLE_VERSION, len(names))
+    index = b''
+    offset = index_size
+    for name, blob in zip(names, blobs):
+        n = name.encode('utf-8')
+        index += struct.pack('<H', len(n)) + n + struct.pack('<II', offset, len(blob))
+        offset += len(blob)
+
+    with open(out, 'wb') as f:
+        f.write(header)
+        f.write(index)
+        for blob in blobs:
+            f.write(blob)
+    print('%s: %d scripts, %d bytes' % (out, len(names), offset))
+
+
+def main():
+    if len(sys.argv) <= 1:
+        help()
+        sys.exit(0)
+
+    try:
+        opts, args = getopt.getopt(sys.argv[1:], 'o:c:h', ['output=', 'compile=', 'help'])
+    except getopt.GetoptError:
+        help()
+        sys.exit(1)
+
+    out = None
+    luajit = None
+    for opt, value in opts:
+        if opt in ('-o', '--output'):
+            out = value
+        elif opt in ('-c', '--compile'):
+            luajit = value
+        elif opt in ('-h', '--help'):
+            help()
+            sys.exit(0)
+
+    if not out or not args:
+        help()
+        sys.exit(1)
+
+    pack(args, out, luajit)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,171 @@
+# coding:utf8
+#!/usr/bin/python
+
+import sys
+import os
+import re
+import getopt
+import struct
+import plistlib
+
+SFB_MAGIC = 0x42465343
+SFB_VERSION = 1
+SFB_NO_STRING = 0xffffffff
+
+
+def help():
+    print('#####################################################')
+    print('# Usage of binary sprite sheet converter')
+    print('# plist2sfb [options] plist...')
+    print('# Convert Zwoptex/TexturePacker plist to binary sprite sheet')
+    print('# (.sfb) which is loaded by CCSpriteFrameCache instead of')
+    print('# plist when it is beside plist file')
+    print('# Options:')
+    print('# [-s|--source] folder')
+    print('#     convert all plist files in folder, recursively')
+    print('# [-o|--output] folder')
+    print('#     output directory, if not set, sfb is saved beside plist')
+    print('# [-h|--help]')
+    print('#     show command usage, or just don\'t specify any arguments')
+
+
+def read_plist(path):
+    if hasattr(plistlib, 'load'):
+        with open(path, 'rb') as f:
+            return plistlib.load(f)
+    return plistlib.readPlist(path)
+
+
+def numbers(s):
+    return [float(n) for n in re.findall(r'-?[0-9.eE+-]+', s)]
+
+
+def parse_rect(s):
+    n = numbers(s)
+    return n[0], n[1], n[2], n[3]
+
+
+def parse_pair(s):
+    n = numbers(s)
+    return n[0], n[1]
+
+
+class StringTable:
+    def __init__(self):
+        self.data = bytearray()
+        self.offsets = {}
+
+    def add(self, s):
+        if s in self.offsets:
+            return self.offsets[s]
+        off = len(self.data)
+        self.offsets[s] = off
+        self.data += s.encode('utf-8') + b'\0'
+        return off
+
+
+def convert(plist, out):
+    root = read_plist(plist)
+    metadata = root.get('metadata', {})
+    frames = root.get('frames', {})
+    fmt = int(metadata.get('format', 0))
+    if fmt < 0 or fmt > 3:
+        print('unsupported format %d: %s' % (fmt, plist))
+        return False
+
+    strings = StringTable()
+    frame_data = []
+    alias_data = []
+    names = sorted(frames.keys())
+    for index, name in enumerate(names):
+        fd = frames[name]
+        if fmt == 0:
+            x, y = float(fd['x']), float(fd['y'])
+            w, h = float(fd['width']), float(fd['height'])
+            ox, oy = float(fd['offsetX']), float(fd['offsetY'])
+            sw, sh = abs(int(fd.get('originalWidth', 0))), abs(int(fd.get('originalHeight', 0)))
+            rotated = False
+        elif fmt == 1 or fmt == 2:
+            x, y, w, h = parse_rect(fd['frame'])
+            rotated = fmt == 2 and bool(fd.get('rotated', False))
+            ox, oy = parse_pair(fd['offset'])
+            sw, sh = parse_pair(fd['sourceSize'])
+        else:
+            w, h = parse_pair(fd['spriteSize'])
+            ox, oy = parse_pair(fd['spriteOffset'])
+            sw, sh = parse_pair(fd['spriteSourceSize'])
+            x, y, _, _ = parse_rect(fd['textureRect'])
+            rotated = bool(fd.get('textureRotated', False))
+            for alias in fd.get('aliases', []):
+                alias_data.append((alias, index))
+        frame_data.append((strings.add(name), x, y, w, h, ox, oy, sw, sh, 1 if rotated else 0))
+
+    texture = metadata.get('textureFileName', '')
+    texture_off = strings.add(texture) if texture else SFB_NO_STRING
+
+    body = bytearray()
+    body += struct.pack('<IHHIIII', SFB_MAGIC, SFB_VERSION, 0, len(frame_data), len(alias_data), len(strings.data), texture_off)
+    for f in frame_data:
+        body += struct.pack('<I8fI', *f)
+    for alias, index in alias_data:
+        body += struct.pack('<II', strings.add(alias), index)
+
+    # aliases may add strings, so string table is packed last, 4 bytes aligned
+    while len(strings.data) % 4 != 0:
+        strings.data += b'\0'
+    struct.pack_into('<I', body, 16, len(strings.data))
+    body += strings.data
+
+    with open(out, 'wb') as f:
+        f.write(body)
+    print('%s -> %s, %d frames' % (plist, out, len(frame_data)))
+    return True
+
+
+def output_path(plist, outDir):
+    name = os.path.splitext(plist)[0] + '.sfb'
+    if outDir:
+        name = os.path.join(outDir, os.path.basename(name))
+    return name
+
+
+def main():
+    if len(sys.argv) <= 1:
+        help()
+        sys.exit(0)
+
+    try:
+        opts, args = getopt.getopt(sys.argv[1:], 's:o:h', ['source=', 'output=', 'help'])
+    except getopt.GetoptError:
+        help()
+        sys.exit(1)
+
+    outDir = None
+    plists = list(args)
+    for opt, value in opts:
+        if opt in ('-s', '--source'):
+            for root, dirs, files in os.walk(value):
+                for f in files:
+                    if f.endswith('.plist'):
+                        plists.append(os.path.join(root, f))
+        elif opt in ('-o', '--output'):
+            outDir = value
+        elif opt in ('-h', '--help'):
+            help()
+            sys.exit(0)
+
+    if outDir and not os.path.exists(outDir):
+        os.makedirs(outDir)
+
+    failed = 0
+    for plist in plists:
+        root = read_plist(plist)
+        if not isinstance(root, dict) or 'frames' not in root:
+            continue
+        if not convert(plist, output_path(plist, outDir)):
+            failed += 1
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == '__main__':
+    main()
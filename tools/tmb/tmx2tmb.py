@@ -0,0 +1,256 @@
+# coding:utf8
+#!/usr/bin/python
+
+import sys
+import os
+import getopt
+import struct
+import base64
+import zlib
+import xml.etree.ElementTree as ET
+
+TMB_MAGIC = 0x424d5443
+TMB_VERSION = 1
+
+ORIENTATIONS = {'orthogonal': 1, 'isometric': 2, 'hexagonal': 3}
+
+# same as CCTMXObject::Shape
+SHAPE_NORMAL = 0
+SHAPE_POLYGON = 1
+SHAPE_POLYLINE = 2
+
+
+def help():
+    print('#####################################################')
+    print('# Usage of binary tmx map converter')
+    print('# tmx2tmb [options] tmx...')
+    print('# Convert tmx map to binary map (.tmb) which is loaded by')
+    print('# CCTMXLoader instead of tmx when it is beside tmx file.')
+    print('# External tilesets are embedded, tile layers are decoded')
+    print('# and saved as raw gid arrays')
+    print('# Options:')
+    print('# [-s|--source] folder')
+    print('#     convert all tmx files in folder, recursively')
+    print('# [-o|--output] folder')
+    print('#     output directory, if not set, tmb is saved beside tmx')
+    print('# [-h|--help]')
+    print('#     show command usage, or just don\'t specify any arguments')
+
+
+class Writer:
+    def __init__(self):
+        self.data = bytearray()
+
+    def int(self, v):
+        self.data += struct.pack('<i', int(v))
+
+    def uint(self, v):
+        self.data += struct.pack('<I', int(v) & 0xffffffff)
+
+    def float(self, v):
+        self.data += struct.pack('<f', float(v))
+
+    def string(self, s):
+        b = (s or '').encode('utf-8')
+        self.int(len(b))
+        self.data += b
+        while len(self.data) % 4 != 0:
+            self.data += b'\0'
+
+    def properties(self, elem):
+        props = []
+        if elem is not None:
+            for p in elem.findall('properties/property'):
+                value = p.get('value')
+                if value is None:
+                    value = p.text or ''
+                props.append((p.get('name', ''), value))
+        self.int(len(props))
+        for key, value in props:
+            self.string(key)
+            self.string(value)
+
+
+def decode_layer(layer, width, height):
+    data = layer.find('data')
+    count = width * height
+    if data is None:
+        return [0] * count
+    encoding = data.get('encoding')
+    compression = data.get('compression')
+    if encoding == 'base64':
+        raw = base64.b64decode(data.text.strip())
+        if compression == 'zlib':
+            raw = zlib.decompress(raw)
+        elif compression == 'gzip':
+            raw = zlib.decompress(raw, 16 + zlib.MAX_WBITS)
+        elif compression is not None:
+            raise ValueError('unsupported layer compression: %s' % compression)
+        gids = list(struct.unpack('<%dI' % (len(raw) // 4), raw[:len(raw) // 4 * 4]))
+    elif encoding == 'csv':
+        gids = [int(v) for v in data.text.replace('\n', '').split(',') if v.strip()]
+    elif encoding is None:
+        gids = [int(t.get('gid', 0)) for t in data.findall('tile')]
+    else:
+        raise ValueError('unsupported layer encoding: %s' % encoding)
+    gids += [0] * (count - len(gids))
+    return gids[:count]
+
+
+def parse_points(s):
+    points = []
+    for p in s.split():
+        x, y = p.split(',')
+        points.append((float(x), float(y)))
+    return points
+
+
+def convert(tmx, out):
+    tmxDir = os.path.dirname(tmx)
+    root = ET.parse(tmx).getroot()
+    w = Writer()
+
+    # header
+    w.uint(TMB_MAGIC)
+    w.int(TMB_VERSION)
+    w.int(ORIENTATIONS.get(root.get('orientation'), 1))
+    w.int(root.get('width', 0))
+    w.int(root.get('height', 0))
+    w.float(root.get('tilewidth', 0))
+    w.float(root.get('tileheight', 0))
+    w.properties(root)
+
+    # tilesets, external tileset is embedded
+    tilesets = []
+    for ts in root.findall('tileset'):
+        firstgid = int(ts.get('firstgid', 1))
+        source = ts.get('source')
+        if source:
+            ts = ET.parse(os.path.join(tmxDir, source)).getroot()
+        tilesets.append((firstgid, ts))
+    w.int(len(tilesets))
+    for firstgid, ts in tilesets:
+        image = ts.find('image')
+        w.string(ts.get('name', ''))
+        w.int(firstgid)
+        w.float(ts.get('tilewidth', 0))
+        w.float(ts.get('tileheight', 0))
+        w.float(ts.get('spacing', 0))
+        w.float(ts.get('margin', 0))
+        w.string(image.get('source', '') if image is not None else '')
+
+    # tile properties
+    tiles = []
+    for firstgid, ts in tilesets:
+        for tile in ts.findall('tile'):
+            if tile.find('properties') is not None:
+                tiles.append((firstgid + int(tile.get('id', 0)), tile))
+    w.int(len(tiles))
+    for gid, tile in tiles:
+        w.int(gid)
+        w.properties(tile)
+
+    # layers
+    layers = root.findall('layer')
+    w.int(len(layers))
+    for layer in layers:
+        width = int(layer.get('width', 0))
+        height = int(layer.get('height', 0))
+        w.string(layer.get('name', ''))
+        w.int(width)
+        w.int(height)
+        w.int(int(layer.get('visible', 1)) == 1)
+        w.int(float(layer.get('opacity', 1)) * 255)
+        w.float(layer.get('x', 0))
+        w.float(layer.get('y', 0))
+        w.properties(layer)
+        gids = decode_layer(layer, width, height)
+        w.data += struct.pack('<%dI' % len(gids), *gids)
+
+    # object groups
+    groups = root.findall('objectgroup')
+    w.int(len(groups))
+    for group in groups:
+        color = group.get('color')
+        w.string(group.get('name', ''))
+        w.float(group.get('x', 0))
+        w.float(group.get('y', 0))
+        w.uint((int(color.lstrip('#'), 16) | 0xff000000) if color else 0xffffffff)
+        w.float(group.get('opacity', 1))
+        w.properties(group)
+        objects = group.findall('object')
+        w.int(len(objects))
+        for obj in objects:
+            shape = SHAPE_NORMAL
+            points = []
+            if obj.find('polygon') is not None:
+                shape = SHAPE_POLYGON
+                points = parse_points(obj.find('polygon').get('points', ''))
+            elif obj.find('polyline') is not None:
+                shape = SHAPE_POLYLINE
+                points = parse_points(obj.find('polyline').get('points', ''))
+            w.string(obj.get('name', ''))
+            w.string(obj.get('type', ''))
+            w.int(shape)
+            w.float(obj.get('x', 0))
+            w.float(obj.get('y', 0))
+            w.float(obj.get('width', 0))
+            w.float(obj.get('height', 0))
+            w.int(len(points))
+            for x, y in points:
+                w.float(x)
+                w.float(y)
+            w.properties(obj)
+
+    with open(out, 'wb') as f:
+        f.write(w.data)
+    print('%s -> %s, %d layers, %d object groups' % (tmx, out, len(layers), len(groups)))
+
+
+def output_path(tmx, outDir):
+    name = os.path.splitext(tmx)[0] + '.tmb'
+    if outDir:
+        name = os.path.join(outDir, os.path.basename(name))
+    return name
+
+
+def main():
+    if len(sys.argv) <= 1:
+        help()
+        sys.exit(0)
+
+    try:
+        opts, args = getopt.getopt(sys.argv[1:], 's:o:h', ['source=', 'output=', 'help'])
+    except getopt.GetoptError:
+        help()
+        sys.exit(1)
+
+    outDir = None
+    tmxs = list(args)
+    for opt, value in opts:
+        if opt in ('-s', '--source'):
+            for root, dirs, files in os.walk(value):
+                for f in files:
+                    if f.endswith('.tmx'):
+                        tmxs.append(os.path.join(root, f))
+        elif opt in ('-o', '--output'):
+            outDir = value
+        elif opt in ('-h', '--help'):
+            help()
+            sys.exit(0)
+
+    if outDir and not os.path.exists(outDir):
+        os.makedirs(outDir)
+
+    failed = 0
+    for tmx in tmxs:
+        try:
+            convert(tmx, output_path(tmx, outDir))
+        except Exception as e:
+            print('failed to convert %s: %s' % (tmx, e))
+            failed += 1
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == '__main__':
+    main()